@@ -0,0 +1,305 @@
+/*******************************************************************************************
+ *
+ *  Utility to merge .1aln files, each sorted in (aread,abpos) order, into a single .1aln
+ *    file so sorted.  In particular merging the outputs of the FastGA runs -shard:1/n ...
+ *    -shard:n/n of a comparison gives exactly the alignments, in the same order, of the
+ *    run without -shard.  The lines of each alignment object are copied verbatim, so any
+ *    CIGAR strings are kept, and the target is given an alignment index (see alncode.h).
+ *
+ *  Author:  agent (agent@local)
+ *  Date  :  October 2026
+ *
+ *******************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "GDB.h"
+#include "alncode.h"
+
+static char *Usage = "[-v] <target:path>[.1aln] <source:path>[.1aln] ...";
+
+  //  An input file and the sort key of the alignment whose A-line it is positioned at
+
+typedef struct
+  { OneFile *of;
+    char    *name;
+    int64    aread;
+    int64    abpos;
+    int64    aepos;
+    int64    bread;
+    int64    count;
+  } Source;
+
+static size_t fieldSize[128];
+
+  //  Set the key of src from its current A-line, returning 0 if it is at the end of file
+
+static int src_key(Source *src)
+{ OneFile *of = src->of;
+
+  if (of->lineType != 'A')
+    return (0);
+  src->aread = oneInt(of,0);
+  src->abpos = oneInt(of,1);
+  src->aepos = oneInt(of,2);
+  src->bread = oneInt(of,3);
+  return (1);
+}
+
+  //  Order by (aread,abpos,bread) breaking ties in favor of the earlier file
+
+#define BIGGER(l,r)				\
+  ( (l)->aread != (r)->aread ? (l)->aread > (r)->aread :	\
+    (l)->abpos != (r)->abpos ? (l)->abpos > (r)->abpos :	\
+    (l)->bread != (r)->bread ? (l)->bread > (r)->bread :	\
+    (l) > (r) )
+
+static void reheap(int s, Source **heap, int hsize)
+{ int     c, l, r;
+  Source *hs, *hl;
+
+  c  = s;
+  hs = heap[s];
+  while ((l = 2*c) <= hsize)
+    { r  = l+1;
+      hl = heap[l];
+      if (r <= hsize && BIGGER(hl,heap[r]))
+        { l  = r;
+          hl = heap[r];
+        }
+      if ( ! BIGGER(hs,hl))
+        break;
+      heap[c] = hl;
+      c = l;
+    }
+  heap[c] = hs;
+}
+
+  //  Copy the alignment object src is at to out, leaving src at the next A-line (if any)
+
+static void copy_object(Source *src, OneFile *out)
+{ OneFile *in = src->of;
+
+  do
+    { memcpy(out->field,in->field,fieldSize[(int) in->lineType]);
+      oneWriteLine(out,in->lineType,oneLen(in),oneString(in));
+    }
+  while (oneReadLine(in) && in->lineType != 'A');
+  if (in->lineType != 'A')
+    in->lineType = 0;
+  src->count += 1;
+}
+
+int main(int argc, char *argv[])
+{ Source     *src;
+  Source    **heap;
+  OneSchema  *schema;
+  OneFile    *out;
+  Aln_Index  *aix;
+  int         nsrc, hsize;
+  int         tspace;
+  char       *db1_name, *db2_name;
+  char       *opath, *oroot;
+  int         VERBOSE;
+
+  //  Process options
+
+  { int    i, j, k;
+    int    flags[128];
+
+    ARG_INIT("ALNmerge")
+
+    j = 1;
+    for (i = 1; i < argc; i++)
+      if (argv[i][0] == '-')
+        switch (argv[i][1])
+        { default:
+            ARG_FLAGS("v")
+            break;
+        }
+      else
+        argv[j++] = argv[i];
+    argc = j;
+
+    VERBOSE = flags['v'];
+
+    if (argc < 3)
+      { fprintf(stderr,"Usage: %s %s\n",Prog_Name,Usage);
+        fprintf(stderr,"\n");
+        fprintf(stderr,"      -v: verbose mode, report the alignments taken from each source\n");
+        exit (1);
+      }
+  }
+
+  //  Open each source, check they are all of the same comparison, and move to its first
+  //    alignment
+
+  nsrc = argc-2;
+  src  = (Source *) Malloc(sizeof(Source)*nsrc,"Allocating sources");
+  heap = (Source **) Malloc(sizeof(Source *)*(nsrc+1),"Allocating heap");
+  if (src == NULL || heap == NULL)
+    exit (1);
+
+  schema = make_Aln_Schema();
+  if (schema == NULL)
+    { fprintf(stderr,"%s: Failed to create 1aln schema\n",Prog_Name);
+      exit (1);
+    }
+
+  db1_name = NULL;
+  db2_name = NULL;
+  tspace   = 0;
+  hsize    = 0;
+  { int      i, r, t;
+    char    *path, *root;
+    char    *name1, *name2;
+    OneFile *of;
+
+    for (i = 0; i < nsrc; i++)
+      { path = PathTo(argv[i+2]);
+        root = Root(argv[i+2],".1aln");
+        src[i].name = Strdup(Catenate(path,"/",root,".1aln"),"Allocating source name");
+        if (src[i].name == NULL)
+          exit (1);
+        free(root);
+        free(path);
+
+        of = oneFileOpenRead(src[i].name,schema,"aln",1);
+        if (of == NULL)
+          { fprintf(stderr,"%s: Failed to open .1aln file %s\n",Prog_Name,src[i].name);
+            exit (1);
+          }
+        if (of->info['a'] != NULL && of->info['a']->given.count > 0)
+          { fprintf(stderr,"%s: Chained alignments in %s cannot be merged\n",
+                           Prog_Name,src[i].name);
+            exit (1);
+          }
+        src[i].of    = of;
+        src[i].count = 0;
+
+        name1 = NULL;
+        name2 = NULL;
+        if (of->info['<'] != NULL)
+          { for (r = 0; r < of->info['<']->accum.count; r++)
+              if (of->reference[r].count == 1)
+                name1 = of->reference[r].filename;
+              else if (of->reference[r].count == 2)
+                name2 = of->reference[r].filename;
+          }
+        if (name1 == NULL)
+          { fprintf(stderr,"%s: No genome references in %s\n",Prog_Name,src[i].name);
+            exit (1);
+          }
+
+        t = 0;
+        while (oneReadLine(of) && of->lineType != 'A')
+          if (of->lineType == 't')
+            t = oneInt(of,0);
+        if (of->lineType != 'A')
+          of->lineType = 0;
+        if (t == 0)
+          { fprintf(stderr,"%s: Did not find a t-line before first alignment of %s\n",
+                           Prog_Name,src[i].name);
+            exit (1);
+          }
+
+        if (i == 0)
+          { db1_name = name1;
+            db2_name = name2;
+            tspace   = t;
+          }
+        else
+          { if (strcmp(name1,db1_name) != 0 || (name2 == NULL) != (db2_name == NULL)
+                                           || (name2 != NULL && strcmp(name2,db2_name) != 0))
+              { fprintf(stderr,"%s: %s is not a comparison of the same genomes as %s\n",
+                               Prog_Name,src[i].name,src[0].name);
+                exit (1);
+              }
+            if (t != tspace)
+              { fprintf(stderr,"%s: %s and %s have different trace spacings\n",
+                               Prog_Name,src[i].name,src[0].name);
+                exit (1);
+              }
+          }
+
+        if (src_key(src+i))
+          heap[++hsize] = src+i;
+      }
+
+    for (i = 0; i < 128; i++)
+      if (src[0].of->info[i] != NULL)
+        fieldSize[i] = src[0].of->info[i]->nField*sizeof(OneField);
+  }
+
+  //  Open the target with the references of the sources
+
+  { char *cpath;
+
+    opath = PathTo(argv[1]);
+    oroot = Root(argv[1],".1aln");
+    cpath = getcwd(NULL,0);
+    out = open_Aln_Write(Catenate(opath,"/",oroot,".1aln"),1,Prog_Name,"0.1",Command_Line,
+                         tspace,db1_name,db2_name,cpath);
+    aix = Aln_Index_Start();
+    if (out == NULL || aix == NULL)
+      exit (1);
+    free(cpath);
+  }
+
+  //  Merge: repeatedly copy the least alignment at the top of the heap
+
+  { int i;
+
+    for (i = hsize/2; i >= 1; i--)
+      reheap(i,heap,hsize);
+
+    while (hsize > 0)
+      { Aln_Index_Add(aix,heap[1]->aread,heap[1]->abpos,heap[1]->aepos);
+        copy_object(heap[1],out);
+        if ( ! src_key(heap[1]))
+          { heap[1] = heap[hsize];
+            hsize  -= 1;
+          }
+        if (hsize > 0)
+          reheap(1,heap,hsize);
+      }
+  }
+
+  oneFileClose(out);
+  if (Aln_Index_Write(aix,Catenate(opath,"/",oroot,".1aln")))
+    exit (1);
+  Aln_Index_Free(aix);
+
+  { int   i;
+    int64 total;
+
+    total = 0;
+    for (i = 0; i < nsrc; i++)
+      { if (VERBOSE)
+          { fprintf(stderr,"  %s: ",src[i].name);
+            Print_Number(src[i].count,0,stderr);
+            fprintf(stderr," alignments\n");
+          }
+        total += src[i].count;
+        oneFileClose(src[i].of);
+        free(src[i].name);
+      }
+    if (VERBOSE)
+      { fprintf(stderr,"  %s/%s.1aln: ",opath,oroot);
+        Print_Number(total,0,stderr);
+        fprintf(stderr," alignments\n");
+      }
+  }
+
+  oneSchemaDestroy(schema);
+  free(oroot);
+  free(opath);
+  free(heap);
+  free(src);
+
+  exit (0);
+}
@@ -36,6 +36,8 @@
 #include <string.h>
 #include <stdint.h>
 #include <ctype.h>
+#include <math.h>
+#include <errno.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <sys/types.h>
@@ -61,7 +63,7 @@
   //  Command line syntax and global parameter variables
 
 static char *Usage[] =
-  { "[-vSL] [-T<int(4)>] [-p[:<output:path>[.pdf]]]",
+  { "[-vSL] [-T<int(4)>] [-p[:<output:path>[.pdf]]] [-r[:<image:path>[.png|.ppm]] [-z<int>]]",
     "[-l<int(100)>] [-i<float(.7)>] [-n<int(100000)>]",
     "[-H<int(600)>] [-W<int>] [-f<int>] [-t<float>]",
     "<alignment:path>[.1aln|.paf[.gz]]> [<selection>|<FILE> [<selection>|<FILE>]]",
@@ -75,6 +77,9 @@ static int    LABELS;             // ! -L
 
 static int    NTHREADS = 4;       // -T
 static char  *OUTEPS   = NULL;    // -p
+static char  *OUTIMG   = NULL;    // -r
+static int    IMGPPM   = 0;       // -r:<image>.ppm
+static int    ZOOM     = 0;       // -z
 
 static int    MINALEN  = 100;     // -a
 static double MINAIDNT = 0.7;     // -e
@@ -89,6 +94,7 @@ static double LINESIZE = 0;       // -t
 
 typedef struct
   { uint8 flag;
+    uint8 idnt;     //  percent identity (for -r shading)
     int   aread, bread;
     int   abpos, bbpos;
     int   aepos, bepos;
@@ -303,6 +309,9 @@ void *read_1aln_block(void *args)
 
   //  For each alignment do
 
+  parm->nseg = 0;
+  if (beg >= end)
+    return (NULL);
   if (!oneGoto (parm->in, 'A', beg+1))
     { fprintf(stderr,"%s: Could not locate to object %lld in 1aln file\n",Prog_Name,beg+1);
       exit (1);
@@ -369,6 +378,7 @@ void *read_1aln_block(void *args)
 
         // add to output
         segs->flag  = flag;
+        segs->idnt  = (200*((int64) iid)) / blocksum;
         segs->aread = aread;
         segs->abpos = abpos;
         segs->aepos = aepos;
@@ -389,9 +399,11 @@ void *read_1aln_block(void *args)
   return (NULL);
 }
 
-void read_1aln(char *oneAlnFile)
+void read_1aln(char *oneAlnFile, char *xseq)
 { OneFile   *input;
   int64      novl;
+  int64     *range;
+  int        nrange;
 
   //  Initiate .1aln file reading and read header information
 
@@ -475,7 +487,6 @@ void read_1aln(char *oneAlnFile)
     BSCAFFS  = BGDB->scaffolds;
     BCONTIG  = BGDB->contigs;
 
-    AHASH = New_Hash_Table(NASCAFF,0);
     head  = AGDB->headers;
     for (s = 0; s < NASCAFF; s++)
       { sptr = head + ASCAFFS[s].hoff;
@@ -483,29 +494,26 @@ void read_1aln(char *oneAlnFile)
           if (isspace(*eptr))
             break;
         *eptr = '\0';
-        if (Hash_Lookup(AHASH,sptr) < 0)
-          Hash_Add(AHASH,sptr);
-        else
-          { fprintf(stderr,"%s: Duplicate scaffold name: %s\n",Prog_Name,sptr);
-            exit (1);
-          }
+      }
+    AHASH = New_Hash_Block(head,NASCAFF,&ASCAFFS[0].hoff,sizeof(GDB_SCAFFOLD),&s);
+    if (s >= 0)
+      { fprintf(stderr,"%s: Duplicate scaffold name: %s\n",Prog_Name,head+ASCAFFS[s].hoff);
+        exit (1);
       }
 
     if (ISTWO)
-      { BHASH = New_Hash_Table(NBSCAFF,0);
-        head  = BGDB->headers;
+      { head  = BGDB->headers;
         for (s = 0; s < NBSCAFF; s++)
           { sptr = head + BSCAFFS[s].hoff;
             for (eptr = sptr; *eptr != '\0'; eptr++)
               if (isspace(*eptr))
                 break;
             *eptr = '\0';
-            if (Hash_Lookup(BHASH,sptr) < 0)
-              Hash_Add(BHASH,sptr);
-            else
-              { fprintf(stderr,"%s: Duplicate scaffold name: %s\n",Prog_Name,sptr);
-                exit (1);
-              }
+          }
+        BHASH = New_Hash_Block(head,NBSCAFF,&BSCAFFS[0].hoff,sizeof(GDB_SCAFFOLD),&s);
+        if (s >= 0)
+          { fprintf(stderr,"%s: Duplicate scaffold name: %s\n",Prog_Name,head+BSCAFFS[s].hoff);
+            exit (1);
           }
       }
     else
@@ -538,44 +546,94 @@ void read_1aln(char *oneAlnFile)
   }
 #endif
 
+  //  If only some A-contigs are to be plotted and the .1aln has an alignment index, then
+  //    only the ranges of records that can be on the selected parts of them need be read,
+  //    otherwise all of them.
+
+  range  = NULL;
+  nrange = 0;
+  if (xseq != NULL)
+    { Aln_Index    *aix;
+      Contig_Range *chord;
+      int64         beg, end;
+      int           c;
+
+      aix = Aln_Index_Read(oneAlnFile,novl);
+      if (aix != NULL)
+        { chord = get_selection_contigs(xseq, AGDB, AHASH, 1);
+          range = (int64 *) Malloc(2*sizeof(int64)*NACONTIG,"Allocating record ranges");
+          for (c = 0; c < NACONTIG; c++)
+            if (chord[c].order != 0 && Aln_Index_Range(aix,c,chord[c].beg,chord[c].end,&beg,&end))
+              { if (nrange > 0 && beg <= range[2*nrange-1])
+                  { if (end > range[2*nrange-1])
+                      range[2*nrange-1] = end;
+                  }
+                else
+                  { range[2*nrange]   = beg;
+                    range[2*nrange+1] = end;
+                    nrange += 1;
+                  }
+              }
+          free(chord);
+          Aln_Index_Free(aix);
+        }
+    }
+  if (range == NULL)
+    { range = (int64 *) Malloc(2*sizeof(int64),"Allocating record ranges");
+      range[0] = 0;
+      range[1] = novl;
+      nrange   = 1;
+    }
+
   // Read alignment segments
 
-  { int p;
+  { int p, r;
+    int64     nrec, n, b;
     Packet    parm[NTHREADS];
     pthread_t threads[NTHREADS];
 
-    //  Divide .1aln into NTHREADS parts
-
-    segments = (Segment *) Malloc(sizeof(Segment)*novl, "Allocating segment array");
-    for (p = 0; p < NTHREADS ; p++)
-      { parm[p].beg = (p * novl) / NTHREADS;
-        if (p > 0)
-          parm[p-1].end = parm[p].beg;
-        parm[p].segs = segments + parm[p].beg;
-        parm[p].nseg = 0;
-        parm[p].in   = input + p;
-        parm[p].bctg = BGDB->contigs;
-      }
-    parm[NTHREADS-1].end = novl;
+    nrec = 0;
+    for (r = 0; r < nrange; r++)
+      nrec += range[2*r+1] - range[2*r];
+    segments = (Segment *) Malloc(sizeof(Segment)*(nrec+1), "Allocating segment array");
+    nSegment = 0;
+
+    for (r = 0; r < nrange; r++)
+
+      //  Divide the range into NTHREADS parts
+
+      { b = range[2*r];
+        n = range[2*r+1] - b;
+        for (p = 0; p < NTHREADS ; p++)
+          { parm[p].beg = b + (p * n) / NTHREADS;
+            if (p > 0)
+              parm[p-1].end = parm[p].beg;
+            parm[p].segs = segments + nSegment + (parm[p].beg - b);
+            parm[p].nseg = 0;
+            parm[p].in   = input + p;
+            parm[p].bctg = BGDB->contigs;
+          }
+        parm[NTHREADS-1].end = b + n;
 
-    // Use NTHREADS to produce alignment segments for each part
+        // Use NTHREADS to produce alignment segments for each part
 
-    for (p = 1; p < NTHREADS; p++)
-      pthread_create(threads+p,NULL,read_1aln_block,parm+p);
-    read_1aln_block(parm);
-    for (p = 1; p < NTHREADS; p++)
-      pthread_join(threads[p],NULL);
+        for (p = 1; p < NTHREADS; p++)
+          pthread_create(threads+p,NULL,read_1aln_block,parm+p);
+        read_1aln_block(parm);
+        for (p = 1; p < NTHREADS; p++)
+          pthread_join(threads[p],NULL);
   
-    // Collect results from different part
+        // Collect results from different part
 
-    nSegment = parm[0].nseg;
-    for (p = 1; p < NTHREADS; p++)
-      { if (nSegment < parm[p].beg)
-          memmove(segments+nSegment,parm[p].segs,parm[p].nseg);
-        nSegment += parm[p].nseg;
+        for (p = 0; p < NTHREADS; p++)
+          { if (segments+nSegment < parm[p].segs)
+              memmove(segments+nSegment,parm[p].segs,sizeof(Segment)*parm[p].nseg);
+            nSegment += parm[p].nseg;
+          }
       }
     if (nSegment < novl)
-      segments = Realloc(segments,sizeof(Segment)*nSegment,"Compacting segment arrary");
+      segments = Realloc(segments,sizeof(Segment)*(nSegment+1),"Compacting segment arrary");
+    free(range);
 
 #ifdef DEBUG_READ_1ALN
     fprintf(stderr, "%s: %9lld segments loaded\n",Prog_Name,novl);
@@ -715,6 +773,7 @@ void read_paf(char *pafAlnFile, int gzipd)
         }
 
       segs->flag  = flag;
+      segs->idnt  = (200*((int64) iid)) / blocksum;
       segs->aread = aread;
       segs->bread = bread;
       segs->abpos = abpos;
@@ -1258,7 +1317,7 @@ void aln_filter()
     free(parm);
   }
 
-  if (MAXALIGN == 0 || nseg <= MAXALIGN) return;
+  if (MAXALIGN == 0 || nseg <= MAXALIGN || OUTIMG != NULL) return;
 
   sarray = (int *) Malloc(sizeof(int)*nseg,"Allocating seq array");
   
@@ -1364,24 +1423,11 @@ void aln_filter()
 
 static int SEG_COLOR[3] = { G_COLOR, N_COLOR, C_COLOR };
 
-  // generate eps file
-
-void make_plot(FILE *fo)
-{ int    width, height, fsize, maxis, xmargin, ymargin;
-  int    nxseq, nyseq;
-  char  *xnames, *ynames;
-  int64  txseq, tyseq, *cxoff, *sxoff, *cyoff, *syoff;
-  double sx, sy;
-  double lsize, bsize, gsize; // line size, border size, grid size
-  int    i, c;
-
-  // find total length of x- and y-axis and order of plotting
+  //  Size of the plot panel for axes of txseq & tyseq bases given -W & -H, kept within
+  //    [MIN_XY_LEN,MAX_XY_LEN] on each side
 
-  txseq = tyseq = 0;
-  nxseq = axisConfig(BHASH,BGDB,BCHORD,&cxoff,&sxoff,&xnames,&txseq);
-  nyseq = axisConfig(AHASH,AGDB,ACHORD,&cyoff,&syoff,&ynames,&tyseq);
-
-  alnConfig();
+static void plot_size(int64 txseq, int64 tyseq, int *pwidth, int *pheight)
+{ int width, height, maxis;
 
   width  = IMGWIDTH;
   height = IMGHEIGH;
@@ -1438,6 +1484,31 @@ void make_plot(FILE *fo)
         }
     }
 
+  *pwidth  = width;
+  *pheight = height;
+}
+
+  // generate eps file
+
+void make_plot(FILE *fo)
+{ int    width, height, fsize, maxis, xmargin, ymargin;
+  int    nxseq, nyseq;
+  char  *xnames, *ynames;
+  int64  txseq, tyseq, *cxoff, *sxoff, *cyoff, *syoff;
+  double sx, sy;
+  double lsize, bsize, gsize; // line size, border size, grid size
+  int    i, c;
+
+  // find total length of x- and y-axis and order of plotting
+
+  txseq = tyseq = 0;
+  nxseq = axisConfig(BHASH,BGDB,BCHORD,&cxoff,&sxoff,&xnames,&txseq);
+  nyseq = axisConfig(AHASH,AGDB,ACHORD,&cyoff,&syoff,&ynames,&tyseq);
+
+  alnConfig();
+
+  plot_size(txseq,tyseq,&width,&height);
+
   maxis = (width < height ? width : height);
   
   lsize = LINESIZE;
@@ -1581,8 +1652,535 @@ void make_plot(FILE *fo)
   free(ynames);
 }
 
+/*******************************************************************************************
+ *
+ *  Raster output (-r):  Rather than one vector line per segment, the plot panel is cut into
+ *    bands of TILE_LEN pixel rows that are rendered in parallel by the -T threads.  Each pixel
+ *    accumulates the number of forward and reverse segments crossing it and the sum of their
+ *    identities.  A pixel's color is the mix of N_COLOR and C_COLOR by the forward/reverse
+ *    split, its strength rising logarithmically with the count and fading with low identity.
+ *    The image is written directly as a PNG (or binary PPM) or, with -z, as a pyramid of
+ *    TILE_LEN x TILE_LEN PNG tiles <dir>/<z>/<x>/<y>.png where level z is TILE_LEN*2^z pixels
+ *    along its longer axis.  Labels are not drawn, only the border and grid.
+ *
+ *******************************************************************************************/
+
+#define TILE_LEN    256     //  Rows in a band and side of a tile
+#define MAX_ZOOM     12     //  Maximum number of tile levels
+#define DENSE_SAT    64.    //  Segment count at which a pixel is fully saturated
+
+typedef struct
+  { float fwd;     //  # of forward segments crossing the pixel
+    float rev;     //  # of reverse segments crossing the pixel
+    float idn;     //  sum of the identities of the above
+  } Pixel;
+
+  //  Geometry of an image and the segments crossing each band of it
+
+typedef struct
+  { int     width, height;   //  Image size
+    int     bwide;           //  Columns in a band (width rounded up to TILE_LEN if tiled)
+    int     nband;           //  Number of bands
+    double  sx, sy;          //  Pixels per base
+    int64  *cxoff, *cyoff;   //  Axis offsets of each contig
+    uint8  *xgrid, *ygrid;   //  Grid line (1) or border (2) at each column & row
+    int64  *bidx;            //  Segments in band b are segments[blist[bidx[b]..bidx[b+1])]
+    int64  *blist;
+  } Raster;
+
+  //  Threading communication packet (band_render)
+
+typedef struct
+  { Raster *ras;
+    int     band;
+    Pixel  *grid;     //  bwide x TILE_LEN accumulators
+    uint8  *rgb;      //  bwide x TILE_LEN x 3 image bytes
+  } Band;
+
+  //  Image writer: PNG via zlib, or binary PPM
+
+typedef struct
+  { FILE     *file;
+    char     *name;
+    int       ppm;
+    int       width;
+    z_stream  zs;
+    uint8    *zbuf;
+  } Image;
+
+#define ZBUF_LEN 0x10000
+
+static void png_chunk(Image *img, char *type, uint8 *data, uint32 len)
+{ uint8  head[8];
+  uint32 crc;
+
+  head[0] = len >> 24;
+  head[1] = len >> 16;
+  head[2] = len >> 8;
+  head[3] = len;
+  memcpy(head+4,type,4);
+  crc = crc32(0,head+4,4);
+  fwrite(head,8,1,img->file);
+  if (len > 0)
+    { crc = crc32(crc,data,len);
+      fwrite(data,len,1,img->file);
+    }
+  head[0] = crc >> 24;
+  head[1] = crc >> 16;
+  head[2] = crc >> 8;
+  head[3] = crc;
+  fwrite(head,4,1,img->file);
+}
+
+  //  Deflate the next len bytes of the image data, emitting IDAT chunks as the buffer fills
+
+static void png_deflate(Image *img, uint8 *data, uint32 len, int flush)
+{ z_stream *zs = &(img->zs);
+
+  zs->next_in  = data;
+  zs->avail_in = len;
+  do
+    { if (deflate(zs,flush) == Z_STREAM_ERROR)
+        { fprintf(stderr,"%s: Compression of image %s failed\n",Prog_Name,img->name);
+          exit (1);
+        }
+      if (zs->avail_out == 0 || (flush == Z_FINISH && zs->avail_out < ZBUF_LEN))
+        { png_chunk(img,"IDAT",img->zbuf,ZBUF_LEN-zs->avail_out);
+          zs->next_out  = img->zbuf;
+          zs->avail_out = ZBUF_LEN;
+        }
+    }
+  while (zs->avail_in > 0 || (flush == Z_FINISH && zs->avail_out < ZBUF_LEN));
+}
+
+static Image *image_open(char *name, int width, int height, int ppm)
+{ Image *img;
+
+  img = Malloc(sizeof(Image),"Allocating image");
+  img->zbuf = Malloc(ZBUF_LEN,"Allocating image");
+  img->name = Strdup(name,"Allocating image");
+  img->file = fopen(name,"w");
+  if (img->file == NULL)
+    { fprintf(stderr,"%s: Could not open file %s for writing\n",Prog_Name,name);
+      exit (1);
+    }
+  img->ppm   = ppm;
+  img->width = width;
+
+  if (ppm)
+    fprintf(img->file,"P6\n%d %d\n255\n",width,height);
+  else
+    { static uint8 sign[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+      uint8 ihdr[13];
+
+      fwrite(sign,8,1,img->file);
+      ihdr[0] = width >> 24;
+      ihdr[1] = width >> 16;
+      ihdr[2] = width >> 8;
+      ihdr[3] = width;
+      ihdr[4] = height >> 24;
+      ihdr[5] = height >> 16;
+      ihdr[6] = height >> 8;
+      ihdr[7] = height;
+      ihdr[8] = 8;              //  8-bit
+      ihdr[9] = 2;              //  RGB
+      ihdr[10] = ihdr[11] = ihdr[12] = 0;
+      png_chunk(img,"IHDR",ihdr,13);
+
+      img->zs.zalloc = Z_NULL;
+      img->zs.zfree  = Z_NULL;
+      img->zs.opaque = Z_NULL;
+      if (deflateInit(&(img->zs),6) != Z_OK)
+        { fprintf(stderr,"%s: Could not initialize compression of %s\n",Prog_Name,name);
+          exit (1);
+        }
+      img->zs.next_out  = img->zbuf;
+      img->zs.avail_out = ZBUF_LEN;
+    }
+  return (img);
+}
+
+  //  Add the next image row of 3*width RGB bytes
+
+static void image_row(Image *img, uint8 *row)
+{ static uint8 none = 0;
+
+  if (img->ppm)
+    fwrite(row,3*img->width,1,img->file);
+  else
+    { png_deflate(img,&none,1,Z_NO_FLUSH);   //  filter type 0
+      png_deflate(img,row,3*img->width,Z_NO_FLUSH);
+    }
+}
+
+static void image_close(Image *img)
+{ if ( ! img->ppm)
+    { png_deflate(img,NULL,0,Z_FINISH);
+      deflateEnd(&(img->zs));
+      png_chunk(img,"IEND",NULL,0);
+    }
+  if (fclose(img->file) != 0)
+    { fprintf(stderr,"%s: IO error writing image %s\n",Prog_Name,img->name);
+      exit (1);
+    }
+  free(img->name);
+  free(img->zbuf);
+  free(img);
+}
+
+  //  Pixel coordinates of the ends of segment seg, rows counting down from the top
+
+static inline void seg_pixels(Raster *ras, Segment *seg,
+                              double *x0, double *r0, double *x1, double *r1)
+{ int64 xo = ras->cxoff[seg->bread];
+  int64 yo = ras->cyoff[seg->aread];
+
+  *x0 = (seg->bbpos + xo) * ras->sx;
+  *x1 = (seg->bepos + xo) * ras->sx;
+  *r0 = ras->height - (seg->abpos + yo) * ras->sy;
+  *r1 = ras->height - (seg->aepos + yo) * ras->sy;
+}
+
+  //  Accumulate and then color the pixels of band parm->band
+
+static void *band_render(void *args)
+{ Band   *parm = (Band *) args;
+  Raster *ras  = parm->ras;
+  Pixel  *grid = parm->grid;
+  uint8  *rgb  = parm->rgb;
+  int     bwide = ras->bwide;
+  int     rbeg, rend;
+
+  rbeg = parm->band * TILE_LEN;
+  rend = rbeg + TILE_LEN;
+  if (rend > ras->height)
+    rend = ras->height;
+
+  bzero(grid,sizeof(Pixel)*bwide*TILE_LEN);
+
+  { int64    j;
+    Segment *seg;
+    double   x0, r0, x1, r1, dx, dr, t, u;
+    int      n, k, kbeg, kend, c, r, lc, lr;
+    float    idn;
+    Pixel   *p;
+
+    for (j = ras->bidx[parm->band]; j < ras->bidx[parm->band+1]; j++)
+      { seg = segments + ras->blist[j];
+        seg_pixels(ras,seg,&x0,&r0,&x1,&r1);
+        dx = x1-x0;
+        dr = r1-r0;
+        n  = (int) (fabs(dx) > fabs(dr) ? fabs(dx) : fabs(dr)) + 1;
+
+        kbeg = 0;               //  Only step through the samples within the band
+        kend = n;
+        if (dr != 0.)
+          { t = (rbeg-r0) / dr;
+            u = (rend-r0) / dr;
+            if (t > u)
+              { double x = t; t = u; u = x; }
+            if (t > 0.)
+              kbeg = (int) (t*n) - 1;
+            if (u < 1.)
+              kend = (int) (u*n) + 1;
+            if (kbeg < 0)
+              kbeg = 0;
+            if (kend > n)
+              kend = n;
+          }
+
+        idn = (seg->idnt > 100 ? 100 : seg->idnt) / 100.;
+        lc = lr = -1;
+        for (k = kbeg; k <= kend; k++)
+          { c = (int) (x0 + (dx*k)/n);
+            r = (int) (r0 + (dr*k)/n);
+            if (c == lc && r == lr)
+              continue;
+            lc = c;
+            lr = r;
+            if (r < rbeg || r >= rend || c < 0 || c >= ras->width)
+              continue;
+            p = grid + ((r-rbeg)*bwide + c);
+            if (IS_RED(seg->flag))
+              p->fwd += 1.;
+            else
+              p->rev += 1.;
+            p->idn += idn;
+          }
+      }
+  }
+
+  { int    r, c, i, gray;
+    double w, d, q, s, f;
+    uint8 *o;
+    Pixel *p;
+    static int ncol[3] = { (N_COLOR >> 16) & 0xff, (N_COLOR >> 8) & 0xff, N_COLOR & 0xff };
+    static int ccol[3] = { (C_COLOR >> 16) & 0xff, (C_COLOR >> 8) & 0xff, C_COLOR & 0xff };
+
+    for (r = 0; r < TILE_LEN; r++)
+      for (c = 0; c < bwide; c++)
+        { p = grid + (r*bwide + c);
+          o = rgb + 3*(r*bwide + c);
+          w = p->fwd + p->rev;
+          if (w > 0.)
+            { d = log1p(w) / log1p(DENSE_SAT);
+              if (d > 1.)
+                d = 1.;
+              q = (p->idn/w - MINAIDNT) / (1.-MINAIDNT);
+              if (q < 0.)
+                q = 0.;
+              else if (q > 1.)
+                q = 1.;
+              s = (.35 + .65*d) * (.4 + .6*q);
+              f = p->fwd / w;
+              for (i = 0; i < 3; i++)
+                o[i] = (uint8) (255. - s*(255. - (f*ncol[i] + (1.-f)*ccol[i])) + .5);
+            }
+          else if (rbeg+r >= rend || c >= ras->width)
+            o[0] = o[1] = o[2] = 255;
+          else
+            { gray = ras->xgrid[c] | ras->ygrid[rbeg+r];
+              if (gray >= 2)
+                o[0] = o[1] = o[2] = 0;
+              else if (gray)
+                o[0] = o[1] = o[2] = 0x99;
+              else
+                o[0] = o[1] = o[2] = 255;
+            }
+        }
+  }
+
+  return (NULL);
+}
+
+  //  Setup the image geometry of a width x height rendering and the segments of each band
+
+static void raster_setup(Raster *ras, int width, int height, int bwide, int64 txseq, int64 tyseq,
+                         int nxseq, int64 *sxoff, int nyseq, int64 *syoff)
+{ int64    i, *bidx, *blist;
+  int      b, b0, b1, nband;
+  double   x0, r0, x1, r1;
+  Segment *seg;
+
+  nband = (height + TILE_LEN-1) / TILE_LEN;
+
+  ras->width  = width;
+  ras->height = height;
+  ras->bwide  = bwide;
+  ras->nband  = nband;
+  ras->sx     = (double) width / txseq;
+  ras->sy     = (double) height / tyseq;
+
+  ras->xgrid = Malloc(width+height,"Allocating grid lines");
+  ras->ygrid = ras->xgrid + width;
+  bzero(ras->xgrid,width+height);
+  for (b = 0; b < nxseq-1; b++)
+    { b0 = (int) (sxoff[b]*ras->sx);
+      if (b0 >= 0 && b0 < width)
+        ras->xgrid[b0] = 1;
+    }
+  for (b = 0; b < nyseq-1; b++)
+    { b0 = (int) (height - syoff[b]*ras->sy);
+      if (b0 >= 0 && b0 < height)
+        ras->ygrid[b0] = 1;
+    }
+  ras->xgrid[0] = ras->xgrid[width-1] = 2;
+  ras->ygrid[0] = ras->ygrid[height-1] = 2;
+
+  //  Bucket the segments by the bands their rows span (a counting sort)
+
+  bidx = Malloc(sizeof(int64)*(nband+1),"Allocating band index");
+  bzero(bidx,sizeof(int64)*(nband+1));
+  for (i = 0, seg = segments; i < nSegment; i++, seg++)
+    { if (IS_DEL(seg->flag))
+        continue;
+      seg_pixels(ras,seg,&x0,&r0,&x1,&r1);
+      if (r0 > r1)
+        { double x = r0; r0 = r1; r1 = x; }
+      b0 = (r0 < 0. ? 0 : (int) r0 / TILE_LEN);
+      b1 = (r1 >= height ? nband-1 : (int) r1 / TILE_LEN);
+      for (b = b0; b <= b1; b++)
+        bidx[b+1] += 1;
+    }
+  for (b = 1; b <= nband; b++)
+    bidx[b] += bidx[b-1];
+
+  blist = Malloc(sizeof(int64)*(bidx[nband]+1),"Allocating band lists");
+  for (i = 0, seg = segments; i < nSegment; i++, seg++)
+    { if (IS_DEL(seg->flag))
+        continue;
+      seg_pixels(ras,seg,&x0,&r0,&x1,&r1);
+      if (r0 > r1)
+        { double x = r0; r0 = r1; r1 = x; }
+      b0 = (r0 < 0. ? 0 : (int) r0 / TILE_LEN);
+      b1 = (r1 >= height ? nband-1 : (int) r1 / TILE_LEN);
+      for (b = b0; b <= b1; b++)
+        blist[bidx[b]++] = i;
+    }
+  for (b = nband; b > 0; b--)
+    bidx[b] = bidx[b-1];
+  bidx[0] = 0;
+
+  ras->bidx  = bidx;
+  ras->blist = blist;
+}
+
+static void raster_free(Raster *ras)
+{ free(ras->blist);
+  free(ras->bidx);
+  free(ras->xgrid);
+}
+
+  //  Render the bands of ras NTHREADS at a time, handing each finished band to out
+
+static void raster_render(Raster *ras, void (*out)(Raster *, Band *, void *), void *arg)
+{ Band      *parm;
+  pthread_t  threads[NTHREADS];
+  int        p, b, nb;
+
+  parm = Malloc(sizeof(Band)*NTHREADS,"Allocating band buffers");
+  for (p = 0; p < NTHREADS; p++)
+    { parm[p].ras  = ras;
+      parm[p].grid = Malloc(sizeof(Pixel)*ras->bwide*TILE_LEN,"Allocating band buffers");
+      parm[p].rgb  = Malloc(3*ras->bwide*TILE_LEN,"Allocating band buffers");
+    }
+
+  for (b = 0; b < ras->nband; b += NTHREADS)
+    { nb = ras->nband - b;
+      if (nb > NTHREADS)
+        nb = NTHREADS;
+      for (p = 0; p < nb; p++)
+        parm[p].band = b+p;
+      for (p = 1; p < nb; p++)
+        pthread_create(threads+p,NULL,band_render,parm+p);
+      band_render(parm);
+      for (p = 1; p < nb; p++)
+        pthread_join(threads[p],NULL);
+      for (p = 0; p < nb; p++)
+        out(ras,parm+p,arg);
+    }
+
+  for (p = 0; p < NTHREADS; p++)
+    { free(parm[p].rgb);
+      free(parm[p].grid);
+    }
+  free(parm);
+}
+
+static void band_to_image(Raster *ras, Band *band, void *arg)
+{ Image *img = (Image *) arg;
+  int    r, rend;
+
+  rend = ras->height - band->band*TILE_LEN;
+  if (rend > TILE_LEN)
+    rend = TILE_LEN;
+  for (r = 0; r < rend; r++)
+    image_row(img,band->rgb + 3*r*ras->bwide);
+}
+
+typedef struct
+  { char *dir;    //  Directory of the level
+    char *name;   //  Buffer for the names of its column directories and tiles
+  } Level;
+
+static void band_to_tiles(Raster *ras, Band *band, void *arg)
+{ Level *lev = (Level *) arg;
+  Image *img;
+  int    x, r;
+
+  for (x = 0; x < ras->bwide / TILE_LEN; x++)
+    { sprintf(lev->name,"%s/%d",lev->dir,x);
+      if (band->band == 0 && mkdir(lev->name,0777) < 0 && errno != EEXIST)
+        { fprintf(stderr,"%s: Could not create directory %s\n",Prog_Name,lev->name);
+          exit (1);
+        }
+      sprintf(lev->name,"%s/%d/%d.png",lev->dir,x,band->band);
+      img = image_open(lev->name,TILE_LEN,TILE_LEN,0);
+      for (r = 0; r < TILE_LEN; r++)
+        image_row(img,band->rgb + 3*(r*ras->bwide + x*TILE_LEN));
+      image_close(img);
+    }
+}
+
+static void make_raster(char *path, int ppm, int zoom)
+{ int    width, height, nxseq, nyseq;
+  int64  txseq, tyseq, *cxoff, *sxoff, *cyoff, *syoff;
+  Raster ras;
+
+  txseq = tyseq = 0;
+  nxseq = axisConfig(BHASH,BGDB,BCHORD,&cxoff,&sxoff,NULL,&txseq);
+  nyseq = axisConfig(AHASH,AGDB,ACHORD,&cyoff,&syoff,NULL,&tyseq);
+
+  alnConfig();
+
+  ras.cxoff = cxoff;
+  ras.cyoff = cyoff;
+
+  if (zoom == 0)
+    { Image *img;
+
+      plot_size(txseq,tyseq,&width,&height);
+      raster_setup(&ras,width,height,width,txseq,tyseq,nxseq,sxoff,nyseq,syoff);
+      img = image_open(path,width,height,ppm);
+      raster_render(&ras,band_to_image,img);
+      image_close(img);
+      raster_free(&ras);
+
+      if (VERBOSE)
+        fprintf(stderr,"  Wrote %d x %d image %s\n",width,height,path);
+    }
+  else
+    { Level lev;
+      int   z, side;
+
+      if (mkdir(path,0777) < 0 && errno != EEXIST)
+        { fprintf(stderr,"%s: Could not create directory %s\n",Prog_Name,path);
+          exit (1);
+        }
+      for (z = 0; z < zoom; z++)
+        { side = (TILE_LEN << z);
+          if (txseq >= tyseq)
+            { width  = side;
+              height = (int) ((((double) side) / txseq) * tyseq + .499);
+            }
+          else
+            { height = side;
+              width  = (int) ((((double) side) / tyseq) * txseq + .499);
+            }
+          if (width < 1)
+            width = 1;
+          if (height < 1)
+            height = 1;
+
+          lev.dir  = Malloc(strlen(path)+20,"Allocating tile names");
+          lev.name = Malloc(strlen(path)+60,"Allocating tile names");
+          sprintf(lev.dir,"%s/%d",path,z);
+          if (mkdir(lev.dir,0777) < 0 && errno != EEXIST)
+            { fprintf(stderr,"%s: Could not create directory %s\n",Prog_Name,lev.dir);
+              exit (1);
+            }
+
+          raster_setup(&ras,width,height,((width+TILE_LEN-1)/TILE_LEN)*TILE_LEN,
+                       txseq,tyseq,nxseq,sxoff,nyseq,syoff);
+          raster_render(&ras,band_to_tiles,&lev);
+          raster_free(&ras);
+
+          if (VERBOSE)
+            fprintf(stderr,"  Level %d: %d x %d tiles of a %d x %d image\n",
+                           z,ras.bwide/TILE_LEN,ras.nband,width,height);
+          free(lev.name);
+          free(lev.dir);
+        }
+    }
+
+  free(cxoff);
+  free(cyoff);
+  free(sxoff);
+  free(syoff);
+}
+
 int main(int argc, char *argv[])
-{ char  *xseq, *yseq, *pdf;
+{ char  *xseq, *yseq, *pdf, *img;
   FILE  *foeps;
   char  *pdftool;
 
@@ -1595,6 +2193,7 @@ int main(int argc, char *argv[])
     ARG_INIT("ALNplot")
     
     pdf  = NULL;
+    img  = NULL;
     j = 1;
     for (i = 1; i < argc; i++)
       if (argv[i][0] == '-')
@@ -1624,6 +2223,15 @@ int main(int argc, char *argv[])
               else
                 pdf = "";
               break;
+            case 'r':
+              if (argv[i][2] == ':' && argv[i][3] != '\0')
+                img = argv[i]+3;
+              else
+                img = "";
+              break;
+            case 'z':
+              ARG_POSITIVE(ZOOM,"Number of tile levels")
+              break;
             case 'H':
               ARG_POSITIVE(IMGHEIGH,"Image height")
               break;
@@ -1664,10 +2272,13 @@ int main(int argc, char *argv[])
         fprintf(stderr,"      -L: do not print labels\n");
         fprintf(stderr,"      -T: use -T threads\n");
         fprintf(stderr,"      -p: make PDF output (requires \'[e]ps[to|2]pdf\')\n");
+        fprintf(stderr,"      -r: make a raster image shaded by density & identity (no labels)\n");
+        fprintf(stderr,"      -z: with -r write a pyramid of -z levels of 256x256 tiles\n");
         fprintf(stderr,"\n");
         fprintf(stderr,"      -l: minimum alignment length\n");
         fprintf(stderr,"      -i: minimum alignment identity\n");
         fprintf(stderr,"      -n: maximum number of lines to display (set '0' to force all)\n");
+        fprintf(stderr,"            (ignored with -r, which displays all)\n");
         fprintf(stderr,"\n");
         fprintf(stderr,"      -H: image height\n");
         fprintf(stderr,"      -W: image width\n");
@@ -1687,6 +2298,21 @@ int main(int argc, char *argv[])
         yseq = argv[3];
       }
   
+    if (pdf != NULL && img != NULL)
+      { fprintf(stderr,"%s: Cannot ask for both PDF (-p) and raster (-r) output\n",Prog_Name);
+        exit (1);
+      }
+    if (ZOOM > 0 && img == NULL)
+      { fprintf(stderr,"%s: A tile pyramid (-z) requires raster (-r) output\n",Prog_Name);
+        exit (1);
+      }
+    if (ZOOM > MAX_ZOOM)
+      { fprintf(stderr,"%s: At most %d tile levels (-z) are supported\n",Prog_Name,MAX_ZOOM);
+        exit (1);
+      }
+    if (img != NULL)
+      LABELS = 0;
+
     if (pdf != NULL && !(pdftool = findPDFtool()))
       { fprintf(stderr,"%s: Cannot find [e]ps[to|2]pdf needed to produce .pdf output\n",Prog_Name);
         exit (1);
@@ -1749,13 +2375,28 @@ int main(int argc, char *argv[])
             OUTEPS = strdup(Catenate(pwd,"/",root,".eps"));
           }
       }
+    if (img != NULL)
+      { if (*img != '\0')
+          { int len = strlen(img);
+
+            IMGPPM = (len > 4 && strcmp(img+(len-4),".ppm") == 0);
+            free(pwd);
+            free(root);
+            pwd  = PathTo(img);
+            root = Root(img,IMGPPM ? ".ppm" : ".png");
+          }
+        if (ZOOM > 0)
+          OUTIMG = strdup(Catenate(pwd,"/",root,".tiles"));
+        else
+          OUTIMG = strdup(Catenate(pwd,"/",root,IMGPPM ? ".ppm" : ".png"));
+      }
     free(pwd);
     free(root);
 
     if (ispaf)
       read_paf(name,gzipd);
     else
-      read_1aln(name);
+      read_1aln(name,xseq);
 
     free(name);
   }
@@ -1765,30 +2406,34 @@ int main(int argc, char *argv[])
 
   aln_filter();
 
-  if (OUTEPS != NULL)
-    { foeps = fopen(OUTEPS,"w");
-      if (foeps == NULL)
-        { fprintf(stderr,"%s: Could not open file %s for writing\n",Prog_Name,OUTEPS);
-          exit (1);
-        }
-    }
+  if (OUTIMG != NULL)
+    make_raster(OUTIMG,IMGPPM,ZOOM);
   else
-    foeps = stdout;
+    { if (OUTEPS != NULL)
+        { foeps = fopen(OUTEPS,"w");
+          if (foeps == NULL)
+            { fprintf(stderr,"%s: Could not open file %s for writing\n",Prog_Name,OUTEPS);
+              exit (1);
+            }
+        }
+      else
+        foeps = stdout;
 
-  make_plot(foeps);
+      make_plot(foeps);
 
-  if (foeps != stdout)
-    fclose(foeps);
-  
-  if (OUTEPS != NULL)
-    { char cmd[4096];
+      if (foeps != stdout)
+        fclose(foeps);
+
+      if (OUTEPS != NULL)
+        { char cmd[4096];
 
-      sprintf(cmd,"%s %s",pdftool,OUTEPS);
-      run_system_cmd(cmd, 1);
-      sprintf(cmd,"rm -f %s",OUTEPS);
-      run_system_cmd(cmd, 1);
+          sprintf(cmd,"%s %s",pdftool,OUTEPS);
+          run_system_cmd(cmd, 1);
+          sprintf(cmd,"rm -f %s",OUTEPS);
+          run_system_cmd(cmd, 1);
+        }
     }
-  
+
   free(BCHORD);
   free(ACHORD);
 
@@ -1798,6 +2443,7 @@ int main(int argc, char *argv[])
 
   free(segments);
   free(OUTEPS);
+  free(OUTIMG);
   free(Command_Line);
   free(Prog_Name);
 
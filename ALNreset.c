@@ -44,8 +44,8 @@ void *threadCopy(void *args)
 
   n = copy->end - copy->beg;
   i = 0;
-  for (i = 1; oneReadLine(in); i++)
-    { if (in->lineType == 'A' && i > n)
+  while (oneReadLine(in))
+    { if (in->lineType == 'A' && ++i > n)
         break;
       memcpy(out->field,in->field,fieldSize[(int) in->lineType]);
       oneWriteLine(out,in->lineType,oneLen(in),oneString(in));
@@ -116,6 +116,7 @@ int main(int argc, char *argv[])
   { OneSchema *schema;
     char      *inFileName, *tmpFileName, *cpath;
     OneFile   *ofIn, *ofOut;
+    Aln_Index *aix;
     int        i;
 
     APATH = PathTo(argv[1]);
@@ -135,6 +136,10 @@ int main(int argc, char *argv[])
       { fprintf(stderr,"%s: Failed to open .1aln file %s\n",Prog_Name,inFileName);
         exit (1);
       }
+    if (ofIn->info['A'] != NULL)       //  Keep any alignment index, the records are unchanged
+      aix = Aln_Index_Read(inFileName,ofIn->info['A']->given.count);
+    else
+      aix = NULL;
     ofOut = oneFileOpenWriteFrom(tmpFileName,ofIn,true,NTHREADS);
     if (ofOut == NULL)
       { fprintf(stderr,"%s: Failed to open .1aln file %s\n",Prog_Name,tmpFileName);
@@ -149,6 +154,10 @@ int main(int argc, char *argv[])
     oneAddReference(ofOut,cpath,3);
     free(cpath);
 
+    for (i = 0; i < 128;++i)
+      if (ofIn->info[i] != NULL)
+        fieldSize[i] = ofIn->info[i]->nField*sizeof(OneField);
+
     while (oneReadLine(ofIn))         // Transfer any pre-object lines
       { if (ofIn->lineType == 'A')
           break;
@@ -161,16 +170,6 @@ int main(int argc, char *argv[])
         Copy_Args  args[NTHREADS];
         pthread_t  threads[NTHREADS];
 
-        for (i = 0; i < 128;++i)
-          if (ofIn->info[i] != NULL)
-            fieldSize[i] = ofIn->info[i]->nField*sizeof(OneField);
-
-        //  Write global lines before 'A'
-        while (oneReadLine(ofIn) && ofIn->lineType != 'A')
-          { memcpy(ofOut->field,ofIn->field,fieldSize[(int) ofIn->lineType]);
-            oneWriteLine(ofOut,ofIn->lineType,oneLen(ofIn),oneString(ofIn));
-          }
-
         for (i = 0; i < NTHREADS; i++)
           { args[i].in  = ofIn + i;
             args[i].out = ofOut + i;
@@ -200,6 +199,11 @@ int main(int argc, char *argv[])
       { fprintf(stderr,"%s: Could mv the temp file %s to the source name\n",Prog_Name,tmpFileName);
         exit (1);
       }
+    if (aix != NULL)
+      { if (Aln_Index_Write(aix,inFileName))
+          exit (1);
+        Aln_Index_Free(aix);
+      }
 
     free(inFileName);
     free(tmpFileName);
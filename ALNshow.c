@@ -58,6 +58,10 @@ int main(int argc, char *argv[])
   Contig_Range *ACHORD;
   Contig_Range *BCHORD;
 
+  char         *AFILE;    //  The .1aln file
+  int64        *RANGE;    //  If not NULL, only records [RANGE[2r],RANGE[2r+1]) for r < NRANGE
+  int           NRANGE;   //    can be selected (from the file's alignment index)
+
   int     nascaff, nacontig, amaxlen, actgmax;
   int     nbscaff, nbcontig, bmaxlen, bctgmax;
 
@@ -132,8 +136,10 @@ int main(int argc, char *argv[])
 
     pwd   = PathTo(argv[1]);
     root  = Root(argv[1],".1aln");
-    input = open_Aln_Read(Catenate(pwd,"/",root,".1aln"),1,
-			   &novl,&tspace,&src1_name,&src2_name,&cpath) ;
+    AFILE = Strdup(Catenate(pwd,"/",root,".1aln"),"Allocating file name");
+    if (AFILE == NULL)
+      exit (1);
+    input = open_Aln_Read(AFILE,1,&novl,&tspace,&src1_name,&src2_name,&cpath) ;
     if (input == NULL)
       exit (1);
     free(root);
@@ -229,7 +235,6 @@ int main(int argc, char *argv[])
     acontigs = gdb1->contigs;
     bcontigs = gdb2->contigs;
 
-    ahash = New_Hash_Table(nascaff,0);
     head  = gdb1->headers;
     amaxlen = 0;
     actgmax = 0;
@@ -239,21 +244,19 @@ int main(int argc, char *argv[])
           if (isspace(*eptr))
             break;
         *eptr = '\0';
-        if (Hash_Lookup(ahash,sptr) < 0)
-          Hash_Add(ahash,sptr);
-        else
-          { fprintf(stderr,"%s: Duplicate scaffold name: %s\n",Prog_Name,sptr);
-            exit (1);
-          }
         if (ascaffs[s].slen > amaxlen)
           amaxlen = ascaffs[s].slen;
         if (ascaffs[s].ectg - ascaffs[s].fctg > actgmax)
           actgmax = ascaffs[s].ectg - ascaffs[s].fctg;
       }
+    ahash = New_Hash_Block(head,nascaff,&ascaffs[0].hoff,sizeof(GDB_SCAFFOLD),&s);
+    if (s >= 0)
+      { fprintf(stderr,"%s: Duplicate scaffold name: %s\n",Prog_Name,head+ascaffs[s].hoff);
+        exit (1);
+      }
 
     if (ISTWO)
-      { bhash = New_Hash_Table(nbscaff,0);
-        head  = gdb2->headers;
+      { head  = gdb2->headers;
         bmaxlen = 0;
         bctgmax = 0;
         for (s = 0; s < nbscaff; s++)
@@ -262,17 +265,16 @@ int main(int argc, char *argv[])
               if (isspace(*eptr))
                 break;
             *eptr = '\0';
-            if (Hash_Lookup(bhash,sptr) < 0)
-              Hash_Add(bhash,sptr);
-            else
-              { fprintf(stderr,"%s: Duplicate scaffold name: %s\n",Prog_Name,sptr);
-                exit (1);
-              }
             if (bscaffs[s].slen > bmaxlen)
               bmaxlen = bscaffs[s].slen;
             if (bscaffs[s].ectg - bscaffs[s].fctg > bctgmax)
               bctgmax = bscaffs[s].ectg - bscaffs[s].fctg;
           }
+        bhash = New_Hash_Block(head,nbscaff,&bscaffs[0].hoff,sizeof(GDB_SCAFFOLD),&s);
+        if (s >= 0)
+          { fprintf(stderr,"%s: Duplicate scaffold name: %s\n",Prog_Name,head+bscaffs[s].hoff);
+            exit (1);
+          }
       }
     else
       { bhash   = ahash;
@@ -296,11 +298,43 @@ int main(int argc, char *argv[])
 
     ACHORD = get_selection_contigs(aseq,gdb1,ahash,0);
     BCHORD = get_selection_contigs(bseq,gdb2,bhash,0);
+
+    //  If only some A-contigs are selected and the file has an alignment index, then find
+    //    the ranges of records that can be on the selected parts of them
+
+    RANGE  = NULL;
+    NRANGE = 0;
+    if (aseq != NULL)
+      { Aln_Index *aix;
+        int64      beg, end;
+        int        c;
+
+        aix = Aln_Index_Read(AFILE,novl);
+        if (aix != NULL)
+          { RANGE = (int64 *) Malloc(2*sizeof(int64)*nacontig,"Allocating record ranges");
+            if (RANGE == NULL)
+              exit (1);
+            for (c = 0; c < nacontig; c++)
+              if (ACHORD[c].order && Aln_Index_Range(aix,c,ACHORD[c].beg,ACHORD[c].end,&beg,&end))
+                { if (NRANGE > 0 && beg <= RANGE[2*NRANGE-1])
+                    { if (end > RANGE[2*NRANGE-1])
+                        RANGE[2*NRANGE-1] = end;
+                    }
+                  else
+                    { RANGE[2*NRANGE]   = beg;
+                      RANGE[2*NRANGE+1] = end;
+                      NRANGE += 1;
+                    }
+                }
+            Aln_Index_Free(aix);
+          }
+      }
   }
 
   //  Read the file and display selected records
   
-  { int           j;
+  { int64         j, jend;
+    int           r;
     uint16       *trace;
     Work_Data    *work;
     Contig_Range *aptr;
@@ -318,8 +352,10 @@ int main(int argc, char *argv[])
     int        ac_wide, bc_wide;
     int        mn_wide, mx_wide;
     int        tp_wide;
+    Line_Buffer line;
 
     aln->path = &(ovl->path);
+    Line_Init(&line);
     if (ALIGN || REFERENCE)
       { work = New_Work_Data();
         abuffer = New_Contig_Buffer(gdb1);
@@ -376,11 +412,31 @@ int main(int argc, char *argv[])
 
     //  For each record do
 
+    if (RANGE != NULL)
+      jend = 0;
+    else
+      jend = novl;
+    r = 0;
     for (j = 0; j < novl; j++)
 
-       //  Read it in
+       //  Read it in, first moving to the next range of records that can be selected if the
+       //    end of the current one has been reached
+
+      { if (j >= jend)
+          { if (r >= NRANGE)
+              break;
+            j    = RANGE[2*r];
+            jend = RANGE[2*r+1];
+            r   += 1;
+            if ( ! oneGoto(input,'A',j+1))
+              { fprintf(stderr,"%s: Could not locate to object %lld in 1aln file\n",
+                               Prog_Name,j+1);
+                exit (1);
+              }
+            oneReadLine(input);
+          }
 
-      { Read_Aln_Overlap(input,ovl);
+        Read_Aln_Overlap(input,ovl);
         ovl->path.tlen  = Read_Aln_Trace(input,(uint8 *) trace);
         ovl->path.trace = trace;
 
@@ -427,66 +483,70 @@ int main(int argc, char *argv[])
         blens = bscaffs[bscaf].slen;
 
         if (ALIGN || REFERENCE)
-          printf("\n");
-
-        Print_Number((int64) ascaf+1,ar_wide+1,stdout);
-        printf(".%0*d",ac_wide,(aread - ascaffs[ascaf].fctg)+1);
-        printf("  ");
-        Print_Number((int64) bscaf+1,br_wide+1,stdout);
-        printf(".%0*d",bc_wide,(bread - bscaffs[bscaf].fctg)+1);
+          Line_Char(&line,'\n');
+
+        Line_Number(&line,(int64) ascaf+1,ar_wide+1);
+        Line_Char(&line,'.');
+        Line_Padded(&line,(aread - ascaffs[ascaf].fctg)+1,ac_wide,1);
+        Line_String(&line,"  ");
+        Line_Number(&line,(int64) bscaf+1,br_wide+1);
+        Line_Char(&line,'.');
+        Line_Padded(&line,(bread - bscaffs[bscaf].fctg)+1,bc_wide,1);
         if (COMP(ovl->flags))
-          printf(" c");
+          Line_String(&line," c");
         else
-          printf(" n");
+          Line_String(&line," n");
         if (ovl->path.abpos+aoffs == 0)
-          printf("   <");
+          Line_String(&line,"   <");
         else
-          printf("   [");
-        Print_Number((int64) ovl->path.abpos+aoffs,ai_wide,stdout);
-        printf("..");
-        Print_Number((int64) ovl->path.aepos+aoffs,ai_wide,stdout);
+          Line_String(&line,"   [");
+        Line_Number(&line,(int64) ovl->path.abpos+aoffs,ai_wide);
+        Line_String(&line,"..");
+        Line_Number(&line,(int64) ovl->path.aepos+aoffs,ai_wide);
         if (ovl->path.aepos+aoffs == alens)
-          printf("> x ");
+          Line_String(&line,"> x ");
         else
-          printf("] x ");
+          Line_String(&line,"] x ");
         if (COMP(ovl->flags))
           { if ((bclen-ovl->path.bbpos)+boffs == blens)
-              printf("<");
+              Line_Char(&line,'<');
             else
-              printf("[");
-            Print_Number((int64) boffs+(bclen-ovl->path.bbpos),bi_wide,stdout);
-            printf("..");
-            Print_Number((int64) boffs+(bclen-ovl->path.bepos),bi_wide,stdout);
+              Line_Char(&line,'[');
+            Line_Number(&line,(int64) boffs+(bclen-ovl->path.bbpos),bi_wide);
+            Line_String(&line,"..");
+            Line_Number(&line,(int64) boffs+(bclen-ovl->path.bepos),bi_wide);
             if ((bclen-ovl->path.bepos)+boffs == 0)
-              printf(">");
+              Line_Char(&line,'>');
             else
-              printf("]");
+              Line_Char(&line,']');
           }
         else
           { if (ovl->path.bbpos+boffs == 0)
-              printf("<");
+              Line_Char(&line,'<');
             else
-              printf("[");
-            Print_Number((int64) ovl->path.bbpos+boffs,bi_wide,stdout);
-            printf("..");
-            Print_Number((int64) ovl->path.bepos+boffs,bi_wide,stdout);
+              Line_Char(&line,'[');
+            Line_Number(&line,(int64) ovl->path.bbpos+boffs,bi_wide);
+            Line_String(&line,"..");
+            Line_Number(&line,(int64) ovl->path.bepos+boffs,bi_wide);
             if (ovl->path.bepos+boffs == blens)
-              printf(">");
+              Line_Char(&line,'>');
             else
-              printf("]");
+              Line_Char(&line,']');
           }
 
-        printf("  ~  %5.2f%% ",(200.*ovl->path.diffs) /
-               ((ovl->path.aepos - ovl->path.abpos) + (ovl->path.bepos - ovl->path.bbpos)) );
-        printf("  (");
-        Print_Number(alens,ai_wide,stdout);
-        printf(" x ");
-        Print_Number(blens,bi_wide,stdout);
-        printf(" bps,");
-        Print_Number((int64) ovl->path.diffs,mn_wide,stdout);
-        printf(" diffs, ");
-        Print_Number(tps,tp_wide,stdout);
-        printf(" trace pts)\n");
+        Line_String(&line,"  ~  ");
+        Line_Fixed(&line,(200.*ovl->path.diffs) /
+               ((ovl->path.aepos - ovl->path.abpos) + (ovl->path.bepos - ovl->path.bbpos)),5,2);
+        Line_String(&line,"%   (");
+        Line_Number(&line,alens,ai_wide);
+        Line_String(&line," x ");
+        Line_Number(&line,blens,bi_wide);
+        Line_String(&line," bps,");
+        Line_Number(&line,(int64) ovl->path.diffs,mn_wide);
+        Line_String(&line," diffs, ");
+        Line_Number(&line,tps,tp_wide);
+        Line_String(&line," trace pts)\n");
+        Line_Write(&line,stdout);
 
         if (ALIGN || REFERENCE)
           { char *aseq, *bseq;
@@ -568,6 +628,7 @@ int main(int argc, char *argv[])
           }
       }
 
+    Line_Free(&line);
     free(trace);
     if (ALIGN)
       { free(bbuffer-1);
@@ -578,6 +639,8 @@ int main(int argc, char *argv[])
 
   oneFileClose(input);
 
+  free(RANGE);
+  free(AFILE);
   free(BCHORD);
   free(ACHORD);
 
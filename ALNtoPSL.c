@@ -22,276 +22,19 @@
 #include "GDB.h"
 #include "align.h"
 #include "alncode.h"
+#include "alnout.h"
 
-#undef DEBUG_THREADS
-
-static char *Usage = " [-T<int(8)>} <alignment:path>[.1aln]";
+static char *Usage = " [-z] [-T<int(8)>] <alignment:path>[.1aln]";
 
+static int  BGZF;      // -z
+static int  SEQS;      // the alignments are not all with C-lines
 static int  NTHREADS;  // -T
 static int  ISTWO;     // one gdb or two?
 
 static int TSPACE;   // Trace spacing
 
-//  THREAD ROUTINE TO GENERATE A SECTION OF THE DESIRED .PAF FILE
-
-typedef struct
-  { int64    beg;
-    int64    end;
-    GDB      gdb1;
-    GDB      gdb2;
-    OneFile *in;
-    FILE    *out;
-  } Packet;
-
-void *gen_psl(void *args)
-{ Packet *parm = (Packet *) args;
-
-  int64    beg  = parm->beg;
-  int64    end  = parm->end;
-  GDB     *gdb1 = &(parm->gdb1);
-  GDB     *gdb2 = &(parm->gdb2);
-  OneFile *in   = parm->in;
-  FILE    *out  = parm->out;
-
-  Overlap   _ovl, *ovl = &_ovl;
-  Alignment _aln, *aln = &_aln;
-
-  uint16       *trace;
-  int           tmax;
-  GDB_CONTIG   *contig1, *contig2;
-  GDB_SCAFFOLD *scaff1, *scaff2;
-  char         *ahead, *bhead;
-  int           acontig, bcontig;
-  int           ascaff, bscaff;
-  int           bmin, bmax;
-  char         *aseq, *bseq, *bact;
-  int64         aoff, boff;
-  Path         *path;
-  Work_Data    *work;
-
-  work = New_Work_Data();
-  aseq = New_Contig_Buffer(gdb1);
-  bseq = New_Contig_Buffer(gdb2);
-  if (aseq == NULL || bseq == NULL)
-    exit (1);
-
-  contig1 = gdb1->contigs;
-  contig2 = gdb2->contigs;
-  scaff1  = gdb1->scaffolds;
-  scaff2  = gdb2->scaffolds;
-  ahead   = gdb1->headers;
-  bhead   = gdb2->headers;
-
-  aln->path = path = &(ovl->path);
-  aln->aseq = aseq;
-
-  tmax  = in->info['T']->given.max;
-  trace = (uint16 *) Malloc(2*sizeof(uint16)*tmax,"Allocating trace vector");
-  if (trace == NULL)
-    exit (1);
-  path->trace = (void *) trace;
-
-  //  For each alignment do
-
-  if (!oneGoto(parm->in,'A',beg+1))
-    { fprintf(stderr,"%s: Can't locate to object %lld in aln file\n",Prog_Name,beg+1);
-      exit (1);
-    }
-  oneReadLine(parm->in);
-
-  aoff = 0;
-  for (acontig = -1; beg < end; beg++)
-    { Read_Aln_Overlap(in,ovl);
-      path->tlen  = Read_Aln_Trace(in,(uint8 *) trace);
-      path->trace = trace;
-
-      Decompress_TraceTo16(ovl);
-
-      if (acontig != ovl->aread)
-        { acontig = ovl->aread;
-          Get_Contig(gdb1,acontig,NUMERIC,aseq);
-          aln->alen = contig1[acontig].clen;
-          aoff      = contig1[acontig].sbeg;
-        }
-      bcontig = ovl->bread;
-      aln->blen  = contig2[bcontig].clen;
-      aln->flags = ovl->flags;
-
-      ascaff = contig1[acontig].scaf;
-      bscaff = contig2[bcontig].scaf;
-
-      if (COMP(aln->flags))
-        boff = contig2[bcontig].sbeg + contig2[bcontig].clen;
-      else
-        boff = contig2[bcontig].sbeg;
-
-      if (COMP(aln->flags))
-        { bmin = (aln->blen-path->bepos);
-          if (bmin < 0) bmin = 0;
-          bmax = (aln->blen-path->bbpos);
-          if (bmax > aln->blen) bmax = aln->blen;
-        }
-      else
-        { bmin = path->bbpos;
-          if (bmin < 0) bmin = 0;
-          bmax = path->bepos;
-          if (bmax > aln->blen) bmax = aln->blen;
-        }
-
-      bact = Get_Contig_Piece(gdb2,bcontig,bmin,bmax,NUMERIC,bseq);
-      if (COMP(aln->flags))
-        { Complement_Seq(bact,bmax-bmin);
-          aln->bseq = bact - (aln->blen-bmax);
-        }
-      else
-        aln->bseq = bact - bmin; 
-
-      Compute_Trace_PTS(aln,work,TSPACE,GREEDIEST);
-      Gap_Improver(aln,work);
-
-      { int     i, j, x, p, q;
-        int    *t, T;
-        int     M, N;
-        int     I, D, S, X;
-        int     IB, DB;
-        int     bcnt, bmat;
-
-        t = (int *) path->trace;
-        T = path->tlen;
-
-        M = path->aepos - path->abpos;
-        N = path->bepos - path->bbpos;
-        I = D = 0;
-        IB = DB = 0;
-        p = 0; 
-        for (x = 0; x < T; x++)
-          { q = p;
-            if ((p = t[x]) < 0)
-              { I += 1;
-                if (p != q)
-                  IB += 1;
-              }
-            else
-              { D += 1;
-                if (p != q)
-                  DB += 1;
-              }
-          }
-        S = path->diffs - (I+D);
-        X = (M+N - (I+D+2*S))/2;
-
-        fprintf(out,"%d\t%d\t0\t0\t%d\t%d\t%d\t%d\t%c",X,S,IB,I,DB,D,COMP(ovl->flags)?'-':'+');
-        fprintf(out,"\t%s\t%lld\t%lld\t%lld",
-                  ahead+scaff1[ascaff].hoff,scaff1[ascaff].slen,aoff+path->abpos,aoff+path->aepos);
-        if (COMP(aln->flags))
-          fprintf(out,"\t%s\t%lld\t%lld\t%lld",
-                   bhead+scaff2[bscaff].hoff,scaff2[bscaff].slen,boff-path->bepos,boff-path->bbpos);
-        else
-          fprintf(out,"\t%s\t%lld\t%lld\t%lld",
-                   bhead+scaff2[bscaff].hoff,scaff2[bscaff].slen,boff+path->bbpos,boff+path->bepos);
-
-        bcnt = 0;
-        i = path->abpos+1;
-        j = path->bbpos+1;
-        for (x = 0; x < T; x++)
-          { if ((p = t[x]) < 0)
-              { bmat = -(p+i);
-                i += bmat;
-                j += bmat+1;
-              }
-            else
-              { bmat = p-j;
-                i += bmat+1;
-                j += bmat;
-              }
-            if (bmat > 0)
-              bcnt += 1;
-          }
-        bmat = (path->aepos - i)+1;
-        if (bmat > 0)
-          bcnt += 1;
-        fprintf(out,"\t%d\t",bcnt);
-
-        i = path->abpos+1;
-        j = path->bbpos+1;
-        for (x = 0; x < T; x++)
-          { if ((p = t[x]) < 0)
-              { bmat = -(p+i);
-                i += bmat;
-                j += bmat+1;
-              }
-            else
-              { bmat = p-j;
-                i += bmat+1;
-                j += bmat;
-              }
-            if (bmat > 0)
-              fprintf(out,"%d,",bmat);
-          }
-        bmat = (path->aepos - i)+1;
-        if (bmat > 0)
-          fprintf(out,"%d,",bmat);
-        fprintf(out,"\t");
-
-        i = path->abpos+1;
-        j = path->bbpos+1;
-        for (x = 0; x < T; x++)
-          { if ((p = t[x]) < 0)
-              { bmat = -(p+i);
-                if (bmat > 0)
-                  fprintf(out,"%d,",i);
-                i += bmat;
-                j += bmat+1;
-              }
-            else
-              { bmat = p-j;
-                if (bmat > 0)
-                  fprintf(out,"%d,",i);
-                i += bmat+1;
-                j += bmat;
-              }
-          }
-        bmat = (path->aepos - i)+1;
-        if (bmat > 0)
-          fprintf(out,"%d,",i);
-        fprintf(out,"\t");
-
-        i = path->abpos+1;
-        j = path->bbpos+1;
-        for (x = 0; x < T; x++)
-          { if ((p = t[x]) < 0)
-              { bmat = -(p+i);
-                if (bmat > 0)
-                  fprintf(out,"%d,",j);
-                i += bmat;
-                j += bmat+1;
-              }
-            else
-              { bmat = p-j;
-                if (bmat > 0)
-                  fprintf(out,"%d,",j);
-                i += bmat+1;
-                j += bmat;
-              }
-          }
-        bmat = (path->aepos - i)+1;
-        if (bmat > 0)
-          fprintf(out,"%d,",j);
-        fprintf(out,"\n");
-      }
-    }
-
-  free(trace);
-  free(bseq-1);
-  free(aseq-1);
-  Free_Work_Data(work);
-
-  return (NULL);
-}
-
 int main(int argc, char *argv[])
-{ Packet    *parm;
-  GDB       _gdb1, *gdb1 = &_gdb1;
+{ GDB       _gdb1, *gdb1 = &_gdb1;
   GDB       _gdb2, *gdb2 = &_gdb2;
   FILE     **units1;
   FILE     **units2;
@@ -306,8 +49,6 @@ int main(int argc, char *argv[])
 
     ARG_INIT("ALNtoPSL")
 
-    (void) flags;
-
     NTHREADS = 8;
 
     j = 1;
@@ -315,7 +56,7 @@ int main(int argc, char *argv[])
       if (argv[i][0] == '-')
         switch (argv[i][1])
         { default:
-            ARG_FLAGS("")
+            ARG_FLAGS("z")
             break;
           case 'T':
             ARG_POSITIVE(NTHREADS,"Number of threads")
@@ -325,16 +66,16 @@ int main(int argc, char *argv[])
         argv[j++] = argv[i];
     argc = j;
 
+    BGZF = flags['z'];
+
     if (argc != 2)
       { fprintf(stderr,"Usage: %s %s\n",Prog_Name,Usage);
+        fprintf(stderr,"\n");
+        fprintf(stderr,"      -z: compress the output with bgzip's blocked gzip format\n");
         fprintf(stderr,"\n");
         fprintf(stderr,"      -T: Use -T threads.\n");
         exit (1);
       }
-
-    parm = Malloc(sizeof(Packet)*NTHREADS,"Allocating thread records");
-    if (parm == NULL)
-      exit (1);
   }
 
   //  Initiate .1aln file reading and read header information
@@ -354,6 +95,10 @@ int main(int argc, char *argv[])
     free(root);
     free(pwd);
 
+    //  Sequences are not needed if every alignment has a C-line giving its exact alignment
+
+    SEQS = (input->info['C'] == NULL || input->info['C']->given.count < novl);
+
     test = fopen(src1_name,"r");
     if (test == NULL)
       { if (*src1_name != '/')
@@ -388,15 +133,19 @@ int main(int argc, char *argv[])
 
     //  Prepare GDBs from sources if necessary
 
+    Set_GDB_Threads(NTHREADS);
     units1 = NULL;
     units2 = NULL;
     ISTWO = 0;
     type  = Get_GDB_Paths(src1_name,NULL,&spath,&tpath,0);
     if (type != IS_GDB)
-      units1 = Create_GDB(gdb1,spath,type,NTHREADS,NULL);
+      if (SEQS)
+        units1 = Create_GDB(gdb1,spath,type,NTHREADS,NULL);
+      else
+        Create_GDB(gdb1,spath,type,0,NULL);
     else
       { Read_GDB(gdb1,tpath);
-        if (gdb1->seqs == NULL)
+        if (SEQS && gdb1->seqs == NULL)
           { fprintf(stderr,"%s: GDB %s must have sequence data\n",Prog_Name,tpath);
             exit (1);
           }
@@ -407,10 +156,13 @@ int main(int argc, char *argv[])
     if (src2_name != NULL)
       { type = Get_GDB_Paths(src2_name,NULL,&spath,&tpath,0);
         if (type != IS_GDB)
-          units2 = Create_GDB(gdb2,spath,type,NTHREADS,NULL);
+          if (SEQS)
+            units2 = Create_GDB(gdb2,spath,type,NTHREADS,NULL);
+          else
+            Create_GDB(gdb2,spath,type,0,NULL);
         else
           { Read_GDB(gdb2,tpath);
-            if (gdb2->seqs == NULL)
+            if (SEQS && gdb2->seqs == NULL)
               { fprintf(stderr,"%s: GDB %s must have sequence data\n",Prog_Name,tpath);
                 exit (1);
               }
@@ -426,40 +178,28 @@ int main(int argc, char *argv[])
     free(src2_name);
   }
 
-  //  Divide .1aln into NTHREADS parts
-
-  { int p;
-
-    for (p = 0; p < NTHREADS; p++)
-      { parm[p].beg = (p * novl) / NTHREADS;
-        if (p > 0)
-          parm[p-1].end = parm[p].beg;
-      }
-    parm[NTHREADS-1].end = novl;
-  }
-
-  //   Use NTHREADS to produce .paf for each part and then cat the parts to stdout
+  //  Use NTHREADS to format the alignments in order-preserving batches that are written
+  //    straight to stdout as they are completed
 
-  { int   p, x;
-    char *oprefix;
-    char *buffer;
-#ifndef DEBUG_THREADS
-    pthread_t threads[NTHREADS];
-#endif
+  { int   p;
+    GDB  *g1, *g2;
 
-    //  Setup thread packets
+    //  Give each thread its own file pointers for the sequences
 
-    oprefix = Strdup(Numbered_Suffix("_psl.",getpid(),"."),"Allocating temp file prefix");
+    g1 = Malloc(2*NTHREADS*sizeof(GDB),"Allocating thread GDBs");
+    if (g1 == NULL)
+      exit (1);
+    g2 = g1 + NTHREADS;
 
     for (p = 0; p < NTHREADS; p++)
-      { parm[p].gdb1 = *gdb1;
-        parm[p].gdb2 = *gdb2;
-        if (p > 0)
+      { g1[p] = *gdb1;
+        g2[p] = *gdb2;
+        if (p > 0 && SEQS)
           { if (units1 != NULL)
-              parm[p].gdb1.seqs = units1[p];
+              g1[p].seqs = units1[p];
             else
-              { parm[p].gdb1.seqs = fopen(gdb1->seqpath,"r");
-                if (parm[p].gdb1.seqs == NULL)
+              { g1[p].seqs = fopen(gdb1->seqpath,"r");
+                if (g1[p].seqs == NULL)
                   { fprintf(stderr,"%s: Cannot open another copy of GDB %s\n",
                                    Prog_Name,gdb1->seqpath);
                     exit (1);
@@ -467,10 +207,10 @@ int main(int argc, char *argv[])
               }
             if (ISTWO)
               { if (units2 != NULL)
-                  parm[p].gdb2.seqs = units2[p];
+                  g2[p].seqs = units2[p];
                 else
-                  { parm[p].gdb2.seqs = fopen(gdb2->seqpath,"r");
-                    if (parm[p].gdb2.seqs == NULL)
+                  { g2[p].seqs = fopen(gdb2->seqpath,"r");
+                    if (g2[p].seqs == NULL)
                       { fprintf(stderr,"%s: Cannot open another copy of GDB %s\n",
                                        Prog_Name,gdb2->seqpath);
                         exit (1);
@@ -478,65 +218,24 @@ int main(int argc, char *argv[])
                   }
               }
             else
-              { if (units1 != NULL)
-                  parm[p].gdb2.seqs = units1[p];
-                else
-                  parm[p].gdb2.seqs = parm[p].gdb1.seqs;
-              }
+              g2[p].seqs = g1[p].seqs;
           }
-        parm[p].in  = input + p ;
-        parm[p].out = fopen(Numbered_Suffix(oprefix,p,".psl"),"w+");
-        if (parm[p].out == NULL)
-          { fprintf(stderr,"%s: Cannot open %s.%d.paf for reading & writing\n",
-                           Prog_Name,oprefix,p);
-            exit (1);
-          }
-        unlink(Numbered_Suffix(oprefix,p,".psl"));
       }
 
-    //  Launch and then gather threads
+    Output_Aln_File(input,novl,g1,g2,PSL_OUT,TSPACE,NTHREADS,stdout,BGZF);
 
-#ifdef DEBUG_THREADS
-    for (p = 0; p < NTHREADS; p++)
-      gen_psl(parm+p);
-#else
-    for (p = 1; p < NTHREADS; p++)
-      pthread_create(threads+p,NULL,gen_psl,parm+p);
-    gen_psl(parm);
-    for (p = 1; p < NTHREADS; p++)
-      pthread_join(threads[p],NULL);
-#endif
-
-    for (p = 1; p < NTHREADS; p++)
-      { fclose(parm[p].gdb1.seqs);
-        if (ISTWO)
-          fclose(parm[p].gdb2.seqs);
-      }
+    if (SEQS)
+      for (p = 1; p < NTHREADS; p++)
+        { fclose(g1[p].seqs);
+          if (ISTWO)
+            fclose(g2[p].seqs);
+        }
     if (units1 != NULL)
       free(units1);
     if (units2 != NULL)
       free(units2);
 
-    //  Concatenate thread generated paf parts to stdout
-
-#define PUSH_BLOCK 0x100000
-
-    buffer = Malloc(PUSH_BLOCK,"Allocating seek block");
-
-    for (p = 0; p < NTHREADS; p++)
-      { FILE *o = parm[p].out;
-
-        rewind(o);
-        x = PUSH_BLOCK;
-        while (x >= PUSH_BLOCK)
-          { x = fread(buffer,1,PUSH_BLOCK,o);
-            if (x > 0)
-              fwrite(buffer,x,1,stdout);
-          }
-        fclose(o);
-      }
-
-    free(buffer);
+    free(g1);
   }
 
   Close_GDB(gdb1);
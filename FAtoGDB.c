@@ -22,7 +22,7 @@
 
 #include "GDB.h"
 
-static char *Usage = "[-v] <source:path>[<fa_extn>|<1_extn>] [<target:path>[.1gdb]]";
+static char *Usage = "[-v] [-T<int(8)>] <source:path>[<fa_extn>|<1_extn>] [<target:path>[.1gdb]]";
 
 int main(int argc, char *argv[])
 { char *spath, *tpath;
@@ -31,14 +31,18 @@ int main(int argc, char *argv[])
   GDB   gdb;
 
   int VERBOSE;
+  int NTHREADS;
 
   //   Process command line
 
   { int   i, j, k;
     int   flags[128];
+    char *eptr;
 
     ARG_INIT("FAtoGDB")
 
+    NTHREADS = 8;
+
     j = 1;
     for (i = 1; i < argc; i++)
       if (argv[i][0] == '-')
@@ -46,6 +50,9 @@ int main(int argc, char *argv[])
         { default:
             ARG_FLAGS("v")
             break;
+          case 'T':
+            ARG_POSITIVE(NTHREADS,"number of threads to use")
+            break;
         }
       else
         argv[j++] = argv[i];
@@ -58,6 +65,9 @@ int main(int argc, char *argv[])
         fprintf(stderr,"\n");
         fprintf(stderr,"           <fa_extn> = (.fa|.fna|.fasta)[.gz]\n");
         fprintf(stderr,"           <1_extn>  = any valid 1-code sequence file type\n");
+        fprintf(stderr,"\n");
+        fprintf(stderr,"      -v: Verbose mode, output progress as proceed.\n");
+        fprintf(stderr,"      -T: Number of threads to use.\n");
         exit (1);
       }
   }
@@ -83,6 +93,7 @@ int main(int argc, char *argv[])
       free(TPATH);
     }
 
+  Set_GDB_Threads(NTHREADS);
   Create_GDB(&gdb,spath,ftype,1,tpath);
 
   Write_GDB(&gdb,tpath);
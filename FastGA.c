@@ -21,11 +21,22 @@
 #include <math.h>
 #include <pthread.h>
 #include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <errno.h>
+#include <zlib.h>
 
 #include "libfastk.h"
 #include "GDB.h"
 #include "align.h"
 #include "alncode.h"
+#include "alnout.h"
+#include "GIX.h"
 
 #undef    DEBUG_SPLIT
 #undef    DEBUG_MERGE
@@ -51,9 +62,11 @@ static int EXO_SIZE = sizeof(Overlap) - sizeof(void *);
 #define    BUCK_ANTI    128  //  2*BUCK_WIDTH
 #define    BOX_FUZZ      10
 
-static char *Usage[] = { "[-vk] [-T<int(8)>] [-P<dir(/tmp)>] [<format(-paf)>]",
+static char *Usage[] = { "[-vkmbz] [-T<int(8)>] [-P<dir(/tmp)>] [-M<int(16)>] [<format(-paf)>]",
                          "[-f<int(10)>] [-c<int(100)> [-s<int(500)>] [-l<int(100)>] [-i<float(.7)]",
-                         "<source1:path>[<precursor>] [<source2:path>[<precursor>]]"
+                         "<source1:path>[<precursor>] [<source2:path>[<precursor>]]",
+                         "[-stats:<file>[.tsv]] [-S:<socket:path> | -C:<socket:path>] [-plan] [-ckpt:<dir>]",
+                         "[-shard:<int>/<int>]"
                        };
 
 static int    FREQ;        //  -f: Adaptemer frequence cutoff parameter
@@ -64,12 +77,24 @@ static int    ALIGN_MIN;   //  -a
 static double ALIGN_RATE;  //  -e
 static int    NTHREADS;    //  -T
 static char  *SORT_PATH;   //  -P
+static int    MEM_BUDGET;  //  -M: Memory budget in GB
 static int    KEEP;        //  -k
+static int    MAP_GIX;     //  -m: memory map the k-mer tables and post lists
+static int    BASE_SNAKE;  //  -b: extend matches a base at a time in the aligner
+static int    ZIP_SEEDS;   //  -z: deflate the blocks of the seed pair files
 static int    SELF;        //  Comparing A to A, or A to B?
 static int    OUT_TYPE;    //  -paf = 0; -psl = 1; -one = 2
-static int    OUT_OPT;     //  -pafm = 1; -pafx = 2; all others = 0
+static int    OUT_OPT;     //  -pafm = 1; -pafx or -1x = 2; all others = 0
 static char  *ONE_PATH;    //  -one option path
 static char  *ONE_ROOT;    //  -one option path
+static char  *SERVER;      //  -S: socket path if serving source1 as a resident reference
+static char  *CLIENT;      //  -C: socket path if sending a query to a reference server
+static int    RESIDENT;    //  Source1 belongs to a reference server (do not remove it)
+static char  *STAT_NAME;   //  -stats: file to which phase records are written (or NULL)
+static int    PLAN;        //  -plan: report the resources a run would need and exit
+static char  *CKPT_PATH;   //  -ckpt: directory keeping phase outputs for a restart (or NULL)
+static int    SHARD;       //  -shard: compare only the A-contigs of shard SHARD (0-based) ...
+static int    NSHARDS;     //    ... of NSHARDS (1 if not sharding)
 
 static char *PATH1, *PATH2;   //  GDB & GIX are PATHx/ROOTx[GEXTNx|.gix]
 static char *ROOT1, *ROOT2;
@@ -84,6 +109,10 @@ static char *PAIR_NAME;    //  Prefixes for temporary files
 static char *ALGN_UNIQ;
 static char *ALGN_PAIR;
 
+static char *PAIR_PATH;    //  Seed pair files are PAIR_PATH/PAIR_NAME.#.[NC] and alignment
+static char *UNIQ_PATH;    //    files UNIQ_PATH/UNIQ_NAME.#.las, in SORT_PATH unless -ckpt
+static char *UNIQ_NAME;
+
 static int IBYTE;         // # of bytes for an entry in P1
 static int IPOST;         // # of bytes in post of a P1 entry
 static int ICONT;         // # of bytes in contig of a P1 entry
@@ -94,6 +123,9 @@ static int JPOST;         // # of bytes in post of a P2 entry
 static int JCONT;         // # of bytes in contig of a P2 entry
 static int JSIGN;         // byte index in a P2 entry of the sign flag
 
+static int64 IMASK;       // mask for the IBYTE bytes of a P1 entry
+static int64 JMASK;       // mask for the JBYTE bytes of a P2 entry
+
 static int KBYTE;         // # of bytes for a k-mer table entry (both T1 & T2)
 static int CBYTE;         // byte of k-mer table entry containing post count
 static int LBYTE;         // byte of k-mer table entry containing lcp
@@ -105,6 +137,7 @@ static int   DBYTE;      // # of bytes for a pair diagonal or anti-diagonal
 
 static int    NCONTS;    //  # of A contigs
 static int    NPARTS;    //  # of panels A-contigs divided into
+static int64  SHARD_LEN; //  # of bases in the A-contigs of the shard (all of them if no -shard)
 static int    ESHIFT;    //  shift to extract P1-contig # from a post
 
 static int   *Select;    //  Select[bucket] = thread file for bucket
@@ -119,6 +152,10 @@ typedef struct
     int64 *buck;
     int    file;
     int    inum;
+    int    type;   //  'N' or 'C'
+    int    lcp;    //  lcp, apost, & bpost of the last seed written (see SEED PAIR FILE CODE)
+    int64  apost;
+    int64  bpost;
   } IOBuffer;
 
 static IOBuffer *N_Units;  //  NTHREADS^2 IO units for + pair temporary files
@@ -150,7 +187,7 @@ static void Clean_Exit(int status)
   if (command == NULL)
     fail = 1;
   else
-    { if (TYPE1 <= IS_GDB)
+    { if (TYPE1 <= IS_GDB && !RESIDENT)
         { if (TYPE1 < IS_GDB)
             sprintf(command,"GIXrm -fg %s/%s%s",PATH1,ROOT1,GEXTN1);
           else
@@ -180,6 +217,165 @@ static void Clean_Exit(int status)
 }
 
 
+/***********************************************************************************************
+ *
+ *   PHASE STATISTICS:
+ *     With -stats:<file> a record is written for each phase giving its wall time, the user
+ *     and system time of FastGA and any programs it called, the peak RSS so far, the bytes
+ *     moved to and from SORT_PATH temporaries, and counts particular to the phase, in total
+ *     and per thread.  Records are JSON objects, one per line, unless the file name ends in
+ *     .tsv in which case each value is a line "phase thread key value" (thread = - if a total).
+ *     All calls are made by the main thread.
+ *
+ **********************************************************************************************/
+
+typedef struct
+  { char  *key;
+    int    thread;    //  -1 for a phase total
+    double value;
+  } Stat_Item;
+
+static int             Stat_Tsv;
+static char           *Stat_Phase;
+static struct rusage   Stat_Self, Stat_Kids;
+static struct timespec Stat_Wall;
+static struct timespec Stat_Start;
+static int             Stat_Num;
+static int             Stat_Max;
+static Stat_Item      *Stat_Items;   //  Grown as needed as there are per-thread items
+
+//  Create (truncate) the statistics file and start the clock for the "total" record
+
+static void Stats_Init(char *name)
+{ FILE *f;
+
+  STAT_NAME = name;
+  Stat_Tsv  = (strlen(name) >= 4 && strcmp(name+(strlen(name)-4),".tsv") == 0);
+  f = fopen(name,"w");
+  if (f == NULL)
+    { fprintf(stderr,"%s: Cannot open %s for statistics output\n",Prog_Name,name);
+      exit (1);
+    }
+  if (Stat_Tsv)
+    fprintf(f,"phase\tthread\tkey\tvalue\n");
+  fclose(f);
+  clock_gettime(CLOCK_MONOTONIC,&Stat_Start);
+}
+
+static void Stats_Begin(char *phase)
+{ if (STAT_NAME == NULL)
+    return;
+  Stat_Phase = phase;
+  Stat_Num   = 0;
+  getrusage(RUSAGE_SELF,&Stat_Self);
+  getrusage(RUSAGE_CHILDREN,&Stat_Kids);
+  clock_gettime(CLOCK_MONOTONIC,&Stat_Wall);
+}
+
+//  Add value to key of the current phase, for thread (or the phase total if thread < 0)
+
+static void Stats_Count(char *key, int thread, double value)
+{ int i;
+
+  if (STAT_NAME == NULL)
+    return;
+  if (thread < 0)
+    thread = -1;
+  for (i = 0; i < Stat_Num; i++)
+    if (Stat_Items[i].thread == thread && strcmp(Stat_Items[i].key,key) == 0)
+      { Stat_Items[i].value += value;
+        return;
+      }
+  if (Stat_Num >= Stat_Max)
+    { Stat_Max   = 1.2*Stat_Num + 64;
+      Stat_Items = Realloc(Stat_Items,Stat_Max*sizeof(Stat_Item),"Allocating statistics");
+      if (Stat_Items == NULL)
+        Clean_Exit(1);
+    }
+  Stat_Items[Stat_Num].key    = key;
+  Stat_Items[Stat_Num].thread = thread;
+  Stat_Items[Stat_Num].value  = value;
+  Stat_Num += 1;
+}
+
+static double tv_secs(struct timeval *t)
+{ return (t->tv_sec + t->tv_usec/1e6); }
+
+static void Stats_End()
+{ struct rusage   self, kids;
+  struct timespec wall;
+  FILE  *f;
+  double w, u, y;
+  int    i, t, nthr;
+
+  if (STAT_NAME == NULL)
+    return;
+
+  getrusage(RUSAGE_SELF,&self);
+  getrusage(RUSAGE_CHILDREN,&kids);
+  clock_gettime(CLOCK_MONOTONIC,&wall);
+
+  if (strcmp(Stat_Phase,"total") == 0)
+    { w = (wall.tv_sec - Stat_Start.tv_sec) + (wall.tv_nsec - Stat_Start.tv_nsec)/1e9;
+      u = tv_secs(&self.ru_utime) + tv_secs(&kids.ru_utime);
+      y = tv_secs(&self.ru_stime) + tv_secs(&kids.ru_stime);
+    }
+  else
+    { w = (wall.tv_sec - Stat_Wall.tv_sec) + (wall.tv_nsec - Stat_Wall.tv_nsec)/1e9;
+      u = (tv_secs(&self.ru_utime) - tv_secs(&Stat_Self.ru_utime))
+        + (tv_secs(&kids.ru_utime) - tv_secs(&Stat_Kids.ru_utime));
+      y = (tv_secs(&self.ru_stime) - tv_secs(&Stat_Self.ru_stime))
+        + (tv_secs(&kids.ru_stime) - tv_secs(&Stat_Kids.ru_stime));
+    }
+
+  f = fopen(STAT_NAME,"a");
+  if (f == NULL)
+    { fprintf(stderr,"%s: Cannot append to statistics file %s\n",Prog_Name,STAT_NAME);
+      STAT_NAME = NULL;
+      return;
+    }
+
+  nthr = 0;
+  for (i = 0; i < Stat_Num; i++)
+    if (Stat_Items[i].thread >= nthr)
+      nthr = Stat_Items[i].thread+1;
+
+  if (Stat_Tsv)
+    { fprintf(f,"%s\t-\twall\t%.3f\n",Stat_Phase,w);
+      fprintf(f,"%s\t-\tuser\t%.3f\n",Stat_Phase,u);
+      fprintf(f,"%s\t-\tsys\t%.3f\n",Stat_Phase,y);
+      fprintf(f,"%s\t-\tmaxrss_kb\t%ld\n",Stat_Phase,self.ru_maxrss);
+      for (i = 0; i < Stat_Num; i++)
+        if (Stat_Items[i].thread < 0)
+          fprintf(f,"%s\t-\t%s\t%.15g\n",Stat_Phase,Stat_Items[i].key,Stat_Items[i].value);
+      for (t = 0; t < nthr; t++)
+        for (i = 0; i < Stat_Num; i++)
+          if (Stat_Items[i].thread == t)
+            fprintf(f,"%s\t%d\t%s\t%.15g\n",Stat_Phase,t,Stat_Items[i].key,Stat_Items[i].value);
+    }
+  else
+    { fprintf(f,"{\"phase\":\"%s\",\"wall\":%.3f,\"user\":%.3f,\"sys\":%.3f,\"maxrss_kb\":%ld",
+                Stat_Phase,w,u,y,self.ru_maxrss);
+      for (i = 0; i < Stat_Num; i++)
+        if (Stat_Items[i].thread < 0)
+          fprintf(f,",\"%s\":%.15g",Stat_Items[i].key,Stat_Items[i].value);
+      if (nthr > 0)
+        { fprintf(f,",\"threads\":[");
+          for (t = 0; t < nthr; t++)
+            { fprintf(f,"%s{\"thread\":%d",t>0?",":"",t);
+              for (i = 0; i < Stat_Num; i++)
+                if (Stat_Items[i].thread == t)
+                  fprintf(f,",\"%s\":%.15g",Stat_Items[i].key,Stat_Items[i].value);
+              fprintf(f,"}");
+            }
+          fprintf(f,"]");
+        }
+      fprintf(f,"}\n");
+    }
+  fclose(f);
+}
+
+
 /***********************************************************************************************
  *
  *   POSITION LIST ABSTRACTION:
@@ -208,11 +404,63 @@ typedef struct
     uint8  *ctop;       //  Ptr top of current table block in buffer
     int64  *neps;       //  Size of each thread part in elements
     int     clone;      //  Is this a clone?
+    uint8 **maps;       //  If mapped, maps[p] = data of part p+1, else NULL
+    int64   mpos;       //  If mapped, index of next post in current part
   } Post_List;
 
 #define POST_BLOCK 0x20000
+#define POST_HEAD  (2*sizeof(int) + sizeof(int64))   //  Header size of a post part file
+
+static inline int64 Post_Part_Size(Post_List *P, int p)
+{ if (p == 1)
+    return (P->neps[0]);
+  return (P->neps[p-1] - P->neps[p-2]);
+}
+
+//  Make part p current, opening its file unless the post list is memory mapped
+
+static void Open_Post_Part(Post_List *P, int p)
+{ P->part = p;
+  if (P->maps == NULL)
+    { sprintf(P->name+P->nlen,"%d",p);
+      P->copn = open(P->name,O_RDONLY);
+      if (P->copn < 0)
+        { fprintf(stderr,"\n%s: Could not open post part file %s\n",Prog_Name,P->name);
+          Clean_Exit(1);
+        }
+    }
+}
+
+static void Close_Post_Part(Post_List *P)
+{ if (P->maps == NULL)
+    close(P->copn);
+}
+
+//  Position at post i of the current part.  If mapped, hint that the next block is needed.
+
+static void Seek_Post_Part(Post_List *P, int64 i)
+{ if (P->maps != NULL)
+    { int64  n = Post_Part_Size(P,P->part);
+      int64  e = i + POST_BLOCK;
+      uint64 b, page;
+
+      P->mpos = i;
+      if (e > n)
+        e = n;
+      if (i >= e)
+        return;
+      page = sysconf(_SC_PAGESIZE);
+      b    = (uint64) (P->maps[P->part-1] + i*P->pbyte);
+      madvise((void *) (b & ~(page-1)),(b & (page-1)) + (e-i)*P->pbyte,MADV_WILLNEED);
+    }
+  else if (lseek(P->copn,POST_HEAD + i*P->pbyte,SEEK_SET) < 0)
+    { fprintf(stderr,"\n%s: Could not seek file %s\n",Prog_Name,P->name);
+      Clean_Exit(1);
+    }
+}
 
-//  Load up the table buffer with the next STREAM_BLOCK suffixes (if possible)
+//  Load up the table buffer with the next STREAM_BLOCK suffixes (if possible).  If mapped
+//    then simply point at the remainder of the current part.
 
 static void More_Post_List(Post_List *P)
 { int    pbyte = P->pbyte;
@@ -223,6 +471,24 @@ static void More_Post_List(Post_List *P)
 
   if (P->part > P->nthr)
     return;
+  if (P->maps != NULL)
+    { while (1)
+        { int64 n = Post_Part_Size(P,P->part);
+
+          if (P->mpos < n)
+            { P->cptr = P->maps[P->part-1] + P->mpos*pbyte;
+              P->ctop = P->maps[P->part-1] + n*pbyte;
+              P->mpos = n;
+              return;
+            }
+          P->part += 1;
+          P->mpos  = 0;
+          if (P->part > P->nthr)
+            { P->cptr = NULL;
+              return;
+            }
+        }
+    }
   while (1)
     { len  = read(copn,cache,POST_BLOCK*pbyte);
       if (len < 0)
@@ -254,7 +520,7 @@ static void More_Post_List(Post_List *P)
   P->copn = copn;
 }
 
-static Post_List *Open_Post_List(char *name)
+static Post_List *Open_Post_List(char *name, int map)
 { Post_List *P;
   int        pbyte, cbyte, nctg;
   int64      nels, maxp, n;
@@ -300,11 +566,22 @@ static Post_List *Open_Post_List(char *name)
   P->name   = full;
   P->nlen   = strlen(full);
   P->maxp   = maxp;
-  P->cache  = Malloc(POST_BLOCK*pbyte,"Allocating post list buffer\n");
+  if (map)
+    { P->cache = NULL;
+      P->maps  = Malloc(nfile*sizeof(uint8 *),"Allocating part maps of Post_List");
+      if (P->maps == NULL)
+        Clean_Exit(1);
+    }
+  else
+    { P->cache = Malloc(POST_BLOCK*pbyte,"Allocating post list buffer\n");
+      P->maps  = NULL;
+      if (P->cache == NULL)
+        Clean_Exit(1);
+    }
   P->neps   = Malloc(nfile*sizeof(int64),"Allocating parts table of Post_List");
   P->perm   = Malloc(nctg*sizeof(int),"Allocating sort permutation");
   P->index  = Malloc(0x10000*sizeof(int64),"Allocating index array");
-  if (P->cache == NULL || P->neps == NULL || P->perm == NULL || P->index == NULL)
+  if (P->neps == NULL || P->perm == NULL || P->index == NULL)
     { Clean_Exit(1);
       exit (1);
     }
@@ -334,6 +611,17 @@ static Post_List *Open_Post_List(char *name)
           Clean_Exit(1);
           exit (1);
         }
+      if (map)
+        { uint8 *base;
+
+          base = mmap(NULL,POST_HEAD + n*pbyte,PROT_READ,MAP_SHARED,copn,0);
+          if (base == MAP_FAILED)
+            { fprintf(stderr,"%s: Cannot memory map post part %s\n",Prog_Name,P->name);
+              Clean_Exit(1);
+            }
+          madvise(base,POST_HEAD + n*pbyte,MADV_SEQUENTIAL);
+          P->maps[p-1] = base + POST_HEAD;
+        }
       close(copn);
     }
 
@@ -344,19 +632,10 @@ static Post_List *Open_Post_List(char *name)
   P->freq  = freq;
   P->nctg  = nctg;
   P->clone = 0;
+  P->copn  = -1;
 
-  sprintf(P->name+P->nlen,"%d",1);
-  copn = open(P->name,O_RDONLY);
-  if (copn < 0) goto part_io_error;
-
-  if (lseek(copn,2*sizeof(int)+sizeof(int64),SEEK_SET) < 0)
-    { fprintf(stderr,"\n%s: Could not seek file %s\n",Prog_Name,P->name);
-      Clean_Exit(1);
-      exit (1);
-    }
-
-  P->copn  = copn;
-  P->part  = 1;
+  Open_Post_Part(P,1);
+  Seek_Post_Part(P,0);
 
   More_Post_List(P);
   P->cidx = 0;
@@ -376,7 +655,6 @@ part_io_error:
 
 Post_List *Clone_Post_List(Post_List *O)
 { Post_List *P;
-  int copn;
 
   P = Malloc(sizeof(Post_List),"Allocating post record");
   if (P == NULL)
@@ -385,18 +663,19 @@ Post_List *Clone_Post_List(Post_List *O)
   *P = *O;
   P->clone = 1;
 
-  P->cache = Malloc(POST_BLOCK*O->pbyte,"Allocating post list buffer\n");
+  if (P->maps == NULL)
+    { P->cache = Malloc(POST_BLOCK*O->pbyte,"Allocating post list buffer\n");
+      if (P->cache == NULL)
+        Clean_Exit(1);
+    }
   P->name  = Malloc(P->nlen+20,"Allocating post list buffer\n");
-  if (P->cache == NULL || P->name == NULL)
+  if (P->name == NULL)
     Clean_Exit(1);
   strncpy(P->name,O->name,P->nlen);
 
-  sprintf(P->name+P->nlen,"%d",1);
-  copn = open(P->name,O_RDONLY);
-  lseek(copn,2*sizeof(int)+sizeof(int64),SEEK_SET);
-
-  P->copn  = copn;
-  P->part  = 1;
+  P->copn = -1;
+  Open_Post_Part(P,1);
+  Seek_Post_Part(P,0);
 
   More_Post_List(P);
   P->cidx = 0;
@@ -406,13 +685,20 @@ Post_List *Clone_Post_List(Post_List *O)
 
 static void Free_Post_List(Post_List *P)
 { if (!P->clone)
-    { free(P->index);
+    { if (P->maps != NULL)
+        { int p;
+
+          for (p = 1; p <= P->nthr; p++)
+            munmap(P->maps[p-1] - POST_HEAD, POST_HEAD + Post_Part_Size(P,p)*P->pbyte);
+          free(P->maps);
+        }
+      free(P->index);
       free(P->perm);
       free(P->neps);
     }
   free(P->name);
   free(P->cache);
-  if (P->copn >= 0)
+  if (P->copn >= 0 && P->maps == NULL)
     close(P->copn);
   free(P);
 }
@@ -421,20 +707,11 @@ static inline void First_Post_Entry(Post_List *P)
 { if (P->cidx != 0)
     { if (P->part != 1)
         { if (P->part <= P->nthr)
-            close(P->copn);
-          sprintf(P->name+P->nlen,"%d",1);
-          P->copn = open(P->name,O_RDONLY);
-          if (P->copn < 0)
-            { fprintf(stderr,"\n%s: Could not open post part file %s\n",Prog_Name,P->name);
-              Clean_Exit(1);
-            }
-          P->part = 1;
+            Close_Post_Part(P);
+          Open_Post_Part(P,1);
         }
 
-      if (lseek(P->copn,sizeof(int)+sizeof(int64),SEEK_SET) < 0)
-        { fprintf(stderr,"\n%s: Could not seek file %s\n",Prog_Name,P->name);
-          Clean_Exit(1);
-        }
+      Seek_Post_Part(P,0);
 
       More_Post_List(P);
       P->cidx = 0;
@@ -474,26 +751,16 @@ static inline void GoTo_Post_Index(Post_List *P, int64 i)
 
   if (P->part != p)
     { if (P->part <= P->nthr)
-        close(P->copn);
+        Close_Post_Part(P);
       if (P->cidx >= P->nels)
         { P->cptr = NULL;
           P->part = P->nthr+1;
           return;
         }
-      sprintf(P->name+P->nlen,"%d",p);
-      P->copn = open(P->name,O_RDONLY);
-      if (P->copn < 0)
-        { fprintf(stderr,"\n%s: Could not open post part file %s\n",Prog_Name,P->name);
-          Clean_Exit(1);
-        }
-
-      P->part = p;
+      Open_Post_Part(P,p);
     }
 
-  if (lseek(P->copn,2*sizeof(int) + sizeof(int64) + i*P->pbyte,SEEK_SET) < 0)
-    { fprintf(stderr,"\n%s: Could not seek file %s\n",Prog_Name,P->name);
-      Clean_Exit(1);
-    }
+  Seek_Post_Part(P,i);
 
   More_Post_List(P);
 }
@@ -518,27 +785,126 @@ static inline void JumpTo_Post_Index(Post_List *P, int64 del)
 
   if (P->part != p)
     { if (P->part <= P->nthr)
-        close(P->copn);
+        Close_Post_Part(P);
       if (P->cidx >= P->nels)
         { P->cptr = NULL;
           P->part = P->nthr+1;
           return;
         }
-      sprintf(P->name+P->nlen,"%d",p);
-      P->copn = open(P->name,O_RDONLY);
-      if (P->copn < 0)
-        { fprintf(stderr,"\n%s: Could not open post part file %s\n",Prog_Name,P->name);
-          Clean_Exit(1);
+      Open_Post_Part(P,p);    }
+
+  Seek_Post_Part(P,i);
+
+  More_Post_List(P);
+}
+
+/***********************************************************************************************
+ *
+ *   SEED PAIR FILE CODE:
+ *     Each thread writes the seed pairs for a part to its own temporary file as a sequence
+ *     of blocks, each an 8-byte header followed by a payload.  The header gives the size of
+ *     the payload if it is deflated (0 if not) and the size of the encoded seeds in it.
+ *     A seed (lcp, apost, bpost) is encoded as a byte holding lcp followed by the zig-zag
+ *     varint difference of apost to the apost of the previous seed, save that if lcp and
+ *     apost are those of the previous seed (as for all but the first of the pairs of an
+ *     A-post) just the byte SAME_APOST is output.  Then follows the varint difference of bpost
+ *     to the previous bpost.  With -z each block is deflated (level 1) if it gets smaller.
+ *
+ **********************************************************************************************/
+
+#define SEED_BLOCK 1000000   //  Size of a seed IO buffer, and so the most bytes in a block
+#define SEED_HEAD        8   //  Bytes in a block header
+#define SEED_MAX        21   //  Most bytes in an encoded seed
+#define SAME_APOST    0xff   //  Lead byte of a seed with the lcp and apost of its predecessor
+
+static inline uint8 *put_varint(uint8 *b, int64 d)
+{ uint64 x = (((uint64) d) << 1) ^ ((uint64) (d >> 63));
+
+  while (x >= 0x80)
+    { *b++ = (x | 0x80);
+      x >>= 7;
+    }
+  *b++ = x;
+  return (b);
+}
+
+  //  Decode the varint at b, which must end before e, returning the byte after it or NULL
+  //    if it does not (the seed file is corrupt)
+
+static inline uint8 *get_varint(uint8 *b, uint8 *e, int64 *d)
+{ uint64 x;
+  int    s;
+
+  x = 0;
+  for (s = 0; b < e && (*b & 0x80); s += 7)
+    { if (s > 56)
+        return (NULL);
+      x |= ((uint64) (*b++ & 0x7f)) << s;
+    }
+  if (b >= e)
+    return (NULL);
+  x |= ((uint64) *b++) << s;
+  *d = (int64) ((x >> 1) ^ (-(x & 0x1)));
+  return (b);
+}
+
+static inline void encode_seed(IOBuffer *ou, int lcp, int64 apost, int64 bpost)
+{ uint8 *b = ou->btop;
+
+  if (lcp == ou->lcp && apost == ou->apost)
+    *b++ = SAME_APOST;
+  else
+    { *b++ = lcp;
+      b = put_varint(b,apost-ou->apost);
+      ou->lcp   = lcp;
+      ou->apost = apost;
+    }
+  ou->btop  = put_varint(b,bpost-ou->bpost);
+  ou->bpost = bpost;
+}
+
+static void start_seeds(IOBuffer *ou)
+{ ou->btop  = ou->bufr + SEED_HEAD;
+  ou->bend  = ou->bufr + (SEED_BLOCK-SEED_MAX);
+  ou->lcp   = -1;
+  ou->apost = 0;
+  ou->bpost = 0;
+}
+
+  //  Write the block of seeds in ou's buffer, deflating it into zbuf first if zs != NULL
+
+static void flush_seeds(IOBuffer *ou, z_stream *zs, uint8 *zbuf)
+{ uint32  head[2];
+  uint8  *out;
+  int64   olen;
+
+  head[1] = ou->btop - (ou->bufr + SEED_HEAD);
+  if (head[1] == 0)
+    return;
+
+  head[0] = 0;
+  out  = ou->bufr;
+  olen = SEED_HEAD + head[1];
+  if (zs != NULL)
+    { deflateReset(zs);
+      zs->next_in   = ou->bufr + SEED_HEAD;
+      zs->avail_in  = head[1];
+      zs->next_out  = zbuf + SEED_HEAD;
+      zs->avail_out = head[1]-1;
+      if (deflate(zs,Z_FINISH) == Z_STREAM_END)
+        { head[0] = zs->total_out;
+          out  = zbuf;
+          olen = SEED_HEAD + head[0];
         }
-      P->part = p;
     }
+  memcpy(out,head,SEED_HEAD);
 
-  if (lseek(P->copn,2*sizeof(int) + sizeof(int64) + i*P->pbyte,SEEK_SET) < 0)
-    { fprintf(stderr,"\n%s: Could not seek file %s\n",Prog_Name,P->name);
+  if (write(ou->file,out,olen) < 0)
+    { fprintf(stderr,"%s: IO write to file %s/%s.%d.%c failed\n",
+                     Prog_Name,PAIR_PATH,PAIR_NAME,ou->inum,ou->type);
       Clean_Exit(1);
     }
-
-  More_Post_List(P);
+  ou->btop = ou->bufr + SEED_HEAD;
 }
 
 /***********************************************************************************************
@@ -609,6 +975,9 @@ static void *merge_thread(void *args)
   int     qcnt, pcnt;
   int64   nhits, g1len, tseed;
 
+  z_stream  zstream, *zs;
+  uint8    *zbuf = NULL;
+
 #ifdef DEBUG_MERGE
   int64   Tdp;
   char   *tbuffer;
@@ -617,13 +986,20 @@ static void *merge_thread(void *args)
   { int j;
 
     for (j = 0; j < NPARTS; j++)
-      { nunit[j].bend = nunit[j].bufr + (1000000-(IBYTE+JBYTE+1));
-        nunit[j].btop = nunit[j].bufr;
-        cunit[j].bend = cunit[j].bufr + (1000000-(IBYTE+JBYTE+1));
-        cunit[j].btop = cunit[j].bufr;
+      { start_seeds(nunit+j);
+        start_seeds(cunit+j);
       }
   }
 
+  zs = NULL;
+  if (ZIP_SEEDS)
+    { zs   = &zstream;
+      zbuf = Malloc(SEED_BLOCK,"Allocating deflate buffer");
+      memset(zs,0,sizeof(z_stream));
+      if (zbuf == NULL || deflateInit(zs,1) != Z_OK)
+        Clean_Exit(1);
+    }
+
   cpre  = -1;
   ctop  = cache;
   vhgh  = cache;
@@ -815,7 +1191,7 @@ static void *merge_thread(void *args)
       { int       freq, lcs, udx;
         int       asign, acont, adest;
         IOBuffer *ou;
-        uint8    *l, *vcp, *jptr, *btop;
+        uint8    *l, *vcp, *jptr;
         int       m, n, k, b;
         
         freq = 0;
@@ -895,18 +1271,17 @@ static void *merge_thread(void *args)
             aptr[ISIGN] &= 0x7f;
             acont = (apost >> ESHIFT);
             adest = Select[acont];
+            if (adest < 0)            //  A-contig is not in this run's shard
+              { Next_Post_Entry(P1);
+                continue;
+              }
             jptr  = (uint8 *) (post+b);
             for (k = 0; k < freq; k++)
               { if (asign == (jptr[JSIGN] & 0x80))
                   ou = nunit + adest;
                 else
                   ou = cunit + adest;
-                btop = ou->btop;
-                *btop++ = plen;
-                memcpy(btop,aptr,IBYTE);
-                btop += IBYTE;
-                memcpy(btop,jptr,JBYTE);
-                btop += JBYTE;
+                encode_seed(ou,plen,apost,(*((int64 *) jptr)) & JMASK);
 
                 ou->buck[acont] += 1;
 
@@ -930,17 +1305,8 @@ static void *merge_thread(void *args)
                   }
 #endif
 
-                if (btop >= ou->bend)
-                  { if (write(ou->file,ou->bufr,btop-ou->bufr) < 0)
-                      { fprintf(stderr,"%s: IO write to file %s/%s.%d.%c failed\n",
-                                       Prog_Name,SORT_PATH,PAIR_NAME,ou->inum,
-                                       (asign == (jptr[JSIGN] & 0x80)) ? 'N' : 'C');
-                        Clean_Exit(1);
-                      }
-                    ou->btop = ou->bufr;
-                  }
-                else
-                  ou->btop = btop;
+                if (ou->btop >= ou->bend)
+                  flush_seeds(ou,zs,zbuf);
 
                 jptr += sizeof(int64);
               }
@@ -974,21 +1340,16 @@ static void *merge_thread(void *args)
   { int j;
 
     for (j = 0; j < NPARTS; j++)
-      { if (nunit[j].btop > nunit[j].bufr)
-          if (write(nunit[j].file,nunit[j].bufr,nunit[j].btop-nunit[j].bufr) < 0)
-            { fprintf(stderr,"%s: IO write to file %s/%s.%d.N failed\n",
-                             Prog_Name,SORT_PATH,PAIR_NAME,nunit[j].inum);
-              Clean_Exit(1);
-            }
-        if (cunit[j].btop > cunit[j].bufr)
-          if (write(cunit[j].file,cunit[j].bufr,cunit[j].btop-cunit[j].bufr) < 0)
-            { fprintf(stderr,"%s: IO write to file %s/%s.%d.C failed\n",
-                             Prog_Name,SORT_PATH,PAIR_NAME,cunit[j].inum);
-              Clean_Exit(1);
-            }
+      { flush_seeds(nunit+j,zs,zbuf);
+        flush_seeds(cunit+j,zs,zbuf);
       }
   }
 
+  if (zs != NULL)
+    { deflateEnd(zs);
+      free(zbuf);
+    }
+
   parm->nhits = nhits;
   parm->g1len = g1len;
   parm->tseed = tseed;
@@ -1094,6 +1455,9 @@ static void *self_merge_thread(void *args)
   int     qcnt, pcnt;
   int64   nhits, g1len, tseed;
 
+  z_stream  zstream, *zs;
+  uint8    *zbuf = NULL;
+
 #ifdef DEBUG_MERGE
   int64   Tdp;
   char   *tbuffer;
@@ -1102,13 +1466,20 @@ static void *self_merge_thread(void *args)
   { int j;
 
     for (j = 0; j < NPARTS; j++)
-      { nunit[j].bend = nunit[j].bufr + (1000000-(IBYTE+JBYTE+1));
-        nunit[j].btop = nunit[j].bufr;
-        cunit[j].bend = cunit[j].bufr + (1000000-(IBYTE+JBYTE+1));
-        cunit[j].btop = cunit[j].bufr;
+      { start_seeds(nunit+j);
+        start_seeds(cunit+j);
       }
   }
 
+  zs = NULL;
+  if (ZIP_SEEDS)
+    { zs   = &zstream;
+      zbuf = Malloc(SEED_BLOCK,"Allocating deflate buffer");
+      memset(zs,0,sizeof(z_stream));
+      if (zbuf == NULL || deflateInit(zs,1) != Z_OK)
+        Clean_Exit(1);
+    }
+
   memset(post,0,sizeof(int64)*(POST_BUF_LEN+FREQ));
 
   ctop  = cache;
@@ -1243,7 +1614,7 @@ static void *self_merge_thread(void *args)
         int       icont, idest;
         uint8    *iptr, *jptr;
         IOBuffer *ou;
-        uint8    *l, *vcp, *btop;
+        uint8    *l, *vcp;
         int       m, n, k, b;
 
         if (suf1[CBYTE] > 1)
@@ -1336,6 +1707,11 @@ static void *self_merge_thread(void *args)
             ipost = *((int64 *) iptr);
             icont = (ipost >> ESHIFT);
             idest = Select[icont];
+            if (idest < 0)            //  A-contig is not in this run's shard
+              { if (isign)
+                  iptr[ISIGN] |= 0x80;
+                continue;
+              }
 
             jptr  = (uint8 *) (post+b);
             for (k = 0; k < freq; k++, jptr += sizeof(int64))
@@ -1371,26 +1747,12 @@ static void *self_merge_thread(void *args)
                   ou = nunit + idest;
                 else
                   ou = cunit + idest;
-                btop = ou->btop;
-                *btop++ = mlen;
-                memcpy(btop,iptr,IBYTE);
-                btop += IBYTE;
-                memcpy(btop,jptr,JBYTE);
-                btop += JBYTE;
+                encode_seed(ou,mlen,ipost & IMASK,(*((int64 *) jptr)) & JMASK);
 
                 ou->buck[icont] += 1;
 
-                if (btop >= ou->bend)
-                  { if (write(ou->file,ou->bufr,btop-ou->bufr) < 0)
-                      { fprintf(stderr,"%s: IO write to file %s/%s.%d.%c failed\n",
-                                       Prog_Name,SORT_PATH,PAIR_NAME,
-                                       ou->inum,(isign == jsign) ? 'N' : 'C');
-                        Clean_Exit(1);
-                      }
-                    ou->btop = ou->bufr;
-                  }
-                else
-                  ou->btop = btop;
+                if (ou->btop >= ou->bend)
+                  flush_seeds(ou,zs,zbuf);
               }
 
 #ifdef DEBUG_MERGE
@@ -1419,21 +1781,16 @@ static void *self_merge_thread(void *args)
   { int j;
 
     for (j = 0; j < NPARTS; j++)
-      { if (nunit[j].btop > nunit[j].bufr)
-          if (write(nunit[j].file,nunit[j].bufr,nunit[j].btop-nunit[j].bufr) < 0)
-            { fprintf(stderr,"%s: IO write to file %s/%s.%d.N failed\n",
-                             Prog_Name,SORT_PATH,PAIR_NAME,nunit[j].inum);
-              Clean_Exit(1);
-            }
-        if (cunit[j].btop > cunit[j].bufr)
-          if (write(cunit[j].file,cunit[j].bufr,cunit[j].btop-cunit[j].bufr) < 0)
-            { fprintf(stderr,"%s: IO write to file %s/%s.%d.C failed\n",
-                             Prog_Name,SORT_PATH,PAIR_NAME,cunit[j].inum);
-              Clean_Exit(1);
-            }
+      { flush_seeds(nunit+j,zs,zbuf);
+        flush_seeds(cunit+j,zs,zbuf);
       }
   }
 
+  if (zs != NULL)
+    { deflateEnd(zs);
+      free(zbuf);
+    }
+
   parm->nhits = nhits/2;
   parm->g1len = g1len;
   parm->tseed = tseed/2;
@@ -1547,7 +1904,12 @@ static void adaptamer_merge(Kmer_Stream *T1, Kmer_Stream *T2,
     { nhits += parm[i].nhits;
       g1len += parm[i].g1len;
       tseed += parm[i].tseed;
+      Stats_Count("seeds",i,parm[i].nhits);
+      Stats_Count("seed_bases",i,parm[i].tseed);
     }
+  Stats_Count("seeds",-1,nhits);
+  Stats_Count("seed_bases",-1,tseed);
+  Stats_Count("g1_positions",-1,g1len);
 
   if (VERBOSE)
     { fprintf(stderr,"\n  Total seeds = %lld, ave. len = %.1f, seeds per G1 position = %.1f\n",
@@ -1650,7 +2012,12 @@ static void self_adaptamer_merge(Kmer_Stream *T1, Post_List *P1)
     { nhits += parm[i].nhits;
       g1len += parm[i].g1len;
       tseed += parm[i].tseed;
+      Stats_Count("seeds",i,parm[i].nhits);
+      Stats_Count("seed_bases",i,parm[i].tseed);
     }
+  Stats_Count("seeds",-1,nhits);
+  Stats_Count("seed_bases",-1,tseed);
+  Stats_Count("g1_positions",-1,g1len);
 
   if (VERBOSE)
     { fprintf(stderr,"\n  Total seeds = %lld, ave. len = %.1f, seeds per G1 position = %.1f\n",
@@ -1679,123 +2046,137 @@ typedef struct
     Range    *range;
   } RP;
 
+  //  Read len bytes of seed file in into buf, returning the # read (< len only at the end)
+
+static int64 read_seeds(RP *parm, uint8 *buf, int64 len)
+{ int64 n, r;
+
+  for (n = 0; n < len; n += r)
+    { r = read(parm->in,buf+n,len-n);
+      if (r < 0)
+        { fprintf(stderr,"%s: IO read error for file %s/%s.%d.%c\n",
+                         Prog_Name,PAIR_PATH,PAIR_NAME,parm->inum,parm->comp?'C':'N');
+          Clean_Exit(1);
+        }
+      if (r == 0)
+        break;
+    }
+  return (n);
+}
+
 static void *reimport_thread(void *args)
 { RP *parm = (RP *) args;
   int    swide  = parm->swide;
-  int    in     = parm->in;
   int    comp   = parm->comp;
   uint8 *sarr   = parm->sarr;
-  uint8 *bufr   = parm->buffer;
+  uint8 *ubuf   = parm->buffer;
+  uint8 *zbuf   = parm->buffer + SEED_BLOCK;
   int64 *buck   = parm->buck;
 
   int64  ipost, jpost, icont, jcont, band, anti;
-  uint8 *_ipost = (uint8 *) (&ipost);
-  uint8 *_jpost = (uint8 *) (&jpost);
-  uint8 *_icont = (uint8 *) (&icont);
   uint8 *_jcont = (uint8 *) (&jcont);
   uint8 *_band  = (uint8 *) (&band);
   uint8 *_anti  = (uint8 *) (&anti);
 
-  int    iamt;
   uint8 *x;
-  int    iolen, iunit, lcp, flip;
-  int64  diag, flag, mask;
-  uint8 *bend, *btop, *b;
-
-  iolen = 2*NPARTS*1000000;
-  iunit = IBYTE + JBYTE + 1;
-
-  iamt = read(in,bufr,iolen);
-  if (iamt < 0)
-    { fprintf(stderr,"%s: IO read error for file %s/%s.%d.%c\n",
-                     Prog_Name,SORT_PATH,PAIR_NAME,parm->inum,comp?'C':'N');
-      Clean_Exit(1);
-    }
-  bend = bufr + iamt;
-
-  if (bend-bufr < iolen)
-    btop = bend;
-  else
-    btop = bend-iunit;
-  b = bufr;
-
-  ipost = 0;
-  jpost = 0;
-  jcont = 0;
-  icont = 0;
+  int    lcp, flip, slcp;
+  int64  diag, flag, mask, pmask, apost, bpost, d;
+  uint32 head[2];
+  uLongf ulen;
+  uint8 *b, *e;
 
-  flag = (0x1ll << (8*JCONT-1));
-  mask = flag-1;
-
-  if (bend > bufr)
+  flag  = (0x1ll << (8*JCONT-1));
+  mask  = flag-1;
+  pmask = (0x1ll << (8*JPOST)) - 1;
 
+  slcp  = 0;
+  apost = 0;
+  bpost = 0;
   while (1)
-    { lcp = *b++;
-      memcpy(_ipost,b,IPOST);
-      b += IPOST;
-      memcpy(_icont,b,ICONT);
-      b += ICONT;
-      memcpy(_jpost,b,JPOST);
-      b += JPOST;
-      memcpy(_jcont,b,JCONT);
-      b += JCONT;
-      flip = ((jcont & flag) != 0);
-      jcont &= mask;
-
-      x = sarr + swide * buck[icont]++;
-      *x++ = lcp;
-      if (comp)
-        { if (flip)
-            { ipost += lcp;
-              jpost += KMER-lcp;
-            }
-          else
-            ipost += KMER;
-          diag = MAXDAG - (ipost + jpost);
-          anti = AMXPOS - (ipost - jpost);
+    { d = read_seeds(parm,(uint8 *) head,SEED_HEAD);
+      if (d == 0)
+        break;
+      if (d < SEED_HEAD || head[1] > SEED_BLOCK)
+        goto corrupt;
+      if (head[0] == 0)
+        { if (read_seeds(parm,ubuf,head[1]) < head[1])
+            goto corrupt;
         }
       else
-        { if (flip)
-            { lcp   = KMER-lcp;
-              ipost += lcp;
-              jpost += lcp;
-            }
-          diag = BMXPOS + (ipost - jpost);
-          anti = ipost + jpost;
+        { if (head[0] > SEED_BLOCK || read_seeds(parm,zbuf,head[0]) < head[0])
+            goto corrupt;
+          ulen = head[1];
+          if (uncompress(ubuf,&ulen,zbuf,head[0]) != Z_OK || ulen != head[1])
+            goto corrupt;
         }
-      band = (diag >> BUCK_SHIFT);
-      *x++ = diag-(band<<BUCK_SHIFT);
-
-      memcpy(x,_anti,DBYTE);
-      x += DBYTE;
-      memcpy(x,_band,DBYTE);
-      x += DBYTE;
-      memcpy(x,_jcont,JCONT);
-      x += JCONT;
-
-      if (b >= btop)
-        { int ex = bend-b;
-          memcpy(bufr,b,ex);
-          bend = bufr+ex;
-          iamt = read(in,bend,iolen-ex);
-          if (iamt < 0)
-            { fprintf(stderr,"%s: IO read error for file %s/%s.%d.%c\n",
-                             Prog_Name,SORT_PATH,PAIR_NAME,parm->inum,comp?'C':'N');
-              Clean_Exit(1);
+
+      e = ubuf + head[1];
+      for (b = ubuf; b < e; )
+        { if (*b == SAME_APOST)
+            b += 1;
+          else
+            { slcp = *b++;
+              b = get_varint(b,e,&d);
+              if (b == NULL)
+                goto corrupt;
+              apost += d;
+            }
+          b = get_varint(b,e,&d);
+          if (b == NULL)
+            goto corrupt;
+          bpost += d;
+
+          lcp   = slcp;
+          ipost = (apost & ((0x1ll << ESHIFT) - 1));
+          icont = (apost >> ESHIFT);
+          jpost = (bpost & pmask);
+          jcont = (bpost >> (8*JPOST));
+          flip  = ((jcont & flag) != 0);
+          jcont &= mask;
+          if (icont < 0 || icont >= NCONTS)
+            goto corrupt;
+
+          x = sarr + swide * buck[icont]++;
+          *x++ = lcp;
+          if (comp)
+            { if (flip)
+                { ipost += lcp;
+                  jpost += KMER-lcp;
+                }
+              else
+                ipost += KMER;
+              diag = MAXDAG - (ipost + jpost);
+              anti = AMXPOS - (ipost - jpost);
             }
-          bend += iamt;
-          if (bend == bufr)
-            break;
-          if (bend-bufr < iolen)
-            btop = bend;
           else
-            btop = bend-iunit;
-          b = bufr;
+            { if (flip)
+                { lcp   = KMER-lcp;
+                  ipost += lcp;
+                  jpost += lcp;
+                }
+              diag = BMXPOS + (ipost - jpost);
+              anti = ipost + jpost;
+            }
+          band = (diag >> BUCK_SHIFT);
+          *x++ = diag-(band<<BUCK_SHIFT);
+
+          memcpy(x,_anti,DBYTE);
+          x += DBYTE;
+          memcpy(x,_band,DBYTE);
+          x += DBYTE;
+          memcpy(x,_jcont,JCONT);
+          x += JCONT;
         }
     }
 
-  close(in);
+  close(parm->in);
+
+  return (NULL);
 
+corrupt:
+  fprintf(stderr,"%s: Seed file %s/%s.%d.%c is truncated or corrupted\n",
+                 Prog_Name,PAIR_PATH,PAIR_NAME,parm->inum,comp?'C':'N');
+  Clean_Exit(1);
   return (NULL);
 }
 
@@ -1993,6 +2374,21 @@ static int entwine(Path *jpath, uint8 *jtrace, Path *kpath, uint8 *ktrace, int *
   return (min);
 }
 
+  //  Each aligning thread keeps the B-contigs it most recently decoded in a small LRU cache so
+  //    that a B-contig aligned against several A-contigs in turn is decoded just once.  The
+  //    cache holds at most CTG_SLOTS contigs whose buffers total at most CTG_CACHE bytes, or
+  //    just one contig if it alone is larger.  The buffers are laid out as New_Contig_Buffer's.
+
+#define CTG_SLOTS     8
+#define CTG_CACHE  0x4000000   //  64MB
+
+typedef struct
+  { int     ctg;      //  contig decoded in buf (-1 if none)
+    int64   last;     //  stamp of its last use (0 if none)
+    int64   max;      //  bytes in buf for bases
+    char   *buf;
+  } Ctg_Slot;
+
 typedef struct
 
   { int         tid;
@@ -2004,6 +2400,12 @@ typedef struct
     int64       nlive;
     int64       nlcov;
     int64       nmemo;
+    int64       ngath;      //  bytes written to & read back from the gather file tfile
+    int64       ndecode;    //  contigs decoded
+    int64       nreuse;     //  B-contigs found in the cache
+    Ctg_Slot    cache[CTG_SLOTS];
+    int64       cbytes;     //  total max of the cache slots
+    int64       clock;
                             //  See align.h for doc on the following:
     Work_Data  *work;           //  work storage for alignment module
     Align_Spec *spec;           //  alignment spec
@@ -2019,6 +2421,68 @@ static int ALIGN_SORT(const void *l, const void *r)
   return (ol->path.abpos - or->path.abpos);
 }
 
+  //  Return the bases of B-contig ctg, decoding them into the least recently used slot of
+  //    the cache if they are not already there.
+
+static char *fetch_bcontig(Contig_Bundle *pair, int ctg)
+{ Ctg_Slot *s, *v, *w;
+  int64     need, keep;
+  int       i;
+
+  pair->clock += 1;
+  v = NULL;
+  for (i = 0; i < CTG_SLOTS; i++)
+    { s = pair->cache + i;
+      if (s->ctg == ctg)
+        { s->last = pair->clock;
+          pair->nreuse += 1;
+          return (s->buf);
+        }
+      if (v == NULL || s->last < v->last)
+        v = s;
+    }
+
+  need = pair->gdb2->contigs[ctg].clen;
+  if (v->max >= need)
+    keep = v->max;
+  else
+    keep = need;
+  while (pair->cbytes - v->max + keep > CTG_CACHE)     //  Evict until the contig fits
+    { w = NULL;
+      for (i = 0; i < CTG_SLOTS; i++)
+        { s = pair->cache + i;
+          if (s != v && s->buf != NULL && (w == NULL || s->last < w->last))
+            w = s;
+        }
+      if (w == NULL)
+        break;
+      free(w->buf-1);
+      pair->cbytes -= w->max;
+      w->buf  = NULL;
+      w->max  = 0;
+      w->ctg  = -1;
+      w->last = 0;
+    }
+
+  if (v->max < need)
+    { if (v->buf != NULL)
+        free(v->buf-1);
+      v->buf = Malloc(need+12,"Allocating contig buffer");
+      if (v->buf == NULL)
+        Clean_Exit(1);
+      v->buf += 1;
+      pair->cbytes += need - v->max;
+      v->max = need;
+    }
+
+  if (Get_Contig(pair->gdb2,ctg,NUMERIC,v->buf) == NULL)
+    Clean_Exit(1);
+  pair->ndecode += 1;
+  v->ctg  = ctg;
+  v->last = pair->clock;
+  return (v->buf);
+}
+
 //  [beg,end) in the sorted array of width swide elements contain all the adaptive seeds between
 //    the contigs in the parameter pair.  Look for seed chains in each pair of diagaonl buckets
 //    of sufficient score, and when found search for an alignment, outputing it if found.
@@ -2227,6 +2691,7 @@ static void align_contigs(uint8 *beg, uint8 *end, int swide, int ctg1, int ctg2,
                       if (ctg1 != ovl->aread)
                         { if (Get_Contig(pair->gdb1,ctg1,NUMERIC,align->aseq) == NULL)
                             Clean_Exit(1);
+                          pair->ndecode += 1;
                           align->alen = alen;
                           ovl->aread  = ctg1;
                           if (comp)
@@ -2238,8 +2703,7 @@ static void align_contigs(uint8 *beg, uint8 *end, int swide, int ctg1, int ctg2,
 #endif
                         }
                       if (ctg2 != ovl->bread)
-                        { if (Get_Contig(pair->gdb2,ctg2,NUMERIC,align->bseq) == NULL)
-                            Clean_Exit(1);
+                        { align->bseq = fetch_bcontig(pair,ctg2);
                           align->blen = blen;
                           ovl->bread = ctg2;
 #ifdef DEBUG_HIT
@@ -2467,6 +2931,7 @@ static void align_contigs(uint8 *beg, uint8 *end, int swide, int ctg1, int ctg2,
                          Prog_Name,SORT_PATH,ALGN_PAIR,pair->tid);
           Clean_Exit(1);
         }
+      pair->ngath += nmem;
 
       { void *off;
 
@@ -2701,13 +3166,13 @@ static void align_contigs(uint8 *beg, uint8 *end, int swide, int ctg1, int ctg2,
           o->flags &= RESET_FLAGS;
           if (fwrite( ((char *) o)+PTR_SIZE, EXO_SIZE, 1, ofile) != 1)
             { fprintf(stderr,"%s: Could not write to overlap block file %s/%s.%d.las\n",
-                             Prog_Name,SORT_PATH,ALGN_UNIQ,pair->tid);
+                             Prog_Name,UNIQ_PATH,UNIQ_NAME,pair->tid);
               Clean_Exit(1);
             }
           if (hasmem)
             { if (fwrite(o->path.trace, o->path.tlen, 1, ofile) != 1)
                 { fprintf(stderr,"%s: Could not write to overlap block file %s/%s.%d.las\n",
-                                 Prog_Name,SORT_PATH,ALGN_UNIQ,pair->tid);
+                                 Prog_Name,UNIQ_PATH,UNIQ_NAME,pair->tid);
                   Clean_Exit(1);
                 }
               free(o->path.trace);
@@ -2715,7 +3180,7 @@ static void align_contigs(uint8 *beg, uint8 *end, int swide, int ctg1, int ctg2,
           else
             { if (fwrite( (char *) (o+1), o->path.tlen, 1, ofile) != 1)
                 { fprintf(stderr,"%s: Could not write to overlap block file %s/%s.%d.las\n",
-                                 Prog_Name,SORT_PATH,ALGN_UNIQ,pair->tid);
+                                 Prog_Name,UNIQ_PATH,UNIQ_NAME,pair->tid);
                   Clean_Exit(1);
                 }
             }
@@ -2739,6 +3204,38 @@ static void align_contigs(uint8 *beg, uint8 *end, int swide, int ctg1, int ctg2,
 }
 
 
+//  The seeds between each pair of contigs (a run) form a task.  Each thread first collects
+//    the runs of the range of A-contigs given it by rmsd_sort into its own deque, and then
+//    aligns its tasks front to back.  A thread whose deque is empty steals tasks from the
+//    back of the other threads' deques so that a thread with a few large contigs does not
+//    hold up the rest.  A run is never split as the chaining and redundancy elimination of
+//    align_contigs is over all the seeds of a contig pair.
+
+typedef struct
+  { uint8  *beg;      //  seeds in [beg,end) of the sort array
+    uint8  *end;
+    int     icrnt;    //  sorted A-contig #
+    int     jcrnt;    //  B-contig #
+  } Task;
+
+typedef struct
+  { pthread_mutex_t lock;
+    Task           *task;   //  tasks [top,bot) remain to be done
+    int64           top;
+    int64           bot;
+    int64           max;
+  } Deque;
+
+static Deque *Queues;   //  One task deque per thread
+
+  //  A run is a sorted byte range [beg,end) of alignment records in a file
+
+typedef struct
+  { FILE     *file;
+    int64     beg;
+    int64     end;
+  } Run;
+
 typedef struct
   { int       tid;
     int       swide;
@@ -2755,43 +3252,149 @@ typedef struct
     int64     nlive;
     int64     nlcov;
     int64     nmemo;
+    int64     ngath;
+    int64     ndecode; //  # of contigs decoded for alignment
+    int64     nreuse;  //  # of times a decoded B-contig was reused
+    int64     ntask;   //  # of tasks performed
+    int64     nstol;   //  # of which were stolen
+    int64     nbusy;   //  nanosecs spent aligning tasks (if VERBOSE or -stats)
+    int       nrun;    //  la_sort sorts ofile into nrun runs (if it exceeds its memory share)
+    Run      *runs;
+    int64     rmax;    //  largest alignment record in bytes
   } TP;
 
-static void *search_seeds(void *args)
+  //  Append the task of the seeds in [b,x) of contig pair (icrnt,jcrnt) as the n'th of 'deque',
+  //    growing it as necessary, and return the new number of tasks.
+
+static inline int64 add_task(Deque *deque, int64 n, uint8 *b, uint8 *x, int icrnt, int64 jcrnt)
+{ Task *t;
+
+  if (n >= deque->max)
+    { deque->max  = 1.2*n + 1000;
+      deque->task = Realloc(deque->task,sizeof(Task)*deque->max,"Reallocating task deque");
+      if (deque->task == NULL)
+        Clean_Exit(1);
+    }
+  t = deque->task + n;
+  t->beg   = b;
+  t->end   = x;
+  t->icrnt = icrnt;
+  t->jcrnt = jcrnt;
+  return (n+1);
+}
+
+static void *find_runs(void *args)
 { TP *parm = (TP *) args;
   int      swide  = parm->swide;
-  int      comp   = parm->comp;
   int64   *panel  = parm->panel;
-  uint8   *sarray = parm->sarr;
   Range   *range  = parm->range;
   int      beg    = range->beg;
   int      end    = range->end;
-  GDB     *gdb1   = &(parm->gdb1);
-  GDB     *gdb2   = &(parm->gdb2);
   int      foffs  = swide-JCONT;
-  FILE    *ofile  = parm->ofile;
-  FILE    *tfile  = parm->tfile;
+  Deque   *deque  = Queues + parm->tid;
 
   int    icrnt;
   int64  jcrnt;
   uint8 *_jcrnt = (uint8 *) (&jcrnt);
-
-  Contig_Bundle _pair, *pair = &_pair;
+  int64  n;
 
   uint8 *x, *e, *b;
 
   jcrnt = 0;
+  n     = 0;
 
-  pair->tid  = parm->tid;
-  pair->gdb1 = gdb1;
-  pair->gdb2 = gdb2;
-  pair->align.aseq = New_Contig_Buffer(gdb1);
-  pair->align.bseq = New_Contig_Buffer(gdb2);
-  if (pair->align.bseq == NULL || pair->align.bseq == NULL)
-    Clean_Exit(1);
-  pair->align.path = &(pair->ovl.path);
-  if (comp)
-    { pair->ovl.flags   = COMP_FLAG;
+  x = parm->sarr + range->off;
+  for (icrnt = beg; icrnt < end; icrnt++)
+    { e = x + panel[icrnt];
+      if (e > x)
+        { memcpy(_jcrnt,x+foffs,JCONT);
+          b = x;
+          for (x += swide; x < e; x += swide)
+            if (memcmp(_jcrnt,x+foffs,JCONT))
+              { n = add_task(deque,n,b,x,icrnt,jcrnt);
+                memcpy(_jcrnt,x+foffs,JCONT);
+                b = x;
+              }
+          n = add_task(deque,n,b,x,icrnt,jcrnt);
+        }
+    }
+
+  deque->top = 0;
+  deque->bot = n;
+  return (NULL);
+}
+
+  //  Take the next task from the front of deque 'own', or failing that steal one from the
+  //    back of another thread's deque.  Return NULL when all deques are empty.
+
+static Task *next_task(int own, int *stolen)
+{ Deque *d;
+  Task  *t;
+  int    p;
+
+  d = Queues + own;
+  t = NULL;
+  pthread_mutex_lock(&(d->lock));
+  if (d->top < d->bot)
+    t = d->task + d->top++;
+  pthread_mutex_unlock(&(d->lock));
+  if (t != NULL)
+    { *stolen = 0;
+      return (t);
+    }
+
+  for (p = own+1; p != own; p++)
+    { if (p >= NTHREADS)
+        { p = -1;
+          continue;
+        }
+      d = Queues + p;
+      pthread_mutex_lock(&(d->lock));
+      if (d->top < d->bot)
+        t = d->task + --d->bot;
+      pthread_mutex_unlock(&(d->lock));
+      if (t != NULL)
+        { *stolen = 1;
+          return (t);
+        }
+    }
+  return (NULL);
+}
+
+static void *search_seeds(void *args)
+{ TP *parm = (TP *) args;
+  int      swide  = parm->swide;
+  int      comp   = parm->comp;
+  GDB     *gdb1   = &(parm->gdb1);
+  GDB     *gdb2   = &(parm->gdb2);
+  FILE    *ofile  = parm->ofile;
+  FILE    *tfile  = parm->tfile;
+
+  struct timespec tbeg, tend;
+  Task  *t;
+  int    stolen;
+  int    p;
+
+  Contig_Bundle _pair, *pair = &_pair;
+
+  pair->tid  = parm->tid;
+  pair->gdb1 = gdb1;
+  pair->gdb2 = gdb2;
+  pair->align.aseq = New_Contig_Buffer(gdb1);
+  pair->align.bseq = NULL;
+  if (pair->align.aseq == NULL)
+    Clean_Exit(1);
+  for (p = 0; p < CTG_SLOTS; p++)
+    { pair->cache[p].ctg  = -1;
+      pair->cache[p].last = 0;
+      pair->cache[p].max  = 0;
+      pair->cache[p].buf  = NULL;
+    }
+  pair->cbytes = 0;
+  pair->clock  = 0;
+  pair->align.path = &(pair->ovl.path);
+  if (comp)
+    { pair->ovl.flags   = COMP_FLAG;
       pair->align.flags = ACOMP_FLAG;
     }
   else
@@ -2811,33 +3414,40 @@ static void *search_seeds(void *args)
   pair->nlive = 0;
   pair->nlcov = 0;
   pair->nmemo = 0;
+  pair->ngath = 0;
+  pair->ndecode = 0;
+  pair->nreuse  = 0;
 
-  x = sarray + range->off;
-  for (icrnt = beg; icrnt < end; icrnt++)
-    { e = x + panel[icrnt];
-      if (e > x)
-        { memcpy(_jcrnt,x+foffs,JCONT);
-          b = x;
-          for (x += swide; x < e; x += swide)
-            if (memcmp(_jcrnt,x+foffs,JCONT))
-              { align_contigs(b,x,swide,icrnt,(int) jcrnt,pair);
-                memcpy(_jcrnt,x+foffs,JCONT);
-                b = x;
-              }
-          align_contigs(b,x,swide,icrnt,jcrnt,pair);
+  while ((t = next_task(parm->tid,&stolen)) != NULL)
+    { if (VERBOSE || STAT_NAME != NULL)
+        clock_gettime(CLOCK_MONOTONIC,&tbeg);
+
+      align_contigs(t->beg,t->end,swide,t->icrnt,t->jcrnt,pair);
+
+      if (VERBOSE || STAT_NAME != NULL)
+        { clock_gettime(CLOCK_MONOTONIC,&tend);
+          parm->nbusy += (tend.tv_sec - tbeg.tv_sec)*1000000000ll
+                       + (tend.tv_nsec - tbeg.tv_nsec);
         }
+      parm->ntask += 1;
+      parm->nstol += stolen;
     }
 
   Free_Align_Spec(pair->spec);
   Free_Work_Data(pair->work);
   free(pair->align.aseq-1);
-  free(pair->align.bseq-1);
+  for (p = 0; p < CTG_SLOTS; p++)
+    if (pair->cache[p].buf != NULL)
+      free(pair->cache[p].buf-1);
 
   parm->nhits += pair->nhits;
   parm->nlass += pair->nlass;
   parm->nlive += pair->nlive;
   parm->nlcov += pair->nlcov;
   parm->nmemo += pair->nmemo;
+  parm->ngath += pair->ngath;
+  parm->ndecode += pair->ndecode;
+  parm->nreuse  += pair->nreuse;
   return (NULL);
 }
 
@@ -2878,60 +3488,135 @@ static int SORT_MAP(const void *x, const void *y)
     return (0);
 }
 
+  //  The alignments in ofile are sorted in pieces that fit in the thread's share of the
+  //    memory budget (-M), each piece being written back in place as a sorted run.  Equal
+  //    records stay in file order, both within a run (SORT_MAP breaks ties by address) and
+  //    across runs (la_merge breaks ties by run order), so the result is independent of the
+  //    budget.  With -ckpt the file must survive an interrupted sort, so the runs are instead
+  //    written at the same offsets of a temporary file that then replaces ofile.
+
+#define LA_BLOCK_MIN 0x100000   //  Minimum size of a sort piece or merge block
+
 static void *la_sort(void *args)
 { TP *parm = (TP *) args;
 
   FILE *fid  = parm->ofile;
   int64 novl = parm->nlive;
   int64 size = parm->nmemo;
-  
-  void     *iblock, *off;
+  FILE *out;
+
+  void     *iblock, *off, *top;
   Overlap **perm;
-  int       j;
-  
+  int64     bmax, pmax;
+  int64     beg, len, span;
+  int64     j, n;
+
+  parm->nrun = 0;
+  parm->runs = NULL;
+  parm->rmax = 0;
+
   if (novl == 0)
     return (NULL);
 
-  iblock = Malloc(size+PTR_SIZE,"Allocating overlap block");
-  perm   = Malloc(sizeof(Overlap *)*novl,"Allocating permutation array");
+  //  A piece of bmax bytes has at most bmax/EXO_SIZE records, so reserve that many pointers
+
+  bmax = ((MEM_BUDGET*1000000000ll) / NTHREADS) * EXO_SIZE / (EXO_SIZE + sizeof(Overlap *));
+  if (bmax < LA_BLOCK_MIN)
+    bmax = LA_BLOCK_MIN;
+  if (bmax > size)
+    bmax = size;
+  pmax = bmax/EXO_SIZE + 1;
+
+  iblock = Malloc(bmax+PTR_SIZE,"Allocating overlap block");
+  perm   = Malloc(sizeof(Overlap *)*pmax,"Allocating permutation array");
   if (iblock == NULL || perm == NULL)
     Clean_Exit(1);
   iblock += PTR_SIZE;
 
-  rewind(fid);
-
-  if (fread(iblock,size,1,fid) != 1)
-    { fprintf(stderr,"\n%s: Cannot not read overlap block file %s/%s.%d.las\n",
-                     Prog_Name,SORT_PATH,ALGN_UNIQ,parm->tid);
-      Clean_Exit(1);
-    }
-  
-  rewind(fid);
-    
-  off = iblock-PTR_SIZE;
-  for (j = 0; j < novl; j++)
-    { perm[j] = (Overlap *) off;
-      off += EXO_SIZE + ((Overlap *) off)->path.tlen;
+  if (CKPT_PATH == NULL)
+    out = fid;
+  else
+    { out = fopen(Catenate(SORT_PATH,"/",ALGN_UNIQ,Numbered_Suffix(".",parm->tid,".las")),"w+");
+      if (out == NULL)
+        { fprintf(stderr,"%s: Cannot open %s/%s.%d.las for reading & writing\n",
+                         Prog_Name,SORT_PATH,ALGN_UNIQ,parm->tid);
+          Clean_Exit(1);
+        }
+      unlink(Catenate(SORT_PATH,"/",ALGN_UNIQ,Numbered_Suffix(".",parm->tid,".las")));
     }
 
-  qsort(perm,novl,sizeof(Overlap *),SORT_MAP);
-
-  for (j = 0; j < novl; j++)
-    { Overlap *o = perm[j];
+  beg = 0;
+  while (beg < size)
+    { len = size-beg;
+      if (len > bmax)
+        len = bmax;
 
-      if (fwrite( ((void *) o)+PTR_SIZE, EXO_SIZE, 1, fid) != 1)
-        { fprintf(stderr,"\n%s: Cannot not write sorted overlap block file %s/%s.%d.las\n",
-                         Prog_Name,SORT_PATH,ALGN_UNIQ,parm->tid);
+      fseeko(fid,beg,SEEK_SET);
+      if (fread(iblock,len,1,fid) != 1)
+        { fprintf(stderr,"\n%s: Cannot not read overlap block file %s/%s.%d.las\n",
+                         Prog_Name,UNIQ_PATH,UNIQ_NAME,parm->tid);
           Clean_Exit(1);
         }
-      if (fwrite( (void *) (o+1), o->path.tlen, 1, fid) != 1)
-        { fprintf(stderr,"\n%s: Cannot not write sorted overlap block file %s/%s.%d.las\n",
-                         Prog_Name,SORT_PATH,ALGN_UNIQ,parm->tid);
-          Clean_Exit(1);
+
+      //  Collect the records wholly within the piece
+
+      top = iblock + len;
+      off = iblock - PTR_SIZE;
+      for (n = 0; off + PTR_SIZE + EXO_SIZE <= top; n++)
+        { span = EXO_SIZE + ((Overlap *) off)->path.tlen;
+          if (off + PTR_SIZE + span > top)
+            break;
+          if (span > parm->rmax)
+            parm->rmax = span;
+          perm[n] = (Overlap *) off;
+          off += span;
         }
-    }
 
-  rewind(fid);
+      if (n == 0)    //  A single record larger than the piece: enlarge the piece
+        { bmax  *= 2;
+          pmax   = bmax/EXO_SIZE + 1;
+          iblock = Realloc(iblock-PTR_SIZE,bmax+PTR_SIZE,"Reallocating overlap block");
+          perm   = Realloc(perm,sizeof(Overlap *)*pmax,"Reallocating permutation array");
+          if (iblock == NULL || perm == NULL)
+            Clean_Exit(1);
+          iblock += PTR_SIZE;
+          continue;
+        }
+      len = (off + PTR_SIZE) - iblock;
+
+      qsort(perm,n,sizeof(Overlap *),SORT_MAP);
+
+      fseeko(out,beg,SEEK_SET);
+      for (j = 0; j < n; j++)
+        { Overlap *o = perm[j];
+
+          if (fwrite( ((void *) o)+PTR_SIZE, EXO_SIZE, 1, out) != 1)
+            { fprintf(stderr,"\n%s: Cannot not write sorted overlap block file %s/%s.%d.las\n",
+                             Prog_Name,SORT_PATH,ALGN_UNIQ,parm->tid);
+              Clean_Exit(1);
+            }
+          if (fwrite( (void *) (o+1), o->path.tlen, 1, out) != 1)
+            { fprintf(stderr,"\n%s: Cannot not write sorted overlap block file %s/%s.%d.las\n",
+                             Prog_Name,SORT_PATH,ALGN_UNIQ,parm->tid);
+              Clean_Exit(1);
+            }
+        }
+
+      parm->runs = Realloc(parm->runs,sizeof(Run)*(parm->nrun+1),"Reallocating run list");
+      if (parm->runs == NULL)
+        Clean_Exit(1);
+      parm->runs[parm->nrun].file = out;
+      parm->runs[parm->nrun].beg  = beg;
+      parm->runs[parm->nrun].end  = beg+len;
+      parm->nrun += 1;
+
+      beg += len;
+    }
+  fflush(out);
+  if (out != fid)
+    { fclose(fid);
+      parm->ofile = out;
+    }
 
   free(perm);
   free(iblock-PTR_SIZE);
@@ -2939,9 +3624,9 @@ static void *la_sort(void *args)
   return (NULL);
 }
 
-#define MEMORY 4000   // in Mb
-
-  //  Heap sort of records according to (aread,abpos) order
+  //  Heap sort of records according to (aread,abpos,bread,comp) order.  As the alignments
+  //    of an A-contig may be in several thread files, the order must be total up to the
+  //    alignments of a single contig pair, which are always in the same file.
 
 #define MAPARE(lp,rp)				\
   if (lp->aread > rp->aread)			\
@@ -2952,6 +3637,14 @@ static void *la_sort(void *args)
     bigger = 1;					\
   else if (lp->path.abpos < rp->path.abpos)	\
     bigger = 0;					\
+  else if (lp->bread > rp->bread)		\
+    bigger = 1;					\
+  else if (lp->bread < rp->bread)		\
+    bigger = 0;					\
+  else if (COMP(lp->flags) > COMP(rp->flags))	\
+    bigger = 1;					\
+  else if (COMP(lp->flags) < COMP(rp->flags))	\
+    bigger = 0;					\
   else if (lp > rp)				\
     bigger = 1;					\
   else						\
@@ -3007,10 +3700,12 @@ static void showheap(Overlap **heap, int hsize)
 
 #endif
 
-  //  Input block data structure and block fetcher
+  //  Input block data structure and block fetcher: a block holds the next bytes of a run
 
 typedef struct
   { FILE   *stream;
+    int64   fpos;     //  file position of the next unread byte of the run
+    int64   fend;     //  file position of the end of the run
     void   *block;
     void   *ptr;
     void   *top;
@@ -3018,61 +3713,76 @@ typedef struct
   } IO_block;
 
 static void ovl_reload(IO_block *in, int64 bsize)
-{ int64 remains;
+{ int64 remains, n;
 
   remains = in->top - in->ptr;
   if (remains > 0)
     memmove(in->block, in->ptr, remains);
   in->ptr  = in->block;
   in->top  = in->block + remains;
-  in->top += fread(in->top,1,bsize-remains,in->stream);
+  n = bsize-remains;
+  if (n > in->fend - in->fpos)
+    n = in->fend - in->fpos;
+  if (n > 0)
+    { fseeko(in->stream,in->fpos,SEEK_SET);
+      n = fread(in->top,1,n,in->stream);
+      in->fpos += n;
+      in->top  += n;
+    }
+}
+
+  //  Load the header of the next record of in into ov, making sure its trace is in the
+  //    block, and return 1, or return 0 if the run is exhausted.
+
+static int ovl_next(IO_block *in, int64 bsize, Overlap *ov)
+{ if (in->ptr + EXO_SIZE > in->top)
+    { ovl_reload(in,bsize);
+      if (in->ptr + EXO_SIZE > in->top)
+        return (0);
+    }
+  *ov = *((Overlap *) (in->ptr - PTR_SIZE));
+  in->ptr += EXO_SIZE;
+  if (in->ptr + ov->path.tlen > in->top)
+    ovl_reload(in,bsize);
+  return (1);
 }
 
-static int la_merge(TP *parm)
+  //  Merge the nrun runs in run with blocks of bsize bytes, writing the merged records to
+  //    exactly one of the run file mfile, the .1aln file of, or the stream os, and adding
+  //    them to the index aix if not NULL.  Ties are broken in favor of the earlier run.
+  //    Return the number of records merged.
+
+static int64 merge_runs(Run *run, int nrun, int64 bsize,
+                        FILE *mfile, OneFile *of, Aln_Stream *os, Aln_Index *aix)
 { IO_block *in;
-  int64     bsize;
   char     *block;
-  int       i, c;
   Overlap **heap;
-  int       hsize;
   Overlap  *ovls;
-  int64     totl;
-  OneFile  *of;
-
-  //  Base level merge: Open all the input files and initialize their buffers
-
-  bsize  = (MEMORY*1000000ll)/NTHREADS;
-  block  = (char *) Malloc(bsize*NTHREADS+PTR_SIZE,"Allocating LAmerge blocks");
-  in     = (IO_block *) Malloc(sizeof(IO_block)*NTHREADS,"Allocating LAmerge IO-reacords");
-  if (block == NULL || in == NULL)
-    return (1);
+  int       hsize;
+  int64     count;
+  int       i;
+
+  block = (char *) Malloc(bsize*nrun+PTR_SIZE,"Allocating LAmerge blocks");
+  in    = (IO_block *) Malloc(sizeof(IO_block)*nrun,"Allocating LAmerge IO-records");
+  heap  = (Overlap **) Malloc(sizeof(Overlap *)*(nrun+1),"Allocating heap");
+  ovls  = (Overlap *) Malloc(sizeof(Overlap)*nrun,"Allocating heap");
+  if (block == NULL || in == NULL || heap == NULL || ovls == NULL)
+    Clean_Exit(1);
   block += PTR_SIZE;
 
-  totl = 0;
-  for (c = 0; c < NTHREADS; c++)
-    { void *iblock;
-
-      in[c].stream = parm[c].ofile;
-      in[c].block  = iblock = block+c*bsize;
-      in[c].ptr    = iblock;
-      in[c].top    = iblock + fread(iblock,1,bsize,parm[c].ofile);
-      in[c].count  = 0;
-      totl += parm[c].nlive;
-    }
-
-  //  Initialize the heap
-
-  heap = (Overlap **) Malloc(sizeof(Overlap *)*(NTHREADS+1),"Allocating heap");
-  ovls = (Overlap *) Malloc(sizeof(Overlap)*NTHREADS,"Allocating heap");
-  if (heap == NULL || ovls == NULL)
-    return (1);
+  //  Initialize the blocks and the heap
 
   hsize = 0;
-  for (i = 0; i < NTHREADS; i++)
-    { if (in[i].ptr < in[i].top)
-        { ovls[i]     = *((Overlap *) (in[i].ptr - PTR_SIZE));
-          in[i].ptr  += EXO_SIZE;
-          hsize      += 1;
+  for (i = 0; i < nrun; i++)
+    { in[i].stream = run[i].file;
+      in[i].fpos   = run[i].beg;
+      in[i].fend   = run[i].end;
+      in[i].block  = block + i*bsize;
+      in[i].ptr    = in[i].block;
+      in[i].top    = in[i].block;
+      in[i].count  = 0;
+      if (ovl_next(in+i,bsize,ovls+i))
+        { hsize      += 1;
           heap[hsize] = ovls + i;
         }
     }
@@ -3081,42 +3791,12 @@ static int la_merge(TP *parm)
     for (i = hsize/2; i > 1; i--)
       maheap(i,heap,hsize);
 
-  //  Open the output file buffer and write (novl,tspace) header
-
-  { char *db1_name;
-    char *db2_name;
-    char *cpath;
-
-    if (TYPE1 < IS_GDB && !KEEP)
-      db1_name = Strdup(SPATH1,"db1_name");
-    else
-      db1_name = Strdup(Catenate(PATH1,"/",ROOT1,GEXTN1),"db1_name");
-    if (SELF)
-      db2_name = NULL;
-    else
-      { if (TYPE2 < IS_GDB && !KEEP)
-          db2_name = Strdup(SPATH2, "db2_name");
-        else
-          db2_name = Strdup(Catenate(PATH2,"/",ROOT2,GEXTN2), "db2_name");
-      }
-    cpath = getcwd(NULL,0);
-
-    of = open_Aln_Write(Catenate(ONE_PATH,"/",ONE_ROOT,".1aln"), 1,
-                        Prog_Name, VERSION, Command_Line,
-			TSPACE, db1_name, db2_name, cpath);
-
-    free(cpath);
-    if (db2_name != NULL)
-      free(db2_name);
-    free(db1_name);
-  }
-
   //  While the heap is not empty do
 
   while (hsize > 0)
     { Overlap  *ov;
       IO_block *src;
-      int64     tsize, span;
+      int64     tsize;
 
       maheap(1,heap,hsize);
 
@@ -3126,257 +3806,933 @@ static int la_merge(TP *parm)
       src->count += 1;
 
       tsize = ov->path.tlen;
-      span  = EXO_SIZE + tsize;
-      if (src->ptr + span > src->top)
-        ovl_reload(src,bsize);
-
-      Write_Aln_Overlap (of, ov);
-      Write_Aln_Trace (of, src->ptr, tsize);
+      if (mfile != NULL)
+        { if (fwrite( ((void *) ov)+PTR_SIZE, EXO_SIZE, 1, mfile) != 1 ||
+              fwrite(src->ptr, tsize, 1, mfile) != 1)
+            { fprintf(stderr,"\n%s: Cannot write merged overlap file %s/%s.m.las\n",
+                             Prog_Name,SORT_PATH,ALGN_UNIQ);
+              Clean_Exit(1);
+            }
+        }
+      else if (os != NULL)
+        Put_Aln_Stream(os,ov,src->ptr);
+      else
+        { Write_Aln_Overlap (of, ov);
+          Write_Aln_Trace (of, src->ptr, tsize);
+        }
+      if (aix != NULL)
+        Aln_Index_Add(aix,ov->aread,ov->path.abpos,ov->path.aepos);
 
       src->ptr += tsize;
-      if (src->ptr >= src->top)
+      if ( ! ovl_next(src,bsize,ov))
         { heap[1] = heap[hsize];
           hsize  -= 1;
-          continue;
         }
-      *ov       = *((Overlap *) (src->ptr - PTR_SIZE));
-      src->ptr += EXO_SIZE;
     }
 
-  oneFileClose(of);
-
-  for (i = 0; i < NTHREADS; i++)
-    fclose(parm[i].ofile);
-
-  for (i = 0; i < NTHREADS; i++)
-    totl -= in[i].count;
-  if (totl != 0)
-    { fprintf(stderr,"%s: Did not write all records to %s/%s.1aln (%lld)\n",
-                     Prog_Name,ONE_PATH,ONE_ROOT,totl);
-      return (1);
-    }
+  count = 0;
+  for (i = 0; i < nrun; i++)
+    count += in[i].count;
 
   free(ovls);
   free(heap);
   free(in);
   free(block-PTR_SIZE);
 
-  return (0);
+  return (count);
 }
 
-static void pair_sort_search(GDB *gdb1, GDB *gdb2)
-{ uint8 *sarray;
-  int    swide;
-  int64  nels;
-
-  RP     rarm[NTHREADS];
-  TP     tarm[NTHREADS];
-#ifndef DEBUG_SORT
-  pthread_t threads[NTHREADS];
-#endif
-  int64    *panel;
-  Range     range[NTHREADS];
-
-  IOBuffer *unit[2], *nu;
-  int       nused;
-  int       i, p, j, u;
+  //  Block size for merging nrun runs within the memory budget: never more than the longest
+  //    run, and never less than bmin.
+
+static int64 merge_block(Run *run, int nrun, int64 budget, int64 bmin)
+{ int64 bsize, rlen;
+  int   i;
+
+  rlen = 0;
+  for (i = 0; i < nrun; i++)
+    if (run[i].end - run[i].beg > rlen)
+      rlen = run[i].end - run[i].beg;
+  bsize = budget / nrun;
+  if (bsize > rlen)
+    bsize = rlen;
+  if (bsize < bmin)
+    bsize = bmin;
+  return (bsize);
+}
 
-  if (VERBOSE)
-    { fprintf(stderr,"\n  Starting seed sort and alignment search, %d parts\n",2*NPARTS);
-      fflush(stderr);
+  //  Merge the sorted runs of the threads into the .1aln file of the -1 option, or if PAF
+  //    or PSL is the output format, stream the merged alignments directly to a pool of
+  //    formatting threads whose output goes to stdout in merge order.  If there are more runs
+  //    than can be merged at once with blocks of at least twice the largest record (and
+  //    LA_BLOCK_MIN) within the memory budget, then consecutive groups of runs are first
+  //    merged into longer runs in a temporary file, as many times as necessary.
+
+static int la_merge(TP *parm, GDB *gdb1, GDB *gdb2)
+{ Run        *run, *nrun;
+  int         nruns, fanin;
+  int64       budget, bmin, totl, mbytes;
+  int         i, j, c, pass;
+  FILE       *mfile, *pfile;
+  OneFile    *of;
+  Aln_Stream *os;
+  Aln_Index  *aix;
+
+  budget = MEM_BUDGET*1000000000ll;
+
+  nruns = 0;
+  bmin  = 0;
+  totl  = 0;
+  for (c = 0; c < NTHREADS; c++)
+    { nruns += parm[c].nrun;
+      if (2*parm[c].rmax > bmin)
+        bmin = 2*parm[c].rmax;
+      totl += parm[c].nlive;
     }
+  if (bmin < LA_BLOCK_MIN)
+    bmin = LA_BLOCK_MIN;
 
-  unit[0] = N_Units;
-  unit[1] = C_Units;
-
-  { int64 cum, nelmax;
+  run = Malloc(sizeof(Run)*(nruns+1),"Allocating run list");
+  if (run == NULL)
+    Clean_Exit(1);
+  nruns = 0;
+  for (c = 0; c < NTHREADS; c++)
+    { for (i = 0; i < parm[c].nrun; i++)
+        run[nruns++] = parm[c].runs[i];
+      free(parm[c].runs);
+    }
 
-    nelmax = 0;
-    for (u = 0; u < 2; u++)
-      { cum = 0;
-        nu = unit[u];
+  fanin = budget / bmin;
+  if (fanin < 2)
+    fanin = 2;
 
-        for (j = 0; j < NCONTS; j++)
-          { for (i = 0; i < NTHREADS; i++)
-              { cum += nu[i].buck[j];
-                nu[i].buck[j] = cum;
-              }
-            if (j+1 == NCONTS || Select[j] != Select[j+1])
-              { if (cum > nelmax)
-                  nelmax = cum;
-                cum = 0;
-              }
-          }
+  Stats_Count("runs",-1,nruns);
 
-        for (j = NCONTS-1; j >= 0; j--)
-          { for (i = NTHREADS-1; i >= 1; i--)
-              nu[i].buck[j] = nu[i-1].buck[j];
-            if (j == 0 || Select[j] != Select[j-1])
-              nu[0].buck[j] = 0;
-            else
-              nu[0].buck[j] = nu[NTHREADS-1].buck[j-1];
-          }
-      }
+  //  Intermediate passes
 
-    swide  = 2*DBYTE + JCONT + 2;
-    sarray = Malloc((nelmax+1)*swide,"Sort Array");
-    panel  = Malloc(NCONTS*sizeof(int64),"Bucket Array");
-    if (sarray == NULL || panel == NULL)
-      Clean_Exit(1);
-  }
+  pass   = 0;
+  pfile  = NULL;
+  mbytes = 0;
+  while (nruns > fanin)
+    { if (VERBOSE)
+        { fprintf(stderr,"    Merging %d sorted runs in groups of %d\n",nruns,fanin);
+          fflush(stderr);
+        }
 
-  for (p = 0; p < NTHREADS; p++)
-    { rarm[p].swide  = swide;
-      rarm[p].sarr   = sarray;
-      rarm[p].buffer = N_Units[p].bufr;   //  NB: Units have been transposed
-      rarm[p].range  = range+p;
-      rarm[p].gdb1   = gdb1;
-      rarm[p].gdb2   = gdb2;
+      mfile = fopen(Catenate(SORT_PATH,"/",ALGN_UNIQ,Numbered_Suffix(".m",pass,".las")),"w+");
+      if (mfile == NULL)
+        { fprintf(stderr,"%s: Cannot open %s/%s.m%d.las for reading & writing\n",
+                         Prog_Name,SORT_PATH,ALGN_UNIQ,pass);
+          Clean_Exit(1);
+        }
+      unlink(Catenate(SORT_PATH,"/",ALGN_UNIQ,Numbered_Suffix(".m",pass,".las")));
 
-      tarm[p].tid    = p;
-      tarm[p].swide  = swide;
-      tarm[p].sarr   = sarray;
-      tarm[p].panel  = panel;
-      tarm[p].range  = range+p;
+      nrun = Malloc(sizeof(Run)*((nruns-1)/fanin+1),"Allocating run list");
+      if (nrun == NULL)
+        Clean_Exit(1);
 
-      tarm[p].gdb1   = *gdb1;
-      tarm[p].gdb2   = *gdb2;
-      if (p > 0)
-        { tarm[p].gdb1.seqs = fopen(gdb1->seqpath,"r");
-          if (tarm[p].gdb1.seqs == NULL)
-            { fprintf(stderr,"%s: Cannot open another copy of GDB\n",Prog_Name);
-              Clean_Exit(1);
-            }
-          tarm[p].gdb2.seqs = fopen(gdb2->seqpath,"r");
-          if (tarm[p].gdb2.seqs == NULL)
-            { fprintf(stderr,"%s: Cannot open another copy of GDB\n",Prog_Name);
-              Clean_Exit(1);
-            }
+      j = 0;
+      for (i = 0; i < nruns; i += fanin)
+        { c = nruns-i;
+          if (c > fanin)
+            c = fanin;
+          nrun[j].file = mfile;
+          nrun[j].beg  = ftello(mfile);
+          merge_runs(run+i,c,merge_block(run+i,c,budget,bmin),mfile,NULL,NULL,NULL);
+          nrun[j].end  = ftello(mfile);
+          j += 1;
         }
+      fflush(mfile);
+      mbytes += ftello(mfile);
+
+      if (pfile != NULL)
+        fclose(pfile);
+      pfile = mfile;
+      free(run);
+      run   = nrun;
+      nruns = j;
+      pass += 1;
+    }
 
-      tarm[p].nhits = 0;
-      tarm[p].nlass = 0;
-      tarm[p].nlive = 0;
-      tarm[p].nlcov = 0;
-      tarm[p].nmemo = 0;
+  Stats_Count("merge_passes",-1,pass);
+  Stats_Count("tmp_written",-1,mbytes);
+  Stats_Count("tmp_read",-1,mbytes);
 
-      tarm[p].ofile = fopen(Catenate(SORT_PATH,"/",ALGN_UNIQ,Numbered_Suffix(".",p,".las")),"w+");
-      if (tarm[p].ofile == NULL)
-        { fprintf(stderr,"%s: Cannot open %s/%s.%d.las for writing\n",
-                         Prog_Name,SORT_PATH,ALGN_UNIQ,p);
-          Clean_Exit(1);
-        }
-      unlink(Catenate(SORT_PATH,"/",ALGN_UNIQ,Numbered_Suffix(".",p,".las")));
+  //  Open the output stream, or the output file buffer and write (novl,tspace) header
 
-      tarm[p].tfile = fopen(Catenate(SORT_PATH,"/",ALGN_PAIR,Numbered_Suffix(".",p,".las")),"w+");
-      if (tarm[p].tfile == NULL)
-        { fprintf(stderr,"%s: Cannot open %s/%s.%d.las for reading & writing\n",
-                         Prog_Name,SORT_PATH,ALGN_PAIR,p);
-          Clean_Exit(1);
+  of  = NULL;
+  os  = NULL;
+  aix = NULL;
+  if (OUT_TYPE != 2)
+    { if (OUT_TYPE == 0)
+        { Trim_GDB_Headers(gdb1);
+          if (gdb2 != gdb1)
+            Trim_GDB_Headers(gdb2);
         }
-      unlink(Catenate(SORT_PATH,"/",ALGN_PAIR,Numbered_Suffix(".",p,".las")));
+      os = Open_Aln_Stream(gdb1,gdb2,OUT_TYPE==1?PSL_OUT:OUT_OPT,TSPACE,NTHREADS,stdout,0);
+      if (os == NULL)
+        return (1);
     }
+  else
+    { char *db1_name;
+      char *db2_name;
+      char *cpath;
 
-  for (u = 0; u < 2; u++)
-   for (i = 0; i < NPARTS; i++)
-    { nu = unit[u] + i*NTHREADS;
-
-      if (VERBOSE)
-        { fprintf(stderr,"\r    Loading seeds for part %d  ",u*NPARTS+i+1);
-          fflush(stderr);
+      if (TYPE1 < IS_GDB && !KEEP)
+        db1_name = Strdup(SPATH1,"db1_name");
+      else
+        db1_name = Strdup(Catenate(PATH1,"/",ROOT1,GEXTN1),"db1_name");
+      if (SELF)
+        db2_name = NULL;
+      else
+        { if (TYPE2 < IS_GDB && !KEEP)
+            db2_name = Strdup(SPATH2, "db2_name");
+          else
+            db2_name = Strdup(Catenate(PATH2,"/",ROOT2,GEXTN2), "db2_name");
         }
+      cpath = getcwd(NULL,0);
 
-      for (p = 0; p < NTHREADS; p++)
-        { rarm[p].in = nu[p].file;
-          lseek(nu[p].file,0,SEEK_SET);
-          rarm[p].buck = nu[p].buck;
-          rarm[p].comp = u;
-          rarm[p].inum = nu[p].inum;
+      of = open_Aln_Write(Catenate(ONE_PATH,"/",ONE_ROOT,".1aln"), 1,
+                          Prog_Name, VERSION, Command_Line,
+                          TSPACE, db1_name, db2_name, cpath);
+
+      free(cpath);
+      if (db2_name != NULL)
+        free(db2_name);
+      free(db1_name);
+
+      if (OUT_OPT == 2)
+        { os = Open_Aln_Writer(gdb1,gdb2,TSPACE,NTHREADS,of);
+          if (os == NULL)
+            return (1);
         }
 
-#ifdef DEBUG_SORT
-      for (p = 0; p < NTHREADS; p++)
-        reimport_thread(rarm+p);
-#else
-      for (p = 1; p < NTHREADS; p++)
-        pthread_create(threads+p,NULL,reimport_thread,rarm+p);
-      reimport_thread(rarm);
-      for (p = 1; p < NTHREADS; p++)
-        pthread_join(threads[p],NULL);
-#endif
+      aix = Aln_Index_Start();
+      if (aix == NULL)
+        return (1);
+    }
+
+  //  Final pass
+
+  if (nruns > 0)
+    totl -= merge_runs(run,nruns,merge_block(run,nruns,budget,bmin),NULL,of,os,aix);
+
+  if (os != NULL)
+    Stats_Count(OUT_TYPE==2?"cigar_bytes":"output_bytes",-1,Close_Aln_Stream(os));
+  if (of != NULL)
+    oneFileClose(of);
+  if (aix != NULL)
+    { if (Aln_Index_Write(aix,Catenate(ONE_PATH,"/",ONE_ROOT,".1aln")))
+        return (1);
+      Aln_Index_Free(aix);
+    }
+
+  if (pfile != NULL)
+    fclose(pfile);
+  for (i = 0; i < NTHREADS; i++)
+    fclose(parm[i].ofile);
+  free(run);
+
+  if (totl != 0)
+    { if (OUT_TYPE != 2)
+        fprintf(stderr,"%s: Did not output all alignment records (%lld)\n",Prog_Name,totl);
+      else
+        fprintf(stderr,"%s: Did not write all records to %s/%s.1aln (%lld)\n",
+                       Prog_Name,ONE_PATH,ONE_ROOT,totl);
+      return (1);
+    }
+
+  return (0);
+}
+
+/***********************************************************************************************
+ *
+ *   CHECKPOINTS:
+ *     With -ckpt:<dir> the seed pair files and the per-thread alignment files are kept in
+ *     <dir> rather than being unlinked in SORT_PATH, along with the contig counts of the seed
+ *     pairs (file "bucks"), and a text "manifest" that records the phases completed.  The
+ *     manifest begins with a signature of every parameter that affects the intermediates and
+ *     hashes of the GDB and GIX stub of each source.  A rerun with the same signature skips
+ *     the completed phases: after CKPT_MERGED it re-sorts and searches the kept seed pairs,
+ *     and after CKPT_SEARCHED (when the seed pair files are removed) it only sorts and merges
+ *     the kept alignments.  A different signature discards the checkpoint.  Each phase's
+ *     files are synced before the manifest (written to a temporary and renamed) says so.
+ *     The checkpoint is removed when a run completes.
+ *
+ **********************************************************************************************/
+
+#define CKPT_NONE     0   //  Nothing kept
+#define CKPT_MERGED   1   //  Seed pair files and their contig counts
+#define CKPT_SEARCHED 2   //  Alignment files and their record & byte counts
+
+static int    CKPT_LEVEL;   //  Phases completed as of the start of this run
+static char  *Ckpt_Sign;    //  Signature line of this run
+static int64 *Ckpt_Live;    //  # of alignments in, and bytes of, each thread's alignment file
+static int64 *Ckpt_Memo;    //    if CKPT_LEVEL = CKPT_SEARCHED
+
+  //  64-bit FNV-1a hash of the contents of file path, continuing from h
+
+static uint64 ckpt_hash(char *path, uint64 h)
+{ uint8 *buf;
+  int64  n, i;
+  int    f;
+
+  f = open(path,O_RDONLY);
+  if (f < 0)
+    { fprintf(stderr,"%s: Cannot open %s to fingerprint it\n",Prog_Name,path);
+      Clean_Exit(1);
+    }
+  buf = Malloc(0x100000,"Allocating hash buffer");
+  if (buf == NULL)
+    Clean_Exit(1);
+  while ((n = read(f,buf,0x100000)) > 0)
+    for (i = 0; i < n; i++)
+      { h ^= buf[i];
+        h *= 0x100000001b3ll;
+      }
+  free(buf);
+  close(f);
+  if (n < 0)
+    { fprintf(stderr,"%s: IO error reading %s to fingerprint it\n",Prog_Name,path);
+      Clean_Exit(1);
+    }
+  return (h);
+}
+
+static void ckpt_write(int level)
+{ char *name, *tmp;
+  FILE *f;
+  int   p;
+
+  name = Strdup(Catenate(CKPT_PATH,"/","manifest",""),"Allocating manifest name");
+  tmp  = Strdup(Catenate(CKPT_PATH,"/","manifest",".tmp"),"Allocating manifest name");
+  if (name == NULL || tmp == NULL)
+    Clean_Exit(1);
+
+  f = fopen(tmp,"w");
+  if (f == NULL)
+    { fprintf(stderr,"%s: Cannot open checkpoint manifest %s for writing\n",Prog_Name,tmp);
+      Clean_Exit(1);
+    }
+  fprintf(f,"%s\n",Ckpt_Sign);
+  fprintf(f,"level %d\n",level);
+  if (level == CKPT_SEARCHED)
+    for (p = 0; p < NTHREADS; p++)
+      fprintf(f,"thread %d %lld %lld\n",p,Ckpt_Live[p],Ckpt_Memo[p]);
+  if (fflush(f) != 0 || fsync(fileno(f)) < 0 || fclose(f) != 0 || rename(tmp,name) < 0)
+    { fprintf(stderr,"%s: Cannot write checkpoint manifest %s\n",Prog_Name,name);
+      Clean_Exit(1);
+    }
+
+  free(tmp);
+  free(name);
+}
+
+  //  Form the signature of this run and set CKPT_LEVEL to the phases a previous run with the
+  //    same signature completed, starting a fresh checkpoint if there is none.
+
+static void ckpt_open()
+{ uint64 h1, h2;
+  char   line[1000];
+  FILE  *f;
+  int    p, t, level;
+
+  h1 = ckpt_hash(Catenate(PATH1,"/",ROOT1,GEXTN1),0xcbf29ce484222325ll);
+  h1 = ckpt_hash(Catenate(PATH1,"/",ROOT1,".gix"),h1);
+  if (SELF)
+    h2 = 0;
+  else
+    { h2 = ckpt_hash(Catenate(PATH2,"/",ROOT2,GEXTN2),0xcbf29ce484222325ll);
+      h2 = ckpt_hash(Catenate(PATH2,"/",ROOT2,".gix"),h2);
+    }
+
+  sprintf(line,"FastGA %s k%d f%d T%d c%d s%d l%d i%g z%d self%d shard%d/%d %016llx %016llx",
+               VERSION,KMER,FREQ,NTHREADS,CHAIN_MIN,CHAIN_BREAK,ALIGN_MIN,ALIGN_RATE,
+               ZIP_SEEDS,SELF,SHARD+1,NSHARDS,h1,h2);
+  Ckpt_Sign = Strdup(line,"Allocating checkpoint signature");
+  Ckpt_Live = Malloc(2*NTHREADS*sizeof(int64),"Allocating checkpoint counts");
+  if (Ckpt_Sign == NULL || Ckpt_Live == NULL)
+    Clean_Exit(1);
+  Ckpt_Memo = Ckpt_Live + NTHREADS;
+
+  CKPT_LEVEL = CKPT_NONE;
+  f = fopen(Catenate(CKPT_PATH,"/","manifest",""),"r");
+  if (f != NULL)
+    { if (fgets(line,1000,f) != NULL && strncmp(line,Ckpt_Sign,strlen(Ckpt_Sign)) == 0
+                                     && line[strlen(Ckpt_Sign)] == '\n'
+                                     && fscanf(f,"level %d\n",&level) == 1)
+        { for (p = 0; p < NTHREADS && level == CKPT_SEARCHED; p++)
+            if (fscanf(f,"thread %d %lld %lld\n",&t,Ckpt_Live+p,Ckpt_Memo+p) != 3 || t != p)
+              level = CKPT_MERGED;
+          CKPT_LEVEL = level;
+        }
+      else
+        fprintf(stderr,"%s: Checkpoint in %s is for another comparison, starting afresh\n",
+                       Prog_Name,CKPT_PATH);
+      fclose(f);
+    }
+
+  if (CKPT_LEVEL == CKPT_NONE)
+    ckpt_write(CKPT_NONE);
+  else if (VERBOSE)
+    { fprintf(stderr,"\n  Resuming from checkpoint %s, %s\n",CKPT_PATH,
+                     CKPT_LEVEL == CKPT_MERGED ? "seeds merged" : "alignments found");
+      fflush(stderr);
+    }
+}
+
+  //  The seed pairs are all in their files: save the contig counts and record the phase
+
+static void ckpt_merged(int64 *bucks)
+{ char *name;
+  int   f, k;
+
+  for (k = 0; k < NPARTS*NTHREADS; k++)
+    if (fsync(N_Units[k].file) < 0 || fsync(C_Units[k].file) < 0)
+      { fprintf(stderr,"%s: Cannot sync seed pair files in %s\n",Prog_Name,CKPT_PATH);
+        Clean_Exit(1);
+      }
+
+  name = Catenate(CKPT_PATH,"/","bucks","");
+  f = open(name,O_WRONLY|O_CREAT|O_TRUNC,S_IRWXU);
+  if (f < 0 || write(f,bucks,2*NTHREADS*NCONTS*sizeof(int64)) < 0 || fsync(f) < 0)
+    { fprintf(stderr,"%s: Cannot write checkpoint file %s\n",Prog_Name,name);
+      Clean_Exit(1);
+    }
+  close(f);
+
+  ckpt_write(CKPT_MERGED);
+}
+
+  //  Restore the contig counts of the seed pairs of a previous run
+
+static void ckpt_bucks(int64 *bucks)
+{ char *name;
+  int64 len;
+  int   f;
+
+  len  = 2*NTHREADS*NCONTS*sizeof(int64);
+  name = Catenate(CKPT_PATH,"/","bucks","");
+  f = open(name,O_RDONLY);
+  if (f < 0 || read(f,bucks,len) != len)
+    { fprintf(stderr,"%s: Cannot read checkpoint file %s\n",Prog_Name,name);
+      Clean_Exit(1);
+    }
+  close(f);
+}
+
+  //  The alignments are all in their files: record their counts and the phase, after which
+  //    the seed pair files are no longer needed
+
+static void ckpt_searched(TP *tarm)
+{ int p, k;
+
+  for (p = 0; p < NTHREADS; p++)
+    { if (fflush(tarm[p].ofile) != 0 || fsync(fileno(tarm[p].ofile)) < 0)
+        { fprintf(stderr,"%s: Cannot sync alignment files in %s\n",Prog_Name,CKPT_PATH);
+          Clean_Exit(1);
+        }
+      Ckpt_Live[p] = tarm[p].nlive;
+      Ckpt_Memo[p] = tarm[p].nmemo;
+    }
+
+  ckpt_write(CKPT_SEARCHED);
+
+  for (k = 0; k < NPARTS*NTHREADS; k++)
+    { unlink(Catenate(PAIR_PATH,"/",PAIR_NAME,Numbered_Suffix(".",k,".N")));
+      unlink(Catenate(PAIR_PATH,"/",PAIR_NAME,Numbered_Suffix(".",k,".C")));
+    }
+}
+
+  //  The run is complete: remove the checkpoint
+
+static void ckpt_done()
+{ int k;
+
+  for (k = 0; k < NPARTS*NTHREADS; k++)
+    { unlink(Catenate(PAIR_PATH,"/",PAIR_NAME,Numbered_Suffix(".",k,".N")));
+      unlink(Catenate(PAIR_PATH,"/",PAIR_NAME,Numbered_Suffix(".",k,".C")));
+    }
+  for (k = 0; k < NTHREADS; k++)
+    unlink(Catenate(UNIQ_PATH,"/",UNIQ_NAME,Numbered_Suffix(".",k,".las")));
+  unlink(Catenate(CKPT_PATH,"/","bucks",""));
+  unlink(Catenate(CKPT_PATH,"/","manifest",""));
+
+  free(Ckpt_Live);
+  free(Ckpt_Sign);
+}
+
+  //  The seeds of a part are loaded and sorted into a "stage", i.e. a sort array and its
+  //    panel and thread ranges.  If two stages fit in the memory budget (-M) then the
+  //    next part is loaded and sorted by a separate thread while the current part is searched.
+
+typedef struct
+  { int       part;    //  part to load, in [0,2*NPARTS)
+    int       swide;
+    uint8    *sarr;
+    int64    *panel;
+    Range    *range;
+    int       nused;   //  # of ranges rmsd_sort divided the part into
+    int       verbose; //  output progress (only if not pipelined)
+    RP       *rarm;
+    int64     nload;   //  nanosecs spent reimporting seeds (if -stats)
+    int64     nsort;   //  nanosecs spent sorting seeds (if -stats)
+  } Stage;
+
+static int64 nano_diff(struct timespec *beg, struct timespec *end)
+{ return ((end->tv_sec - beg->tv_sec)*1000000000ll + (end->tv_nsec - beg->tv_nsec)); }
+
+static void *load_part(void *args)
+{ Stage *stage = (Stage *) args;
+  int    swide = stage->swide;
+  int64 *panel = stage->panel;
+  RP    *rarm  = stage->rarm;
+  int    u     = stage->part / NPARTS;
+  int    i     = stage->part % NPARTS;
+#ifndef DEBUG_SORT
+  pthread_t threads[NTHREADS];
+#endif
+
+  IOBuffer *nu;
+  int64     nels;
+  int       p, j;
+  struct timespec tbeg, tmid, tend;
+
+  if (stage->verbose)
+    { fprintf(stderr,"\r    Loading seeds for part %d  ",stage->part+1);
+      fflush(stderr);
+    }
+
+  if (STAT_NAME != NULL)
+    clock_gettime(CLOCK_MONOTONIC,&tbeg);
+
+  if (u == 0)
+    nu = N_Units + i*NTHREADS;
+  else
+    nu = C_Units + i*NTHREADS;
+
+  for (p = 0; p < NTHREADS; p++)
+    { rarm[p].in    = nu[p].file;
+      lseek(nu[p].file,0,SEEK_SET);
+      rarm[p].buck  = nu[p].buck;
+      rarm[p].comp  = u;
+      rarm[p].inum  = nu[p].inum;
+      rarm[p].sarr  = stage->sarr;
+      rarm[p].range = stage->range+p;
+    }
 
 #ifdef DEBUG_SORT
+  for (p = 0; p < NTHREADS; p++)
+    reimport_thread(rarm+p);
+#else
+  for (p = 1; p < NTHREADS; p++)
+    pthread_create(threads+p,NULL,reimport_thread,rarm+p);
+  reimport_thread(rarm);
+  for (p = 1; p < NTHREADS; p++)
+    pthread_join(threads[p],NULL);
+#endif
+
+#ifdef DEBUG_SORT
+  for (p = 0; p < NTHREADS; p++)
+    printf("  %d",nu[p].file);
+  printf("\n");
+  for (j = 0; j < NCONTS; j++)
+    { printf(" %4d:",j);
       for (p = 0; p < NTHREADS; p++)
-        printf("  %d",nu[p].file);
+        printf(" %10lld",nu[p].buck[j]);
       printf("\n");
-      for (j = 0; j < NCONTS; j++)
-        { printf(" %4d:",j);
-          for (p = 0; p < NTHREADS; p++)
-            printf(" %10lld",unit[u][p].buck[j]);
-          printf("\n");
-        }
-     fflush(stdout);
+    }
+ fflush(stdout);
 #endif
 
-      { int64 prev, next;
+  { int64 prev, next;
 
-        bzero(panel,sizeof(int64)*NCONTS);
-        prev = 0;
-        next = 0;
-        for (j = IDBsplit[i]; j < IDBsplit[i+1]; j++)
-          { next = nu[NTHREADS-1].buck[j];
-            panel[j] = (next - prev)*swide;
-            prev = next;
-          }
-        nels = next;
+    bzero(panel,sizeof(int64)*NCONTS);
+    prev = 0;
+    next = 0;
+    for (j = IDBsplit[i]; j < IDBsplit[i+1]; j++)
+      { next = nu[NTHREADS-1].buck[j];
+        panel[j] = (next - prev)*swide;
+        prev = next;
+      }
+    nels = next;
+  }
+
+#ifdef DEBUG_SORT
+  for (p = 0; p < NCONTS; p++)
+    if (panel[p] > 0)
+      printf(" %2d(%2d): %10lld %10lld\n",p,Perm1[p],panel[p],panel[p]/swide);
+#endif
+
+  if (stage->verbose)
+    { fprintf(stderr,"\r    Sorting seeds for part %d  ",stage->part+1);
+      fflush(stderr);
+    }
+
+  if (STAT_NAME != NULL)
+    clock_gettime(CLOCK_MONOTONIC,&tmid);
+
+  stage->nused = rmsd_sort(stage->sarr,nels,swide,swide-2,NCONTS,panel,NTHREADS,stage->range);
+
+  if (STAT_NAME != NULL)
+    { clock_gettime(CLOCK_MONOTONIC,&tend);
+      stage->nload += nano_diff(&tbeg,&tmid);
+      stage->nsort += nano_diff(&tmid,&tend);
+    }
 
 #ifdef DEBUG_SORT
-        for (p = 0; p < NCONTS; p++)
-          if (panel[p] > 0)
-            printf(" %2d(%2d): %10lld %10lld\n",p,Perm1[p],panel[p],panel[p]/swide);
+  print_seeds(stage->sarr,swide,stage->range,panel,rarm->gdb1,rarm->gdb2,u);
+#endif
+
+  return (NULL);
+}
+
+  //  Sort the alignments found by each thread and merge them into the output
+
+static void sort_merge_alignments(TP *tarm, GDB *gdb1, GDB *gdb2)
+{ pthread_t threads[NTHREADS];
+  int       p;
+
+  if (VERBOSE)
+    { if (OUT_TYPE == 2 && OUT_OPT == 2)
+        fprintf(stderr,"\n  Sorting and merging alignments, adding their CIGAR strings\n");
+      else if (OUT_TYPE == 2)
+        fprintf(stderr,"\n  Sorting and merging alignments\n");
+      else
+        fprintf(stderr,"\n  Sorting and merging alignments, streaming them out in %s-format\n",
+                       OUT_TYPE==0?"PAF":"PSL");
+      fflush(stderr);
+    }
+
+#ifdef DEBUG_LASORT
+  for (p = 0; p < NTHREADS; p++)
+    la_sort(tarm+p);
+#else
+  for (p = 1; p < NTHREADS; p++)
+    pthread_create(threads+p,NULL,la_sort,tarm+p);
+  la_sort(tarm);
+  for (p = 1; p < NTHREADS; p++)
+    pthread_join(threads[p],NULL);
 #endif
 
-        if (VERBOSE)
-          { fprintf(stderr,"\r    Sorting seeds for part %d  ",u*NPARTS+i+1);
-            fflush(stderr);
-          }
+  if (STAT_NAME != NULL)
+    { Stats_End();
+      Stats_Begin("la_merge");
+    }
+
+  if (la_merge(tarm,gdb1,gdb2))
+    Clean_Exit(1);
+}
+
+  //  Resume a run whose checkpoint holds all the alignments: just sort & merge them
+
+static void resume_alignments(GDB *gdb1, GDB *gdb2)
+{ TP  tarm[NTHREADS];
+  int p;
+
+  Stats_Begin("la_sort");
+  for (p = 0; p < NTHREADS; p++)
+    { tarm[p].tid   = p;
+      tarm[p].nlive = Ckpt_Live[p];
+      tarm[p].nmemo = Ckpt_Memo[p];
+      tarm[p].ofile = fopen(Catenate(UNIQ_PATH,"/",UNIQ_NAME,Numbered_Suffix(".",p,".las")),"r+");
+      if (tarm[p].ofile == NULL)
+        { fprintf(stderr,"%s: Cannot open %s/%s.%d.las for reading\n",
+                         Prog_Name,UNIQ_PATH,UNIQ_NAME,p);
+          Clean_Exit(1);
+        }
+      Stats_Count("tmp_read",-1,tarm[p].nmemo);
+      Stats_Count("tmp_written",-1,tarm[p].nmemo);
+    }
+
+  sort_merge_alignments(tarm,gdb1,gdb2);
+}
+
+static void pair_sort_search(GDB *gdb1, GDB *gdb2)
+{ int    swide;
+  int64  nelmax;
+
+  RP     rarm[NTHREADS];
+  TP     tarm[NTHREADS];
+  pthread_t threads[NTHREADS];
+
+  Stage     stage[2];
+  Range     range[2][NTHREADS];
+  int       nstage;
+
+  IOBuffer *unit[2], *nu;
+  int       i, p, j, u, s;
+  int64     nwall;
+
+  if (VERBOSE)
+    { fprintf(stderr,"\n  Starting seed sort and alignment search, %d parts\n",2*NPARTS);
+      fflush(stderr);
+    }
+
+  unit[0] = N_Units;
+  unit[1] = C_Units;
+
+  { int64 cum;
+
+    nelmax = 0;
+    for (u = 0; u < 2; u++)
+      { cum = 0;
+        nu = unit[u];
+
+        for (j = 0; j < NCONTS; j++)
+          { for (i = 0; i < NTHREADS; i++)
+              { cum += nu[i].buck[j];
+                nu[i].buck[j] = cum;
+              }
+            if (j+1 == NCONTS || Select[j] != Select[j+1])
+              { if (cum > nelmax)
+                  nelmax = cum;
+                cum = 0;
+              }
+          }
+
+        for (j = NCONTS-1; j >= 0; j--)
+          { for (i = NTHREADS-1; i >= 1; i--)
+              nu[i].buck[j] = nu[i-1].buck[j];
+            if (j == 0 || Select[j] != Select[j-1])
+              nu[0].buck[j] = 0;
+            else
+              nu[0].buck[j] = nu[NTHREADS-1].buck[j-1];
+          }
+      }
+
+    swide = 2*DBYTE + JCONT + 2;
+
+#if defined(DEBUG_SORT) || defined(DEBUG_SEARCH) || defined(DEBUG_HIT) || defined(DEBUG_ALIGN)
+    nstage = 1;
+#else
+    if (2*(nelmax+1)*swide <= MEM_BUDGET*1000000000ll)
+      nstage = 2;
+    else
+      nstage = 1;
+#endif
+
+    if (VERBOSE)
+      { if (nstage == 2)
+          fprintf(stderr,"    Overlapping sort & search with 2 sort arrays of %.1fGB each\n",
+                         ((nelmax+1)*swide)/1e9);
+        else
+          fprintf(stderr,"    Sort & search in sequence, 2 sort arrays of %.1fGB exceed -M%d\n",
+                         ((nelmax+1)*swide)/1e9,MEM_BUDGET);
+        fflush(stderr);
+      }
+
+    for (s = 0; s < nstage; s++)
+      { stage[s].swide   = swide;
+        stage[s].sarr    = Malloc((nelmax+1)*swide,"Sort Array");
+        stage[s].panel   = Malloc(NCONTS*sizeof(int64),"Bucket Array");
+        stage[s].range   = range[s];
+        stage[s].rarm    = rarm;
+        stage[s].verbose = (VERBOSE && nstage == 1);
+        stage[s].nload   = 0;
+        stage[s].nsort   = 0;
+        if (stage[s].sarr == NULL || stage[s].panel == NULL)
+          Clean_Exit(1);
+      }
+
+    Queues = Malloc(NTHREADS*sizeof(Deque),"Task Deques");
+    if (Queues == NULL)
+      Clean_Exit(1);
+    for (p = 0; p < NTHREADS; p++)
+      { pthread_mutex_init(&(Queues[p].lock),NULL);
+        Queues[p].task = NULL;
+        Queues[p].max  = 0;
+      }
+    nwall = 0;
+  }
+
+  for (p = 0; p < NTHREADS; p++)
+    { rarm[p].swide  = swide;
+      rarm[p].buffer = N_Units[p].bufr;   //  NB: Units have been transposed
+      rarm[p].gdb1   = gdb1;
+      rarm[p].gdb2   = gdb2;
+
+      tarm[p].tid    = p;
+      tarm[p].swide  = swide;
+
+      tarm[p].gdb1   = *gdb1;     //  The bases are normally mapped (see open_gdb) and shared
+      tarm[p].gdb2   = *gdb2;
+      if (p > 0 && gdb1->seqstate == EXTERNAL)
+        { tarm[p].gdb1.seqs = fopen(gdb1->seqpath,"r");
+          if (tarm[p].gdb1.seqs == NULL)
+            { fprintf(stderr,"%s: Cannot open another copy of GDB\n",Prog_Name);
+              Clean_Exit(1);
+            }
+        }
+      if (p > 0 && gdb2->seqstate == EXTERNAL)
+        { tarm[p].gdb2.seqs = fopen(gdb2->seqpath,"r");
+          if (tarm[p].gdb2.seqs == NULL)
+            { fprintf(stderr,"%s: Cannot open another copy of GDB\n",Prog_Name);
+              Clean_Exit(1);
+            }
+        }
+
+      tarm[p].nhits = 0;
+      tarm[p].nlass = 0;
+      tarm[p].nlive = 0;
+      tarm[p].nlcov = 0;
+      tarm[p].nmemo = 0;
+      tarm[p].ngath = 0;
+      tarm[p].ndecode = 0;
+      tarm[p].nreuse  = 0;
+      tarm[p].ntask = 0;
+      tarm[p].nstol = 0;
+      tarm[p].nbusy = 0;
+
+      tarm[p].ofile = fopen(Catenate(UNIQ_PATH,"/",UNIQ_NAME,Numbered_Suffix(".",p,".las")),"w+");
+      if (tarm[p].ofile == NULL)
+        { fprintf(stderr,"%s: Cannot open %s/%s.%d.las for writing\n",
+                         Prog_Name,UNIQ_PATH,UNIQ_NAME,p);
+          Clean_Exit(1);
+        }
+      if (CKPT_PATH == NULL)
+        unlink(Catenate(UNIQ_PATH,"/",UNIQ_NAME,Numbered_Suffix(".",p,".las")));
+
+      tarm[p].tfile = fopen(Catenate(SORT_PATH,"/",ALGN_PAIR,Numbered_Suffix(".",p,".las")),"w+");
+      if (tarm[p].tfile == NULL)
+        { fprintf(stderr,"%s: Cannot open %s/%s.%d.las for reading & writing\n",
+                         Prog_Name,SORT_PATH,ALGN_PAIR,p);
+          Clean_Exit(1);
+        }
+      unlink(Catenate(SORT_PATH,"/",ALGN_PAIR,Numbered_Suffix(".",p,".las")));
+    }
+
+  if (nstage == 2)
+    { stage[0].part = 0;
+      load_part(stage);
+    }
 
-        nused = rmsd_sort(sarray,nels,swide,swide-2,NCONTS,panel,NTHREADS,range);
+  for (i = 0; i < 2*NPARTS; i++)
+    { Stage    *cur;
+      pthread_t loader;
 
-#ifdef DEBUG_SORT
-        print_seeds(sarray,swide,range,panel,gdb1,gdb2,u);
-#endif
-      }
+      if (nstage == 1)
+        { cur = stage;
+          cur->part = i;
+          load_part(cur);
+        }
+      else
+        { cur = stage + (i&0x1);
+          if (i+1 < 2*NPARTS)
+            { stage[(i+1)&0x1].part = i+1;
+              pthread_create(&loader,NULL,load_part,stage+((i+1)&0x1));
+            }
+        }
 
       if (VERBOSE)
-        { fprintf(stderr,"\r    Searching seeds for part %d",u*NPARTS+i+1);
+        { fprintf(stderr,"\r    Searching seeds for part %d",i+1);
           fflush(stderr);
         }
 
-      for (p = 0; p < nused; p++)
-        tarm[p].comp = u;
+      for (p = 0; p < NTHREADS; p++)
+        { tarm[p].comp  = i / NPARTS;
+          tarm[p].sarr  = cur->sarr;
+          tarm[p].panel = cur->panel;
+          tarm[p].range = cur->range+p;
+          Queues[p].top = Queues[p].bot = 0;
+        }
 
 #if defined(DEBUG_SORT) || defined(DEBUG_SEARCH) || defined(DEBUG_HIT) || defined(DEBUG_ALIGN)
-      for (p = 0; p < nused; p++)
+      for (p = 0; p < cur->nused; p++)
+        find_runs(tarm+p);
+      for (p = 0; p < NTHREADS; p++)
         search_seeds(tarm+p);
 #else
-      for (p = 1; p < nused; p++)
-        pthread_create(threads+p,NULL,search_seeds,tarm+p);
-      search_seeds(tarm);
-      for (p = 1; p < nused; p++)
+      for (p = 1; p < cur->nused; p++)
+        pthread_create(threads+p,NULL,find_runs,tarm+p);
+      find_runs(tarm);
+      for (p = 1; p < cur->nused; p++)
         pthread_join(threads[p],NULL);
+
+      { struct timespec tbeg, tend;
+
+        if (VERBOSE || STAT_NAME != NULL)
+          clock_gettime(CLOCK_MONOTONIC,&tbeg);
+
+        for (p = 1; p < NTHREADS; p++)
+          pthread_create(threads+p,NULL,search_seeds,tarm+p);
+        search_seeds(tarm);
+        for (p = 1; p < NTHREADS; p++)
+          pthread_join(threads[p],NULL);
+
+        if (VERBOSE || STAT_NAME != NULL)
+          { clock_gettime(CLOCK_MONOTONIC,&tend);
+            nwall += nano_diff(&tbeg,&tend);
+          }
+      }
 #endif
+
+      if (nstage == 2 && i+1 < 2*NPARTS)
+        pthread_join(loader,NULL);
+    }
+
+  for (p = 0; p < NTHREADS; p++)
+    { pthread_mutex_destroy(&(Queues[p].lock));
+      free(Queues[p].task);
+    }
+  free(Queues);
+  if (STAT_NAME != NULL)
+    { int64 nload, nsort, nmemo, ngath;
+
+      nload = nsort = 0;
+      for (s = 0; s < nstage; s++)
+        { nload += stage[s].nload;
+          nsort += stage[s].nsort;
+        }
+      Stats_Count("parts",-1,2*NPARTS);
+      Stats_Count("sort_arrays",-1,nstage);
+      Stats_Count("sort_array_bytes",-1,(nelmax+1)*swide);
+      Stats_Count("reimport_wall",-1,nload/1e9);
+      Stats_Count("rmsd_sort_wall",-1,nsort/1e9);
+      Stats_Count("search_wall",-1,nwall/1e9);
+
+      nmemo = ngath = 0;
+      for (p = 0; p < NTHREADS; p++)
+        { Stats_Count("tasks",p,tarm[p].ntask);
+          Stats_Count("stolen",p,tarm[p].nstol);
+          Stats_Count("busy",p,tarm[p].nbusy/1e9);
+          Stats_Count("idle",p,(nwall-tarm[p].nbusy)/1e9);
+          Stats_Count("hits",p,tarm[p].nhits);
+          Stats_Count("alns",p,tarm[p].nlass);
+          Stats_Count("alns_kept",p,tarm[p].nlive);
+          Stats_Count("hits",-1,tarm[p].nhits);
+          Stats_Count("alns",-1,tarm[p].nlass);
+          Stats_Count("alns_kept",-1,tarm[p].nlive);
+          Stats_Count("aln_coverage",-1,tarm[p].nlcov);
+          Stats_Count("contig_decodes",-1,tarm[p].ndecode);
+          Stats_Count("contig_reuses",-1,tarm[p].nreuse);
+          nmemo += tarm[p].nmemo;
+          ngath += tarm[p].ngath;
+        }
+      Stats_Count("tmp_written",-1,nmemo+ngath);
+      Stats_Count("tmp_read",-1,ngath);
+      Stats_End();
+      Stats_Begin("la_sort");
+      Stats_Count("tmp_read",-1,nmemo);
+      Stats_Count("tmp_written",-1,nmemo);
     }
 
-  free(panel);
-  free(sarray);
+  for (s = 0; s < nstage; s++)
+    { free(stage[s].panel);
+      free(stage[s].sarr);
+    }
   for (p = 0; p < NTHREADS; p++)
     fclose(tarm[p].tfile);
   for (p = 1; p < NTHREADS; p++)
-    { fclose(tarm[p].gdb2.seqs);
-      fclose(tarm[p].gdb1.seqs);
+    { if (gdb2->seqstate == EXTERNAL)
+        fclose(tarm[p].gdb2.seqs);
+      if (gdb1->seqstate == EXTERNAL)
+        fclose(tarm[p].gdb1.seqs);
     }
 
+  if (CKPT_PATH != NULL)
+    ckpt_searched(tarm);
+
   if (VERBOSE)
     { int64 nhit, nlas, nliv, ncov;
 
@@ -3397,27 +4753,15 @@ static void pair_sort_search(GDB *gdb1, GDB *gdb2)
         fprintf(stderr,
           "\n  Total hits over %dbp = %lld, %lld aln's, %lld non-redundant aln's of ave len %lld\n",
                        CHAIN_MIN/2,nhit,nlas,nliv,ncov/nliv);
-      fflush(stderr);
-    }
 
-  if (VERBOSE)
-    { fprintf(stderr,"\n  Sorting and merging alignments\n");
+      fprintf(stderr,"\n  Search thread load:\n");
+      for (p = 0; p < NTHREADS; p++)
+        fprintf(stderr,"    Thread %2d: %10lld tasks (%lld stolen), busy %.3fs, idle %.3fs\n",
+                       p,tarm[p].ntask,tarm[p].nstol,tarm[p].nbusy/1e9,(nwall-tarm[p].nbusy)/1e9);
       fflush(stderr);
     }
 
-#ifdef DEBUG_LASORT
-  for (p = 0; p < NTHREADS; p++)
-    la_sort(tarm+p);
-#else
-  for (p = 1; p < NTHREADS; p++)
-    pthread_create(threads+p,NULL,la_sort,tarm+p);
-  la_sort(tarm);
-  for (p = 1; p < NTHREADS; p++)
-    pthread_join(threads[p],NULL);
-#endif
-
-  if (la_merge(tarm))
-    Clean_Exit(1);
+  sort_merge_alignments(tarm,gdb1,gdb2);
 }
 
 static void short_GDB_fix(GDB *gdb)
@@ -3441,310 +4785,1122 @@ static void short_GDB_fix(GDB *gdb)
   gdb->ncontig = NTHREADS;
 }
 
-int main(int argc, char *argv[])
-{ Kmer_Stream *T1, *T2;
-  Post_List   *P1, *P2;
-  GDB _gdb1, *gdb1 = &_gdb1;
-  GDB _gdb2, *gdb2 = &_gdb2;
+//  Divide the contigs [beg,end) of gdb in the order perm into at most nparts parts of roughly
+//    equal total length, the p'th starting no earlier than beg+p*nparts.  Return the number
+//    of parts, setting split[p] to the index of the first contig of part p (and split[nparts]
+//    = end) and, if select is not NULL, select[x] to the part of the x'th contig.
+
+static int split_gdb(GDB *gdb, int *perm, int beg, int end, int nparts, int *split, int *select)
+{ int64 npost, cum, t;
+  int   p, r, x;
+
+  npost = 0;
+  for (x = beg; x < end; x++)
+    npost += gdb->contigs[perm[x]].clen;
+  split[0] = beg;
+  if (select != NULL)
+    select[beg] = 0;
+  p = 0;
+  r = beg+nparts;
+  t = npost/nparts;
+  cum = gdb->contigs[perm[beg]].clen;
+  for (x = beg+1; x < end; x++)
+    { if (cum >= t && x >= r)
+        { p += 1;
+          split[p] = x;
+          t = (npost*(p+1))/nparts;
+          r += nparts;
+        }
+      if (select != NULL)
+        select[x] = p;
+      cum += gdb->contigs[perm[x]].clen;
+    }
+  split[p+1] = end;
+  return (p+1);
+}
 
-  //  Process options
-
-  { int    i, j, k;
-    int    flags[128];
-    char  *eptr;
-    FILE  *test;
-
-    ARG_INIT("FastGA");
-
-    FREQ = 10;
-    CHAIN_BREAK = 1000;   //  2x in anti-diagonal space
-    CHAIN_MIN   =  200;
-    ALIGN_MIN   =  100;
-    ALIGN_RATE  = .7;
-    SORT_PATH   = "/tmp";
-    NTHREADS    = 8;
-
-    OUT_TYPE    = 0;
-    OUT_OPT     = 0;
-    ONE_PATH    = NULL;
-    ONE_ROOT    = NULL;
-
-    j = 1;
-    for (i = 1; i < argc; i++)
-      if (argv[i][0] == '-')
-        switch (argv[i][1])
-        { default:
-            ARG_FLAGS("vk")
-            break;
-          case '1':
-            if (strncmp(argv[i]+1,"1:",2) == 0)
-              { OUT_TYPE = 2;
-                ONE_PATH = PathTo(argv[i]+3);
-                ONE_ROOT = Root(argv[i]+3,".1aln");
-                test = fopen(Catenate(ONE_PATH,"/",ONE_ROOT,".1aln"),"w");
-                if (test == NULL)
-                  { fprintf(stderr,"%s: Cannot open %s/%s.1aln for output\n",
-                                   Prog_Name,ONE_PATH,ONE_ROOT);
-                    exit (1);
-                  }
-                fclose(test);
-                break;
-              }
-            fprintf(stderr,"%s: Do not recognize option %s\n",Prog_Name,argv[i]);
-            exit (1);
-          case 'c':
-            ARG_NON_NEGATIVE(CHAIN_MIN,"minimum seed cover");
-            CHAIN_MIN <<= 1;
-            break;
-          case 'f':
-            ARG_NON_NEGATIVE(FREQ,"maximum seed frequency");
-            break;
-          case 'i':
-            ARG_REAL(ALIGN_RATE);
-            if (ALIGN_RATE < .6 || ALIGN_RATE >= 1.)
-              { fprintf(stderr,"%s: '-e' minimum alignment similarity must be in [0.6,1.0)\n",
-                               Prog_Name);
-                exit (1);
-              }
-            break;
-          case 'l':
-            ARG_NON_NEGATIVE(ALIGN_MIN,"minimum alignment length");
-            break;
-          case 'p':
-            if (strncmp(argv[i]+1,"paf",3) == 0)
-              { OUT_TYPE = 0;
-                if (argv[1][4] == '\0')
-                  { OUT_OPT = 0;
-                    break;
-                  }
-                else if (strcmp(argv[i]+4,"m") == 0)
-                  { OUT_OPT = 1;
-                    break;
-                  }
-                else if (strcmp(argv[i]+4,"x") == 0)
-                  { OUT_OPT = 2;
-                    break;
-                  }
-              }
-            else if (strcmp(argv[i]+1,"psl") == 0)
-              { OUT_TYPE = 1;
-                break;
-              }
-            fprintf(stderr,"%s: Do not recognize option %s\n",Prog_Name,argv[i]);
+//  Build the GDB (if spath is a FASTA or 1-code source, i.e. type < IS_GDB) and the GIX for
+//    the genome whose GDB is to be at tpath, all within this process.  A freshly created
+//    GDB's bases are loaded into memory so that the index threads share one 2-bit copy.
+
+static void make_precursors(char *spath, char *tpath, int type)
+{ GDB    _gdb, *gdb = &_gdb;
+  FILE  *bases;
+  char  *tdir, *troot;
+
+  tdir  = PathTo(tpath);
+  troot = Root(tpath,NULL);
+  if (tdir == NULL || troot == NULL)
+    Clean_Exit(1);
+
+  if (type < IS_GDB)
+    { FILE **units;
+
+      if (VERBOSE)
+        { if (strcmp(tdir,".") == 0)
+            fprintf(stderr,"\n  Creating genome data base (GDB) %s.1gdb in the current directory\n",
+                           troot);
+          else
+            fprintf(stderr,"\n  Creating genome data base (GDB) %s.1gdb in directory %s\n",
+                           troot,tdir);
+          fflush(stderr);
+        }
+
+      Set_GDB_Threads(NTHREADS);
+      units = Create_GDB(gdb,spath,type,1,tpath);
+      if (units == NULL)
+        Clean_Exit(1);
+      free(units);
+      if (Write_GDB(gdb,tpath))
+        Clean_Exit(1);
+
+      bases = (FILE *) gdb->seqs;
+      if (Load_Sequences(gdb,COMPRESSED))
+        Clean_Exit(1);
+      fclose(bases);
+    }
+  else
+    { if (Read_GDB(gdb,tpath))
+        Clean_Exit(1);
+    }
+
+  if (VERBOSE)
+    { if (strcmp(tdir,".") == 0)
+        fprintf(stderr,"\n  Creating genome index (GIX) %s.gix in the current directory\n\n",
+                       troot);
+      else
+        fprintf(stderr,"\n  Creating genome index (GIX) %s.gix in directory %s\n\n",troot,tdir);
+      fflush(stderr);
+    }
+
+  Create_GIX(gdb,tpath,GIX_KMER,FREQ,NTHREADS,SORT_PATH,VERBOSE);
+
+  Close_GDB(gdb);
+  free(troot);
+  free(tdir);
+}
+
+/***********************************************************************************************
+ *
+ *   REFERENCE SERVER:
+ *     A server (-S) keeps the GIX, post list, and GDB of its source resident and listens on a
+ *     Unix socket.  A client (-C) sends its working directory, command line, and its stdout &
+ *     stderr descriptors to the server.  The server forks a child that compares the resident
+ *     reference against the client's query, writing directly to the client's descriptors,
+ *     and the child's exit status is returned to the client.  Requests are served in order.
+ *
+ **********************************************************************************************/
+
+static int process_options(int argc, char *argv[]);
+
+static volatile sig_atomic_t Stop_Serving = 0;
+
+static void stop_serving(int sig)
+{ (void) sig;
+  Stop_Serving = 1;
+}
+
+//  Send or receive a request header (# of bytes and # of args to follow), passing the
+//    two descriptors in fds along with it.
+
+static int send_request_header(int sock, int *head, int *fds)
+{ struct msghdr   msg;
+  struct iovec    iov;
+  struct cmsghdr *cmsg;
+  union
+    { char            buf[CMSG_SPACE(2*sizeof(int))];
+      struct cmsghdr  align;
+    } ctrl;
+
+  bzero(&msg,sizeof(msg));
+  bzero(&ctrl,sizeof(ctrl));
+  iov.iov_base       = head;
+  iov.iov_len        = 2*sizeof(int);
+  msg.msg_iov        = &iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = ctrl.buf;
+  msg.msg_controllen = sizeof(ctrl.buf);
+
+  cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type  = SCM_RIGHTS;
+  cmsg->cmsg_len   = CMSG_LEN(2*sizeof(int));
+  memcpy(CMSG_DATA(cmsg),fds,2*sizeof(int));
+
+  return (sendmsg(sock,&msg,0) != 2*sizeof(int));
+}
+
+static int recv_request_header(int sock, int *head, int *fds)
+{ struct msghdr   msg;
+  struct iovec    iov;
+  struct cmsghdr *cmsg;
+  union
+    { char            buf[CMSG_SPACE(2*sizeof(int))];
+      struct cmsghdr  align;
+    } ctrl;
+
+  bzero(&msg,sizeof(msg));
+  iov.iov_base       = head;
+  iov.iov_len        = 2*sizeof(int);
+  msg.msg_iov        = &iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = ctrl.buf;
+  msg.msg_controllen = sizeof(ctrl.buf);
+
+  if (recvmsg(sock,&msg,MSG_WAITALL) != 2*sizeof(int))
+    return (1);
+  cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == NULL || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(2*sizeof(int)))
+    return (1);
+  memcpy(fds,CMSG_DATA(cmsg),2*sizeof(int));
+  return (0);
+}
+
+//  Read the body of the request whose header is head from sock, checking that it consists of
+//    a directory followed by head[1] 0-terminated arguments in exactly head[0] bytes.  Return
+//    the body or NULL if the request is malformed.
+
+#define MAX_REQUEST 0x100000
+
+static char *recv_request_body(int sock, int *head)
+{ char   *msg, *m, *e;
+  ssize_t r;
+  int     n, i;
+
+  n = head[0];
+  if (n <= 0 || n > MAX_REQUEST || head[1] < 0)
+    return (NULL);
+  msg = Malloc(n,"Allocating request");
+  if (msg == NULL)
+    return (NULL);
+  for (i = 0; i < n; i += r)
+    { r = read(sock,msg+i,n-i);
+      if (r < 0 && errno == EINTR)
+        r = 0;
+      else if (r <= 0)
+        { free(msg);
+          return (NULL);
+        }
+    }
+
+  e = msg + n;
+  m = msg;
+  for (i = 0; i <= head[1]; i++)
+    { m = memchr(m,'\0',e-m);
+      if (m == NULL)
+        { free(msg);
+          return (NULL);
+        }
+      m += 1;
+    }
+  return (msg);
+}
+
+static int open_socket(char *path, struct sockaddr_un *addr)
+{ int sock;
+
+  if (strlen(path) >= sizeof(addr->sun_path))
+    { fprintf(stderr,"%s: Socket path %s is too long\n",Prog_Name,path);
+      return (-1);
+    }
+  bzero(addr,sizeof(struct sockaddr_un));
+  addr->sun_family = AF_UNIX;
+  strcpy(addr->sun_path,path);
+
+  sock = socket(AF_UNIX,SOCK_STREAM,0);
+  if (sock < 0)
+    fprintf(stderr,"%s: Cannot create a socket\n",Prog_Name);
+  return (sock);
+}
+
+//  Send the command line argv (less the -C option) and the current directory to the server
+//    at socket path sock, and return the exit status of the comparison.
+
+static int run_client(char *path, int argc, char *argv[])
+{ struct sockaddr_un addr;
+  int    sock, fds[2], head[2], status;
+  char  *cwd, *msg, *m;
+  int    i, len;
+
+  sock = open_socket(path,&addr);
+  if (sock < 0)
+    return (1);
+  if (connect(sock,(struct sockaddr *) &addr,sizeof(addr)) < 0)
+    { fprintf(stderr,"%s: Cannot connect to reference server at %s\n",Prog_Name,path);
+      return (1);
+    }
+
+  cwd = getcwd(NULL,0);
+  len = strlen(cwd)+1;
+  for (i = 0; i < argc; i++)
+    len += strlen(argv[i])+1;
+  msg = Malloc(len,"Allocating request");
+  if (cwd == NULL || msg == NULL)
+    return (1);
+
+  m = stpcpy(msg,cwd)+1;
+  head[1] = 0;
+  for (i = 0; i < argc; i++)
+    if (strncmp(argv[i],"-C:",3) != 0)
+      { m = stpcpy(m,argv[i])+1;
+        head[1] += 1;
+      }
+  head[0] = m-msg;
+
+  fflush(stdout);
+  fflush(stderr);
+  fds[0] = STDOUT_FILENO;
+  fds[1] = STDERR_FILENO;
+  if (send_request_header(sock,head,fds) || write(sock,msg,head[0]) != head[0])
+    { fprintf(stderr,"%s: Could not send request to reference server at %s\n",Prog_Name,path);
+      return (1);
+    }
+  free(msg);
+  free(cwd);
+
+  if (read(sock,&status,sizeof(int)) != sizeof(int))
+    { fprintf(stderr,"%s: Reference server at %s closed connection\n",Prog_Name,path);
+      return (1);
+    }
+  close(sock);
+  return (status);
+}
+
+//  Return an absolute version of path (a new string)
+
+static char *absolute_path(char *path, char *cwd)
+{ if (path[0] == '/')
+    return (Strdup(path,"Allocating path"));
+  else
+    return (Strdup(Catenate(cwd,"/",path,""),"Allocating path"));
+}
+
+//  Make the paths to the reference absolute so that its indices (and any clones thereof)
+//    can still be found after a child changes to the directory of a request.
+
+static void make_resident()
+{ char *cwd;
+
+  cwd = getcwd(NULL,0);
+  if (cwd == NULL)
+    { fprintf(stderr,"%s: Cannot determine current directory\n",Prog_Name);
+      Clean_Exit(1);
+    }
+  PATH1 = absolute_path(PATH1,cwd);
+  if (TYPE1 <= IS_GDB)
+    { char *spath = SPATH1;
+
+      SPATH1 = absolute_path(spath,cwd);
+      free(spath);
+    }
+  free(cwd);
+}
+
+//  Serve requests on the Unix socket at path.  Only returns in a forked child for a request,
+//    with *argv set to FastGA <reference> <query> and the child's options set from the
+//    request, save for -T, -P, -M, and -m which are those of the server.  When the server
+//    is signalled to stop it removes the socket and exits.
+
+static int serve_requests(char *path, char ***argv)
+{ struct sockaddr_un addr;
+  struct sigaction   act;
+  int    lsock, conn;
+  mode_t mask;
+
+  lsock = open_socket(path,&addr);
+  if (lsock < 0)
+    Clean_Exit(1);
+  unlink(path);
+  mask = umask(0077);
+  if (bind(lsock,(struct sockaddr *) &addr,sizeof(addr)) < 0)
+    { fprintf(stderr,"%s: Cannot bind socket %s\n",Prog_Name,path);
+      Clean_Exit(1);
+    }
+  umask(mask);
+  if (chmod(path,0600) < 0 || listen(lsock,16) < 0)  //  Only the server's user may connect
+    { fprintf(stderr,"%s: Cannot listen on socket %s\n",Prog_Name,path);
+      unlink(path);
+      Clean_Exit(1);
+    }
+
+  bzero(&act,sizeof(act));
+  act.sa_handler = stop_serving;
+  sigaction(SIGINT,&act,NULL);
+  sigaction(SIGTERM,&act,NULL);
+  signal(SIGPIPE,SIG_IGN);
+
+  if (VERBOSE)
+    { fprintf(stderr,"\n  Serving %s/%s on socket %s\n",PATH1,ROOT1,path);
+      fflush(stderr);
+    }
+
+  while ( ! Stop_Serving)
+    { int    head[2], fds[2], status;
+      char  *msg;
+      pid_t  pid;
+
+      conn = accept(lsock,NULL,NULL);
+      if (conn < 0)
+        { if (errno == EINTR)
+            continue;
+          fprintf(stderr,"%s: Accept on socket %s failed\n",Prog_Name,path);
+          break;
+        }
+
+      if (recv_request_header(conn,head,fds))
+        { close(conn);
+          continue;
+        }
+      msg = recv_request_body(conn,head);
+      if (msg == NULL)
+        { close(fds[0]);
+          close(fds[1]);
+          close(conn);
+          continue;
+        }
+
+      pid = fork();
+      if (pid == 0)
+        { int    nthreads  = NTHREADS;
+          int    mem       = MEM_BUDGET;
+          int    map       = MAP_GIX;
+          char  *sort_path = SORT_PATH;
+          char **args, *m;
+          int    argc, i;
+
+          close(lsock);
+          close(conn);
+          signal(SIGINT,SIG_DFL);
+          signal(SIGTERM,SIG_DFL);
+          signal(SIGPIPE,SIG_DFL);
+          dup2(fds[0],STDOUT_FILENO);
+          dup2(fds[1],STDERR_FILENO);
+          close(fds[0]);
+          close(fds[1]);
+
+          if (chdir(msg) < 0)
+            { fprintf(stderr,"%s: Server cannot change to directory %s\n",Prog_Name,msg);
+              exit (1);
+            }
+
+          args = Malloc((head[1]+2)*sizeof(char *),"Allocating request arguments");
+          if (args == NULL)
             exit (1);
-          case 's':
-            ARG_NON_NEGATIVE(CHAIN_BREAK,"seed chain break threshold");
-            CHAIN_BREAK <<= 1;
-            break;
-          case 'P':
-            SORT_PATH = argv[i]+2;
-            break;
-          case 'T':
-            ARG_NON_NEGATIVE(NTHREADS,"number of threads to use");
-            break;
+          m = msg + strlen(msg) + 1;
+          for (i = 0; i < head[1]; i++)
+            { args[i] = m;
+              m += strlen(m) + 1;
+            }
+          args[head[1]] = NULL;
+
+          RESIDENT = 1;
+          argc = process_options(head[1],args);
+          if (argc != 2)
+            { fprintf(stderr,"%s: A reference server request must give exactly one source\n",
+                             Prog_Name);
+              exit (1);
+            }
+          NTHREADS   = nthreads;
+          MEM_BUDGET = mem;
+          MAP_GIX    = map;
+          SORT_PATH  = sort_path;
+
+          args[2] = args[1];
+          args[1] = ROOT1;
+          *argv = args;
+          return (3);
+        }
+
+      close(fds[0]);
+      close(fds[1]);
+      free(msg);
+
+      if (pid < 0)
+        status = 1;
+      else
+        { while (waitpid(pid,&status,0) < 0)
+            if (errno != EINTR)
+              break;
+          if (WIFEXITED(status))
+            status = WEXITSTATUS(status);
+          else
+            status = 1;
+        }
+      if (VERBOSE)
+        { fprintf(stderr,"  Request served with exit status %d\n",status);
+          fflush(stderr);
+        }
+
+      if (write(conn,&status,sizeof(int)) != sizeof(int))
+        fprintf(stderr,"%s: Could not return status to client\n",Prog_Name);
+      close(conn);
+    }
+
+  close(lsock);
+  unlink(path);
+
+  if (VERBOSE)
+    { fprintf(stderr,"\n  Server on socket %s stopped\n",path);
+      fflush(stderr);
+    }
+
+  Clean_Exit(0);
+  return (0);
+}
+
+/***********************************************************************************************
+ *
+ *   RESOURCE PLANNER:
+ *     With -plan, FastGA opens the GDBs and GIXs of its sources (which touches only their
+ *     headers, contig tables, and k-mer prefix indices), reports for each phase the peak RSS,
+ *     the bytes held in SORT_PATH, and a rough wall time were the comparison run with the
+ *     given -T and -M, and then recommends settings for the machine it is run on.  The number
+ *     of seed pairs is predicted from the smaller post list at a rate measured on related
+ *     genomes, the usual case, and everything else is sized from it just as FastGA sizes its
+ *     arrays and buffers.  The rates below are per core and are deliberately rough.
+ *
+ **********************************************************************************************/
+
+#define PLAN_SEEDS_PER_POST  1.5    //  Seed pairs per post of the smaller index
+#define PLAN_PART_SKEW       0.8    //  Most seeds in a sort array over those of the largest part
+#define PLAN_SEED_BYTES      0.85   //  Bytes of a seed in a pair file over 1+IBYTE+JBYTE
+#define PLAN_ZIP_BYTES       0.73   //    and with -z
+#define PLAN_ALN_BYTES       0.35   //  Bytes of alignment records per seed
+#define PLAN_THREAD_BYTES    2.0e7  //  Working memory of an aligner
+#define PLAN_MERGE_RATE      9.0e6  //  Seeds per second in the adaptamer merge
+#define PLAN_SEARCH_RATE     8.0e5  //  Seeds per second in the seed sort & search
+#define PLAN_LA_RATE         1.0e8  //  Alignment bytes per second in the alignment sort & merge
+#define PLAN_CIGAR_RATE      4.0e6  //    and when CIGAR strings are computed
+
+#define PLAN_MERGE  0
+#define PLAN_SEARCH 1
+#define PLAN_LA     2
+
+static char *Plan_Phase[3] = { "adaptamer_merge", "seed_sort_search", "la_sort_merge" };
+
+typedef struct
+  { int    nthreads;   //  -T and -M planned for
+    int    budget;
+    int    nparts;     //  # of parts the A-contigs are split into
+    int    nstage;     //  # of sort arrays, 2 if both fit in the budget
+    int64  sarray;     //  bytes of a sort array
+    int64  rss[3];     //  per phase: peak RSS,
+    int64  disk[3];    //             bytes in SORT_PATH,
+    double wall[3];    //             and wall time in seconds
+    int64  peak_rss;   //  maxima and sum over the phases
+    int64  peak_disk;
+    double time;
+  } Plan;
+
+//  Bytes of the inverse prefix index libfastk builds for T (see inverse_index)
+
+static int64 plan_inverse(Kmer_Stream *T)
+{ int64 pow;
+
+  for (pow = 1; 2*pow <= T->nels/T->ixlen; pow <<= 1)
+    ;
+  return ((T->nels/pow + 1) * sizeof(int));
+}
+
+//  Plan a run with nthreads threads and a memory budget of budget GB on ncores cores,
+//    given there will be nseed seed pairs.
+
+static void plan_run(Plan *pl, int nthreads, int budget, int ncores, int64 nseed,
+                     GDB *gdb1, GDB *gdb2, Kmer_Stream *T1, Kmer_Stream *T2,
+                     Post_List *P1, Post_List *P2)
+{ int   *split;
+  int64  len, most, nelmax;
+  int64  index, iobuf, cache, bases, thread, pairs, alns;
+  double cores;
+  int    p, x;
+
+  split = Malloc((nthreads+1)*sizeof(int),"Allocating plan partition");
+  if (split == NULL)
+    Clean_Exit(1);
+
+  pl->nthreads = nthreads;
+  pl->budget   = budget;
+  pl->nparts   = split_gdb(gdb1,Perm1,IDBsplit[0],IDBsplit[NPARTS],nthreads,split,NULL);
+
+  most = 0;
+  for (p = 0; p < pl->nparts; p++)
+    { len = 0;
+      for (x = split[p]; x < split[p+1]; x++)
+        len += gdb1->contigs[Perm1[x]].clen;
+      if (len > most)
+        most = len;
+    }
+  free(split);
+
+  nelmax     = (((double) nseed) * most / SHARD_LEN) * PLAN_PART_SKEW;
+  pl->sarray = (nelmax+1) * (2*DBYTE + JCONT + 2);
+  if (2*pl->sarray <= budget*1000000000ll)
+    pl->nstage = 2;
+  else
+    pl->nstage = 1;
+
+  //  The k-mer tables, their prefix indices and the inverses thereof, are freed after the
+  //    merge.  The pair file IO buffers stay to the end, and the 2-bit bases are touched once
+  //    the search starts.
+
+  index = T1->ixlen*sizeof(int64) + plan_inverse(T1);
+  if (MAP_GIX)
+    index += T1->nels * T1->tbyte + P1->nels * IBYTE;
+  if ( ! SELF)
+    { index += T2->ixlen*sizeof(int64) + plan_inverse(T2);
+      if (MAP_GIX)
+        index += T2->nels * T2->tbyte + P2->nels * JBYTE;
+    }
+  iobuf = 2*pl->nparts*nthreads*((int64) SEED_BLOCK) + 2*nthreads*NCONTS*sizeof(int64);
+  bases = gdb1->seqtot/4;
+  if ( ! SELF)
+    bases += gdb2->seqtot/4;
+  cache = nthreads * (P2->maxp+1) * KBYTE;
+
+  thread = BMXPOS;
+  if (thread < CTG_CACHE)
+    thread = CTG_CACHE;
+  if (thread > gdb2->seqtot)
+    thread = gdb2->seqtot;
+  thread += AMXPOS + PLAN_THREAD_BYTES;
+
+  if (ZIP_SEEDS)
+    pairs = nseed * (1+IBYTE+JBYTE) * PLAN_ZIP_BYTES;
+  else
+    pairs = nseed * (1+IBYTE+JBYTE) * PLAN_SEED_BYTES;
+  alns = nseed * PLAN_ALN_BYTES;
+
+  pl->rss[PLAN_MERGE]  = index + iobuf + cache;
+  pl->rss[PLAN_SEARCH] = iobuf + bases + pl->nstage*(pl->sarray + NCONTS*sizeof(int64))
+                       + nthreads*thread;
+  if (alns < budget*1000000000ll)
+    pl->rss[PLAN_LA] = iobuf + bases + alns;
+  else
+    pl->rss[PLAN_LA] = iobuf + bases + budget*1000000000ll;
+
+  pl->disk[PLAN_MERGE]  = pairs;
+  pl->disk[PLAN_SEARCH] = pairs + alns;
+  pl->disk[PLAN_LA]     = 2*alns;
+
+  cores = (nthreads < ncores ? nthreads : ncores);
+  pl->wall[PLAN_MERGE]  = nseed / (PLAN_MERGE_RATE * cores);
+  pl->wall[PLAN_SEARCH] = nseed / (PLAN_SEARCH_RATE * cores);
+  if (OUT_OPT != 0)
+    pl->wall[PLAN_LA] = alns / (PLAN_CIGAR_RATE * cores);
+  else
+    pl->wall[PLAN_LA] = alns / (PLAN_LA_RATE * cores);
+
+  pl->peak_rss  = 0;
+  pl->peak_disk = 0;
+  pl->time      = 0.;
+  for (p = 0; p < 3; p++)
+    { if (pl->rss[p] > pl->peak_rss)
+        pl->peak_rss = pl->rss[p];
+      if (pl->disk[p] > pl->peak_disk)
+        pl->peak_disk = pl->disk[p];
+      pl->time += pl->wall[p];
+    }
+}
+
+static char *plan_time(double secs)
+{ static char buf[32];
+
+  if (secs < 120.)
+    sprintf(buf,"%.0fs",secs);
+  else if (secs < 7200.)
+    sprintf(buf,"%.1fm",secs/60.);
+  else
+    sprintf(buf,"%.1fh",secs/3600.);
+  return (buf);
+}
+
+//  Print the plan for the current -T and -M and the settings recommended for this machine,
+//    and if -stats was given, record both in a "plan" record.
+
+static void plan_report(GDB *gdb1, GDB *gdb2, Kmer_Stream *T1, Kmer_Stream *T2,
+                        Post_List *P1, Post_List *P2)
+{ Plan    cur, rec;
+  int64   nseed, nfree, phys;
+  int     ncores, nthreads, budget, p;
+  struct  rlimit rlp;
+  struct  statvfs fs;
+
+  if (SELF || P1->nels < P2->nels)
+    nseed = P1->nels * PLAN_SEEDS_PER_POST;
+  else
+    nseed = P2->nels * PLAN_SEEDS_PER_POST;
+  nseed = (((double) nseed) * SHARD_LEN) / gdb1->seqtot;
+
+  ncores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (ncores < 1)
+    ncores = 1;
+  phys = ((int64) sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+
+  plan_run(&cur,NTHREADS,MEM_BUDGET,ncores,nseed,gdb1,gdb2,T1,T2,P1,P2);
+
+  //  Recommend a thread per core (within the open file limit), and the least budget for
+  //    which the sort arrays overlap the search, unless that exceeds half of physical memory
+
+  nthreads = ncores;
+  if (getrlimit(RLIMIT_NOFILE,&rlp) == 0)
+    while (nthreads > 1 && (uint64) (nthreads+3)*2*nthreads + 3 > rlp.rlim_max)
+      nthreads -= 1;
+  plan_run(&rec,nthreads,1,ncores,nseed,gdb1,gdb2,T1,T2,P1,P2);
+  budget = (2*rec.sarray + 999999999ll) / 1000000000ll;
+  if (phys > 0 && budget*1000000000ll > phys/2)
+    budget = phys / 2000000000ll;
+  if (budget < 1)
+    budget = 1;
+  plan_run(&rec,nthreads,budget,ncores,nseed,gdb1,gdb2,T1,T2,P1,P2);
+
+  if (statvfs(SORT_PATH,&fs) == 0)
+    nfree = ((int64) fs.f_bavail) * fs.f_frsize;
+  else
+    nfree = -1;
+
+  printf("\nPlan for comparing %s",ROOT1);
+  if ( ! SELF)
+    printf(" against %s",ROOT2);
+  printf(" with -T%d -M%d (%d part%s)\n\n",NTHREADS,MEM_BUDGET,cur.nparts,
+                                          cur.nparts==1?"":"s");
+  printf("  Source 1: %lld bp in %d contigs, %lld posts\n",
+         gdb1->seqtot,gdb1->ncontig,P1->nels);
+  if ( ! SELF)
+    printf("  Source 2: %lld bp in %d contigs, %lld posts\n",
+           gdb2->seqtot,gdb2->ncontig,P2->nels);
+  printf("  About %lld seed pairs, %d sort array%s of %.2fGB\n\n",
+         nseed,cur.nstage,cur.nstage==1?"":"s",cur.sarray/1e9);
+
+  printf("    %-18s  %9s  %9s  %8s\n","Phase","Peak RSS","SORT_PATH","Wall");
+  for (p = 0; p < 3; p++)
+    printf("    %-18s  %8.2fG  %8.2fG  %8s\n",Plan_Phase[p],cur.rss[p]/1e9,cur.disk[p]/1e9,
+                                            plan_time(cur.wall[p]));
+  printf("    %-18s  %8.2fG  %8.2fG  %8s\n\n","total",cur.peak_rss/1e9,cur.peak_disk/1e9,
+                                            plan_time(cur.time));
+
+  printf("  Recommended for %d core%s: -T%d -M%d (%d part%s), %.2fG RSS, %.2fG SORT_PATH, %s\n",
+         ncores,ncores==1?"":"s",rec.nthreads,rec.budget,rec.nparts,rec.nparts==1?"":"s",
+         rec.peak_rss/1e9,rec.peak_disk/1e9,plan_time(rec.time));
+  if (nfree >= 0)
+    printf("  -P%s has %.2fG free%s\n",SORT_PATH,nfree/1e9,
+           nfree < cur.peak_disk ? ", too little: use a -P directory with more space" : "");
+  if (phys > 0 && cur.peak_rss > phys)
+    printf("  Peak RSS exceeds the %.2fG of physical memory: reduce -M or -T\n",phys/1e9);
+  printf("\n");
+  fflush(stdout);
+
+  if (STAT_NAME != NULL)
+    { Stats_Begin("plan");
+      Stats_Count("seeds",-1,nseed);
+      Stats_Count("parts",-1,cur.nparts);
+      Stats_Count("sort_arrays",-1,cur.nstage);
+      Stats_Count("sort_array_bytes",-1,cur.sarray);
+      Stats_Count("merge_rss",-1,cur.rss[PLAN_MERGE]);
+      Stats_Count("search_rss",-1,cur.rss[PLAN_SEARCH]);
+      Stats_Count("la_rss",-1,cur.rss[PLAN_LA]);
+      Stats_Count("peak_rss",-1,cur.peak_rss);
+      Stats_Count("merge_tmp",-1,cur.disk[PLAN_MERGE]);
+      Stats_Count("search_tmp",-1,cur.disk[PLAN_SEARCH]);
+      Stats_Count("la_tmp",-1,cur.disk[PLAN_LA]);
+      Stats_Count("peak_tmp",-1,cur.peak_disk);
+      Stats_Count("merge_wall",-1,cur.wall[PLAN_MERGE]);
+      Stats_Count("search_wall",-1,cur.wall[PLAN_SEARCH]);
+      Stats_Count("la_wall",-1,cur.wall[PLAN_LA]);
+      Stats_Count("total_wall",-1,cur.time);
+      Stats_Count("tmp_free",-1,nfree);
+      Stats_Count("rec_threads",-1,rec.nthreads);
+      Stats_Count("rec_budget",-1,rec.budget);
+      Stats_Count("rec_parts",-1,rec.nparts);
+      Stats_Count("rec_peak_rss",-1,rec.peak_rss);
+      Stats_Count("rec_total_wall",-1,rec.time);
+      Stats_End();
+    }
+}
+
+//  Determine the path, root name, and type of the source named by arg (see DNAsource.h),
+//    setting *spath and *tpath to the source and target GDB paths if the GDB is not present.
+
+static int parse_source(char *arg, char **path, char **root, char **spath, char **tpath)
+{ char *p;
+  FILE *input;
+  int   type;
+
+  *path = arg;
+  p = rindex(*path,'/');
+  if (p == NULL)
+    { *root = *path;
+      *path = ".";
+    }
+  else
+    { *p++ = '\0';
+      *root = p;
+    }
+
+  input = fopen(Catenate(*path,"/",*root,".gix"),"r");
+  if (input != NULL)
+    { fclose(input);
+      type = IS_GDB+1;
+    }
+  else if (strcmp((*root)+(strlen(*root)-4),".gix") == 0)
+    { (*root)[strlen(*root)-4] = '\0';
+      type = IS_GDB+1;
+    }
+  else
+    { type = Get_GDB_Paths(Catenate(*path,"/",*root,""),NULL,spath,tpath,0);
+      *root = Root(*tpath,NULL);
+
+      input = fopen(Catenate(*path,"/",*root,".gix"),"r");
+      if (input != NULL)
+        { type = IS_GDB+1;
+          fclose(input);
         }
       else
-        argv[j++] = argv[i];
-    argc = j;
-
-    VERBOSE = flags['v'];
-    KEEP    = flags['k'];
-
-    if (argc != 3 && argc != 2)
-      { fprintf(stderr,"\nUsage: %s %s\n",Prog_Name,Usage[0]);
-        fprintf(stderr,"       %*s %s\n",(int) strlen(Prog_Name),"",Usage[1]);
-        fprintf(stderr,"       %*s %s\n",(int) strlen(Prog_Name),"",Usage[2]);
-        fprintf(stderr,"\n");
-        fprintf(stderr,"         <format> = -paf[mx] | -psl | -1:<align:path>[.1aln]\n");
-        fprintf(stderr,"\n");
-        fprintf(stderr,"         <precursor> = .gix | .1gdb | <fa_extn> | <1_extn>\n");
-        fprintf(stderr,"\n");
-        fprintf(stderr,"             <fa_extn> = (.fa|.fna|.fasta)[.gz]\n");
-        fprintf(stderr,"             <1_extn>  = any valid 1-code sequence file type\n");
-        fprintf(stderr,"\n");
-        fprintf(stderr,"      -v: Verbose mode, output statistics as proceed.\n");
-        fprintf(stderr,"      -k: Keep any generated .1gdb's and .gix's.\n");
-        fprintf(stderr,"      -T: Number of threads to use.\n");
-        fprintf(stderr,"      -P: Directory to use for temporary files.\n");
-        fprintf(stderr,"\n");
-        fprintf(stderr,"      -paf: Stream PAF output\n");
-        fprintf(stderr,"        -pafx: Stream PAF output with CIGAR sring with X's\n");
-        fprintf(stderr,"        -pafm: Stream PAF output with CIGAR sring with ='s\n");
-        fprintf(stderr,"      -psl: Stream PSL output\n");
-        fprintf(stderr,"      -1: Generate 1-code output to specified file\n");
-        fprintf(stderr,"\n");
-        fprintf(stderr,"      -f: adaptive seed count cutoff\n");
-        fprintf(stderr,"      -c: minimum seed chain coverage in both genomes\n");
-        fprintf(stderr,"      -s: threshold for starting a new seed chain\n");
-        fprintf(stderr,"      -l: minimum alignment length\n");
-        fprintf(stderr,"      -i: minimum alignment identity\n");
-        fprintf(stderr,"\n");
-        exit (1);
-      }
+        { input = fopen(Catenate(*path,"/",*root,".1gdb"),"r");
+          if (input != NULL)
+            { fclose(input);
+              type = IS_GDB;
+            }
+          else
+            { input = fopen(Catenate(*path,"/",*root,".gdb"),"r");
+              if (input != NULL)
+                { fclose(input);
+                  type = IS_GDB;
+                }
+            }
+        }
+    }
 
-    if (FREQ > 255)
-      { fprintf(stderr,"%s: The maximum allowable frequency cutoff is 255\n",Prog_Name);
-        exit (1);
-      }
-  }
+  return (type);
+}
 
-  if (VERBOSE)
-    StartTime();
+//  Open the k-mer table and post list of the GIX path/root.gix
 
-  //  Parse source names and make precursors if necessary
+static void open_index(char *path, char *root, Kmer_Stream **T, Post_List **P)
+{ if (MAP_GIX)
+    *T = Map_Kmer_Stream(Catenate(path,"/",root,".gix"));
+  else
+    *T = Open_Kmer_Stream(Catenate(path,"/",root,".gix"));
+  if (*T == NULL)
+    { fprintf(stderr,"%s: Cannot find genome index for %s/%s.gix\n",Prog_Name,path,root);
+      Clean_Exit(1);
+    }
+  *P = Open_Post_List(Catenate(path,"/",root,".gix"),MAP_GIX);
+  if (*P == NULL)
+    { fprintf(stderr,"%s: Cannot find genome index for %s/%s.gix\n",Prog_Name,path,root);
+      Clean_Exit(1);
+    }
+}
 
-  { char *p;
-    FILE *input;
-    char *tpath1;
-    char *tpath2;
+//  Read the GDB path/root(.gdb|.1gdb) into gdb, setting *gextn to the extension found
 
-    PATH1 = argv[1];
-    p = rindex(PATH1,'/');
-    if (p == NULL)
-      { ROOT1 = PATH1;
-        PATH1 = ".";
-      }
-    else
-      { *p++ = '\0';
-        ROOT1 = p;
-      }
+static void open_gdb(char *path, char *root, char **gextn, GDB *gdb)
+{ FILE *file;
 
-    input = fopen(Catenate(PATH1,"/",ROOT1,".gix"),"r");
-    if (input != NULL)
-      { fclose(input);
-        TYPE1 = IS_GDB+1;
-      }
-    else if (strcmp(ROOT1+(strlen(ROOT1)-4),".gix") == 0)
-      { ROOT1[strlen(ROOT1)-4] = '\0';
-        TYPE1 = IS_GDB+1;
+  *gextn = ".gdb";
+  if ((file = fopen(Catenate(path,"/",root,*gextn),"r")) == NULL)
+    *gextn = ".1gdb";
+  else
+    fclose(file);
+
+  if (Read_GDB(gdb,Catenate(path,"/",root,*gextn)) < 0)
+    Clean_Exit(1);
+  short_GDB_fix(gdb);
+  if (Map_Sequences(gdb))
+    Clean_Exit(1);
+}
+
+//  Set all options to their defaults, then process the command line options in argv,
+//    removing them from argv.  Return the number of arguments that remain.
+
+static int process_options(int argc, char *argv[])
+{ int    i, j, k;
+  int    flags[128];
+  char  *eptr;
+  FILE  *test;
+
+  ARG_INIT("FastGA");
+
+  FREQ = 10;
+  CHAIN_BREAK = 1000;   //  2x in anti-diagonal space
+  CHAIN_MIN   =  200;
+  ALIGN_MIN   =  100;
+  ALIGN_RATE  = .7;
+  SORT_PATH   = "/tmp";
+  NTHREADS    = 8;
+  MEM_BUDGET  = 16;
+
+  OUT_TYPE    = 0;
+  OUT_OPT     = 0;
+  ONE_PATH    = NULL;
+  ONE_ROOT    = NULL;
+  SERVER      = NULL;
+  CLIENT      = NULL;
+  STAT_NAME   = NULL;
+  PLAN        = 0;
+  CKPT_PATH   = NULL;
+  SHARD       = 0;
+  NSHARDS     = 1;
+
+  j = 1;
+  for (i = 1; i < argc; i++)
+    if (argv[i][0] == '-')
+      switch (argv[i][1])
+      { default:
+          ARG_FLAGS("vkmbz")
+          break;
+        case '1':
+          if (strncmp(argv[i]+1,"1:",2) == 0 || strncmp(argv[i]+1,"1x:",3) == 0)
+            { char *name;
+
+              OUT_TYPE = 2;
+              if (argv[i][2] == 'x')
+                { OUT_OPT = 2;
+                  name    = argv[i]+4;
+                }
+              else
+                { OUT_OPT = 0;
+                  name    = argv[i]+3;
+                }
+              ONE_PATH = PathTo(name);
+              ONE_ROOT = Root(name,".1aln");
+              break;
+            }
+          fprintf(stderr,"%s: Do not recognize option %s\n",Prog_Name,argv[i]);
+          exit (1);
+        case 'C':
+          if (argv[i][2] == ':' && argv[i][3] != '\0')
+            { CLIENT = argv[i]+3;
+              break;
+            }
+          fprintf(stderr,"%s: -C option must be of the form -C:<socket:path>\n",Prog_Name);
+          exit (1);
+        case 'c':
+          if (strncmp(argv[i]+1,"ckpt:",5) == 0)
+            { if (argv[i][6] == '\0')
+                { fprintf(stderr,"%s: -ckpt option must be of the form -ckpt:<dir>\n",
+                                 Prog_Name);
+                  exit (1);
+                }
+              CKPT_PATH = argv[i]+6;
+              break;
+            }
+          ARG_NON_NEGATIVE(CHAIN_MIN,"minimum seed cover");
+          CHAIN_MIN <<= 1;
+          break;
+        case 'f':
+          ARG_NON_NEGATIVE(FREQ,"maximum seed frequency");
+          break;
+        case 'i':
+          ARG_REAL(ALIGN_RATE);
+          if (ALIGN_RATE < .6 || ALIGN_RATE >= 1.)
+            { fprintf(stderr,"%s: '-e' minimum alignment similarity must be in [0.6,1.0)\n",
+                             Prog_Name);
+              exit (1);
+            }
+          break;
+        case 'l':
+          ARG_NON_NEGATIVE(ALIGN_MIN,"minimum alignment length");
+          break;
+        case 'p':
+          if (strncmp(argv[i]+1,"paf",3) == 0)
+            { OUT_TYPE = 0;
+              if (argv[1][4] == '\0')
+                { OUT_OPT = 0;
+                  break;
+                }
+              else if (strcmp(argv[i]+4,"m") == 0)
+                { OUT_OPT = 1;
+                  break;
+                }
+              else if (strcmp(argv[i]+4,"x") == 0)
+                { OUT_OPT = 2;
+                  break;
+                }
+            }
+          else if (strcmp(argv[i]+1,"psl") == 0)
+            { OUT_TYPE = 1;
+              break;
+            }
+          else if (strcmp(argv[i]+1,"plan") == 0)
+            { PLAN = 1;
+              break;
+            }
+          fprintf(stderr,"%s: Do not recognize option %s\n",Prog_Name,argv[i]);
+          exit (1);
+        case 'S':
+          if (argv[i][2] == ':' && argv[i][3] != '\0')
+            { SERVER = argv[i]+3;
+              break;
+            }
+          fprintf(stderr,"%s: -S option must be of the form -S:<socket:path>\n",Prog_Name);
+          exit (1);
+        case 's':
+          if (strncmp(argv[i]+1,"stats:",6) == 0)
+            { if (argv[i][7] == '\0')
+                { fprintf(stderr,"%s: -stats option must be of the form -stats:<file>\n",
+                                 Prog_Name);
+                  exit (1);
+                }
+              Stats_Init(argv[i]+7);
+              break;
+            }
+          if (strncmp(argv[i]+1,"shard:",6) == 0)
+            { char *eptr;
+
+              SHARD   = strtol(argv[i]+7,&eptr,10);
+              NSHARDS = 0;
+              if (eptr > argv[i]+7 && *eptr == '/')
+                NSHARDS = strtol(eptr+1,&eptr,10);
+              if (*eptr != '\0' || SHARD < 1 || SHARD > NSHARDS)
+                { fprintf(stderr,"%s: -shard option must be of the form -shard:<i>/<n>",
+                                 Prog_Name);
+                  fprintf(stderr," where 1 <= i <= n\n");
+                  exit (1);
+                }
+              SHARD -= 1;
+              break;
+            }
+          ARG_NON_NEGATIVE(CHAIN_BREAK,"seed chain break threshold");
+          CHAIN_BREAK <<= 1;
+          break;
+        case 'M':
+          ARG_NON_NEGATIVE(MEM_BUDGET,"memory budget in GB");
+          break;
+        case 'P':
+          SORT_PATH = argv[i]+2;
+          break;
+        case 'T':
+          ARG_NON_NEGATIVE(NTHREADS,"number of threads to use");
+          break;
       }
     else
-      { TYPE1 = Get_GDB_Paths(Catenate(PATH1,"/",ROOT1,""),NULL,&SPATH1,&tpath1,0);
-        ROOT1 = Root(tpath1,NULL);
+      argv[j++] = argv[i];
+  argc = j;
+
+  VERBOSE    = flags['v'];
+  KEEP       = flags['k'];
+  MAP_GIX    = flags['m'];
+  BASE_SNAKE = flags['b'];
+  ZIP_SEEDS  = flags['z'];
+
+  Set_Word_Snakes(!BASE_SNAKE);
+
+  if ((argc != 3 && argc != 2) || ((SERVER != NULL || CLIENT != NULL) && argc != 2)
+                               || (SERVER != NULL && CLIENT != NULL))
+    { fprintf(stderr,"\nUsage: %s %s\n",Prog_Name,Usage[0]);
+      fprintf(stderr,"       %*s %s\n",(int) strlen(Prog_Name),"",Usage[1]);
+      fprintf(stderr,"       %*s %s\n",(int) strlen(Prog_Name),"",Usage[2]);
+      fprintf(stderr,"       %*s %s\n",(int) strlen(Prog_Name),"",Usage[3]);
+      fprintf(stderr,"       %*s %s\n",(int) strlen(Prog_Name),"",Usage[4]);
+      fprintf(stderr,"\n");
+      fprintf(stderr,"         <format> = -paf[mx] | -psl | -1[x]:<align:path>[.1aln]\n");
+      fprintf(stderr,"\n");
+      fprintf(stderr,"         <precursor> = .gix | .1gdb | <fa_extn> | <1_extn>\n");
+      fprintf(stderr,"\n");
+      fprintf(stderr,"             <fa_extn> = (.fa|.fna|.fasta)[.gz]\n");
+      fprintf(stderr,"             <1_extn>  = any valid 1-code sequence file type\n");
+      fprintf(stderr,"\n");
+      fprintf(stderr,"      -v: Verbose mode, output statistics as proceed.\n");
+      fprintf(stderr,"      -k: Keep any generated .1gdb's and .gix's.\n");
+      fprintf(stderr,"      -m: Memory map the genome indices (shared by all threads).\n");
+      fprintf(stderr,"      -b: Extend matches a base rather than a word at a time (same result).\n");
+      fprintf(stderr,"      -z: Deflate the temporary seed pair files (less disk, more CPU).\n");
+      fprintf(stderr,"      -T: Number of threads to use.\n");
+      fprintf(stderr,"      -P: Directory to use for temporary files.\n");
+      fprintf(stderr,"      -M: Memory budget in GB for sorting & merging seeds and alignments.\n");
+      fprintf(stderr,"\n");
+      fprintf(stderr,"      -paf: Stream PAF output\n");
+      fprintf(stderr,"        -pafx: Stream PAF output with CIGAR sring with X's\n");
+      fprintf(stderr,"        -pafm: Stream PAF output with CIGAR sring with ='s\n");
+      fprintf(stderr,"      -psl: Stream PSL output\n");
+      fprintf(stderr,"      -1: Generate 1-code output to specified file\n");
+      fprintf(stderr,"        -1x: with the exact alignment of each as a CIGAR string\n");
+      fprintf(stderr,"\n");
+      fprintf(stderr,"      -stats: Write a JSON (or .tsv) record of each phase's resources\n");
+      fprintf(stderr,"      -plan: Predict the memory, temporary disk, and time of each phase\n");
+      fprintf(stderr,"               and recommend -T and -M, but do not compare the sources\n");
+      fprintf(stderr,"      -ckpt: Keep each phase's results in the directory so that a rerun\n");
+      fprintf(stderr,"               of an interrupted comparison resumes where it stopped\n");
+      fprintf(stderr,"      -shard: Compare only the i'th of n equal divisions of <source1>'s\n");
+      fprintf(stderr,"               contigs (combine the -1 outputs of all n with ALNmerge)\n");
+      fprintf(stderr,"\n");
+      fprintf(stderr,"      -S: Keep <source1> resident and serve queries on the given socket\n");
+      fprintf(stderr,"      -C: Compare <source1> against the reference served on the socket\n");
+      fprintf(stderr,"\n");
+      fprintf(stderr,"      -f: adaptive seed count cutoff\n");
+      fprintf(stderr,"      -c: minimum seed chain coverage in both genomes\n");
+      fprintf(stderr,"      -s: threshold for starting a new seed chain\n");
+      fprintf(stderr,"      -l: minimum alignment length\n");
+      fprintf(stderr,"      -i: minimum alignment identity\n");
+      fprintf(stderr,"\n");
+      exit (1);
+    }
 
-        input = fopen(Catenate(PATH1,"/",ROOT1,".gix"),"r");
-        if (input != NULL)
-          { TYPE1 = IS_GDB+1;
-            fclose(input);
-          }
-        else
-          { input = fopen(Catenate(PATH1,"/",ROOT1,".1gdb"),"r");
-            if (input != NULL)
-              { fclose(input);
-                TYPE1 = IS_GDB;
-              }
-            else
-              { input = fopen(Catenate(PATH1,"/",ROOT1,".gdb"),"r");
-                if (input != NULL)
-                  { fclose(input);
-                    TYPE1 = IS_GDB;
-                  }
-              }
-          }
-      }
+  if (FREQ > 255)
+    { fprintf(stderr,"%s: The maximum allowable frequency cutoff is 255\n",Prog_Name);
+      exit (1);
+    }
 
-    TYPE2 = IS_GDB+1;
-    if (argc == 3)
-      { PATH2 = argv[2];
-        p = rindex(PATH2,'/');
-        if (p == NULL)
-          { ROOT2 = PATH2;
-            PATH2 = ".";
-          }
-        else
-          { *p++ = '\0';
-            ROOT2 = p;
-          }
+  if (PLAN && SERVER != NULL)
+    { fprintf(stderr,"%s: -plan cannot be used with -S\n",Prog_Name);
+      exit (1);
+    }
+  if (CKPT_PATH != NULL && SERVER != NULL)
+    { fprintf(stderr,"%s: -ckpt cannot be used with -S\n",Prog_Name);
+      exit (1);
+    }
+  if (NSHARDS > 1 && (SERVER != NULL || CLIENT != NULL))
+    { fprintf(stderr,"%s: -shard cannot be used with -S or -C\n",Prog_Name);
+      exit (1);
+    }
+  if (PLAN)
+    CKPT_PATH = NULL;
 
-        input = fopen(Catenate(PATH2,"/",ROOT2,".gix"),"r");
-        if (input != NULL)
-          { fclose(input);
-            TYPE2 = IS_GDB+1;
-          }
-        else if (strcmp(ROOT2+(strlen(ROOT2)-4),".gix") == 0)
-          { ROOT2[strlen(ROOT2)-4] = '\0';
-            TYPE2 = IS_GDB+1;
-          }
-        else
-          { TYPE2 = Get_GDB_Paths(Catenate(PATH2,"/",ROOT2,""),NULL,&SPATH2,&tpath2,0);
-            ROOT2 = Root(tpath2,NULL);
+  //  A plan writes nothing, else make sure the .1aln of a -1 option can be written
 
-            input = fopen(Catenate(PATH2,"/",ROOT2,".gix"),"r");
-            if (input != NULL)
-              { TYPE2 = IS_GDB+1;
-                fclose(input);
-              }
-            else
-              { input = fopen(Catenate(PATH2,"/",ROOT2,".1gdb"),"r");
-                if (input != NULL)
-                  { fclose(input);
-                    TYPE2 = IS_GDB;
-                  }
-                else
-                  { input = fopen(Catenate(PATH2,"/",ROOT2,".gdb"),"r");
-                    if (input != NULL)
-                      { fclose(input);
-                        TYPE2 = IS_GDB;
-                      }
-                  }
-              }
-          }
-      }
+  if (OUT_TYPE == 2 && ! PLAN)
+    { test = fopen(Catenate(ONE_PATH,"/",ONE_ROOT,".1aln"),"w");
+      if (test == NULL)
+        { fprintf(stderr,"%s: Cannot open %s/%s.1aln for output\n",Prog_Name,ONE_PATH,ONE_ROOT);
+          exit (1);
+        }
+      fclose(test);
+    }
 
-    if (TYPE1 <= IS_GDB)
-      { char *command;
+  return (argc);
+}
 
-        command = Malloc(strlen(SPATH1)+100,"Allocating command string");
-        if (command == NULL)
-          exit (1);
+int main(int argc, char *argv[])
+{ Kmer_Stream *T1, *T2;
+  Post_List   *P1, *P2;
+  GDB _gdb1, *gdb1 = &_gdb1;
+  GDB _gdb2, *gdb2 = &_gdb2;
+  char *tpath1, *tpath2;
 
-        if (TYPE1 < IS_GDB)
-          { sprintf(command,"FAtoGDB%s %s",VERBOSE?" -v":"",SPATH1);
-            if (system(command) != 0)
-              { fprintf(stderr,"\n%s: Call to FAtoGDB failed\n",Prog_Name);
-                exit (1);
-              }
-          }
+  //  Process options (keeping the original command line for a client request)
 
-	sprintf(command,"GIXmake%s -f%d %s",VERBOSE?" -v":"",FREQ,tpath1);
-        if (system(command) != 0)
-          { fprintf(stderr,"\n%s: Call to GIXmake failed\n",Prog_Name);
-            Clean_Exit(1);
-          }
+  { int    oargc = argc;
+    char  *oargv[argc];
 
-        free(command);
-        free(tpath1);
+    memcpy(oargv,argv,argc*sizeof(char *));
+    argc = process_options(argc,argv);
 
-        if (VERBOSE)
-          TimeTo(stderr,0);
-      }
+    //  If a client, send the request to the server and exit with its outcome
 
-    if (TYPE2 <= IS_GDB)
-      { char *command;
+    if (CLIENT != NULL)
+      exit (run_client(CLIENT,oargc,oargv));
+  }
 
-        command = Malloc(strlen(SPATH2)+100,"Allocating command string");
-        if (command == NULL)
-          exit (1);
+  if (VERBOSE)
+    StartTime();
 
-        if (TYPE2 < IS_GDB)
-          { sprintf(command,"FAtoGDB%s %s",VERBOSE?" -v":"",SPATH2);
-            if (system(command) != 0)
-              { fprintf(stderr,"\n%s: Call to FAtoGDB failed\n",Prog_Name);
-                Clean_Exit(1);
-              }
-          }
-	sprintf(command,"GIXmake%s -f%d %s",VERBOSE?" -v":"",FREQ,tpath2);
-        if (system(command) != 0)
-          { fprintf(stderr,"\n%s: Call to GIXmake failed\n",Prog_Name);
-            Clean_Exit(1);
-          }
-        free(command);
-        free(tpath2);
+  //  Parse source names
 
-        if (VERBOSE)
-          TimeTo(stderr,0);
-      }
-  }
+  TYPE1 = parse_source(argv[1],&PATH1,&ROOT1,&SPATH1,&tpath1);
+  if (argc == 3)
+    TYPE2 = parse_source(argv[2],&PATH2,&ROOT2,&SPATH2,&tpath2);
+  else
+    TYPE2 = IS_GDB+1;
 
   //  Get full path string for sorting subdirectory (in variable SORT_PATH)
 
@@ -3760,7 +5916,6 @@ int main(int argc, char *argv[])
               spath = cpath;
             else
               { fprintf(stderr,"\n%s: -P option: . not followed by /\n",Prog_Name);
-                Clean_Exit(1);
                 exit (1);
               }
           }
@@ -3774,87 +5929,117 @@ int main(int argc, char *argv[])
 
     if ((dirp = opendir(SORT_PATH)) == NULL)
       { fprintf(stderr,"\n%s: -P option: cannot open directory %s\n",Prog_Name,SORT_PATH);
-        Clean_Exit(1);
+        exit (1);
       }
     closedir(dirp);
+
+    if (CKPT_PATH != NULL)
+      { if ((dirp = opendir(CKPT_PATH)) == NULL)
+          { fprintf(stderr,"\n%s: -ckpt option: cannot open directory %s\n",
+                           Prog_Name,CKPT_PATH);
+            exit (1);
+          }
+        closedir(dirp);
+      }
   }
 
+  //  Make the precursors of, and open, the first source
+
+  if (PLAN && TYPE1 <= IS_GDB)
+    { fprintf(stderr,"%s: -plan needs an existing %s/%s.gix (see FAtoGDB and GIXmake)\n",
+                     Prog_Name,PATH1,ROOT1);
+      exit (1);
+    }
+  if (TYPE1 <= IS_GDB)
+    { Stats_Begin("build_source1");
+      make_precursors(SPATH1,tpath1,TYPE1);
+      Stats_End();
+      free(tpath1);
+      if (VERBOSE)
+        TimeTo(stderr,0);
+    }
+
+  if (SERVER != NULL)
+    make_resident();
+
+  open_index(PATH1,ROOT1,&T1,&P1);
+  open_gdb(PATH1,ROOT1,&GEXTN1,gdb1);
+
+  //  If a server, then the first source is the resident reference.  Each request returns
+  //    here in a forked child whose argv = FastGA <reference> <query>.
+
+  if (SERVER != NULL)
+    { argc = serve_requests(SERVER,&argv);
+
+      //  The child shares file offsets with the server's open descriptors, so it works
+      //    on clones of the index and (if they are not mapped) a fresh handle on the bases
+      //    of the reference.
+
+      T1 = Clone_Kmer_Stream(T1);
+      P1 = Clone_Post_List(P1);
+      if (gdb1->seqstate == EXTERNAL)
+        { gdb1->seqs = fopen(gdb1->seqpath,"r");
+          if (gdb1->seqs == NULL)
+            { fprintf(stderr,"%s: Cannot open another copy of GDB\n",Prog_Name);
+              Clean_Exit(1);
+            }
+        }
+      if (VERBOSE)
+        StartTime();
+      TYPE2 = parse_source(argv[2],&PATH2,&ROOT2,&SPATH2,&tpath2);
+    }
+
   SELF = (argc == 2);
 
-  T1 = Open_Kmer_Stream(Catenate(PATH1,"/",ROOT1,".gix"));
-  if (SELF)
-    T2 = T1;
-  else
-    T2 = Open_Kmer_Stream(Catenate(PATH2,"/",ROOT2,".gix"));
-  if (T1 == NULL)
-    { fprintf(stderr,"%s: Cannot find genome index for %s/%s.gix\n",Prog_Name,PATH1,ROOT1);
-      Clean_Exit(1);
+  //  Make the precursors of, and open, the second source (if any)
+
+  if (PLAN && TYPE2 <= IS_GDB)
+    { fprintf(stderr,"%s: -plan needs an existing %s/%s.gix (see FAtoGDB and GIXmake)\n",
+                     Prog_Name,PATH2,ROOT2);
+      exit (1);
     }
-  if (T2 == NULL)
-    { fprintf(stderr,"%s: Cannot find genome index for %s/%s.gix\n",Prog_Name,PATH2,ROOT2);
-      Clean_Exit(1);
+  if (TYPE2 <= IS_GDB)
+    { Stats_Begin("build_source2");
+      make_precursors(SPATH2,tpath2,TYPE2);
+      Stats_End();
+      free(tpath2);
+      if (VERBOSE)
+        TimeTo(stderr,0);
     }
-  
-  P1 = Open_Post_List(Catenate(PATH1,"/",ROOT1,".gix"));
+
   if (SELF)
-    P2 = P1;
-  else
-    P2 = Open_Post_List(Catenate(PATH2,"/",ROOT2,".gix"));
-  if (P1 == NULL)
-    { fprintf(stderr,"%s: Cannot find genome index for %s/%s.gix\n",Prog_Name,PATH1,ROOT1);
-      Clean_Exit(1);
+    { T2   = T1;
+      P2   = P1;
+      gdb2 = gdb1;
     }
-  if (P2 == NULL)
-    { fprintf(stderr,"%s: Cannot find genome index for %s/%s.gix\n",Prog_Name,PATH2,ROOT2);
-      Clean_Exit(1);
+  else
+    { open_index(PATH2,ROOT2,&T2,&P2);
+      open_gdb(PATH2,ROOT2,&GEXTN2,gdb2);
     }
 
   Perm1  = P1->perm;
   Perm2  = P2->perm;
   KMER   = T1->kmer;
 
-  { FILE *file;
-    char *fname;
-
-    GEXTN1 = ".gdb";
-    fname = Catenate(PATH1,"/",ROOT1,GEXTN1);
-    if ((file = fopen(fname,"r")) == NULL)
-      GEXTN1 = ".1gdb";
-    else
-      fclose(file);
-
-    if (Read_GDB(gdb1,Catenate(PATH1,"/",ROOT1,GEXTN1)) < 0)
-      Clean_Exit(1);
-    short_GDB_fix(gdb1);
-
-    if (SELF)
-      gdb2 = gdb1;
-    else
-      { GEXTN2 = ".gdb";
-        fname = Catenate(PATH1,"/",ROOT1,GEXTN2);
-        if ((file = fopen(fname,"r")) == NULL)
-          GEXTN2 = ".1gdb";
-        else
-          fclose(file);
-
-        if (Read_GDB(gdb2,Catenate(PATH2,"/",ROOT2,GEXTN2)) < 0)
-          Clean_Exit(1);
-        short_GDB_fix(gdb2);
-      }
-  }
-
-  if (OUT_TYPE != 2)
-    { ONE_ROOT = Strdup(Numbered_Suffix("_oaln.",getpid(),""),"Allocating temp name");
-      ONE_PATH = SORT_PATH;
-      if (ONE_ROOT == NULL)
-        Clean_Exit(1);
-    }
   ALGN_UNIQ = Strdup(Numbered_Suffix("_uniq.",getpid(),""),"Allocating temp name");
   PAIR_NAME = Strdup(Numbered_Suffix("_pair.",getpid(),""),"Allocating temp name");
   ALGN_PAIR = Strdup(Numbered_Suffix("_algn.",getpid(),""),"Allocating temp name");
   if (ALGN_UNIQ == NULL || PAIR_NAME == NULL || ALGN_PAIR == NULL)
     Clean_Exit(1);
 
+  if (CKPT_PATH != NULL)
+    { free(PAIR_NAME);
+      PAIR_NAME = Strdup("pairs","Allocating temp name");
+      PAIR_PATH = CKPT_PATH;
+      UNIQ_PATH = CKPT_PATH;
+      UNIQ_NAME = "align";
+    }
+  else
+    { PAIR_PATH = SORT_PATH;
+      UNIQ_PATH = SORT_PATH;
+      UNIQ_NAME = ALGN_UNIQ;
+    }
+
   if (P1->freq < FREQ)
     { fprintf(stderr,"%s: Genome index %s/%s.gix cutoff of %d < requested cutoff\n",
                      Prog_Name,PATH1,ROOT1,P1->freq);
@@ -3907,6 +6092,8 @@ int main(int argc, char *argv[])
   LBYTE = CBYTE+1;
 
   ESHIFT = 8*IPOST;
+  IMASK  = (0x1ll << (8*IBYTE)) - 1;
+  JMASK  = (0x1ll << (8*JBYTE)) - 1;
 
   { int64 cum;      // DBYTE accommodates the sum of the largest contig positions in each GDB !
     int   r, len;
@@ -3943,82 +6130,118 @@ int main(int argc, char *argv[])
       fflush(stderr);
     }
 
-  { int64 npost, cum, t;   //  Compute GDB split into NTHREADS parts
-    int   p, r, x;
-
-    NCONTS = gdb1->ncontig;
+  { NCONTS = gdb1->ncontig;   //  Compute GDB split into NTHREADS parts
 
     IDBsplit = Malloc((NTHREADS+1)*sizeof(int),"Allocating GDB1 partitions");
     Select   = Malloc(NCONTS*sizeof(int),"Allocating GDB1 partition");
     if (IDBsplit == NULL || Select == NULL)
       Clean_Exit(1);
 
-    npost = gdb1->seqtot;
-    IDBsplit[0] = 0;
-    Select[0] = 0;
-    p = 0;
-    r = NTHREADS;
-    t = npost/NTHREADS;
-    cum = gdb1->contigs[Perm1[0]].clen;
-    for (x = 1; x < NCONTS; x++)
-      { if (cum >= t && x >= r)
-          { p += 1;
-            IDBsplit[p] = x;
-            t = (npost*(p+1))/NTHREADS;
-            r += NTHREADS;
+    if (NSHARDS > 1)      //  Compare only the A-contigs of the shard, the same on every node
+      { int *shards, x;
+
+        shards = Malloc((NSHARDS+1)*sizeof(int),"Allocating GDB1 shards");
+        if (shards == NULL)
+          Clean_Exit(1);
+        if (split_gdb(gdb1,Perm1,0,NCONTS,NSHARDS,shards,NULL) < NSHARDS)
+          { fprintf(stderr,"%s: %s has too few contigs to divide into %d shards\n",
+                           Prog_Name,ROOT1,NSHARDS);
+            Clean_Exit(1);
+          }
+        for (x = 0; x < NCONTS; x++)
+          Select[x] = -1;
+        SHARD_LEN = 0;
+        for (x = shards[SHARD]; x < shards[SHARD+1]; x++)
+          SHARD_LEN += gdb1->contigs[Perm1[x]].clen;
+        NPARTS = split_gdb(gdb1,Perm1,shards[SHARD],shards[SHARD+1],NTHREADS,IDBsplit,Select);
+        free(shards);
+
+        if (VERBOSE)
+          { fprintf(stderr,"  Shard %d of %d: %d of %d A-contigs, ",
+                           SHARD+1,NSHARDS,IDBsplit[NPARTS]-IDBsplit[0],NCONTS);
+            Print_Number(SHARD_LEN,0,stderr);
+            fprintf(stderr," bp\n\n");
+            fflush(stderr);
           }
-        Select[x] = p;
-        cum += gdb1->contigs[Perm1[x]].clen;
       }
-    NPARTS = p+1;
-    IDBsplit[NPARTS] = NCONTS;
+    else
+      { SHARD_LEN = gdb1->seqtot;
+        NPARTS = split_gdb(gdb1,Perm1,0,NCONTS,NTHREADS,IDBsplit,Select);
+      }
 
 #ifdef DEBUG_SPLIT
-    for (x = 0; x < NPARTS; x++)
-      { printf(" %2d: %4d - %4d\n",x,IDBsplit[x],IDBsplit[x+1]);
-        for (r = IDBsplit[x]; r < IDBsplit[x+1]; r++)
-          if (Select[r] != x)
-            printf("  Not OK: %d->%d\n",r,Select[x]);
-      }
+    { int r, x;
+
+      for (x = 0; x < NPARTS; x++)
+        { printf(" %2d: %4d - %4d\n",x,IDBsplit[x],IDBsplit[x+1]);
+          for (r = IDBsplit[x]; r < IDBsplit[x+1]; r++)
+            if (Select[r] != x)
+              printf("  Not OK: %d->%d\n",r,Select[x]);
+        }
+    }
 #endif
   }
 
+  if (PLAN)
+    { plan_report(gdb1,gdb2,T1,T2,P1,P2);
+      Clean_Exit(0);
+    }
+
+  if (CKPT_PATH != NULL)
+    ckpt_open();
+
   { int    i, j, k, x;   // Setup temporary pair file IO buffers
     uint8 *buffer;
     int64 *bucks;
     char  *name;
     int   *nfile, *cfile;
+    int    mode;
 
     N_Units = Malloc(NPARTS*NTHREADS*sizeof(IOBuffer),"IO buffers");
     C_Units = Malloc(NPARTS*NTHREADS*sizeof(IOBuffer),"IO buffers");
-    buffer  = Malloc(2*NPARTS*NTHREADS*1000000,"IO buffers");
+    buffer  = Malloc(2*NPARTS*NTHREADS*SEED_BLOCK,"IO buffers");
     bucks   = Malloc(2*NTHREADS*NCONTS*sizeof(int64),"IO buffers");
     if (N_Units == NULL || C_Units == NULL || buffer == NULL || bucks == NULL)
       Clean_Exit(1);
 
+    if (CKPT_LEVEL == CKPT_MERGED)    //  Reopen the seed pair files of a checkpoint
+      mode = O_RDWR;
+    else
+      mode = O_RDWR|O_CREAT|O_TRUNC;
+
     k = 0;
     for (i = 0; i < NTHREADS; i++)
       for (j = 0; j < NPARTS; j++)
-        { N_Units[k].bufr = buffer + (2*k) * 1000000; 
-          C_Units[k].bufr = buffer + (2*k+1) * 1000000; 
+        { N_Units[k].bufr = buffer + (2*k) * SEED_BLOCK; 
+          C_Units[k].bufr = buffer + (2*k+1) * SEED_BLOCK; 
           N_Units[k].buck = bucks + (2*i) * NCONTS; 
           C_Units[k].buck = bucks + (2*i+1) * NCONTS; 
           N_Units[k].inum = k;
           C_Units[k].inum = k;
-          name = Catenate(SORT_PATH,"/",PAIR_NAME,Numbered_Suffix(".",k,".N"));
-          N_Units[k].file = open(name,O_RDWR|O_CREAT|O_TRUNC,S_IRWXU);
+          N_Units[k].type = 'N';
+          C_Units[k].type = 'C';
+          if (CKPT_LEVEL == CKPT_SEARCHED)      //  The seed pairs are no longer needed
+            { N_Units[k].file = -1;
+              C_Units[k].file = -1;
+              k += 1;
+              continue;
+            }
+          name = Catenate(PAIR_PATH,"/",PAIR_NAME,Numbered_Suffix(".",k,".N"));
+          N_Units[k].file = open(name,mode,S_IRWXU);
           if (N_Units[k].file < 0)
             { fprintf(stderr,"%s: Cannot open %s for reading & writing\n",Prog_Name,name);
               Clean_Exit(1);
             }
-          unlink(name);
-          name = Catenate(SORT_PATH,"/",PAIR_NAME,Numbered_Suffix(".",k,".C"));
-          C_Units[k].file = open(name,O_RDWR|O_CREAT|O_TRUNC,S_IRWXU);
-          if (C_Units[j].file < 0)
+          if (CKPT_PATH == NULL)
+            unlink(name);
+          name = Catenate(PAIR_PATH,"/",PAIR_NAME,Numbered_Suffix(".",k,".C"));
+          C_Units[k].file = open(name,mode,S_IRWXU);
+          if (C_Units[k].file < 0)
             { fprintf(stderr,"%s: Cannot open %s for reading & writing\n",Prog_Name,name);
               Clean_Exit(1);
             }
-          unlink(name);
+          if (CKPT_PATH == NULL)
+            unlink(name);
           k += 1;
         }
 
@@ -4036,10 +6259,43 @@ int main(int argc, char *argv[])
       }
 #endif
 
-    if (SELF)
-      self_adaptamer_merge(T1,P1);
+    if (CKPT_LEVEL == CKPT_NONE)
+      { Stats_Begin("adaptamer_merge");
+
+        if (SELF)
+          self_adaptamer_merge(T1,P1);
+        else
+          adaptamer_merge(T1,T2,P1,P2);
+
+        if (CKPT_PATH != NULL)
+          ckpt_merged(bucks);
+      }
     else
-      adaptamer_merge(T1,T2,P1,P2);
+      { Free_Kmer_Stream(T1);     //  As the merge would have
+        if ( ! SELF)
+          Free_Kmer_Stream(T2);
+        if (CKPT_LEVEL == CKPT_MERGED)
+          ckpt_bucks(bucks);
+      }
+
+    if (STAT_NAME != NULL && CKPT_LEVEL < CKPT_SEARCHED)
+      { struct stat sb;
+        int64       nbytes;
+
+        nbytes = 0;
+        for (k = 0; k < NPARTS*NTHREADS; k++)
+          { if (fstat(N_Units[k].file,&sb) == 0)
+              nbytes += sb.st_size;
+            if (fstat(C_Units[k].file,&sb) == 0)
+              nbytes += sb.st_size;
+          }
+        if (CKPT_LEVEL == CKPT_NONE)
+          { Stats_Count("tmp_written",-1,nbytes);
+            Stats_End();
+          }
+        Stats_Begin("seed_sort_search");
+        Stats_Count("tmp_read",-1,nbytes);
+      }
 
     if (VERBOSE)
       TimeTo(stderr,0);
@@ -4052,7 +6308,7 @@ int main(int argc, char *argv[])
     for (j = 0; j < NPARTS; j++)
       for (i = 0; i < NTHREADS; i++)
         { N_Units[k].bufr = 
-          C_Units[k].bufr = buffer + i * (2*NPARTS*1000000); 
+          C_Units[k].bufr = buffer + i * (2*NPARTS*SEED_BLOCK); 
           x = i*NPARTS+j;
           nfile[k] = N_Units[x].file;
           cfile[k] = C_Units[x].file;
@@ -4084,7 +6340,21 @@ int main(int argc, char *argv[])
       }
 #endif
   
-    pair_sort_search(gdb1,gdb2);
+    if (CKPT_LEVEL == CKPT_SEARCHED)
+      resume_alignments(gdb1,gdb2);
+    else
+      pair_sort_search(gdb1,gdb2);
+
+    if (CKPT_PATH != NULL)
+      ckpt_done();
+
+    if (STAT_NAME != NULL)
+      { struct stat sb;
+
+        if (OUT_TYPE == 2 && stat(Catenate(ONE_PATH,"/",ONE_ROOT,".1aln"),&sb) == 0)
+          Stats_Count("output_bytes",-1,sb.st_size);
+        Stats_End();
+      }
 
     if (VERBOSE)
       TimeTo(stderr,0);
@@ -4093,55 +6363,15 @@ int main(int argc, char *argv[])
     free(N_Units->bufr);
     free(C_Units);
     free(N_Units);
-
-    if (OUT_TYPE != 2)
-      { char *command;
-
-        if (VERBOSE)
-          { fprintf(stderr,"\n  Converting aln's to %s-format\n",OUT_TYPE==0?"PAF":"PSL");
-            fflush(stderr);
-          }
-
-        command = Malloc(strlen(ONE_ROOT)+strlen(ONE_PATH)+100,"Allocating command buffer");
-        if (command == NULL)
-          { unlink(Catenate(ONE_PATH,"/",ONE_ROOT,".1aln"));
-            Clean_Exit(1);
-          }
-
-        switch (OUT_TYPE)
-        { case 0: // PAF
-            sprintf(command,"ALNtoPAF%s -T%d %s/%s",
-                            OUT_OPT==2?" -x":(OUT_OPT==1?" -m":""),NTHREADS,ONE_PATH,ONE_ROOT);
-            break;
-          case 1: // PSL
-            sprintf(command,"ALNtoPSL -T%d %s/%s",NTHREADS,ONE_PATH,ONE_ROOT);
-            break;
-        }
-
-        if (system(command) != 0)
-          { switch (OUT_TYPE)
-            { case 0:
-                fprintf(stderr,"\n%s: Call to ALNtoPAF failed\n",Prog_Name);
-                break;
-              case 1:
-                fprintf(stderr,"\n%s: Call to ALNtoPSL failed\n",Prog_Name);
-                break;
-            }
-            unlink(Catenate(ONE_PATH,"/",ONE_ROOT,".1aln"));
-            Clean_Exit(1);
-          }
-
-        free(command);
-        unlink(Catenate(ONE_PATH,"/",ONE_ROOT,".1aln"));
-
-        if (VERBOSE)
-          TimeTo(stderr,0);
-      }
   }
 
   if (VERBOSE)
     TimeTo(stderr,1);
 
+  Stats_Begin("total");
+  Stats_End();
+  free(Stat_Items);
+
   free(Select);
   free(IDBsplit);
 
@@ -19,8 +19,10 @@
 #include <dirent.h>
 #include <limits.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <zlib.h>
+#include <pthread.h>
 
 #include "gene_core.h"
 #include "GDB.h"
@@ -341,7 +343,7 @@ error:
  *
  ********************************************************************************************/
 
-static char number[128] =
+static char number[256] =
     { 0, 0, 0, 0, 0, 0, 0, 0,
       0, 0, 0, 0, 0, 0, 0, 0,
       0, 0, 0, 0, 0, 0, 0, 0,
@@ -360,77 +362,567 @@ static char number[128] =
       0, 0, 0, 0, 0, 0, 0, 0,
     };
 
-//  Read next line into a buffer and return a pointer to the buffer and set *plen
-//    the length of the line.  NB: replaces '\n' with '\0'.
+/*******************************************************************************************
+ *
+ *  PARALLEL FASTA INGEST
+ *
+ *  The text of a fasta source is delivered in chunks of about INGEST_CHUNK bytes by a reader
+ *    thread that runs one batch of chunks ahead of the workers.  A chunk never ends inside a
+ *    header line but may end in the middle of a sequence line.  A batch of up to Ingest_Threads
+ *    chunks is then processed in three steps:
+ *      1. In parallel, each chunk is scanned into a list of events (a header, a run of ACGT,
+ *         or a run of N's) and its base counts.
+ *      2. Serially, the events are walked to build the scaffold, contig, and header arrays
+ *         exactly as a line by line reading would, and to place each chunk's bases in the
+ *         .bps file.
+ *      3. In parallel, each chunk packs its bases 2-bits per base.  The first and last byte
+ *         of a chunk's packing may be shared with its neighbors, and are or'd together as the
+ *         packings are written in order.
+ *  A gzip'd source is inflated by the reader thread, save that if it is BGZF then its blocks
+ *    are inflated in parallel by a team of Ingest_Threads threads.
+ *
+ ********************************************************************************************/
 
-static char *read_line(void *input, int gzipd, int *plen, int nline, char *spath)
-{ static char *buffer;
-  static int   bmax = 0;
-  int len;
+#define INGEST_CHUNK 0x200000   //  Target # of bytes of text per chunk
+#define BGZF_BLOCKS  32         //  # of BGZF blocks inflated by each thread per refill
+#define BGZF_HEAD    18         //  # of header bytes in a BGZF block
 
-  if (bmax == 0)
-    { bmax = 500;
-      buffer = (char *) malloc(bmax);
-      if (buffer == NULL)
-        { EPRINTF(EPLACE,"%s: Out of memory reading %s\n",Prog_Name,spath);
-          return (ERROR);
+static int Ingest_Threads = 1;
+
+void Set_GDB_Threads(int nthreads)
+{ if (nthreads < 1)
+    nthreads = 1;
+  Ingest_Threads = nthreads;
+}
+
+#define EVT_HEAD 0   //  A header, text at 'off' in chunk of length 'len' on line 'line' of chunk
+#define EVT_BASE 1   //  A run of 'len' ACGT's
+#define EVT_GAP  2   //  A run of 'len' N's
+
+typedef struct
+  { int   kind;
+    int64 len;
+    int64 off;
+    int64 line;
+  } Ingest_Event;
+
+typedef struct
+  { char         *text;      //  text of the chunk in [0,tlen), tmax bytes allocated
+    int64         tlen;
+    int64         tmax;
+    int           midl;      //  chunk starts in the middle of a sequence line
+
+    int           nevt;      //  events of the chunk (step 1), emax allocated
+    int           emax;
+    Ingest_Event *evts;
+    int64         nlines;    //  # of '\n's in the chunk
+    int64         count[4];  //  # of A, C, G, and T in the chunk
+    int           error;     //  could not allocate events
+
+    int           pin;       //  a contig is in progress at the start of the chunk (step 2)
+    int           phase;     //  # of its bases already in the byte at pbeg
+    int           hold;      //  a contig is in progress at the end whose last byte is partial
+    int64         pbeg;      //  the chunk's bases go to .bps bytes [pbeg,pend)
+    int64         pend;
+    uint8        *pack;      //  2-bit packing of the chunk's bases (step 3), pmax allocated
+    int64         pmax;
+  } Ingest_Chunk;
+
+#define SRC_PLAIN 0
+#define SRC_GZIP  1
+#define SRC_BGZF  2
+
+typedef struct
+  { int      kind;      //  SRC_PLAIN, SRC_GZIP, or SRC_BGZF
+    FILE    *file;      //  open source if PLAIN or BGZF
+    gzFile   gzip;      //  open source if GZIP
+    int      nthreads;
+    int      eof;       //  source is exhausted
+    int      error;     //  0 = OK, 1 = read error, 2 = corrupt BGZF, 3 = out of memory
+
+    uint8   *cbuf;      //  BGZF: compressed blocks of the current refill, cmax allocated
+    int64    cmax;
+    char    *ubuf;      //  BGZF: their inflation, of which [ucur,ulen) remains to be delivered
+    int64    umax;
+    int64    ulen;
+    int64    ucur;
+    int      nblk;      //  BGZF: # of blocks in the refill and the offsets in cbuf & ubuf
+    int64   *coff;      //    of each, [nblk] being the end
+    int64   *uoff;
+
+    char    *tail;      //  start of a header line to carry into the next chunk, tmax allocated
+    int64    ntail;
+    int64    tmax;
+    int      midl;      //  the next chunk starts in the middle of a sequence line
+    int64    nread;     //  total # of bytes of text delivered
+    char     last;      //  the last byte of text delivered
+  } Ingest_Source;
+
+typedef struct
+  { Ingest_Source *src;
+    Ingest_Chunk  *chunk;
+    int            nchunk;
+  } Ingest_Batch;
+
+typedef struct
+  { Ingest_Source *src;
+    int            beg, end;
+    int            error;
+  } Inflate_Arg;
+
+static int is_bgzf(uint8 *h)
+{ return (h[0] == 31 && h[1] == 139 && h[2] == 8 && (h[3] & 0x4) != 0
+       && h[10] == 6 && h[11] == 0 && h[12] == 'B' && h[13] == 'C' && h[14] == 2 && h[15] == 0);
+}
+
+static inline uint32 le32(uint8 *b)
+{ return (b[0] | (b[1] << 8) | (b[2] << 16) | (((uint32) b[3]) << 24)); }
+
+//  Inflate BGZF blocks [beg,end) of the current refill into their places in ubuf
+
+static void *inflate_thread(void *arg)
+{ Inflate_Arg   *parm = (Inflate_Arg *) arg;
+  Ingest_Source *src  = parm->src;
+  z_stream       zs;
+  int            b;
+
+  memset(&zs,0,sizeof(z_stream));
+  if (inflateInit2(&zs,-MAX_WBITS) != Z_OK)
+    { parm->error = 3;
+      return (NULL);
+    }
+  for (b = parm->beg; b < parm->end; b++)
+    { uint8 *blk  = src->cbuf + src->coff[b];
+      int64  blen = src->coff[b+1] - src->coff[b];
+      int64  ulen = src->uoff[b+1] - src->uoff[b];
+      uint8 *out  = (uint8 *) (src->ubuf + src->uoff[b]);
+
+      inflateReset(&zs);
+      zs.next_in   = blk + BGZF_HEAD;
+      zs.avail_in  = blen - (BGZF_HEAD+8);
+      zs.next_out  = out;
+      zs.avail_out = ulen;
+      if (inflate(&zs,Z_FINISH) != Z_STREAM_END || zs.total_out != (uLong) ulen
+                 || crc32(crc32(0,Z_NULL,0),out,ulen) != le32(blk+(blen-8)))
+        { parm->error = 2;
+          break;
         }
     }
+  inflateEnd(&zs);
+  return (NULL);
+}
 
-  if (gzipd)
-    { if (gzgets(input,buffer,bmax) == NULL)
-        { if (gzeof(input))
-            return (NULL);
-          EPRINTF(EPLACE,"%s: Could not read next line, %d, of file %s\n",Prog_Name,nline,spath);
-          return (ERROR);
+//  Read the next run of BGZF blocks and inflate them in parallel.  Returns the # of bytes
+//    of text now available (0 at the end of the source).
+
+static int64 refill_bgzf(Ingest_Source *src)
+{ int          nblk, b, t, T;
+  int64        cur, ulen;
+  uint8        head[BGZF_HEAD];
+  Inflate_Arg *parm;
+  pthread_t   *threads;
+
+  T    = src->nthreads;
+  nblk = T*BGZF_BLOCKS;
+  if (src->coff == NULL)
+    { src->coff = malloc(2*(nblk+1)*sizeof(int64));
+      src->cmax = nblk*0x10000;
+      src->cbuf = malloc(src->cmax);
+      src->umax = nblk*0x10000;
+      src->ubuf = malloc(src->umax);
+      if (src->coff == NULL || src->cbuf == NULL || src->ubuf == NULL)
+        { src->error = 3;
+          return (0);
         }
+      src->uoff = src->coff + (nblk+1);
     }
-  else
-    { if (fgets(buffer,bmax,input) == NULL)
-        { if (feof(input))
-            return (NULL);
-          EPRINTF(EPLACE,"%s: Could not read next line, %d, of file %s\n",Prog_Name,nline,spath);
-          return (ERROR);
+
+  cur  = 0;
+  ulen = 0;
+  for (b = 0; b < nblk; b++)
+    { int64 bsize, n;
+
+      n = fread(head,1,BGZF_HEAD,src->file);
+      if (n == 0 && feof(src->file))
+        break;
+      if (n < BGZF_HEAD || !is_bgzf(head))
+        { src->error = (ferror(src->file) ? 1 : 2);
+          return (0);
+        }
+      bsize = head[16] | (head[17] << 8);
+      bsize += 1;
+      if (bsize < BGZF_HEAD+8)
+        { src->error = 2;
+          return (0);
+        }
+      memcpy(src->cbuf+cur,head,BGZF_HEAD);
+      if (fread(src->cbuf+cur+BGZF_HEAD,bsize-BGZF_HEAD,1,src->file) != 1)
+        { src->error = (ferror(src->file) ? 1 : 2);
+          return (0);
+        }
+      src->coff[b] = cur;
+      src->uoff[b] = ulen;
+      cur  += bsize;
+      ulen += le32(src->cbuf+(cur-4));
+      if (ulen > src->umax)
+        { src->error = 2;
+          return (0);
         }
     }
+  src->coff[b] = cur;
+  src->uoff[b] = ulen;
+  src->nblk    = b;
+  src->ucur    = 0;
+  src->ulen    = ulen;
+  if (b == 0)
+    return (0);
+
+  if (T > b)
+    T = b;
+  parm    = malloc(T*sizeof(Inflate_Arg));
+  threads = malloc(T*sizeof(pthread_t));
+  if (parm == NULL || threads == NULL)
+    { free(threads);
+      free(parm);
+      src->error = 3;
+      return (0);
+    }
+  for (t = 0; t < T; t++)
+    { parm[t].src   = src;
+      parm[t].beg   = (((int64) b)*t)/T;
+      parm[t].end   = (((int64) b)*(t+1))/T;
+      parm[t].error = 0;
+    }
+  for (t = 1; t < T; t++)
+    pthread_create(threads+t,NULL,inflate_thread,parm+t);
+  inflate_thread(parm);
+  for (t = 1; t < T; t++)
+    pthread_join(threads[t],NULL);
+  for (t = 0; t < T; t++)
+    if (parm[t].error)
+      src->error = parm[t].error;
+  free(threads);
+  free(parm);
+
+  if (src->error)
+    return (0);
+  return (ulen);
+}
 
-  len = strlen(buffer);
-  while (buffer[len-1] != '\n')
-    { bmax = ((int) (1.4*bmax)) + 100;
-      buffer = (char *) realloc(buffer,bmax);
-      if (buffer == NULL)
-        { EPRINTF(EPLACE,"%s: Out of memory reading %s\n",Prog_Name,spath);
-          return (ERROR);
+//  Read up to n bytes of text into buf, returning the number read.  Fewer than n are returned
+//    only at the end of the source or on an error (src->error != 0).
+
+static int64 source_read(Ingest_Source *src, char *buf, int64 n)
+{ int64 r, k;
+
+  if (src->eof || src->error)
+    return (0);
+  switch (src->kind)
+  { case SRC_PLAIN:
+      r = fread(buf,1,n,src->file);
+      if (r < n)
+        { if (ferror(src->file))
+            src->error = 1;
+          src->eof = 1;
         }
-      if (gzipd)
-        { if (gzgets(input,buffer+len,bmax-len) == NULL)
-            { if (gzeof(input))
-                EPRINTF(EPLACE,"%s: Last line %d of file %s does not end with new-line\n",
-                               Prog_Name,nline,spath);
-              else
-                EPRINTF(EPLACE,"%s: Could not read next line, %d, of file %s\n",
-                               Prog_Name,nline,spath);
-              return (ERROR);
+      break;
+    case SRC_GZIP:
+      r = gzread(src->gzip,buf,n);
+      if (r < n)
+        { if (r < 0)
+            { src->error = 1;
+              r = 0;
+            }
+          src->eof = 1;
+        }
+      break;
+    default:
+      r = 0;
+      while (r < n)
+        { if (src->ucur >= src->ulen && refill_bgzf(src) == 0)
+            { src->eof = 1;
+              break;
             }
+          k = src->ulen - src->ucur;
+          if (k > n-r)
+            k = n-r;
+          memcpy(buf+r,src->ubuf+src->ucur,k);
+          src->ucur += k;
+          r += k;
+        }
+      break;
+  }
+  return (r);
+}
+
+//  Fill chunk c with the next text of the source, cutting it so that it does not end inside a
+//    header line.  Returns 0 if out of memory.
+
+static int fill_chunk(Ingest_Source *src, Ingest_Chunk *c)
+{ int64 tlen, want;
+  char *p;
+
+  if (c->tmax < src->ntail + INGEST_CHUNK)
+    { c->tmax = src->ntail + INGEST_CHUNK;
+      free(c->text);
+      c->text = malloc(c->tmax);
+      if (c->text == NULL)
+        return (0);
+    }
+  c->midl = src->midl;
+  memcpy(c->text,src->tail,src->ntail);
+  tlen = src->ntail;
+  src->ntail = 0;
+  want = INGEST_CHUNK;
+  while (1)
+    { tlen += source_read(src,c->text+tlen,want);
+      if (src->eof || src->error)
+        break;
+      for (p = c->text + (tlen-1); p >= c->text; p--)
+        if (*p == '\n')
+          break;
+      if (p >= c->text)
+        { if (p+1 < c->text+tlen && p[1] == '>')
+            { src->ntail = (c->text+tlen) - (p+1);
+              if (src->ntail > src->tmax)
+                { src->tmax = 1.2*src->ntail + 1000;
+                  free(src->tail);
+                  src->tail = malloc(src->tmax);
+                  if (src->tail == NULL)
+                    return (0);
+                }
+              memcpy(src->tail,p+1,src->ntail);
+              tlen = (p+1) - c->text;
+            }
+          break;
+        }
+      if (c->midl || c->text[0] != '>')
+        break;
+      c->tmax *= 2;                         //  A header line longer than the chunk
+      c->text  = realloc(c->text,c->tmax);
+      if (c->text == NULL)
+        return (0);
+      want = c->tmax - tlen;
+    }
+  c->tlen = tlen;
+  if (tlen > 0)
+    { src->last  = c->text[tlen-1];
+      src->midl  = (src->last != '\n');
+      src->nread += tlen;
+    }
+  return (1);
+}
+
+//  The reader thread: fill the chunks of a batch
+
+static void *read_batch(void *arg)
+{ Ingest_Batch  *b   = (Ingest_Batch *) arg;
+  Ingest_Source *src = b->src;
+  int            n;
+
+  n = 0;
+  while (n < src->nthreads && (!src->eof || src->ntail > 0) && src->error == 0)
+    { if (!fill_chunk(src,b->chunk+n))
+        { src->error = 3;
+          break;
+        }
+      n += 1;
+    }
+  b->nchunk = n;
+  return (NULL);
+}
+
+static int add_event(Ingest_Chunk *c, int kind, int64 len, int64 off, int64 line)
+{ Ingest_Event *e;
+
+  if (kind != EVT_HEAD && c->nevt > 0 && c->evts[c->nevt-1].kind == kind)
+    { c->evts[c->nevt-1].len += len;
+      return (1);
+    }
+  if (c->nevt >= c->emax)
+    { c->emax = 1.2*c->nevt + 1000;
+      c->evts = realloc(c->evts,c->emax*sizeof(Ingest_Event));
+      if (c->evts == NULL)
+        { c->emax = 0;
+          c->nevt = 0;
+          c->error = 1;
+          return (0);
+        }
+    }
+  e = c->evts + c->nevt++;
+  e->kind = kind;
+  e->len  = len;
+  e->off  = off;
+  e->line = line;
+  return (1);
+}
+
+//  Step 1: scan a chunk into events and base counts
+
+static void *scan_chunk(void *arg)
+{ Ingest_Chunk *c = (Ingest_Chunk *) arg;
+  uint8 *s, *e, *q, *t;
+  int64  line, cnt[4];
+  int    bol, x;
+
+  cnt[0] = cnt[1] = cnt[2] = cnt[3] = 0;
+  c->nevt  = 0;
+  c->error = 0;
+  line = 0;
+  bol  = !c->midl;
+  s = (uint8 *) c->text;
+  e = s + c->tlen;
+  while (s < e)
+    { q = memchr(s,'\n',e-s);
+      if (q == NULL)
+        q = e;
+      if (bol && *s == '>')
+        { if (!add_event(c,EVT_HEAD,q-(s+1),(s+1)-(uint8 *) c->text,line))
+            return (NULL);
         }
       else
-        { if (fgets(buffer+len,bmax-len,input) == NULL)
-            { if (feof(input))
-                EPRINTF(EPLACE,"%s: Last line %d of file %s does not end with new-line\n",
-                               Prog_Name,nline,spath);
-              else
-                EPRINTF(EPLACE,"%s: Could not read next line, %d, of file %s\n",
-                               Prog_Name,nline,spath);
-              return (ERROR);
+        while (s < q)
+          { t = s;
+            if (number[*t] < 4)
+              { while (t < q && (x = number[*t]) < 4)
+                  { cnt[x] += 1;
+                    t += 1;
+                  }
+                if (!add_event(c,EVT_BASE,t-s,0,0))
+                  return (NULL);
+              }
+            else
+              { while (t < q && number[*t] == 4)
+                  t += 1;
+                if (!add_event(c,EVT_GAP,t-s,0,0))
+                  return (NULL);
+              }
+            s = t;
+          }
+      if (q >= e)
+        break;
+      line += 1;
+      s   = q+1;
+      bol = 1;
+    }
+  c->nlines   = line;
+  c->count[0] = cnt[0];
+  c->count[1] = cnt[1];
+  c->count[2] = cnt[2];
+  c->count[3] = cnt[3];
+  return (NULL);
+}
+
+//  Step 3: pack the bases of a chunk into pack[0..pend-pbeg)
+
+static void *pack_chunk(void *arg)
+{ Ingest_Chunk *c = (Ingest_Chunk *) arg;
+  uint8 *s, *e, *q, *p;
+  int64  o;
+  int    m, in, bol, x;
+
+  p  = c->pack;
+  o  = 0;
+  m  = c->phase;
+  in = c->pin;
+  memset(p,0,c->pend-c->pbeg);
+
+  bol = !c->midl;
+  s = (uint8 *) c->text;
+  e = s + c->tlen;
+  while (s < e)
+    { q = memchr(s,'\n',e-s);
+      if (q == NULL)
+        q = e;
+      if (bol && *s == '>')
+        { if (in)
+            { if (m != 0)
+                { o += 1;
+                  m  = 0;
+                }
+              in = 0;
             }
         }
-      len += strlen(buffer+len);
+      else
+        for ( ; s < q; s++)
+          { x = number[*s];
+            if (x < 4)
+              { p[o] |= (x << (m << 1));
+                if (++m == 4)
+                  { o += 1;
+                    m  = 0;
+                  }
+                in = 1;
+              }
+            else if (in)
+              { if (m != 0)
+                  { o += 1;
+                    m  = 0;
+                  }
+                in = 0;
+              }
+          }
+      if (q >= e)
+        break;
+      s   = q+1;
+      bol = 1;
+    }
+  return (NULL);
+}
+
+//  Open the source spath for ingest, returning 1 if it cannot be opened
+
+static int open_source(Ingest_Source *src, char *spath, int ftype)
+{ memset(src,0,sizeof(Ingest_Source));
+  src->nthreads = Ingest_Threads;
+
+  if (ftype == IS_FA_GZ)
+    { uint8 head[BGZF_HEAD];
+
+      src->file = fopen(spath,"r");
+      if (src->file == NULL)
+        return (1);
+      if (fread(head,1,BGZF_HEAD,src->file) == BGZF_HEAD && is_bgzf(head))
+        { src->kind = SRC_BGZF;
+          rewind(src->file);
+          return (0);
+        }
+      fclose(src->file);
+      src->file = NULL;
+      src->kind = SRC_GZIP;
+      src->gzip = gzopen(spath,"r");
+      if (src->gzip == NULL)
+        return (1);
+      gzbuffer(src->gzip,0x40000);
     }
-  buffer[--len] = '\0';
+  else
+    { src->kind = SRC_PLAIN;
+      src->file = fopen(spath,"r");
+      if (src->file == NULL)
+        return (1);
+    }
+  return (0);
+}
 
-  if (plen != NULL)
-    *plen = len;
-  return (buffer);
+static void close_source(Ingest_Source *src, Ingest_Chunk *chunks, int nchunks)
+{ int i;
+
+  if (src->gzip != NULL)
+    gzclose(src->gzip);
+  if (src->file != NULL)
+    fclose(src->file);
+  free(src->tail);
+  free(src->coff);
+  free(src->cbuf);
+  free(src->ubuf);
+  if (chunks != NULL)
+    { for (i = 0; i < nchunks; i++)
+        { free(chunks[i].text);
+          free(chunks[i].evts);
+          free(chunks[i].pack);
+        }
+      free(chunks);
+    }
 }
 
 FILE **Create_GDB(GDB *gdb, char *spath, int ftype, int bps, char *tpath)
@@ -444,11 +936,13 @@ FILE **Create_GDB(GDB *gdb, char *spath, int ftype, int bps, char *tpath)
   FILE          *bases;
   int64          hdrtot, maxctg, seqtot, boff;
   int            ncontig, nscaff, nprov;
-  int            len, clen;
-  int64          spos;
+  int            len;
+  int64          clen, spos;
 
-  int            gzipd, nline;
-  void          *input;
+  Ingest_Source  src;
+  Ingest_Chunk  *chunks;
+  pthread_t     *threads, reader;
+  int            T, reading;
 
   OneSchema     *schema;
   OneFile       *of;
@@ -683,227 +1177,272 @@ FILE **Create_GDB(GDB *gdb, char *spath, int ftype, int bps, char *tpath)
 
   else  //  Fasta reader
 
-    { char          bpsbuf[1024];
-      int           bpscur;
-      char         *line;
-      int           i, x, m, in;
-      uint8         byte;
+    { Ingest_Chunk *c;
+      Ingest_Batch  batch[2];
+      int           N, more, started, holding;
+      int           in, i, b, k;
+      int64         clen, cboff, nline, plen;
+      uint8         cbyte;
 
-      byte    = 0;
-      bpscur  = 0;
+      nprov = 0;
+      prov  = NULL;
 
-      gzipd = (ftype == IS_FA_GZ);
-      if (gzipd)
-        input = gzopen(spath,"r");
-      else
-        input = fopen(spath,"r");
-      if (input == NULL)
+      T       = Ingest_Threads;
+      chunks  = NULL;
+      threads = NULL;
+      reading = 0;
+      if (open_source(&src,spath,ftype))
         { EPRINTF(EPLACE,"%s: Cannot open %s for reading\n",Prog_Name,spath);
+          close_source(&src,NULL,0);
           goto error1;
         }
+      chunks  = calloc(2*T,sizeof(Ingest_Chunk));
+      threads = malloc(T*sizeof(pthread_t));
+      if (chunks == NULL || threads == NULL)
+        { EPRINTF(EPLACE,"%s: Out of memory creating GDB for %s\n",Prog_Name,spath);
+          goto error2;
+        }
+      for (b = 0; b < 2; b++)
+        { batch[b].src    = &src;
+          batch[b].chunk  = chunks + b*T;
+          batch[b].nchunk = 0;
+        }
 
-      nprov = 0;
-      prov  = NULL;
-    
-      //  Get the header of the first line.  If the file is empty skip.
-    
-      nline = 1;
-      line  = read_line(input,gzipd,&len,nline,spath);
-      if (line == ERROR)
-        goto error2;
-      else if (line == NULL)
+      //  Get the first batch.  If the file is empty or does not start with a header, quit.
+
+      read_batch(batch);
+      if (src.error)
+        goto error5;
+      if (src.nread == 0)
         { EPRINTF(EPLACE,"%s: Input %s is empty, terminating!\n",Prog_Name,spath);
           goto error2;
         }
-    
-      if (line[0] != '>')
+      if (chunks[0].text[0] != '>')
         { EPRINTF(EPLACE,"%s: First header in fasta file %s is missing\n",
                          Prog_Name,spath);
           goto error2;
         }
-    
-      while (line != NULL)
-        { for (i = 1; i < len; i++)
-            if (!isspace(line[i]))
-              break;
-          len -= i;
-    
-          if (nscaff >= scftop)
-            { scftop = 1.2*nscaff + 500;
-              scaffs = realloc(scaffs,scftop*sizeof(GDB_SCAFFOLD));
-              if (scaffs == NULL)
-                { EPRINTF(EPLACE,"%s: Out of memory creating GDB for %s\n",Prog_Name,spath);
-                  goto error2;
-                }
+
+      started = 0;
+      holding = 0;
+      cbyte   = 0;
+      in      = 0;
+      clen    = 0;
+      cboff   = 0;
+      nline   = 0;
+      spos    = 0;
+      for (b = 0; batch[b].nchunk > 0; b = 1-b)
+        { c = batch[b].chunk;
+          N = batch[b].nchunk;
+
+          //  Start reading the next batch while this one is processed
+
+          more = (!src.eof || src.ntail > 0) && src.error == 0;
+          if (more)
+            { pthread_create(&reader,NULL,read_batch,batch+(1-b));
+              reading = 1;
             }
-          scaffs[nscaff].fctg = ncontig;
-          scaffs[nscaff].hoff = hdrtot; 
-    
-          if (hdrtot + len + 1 > hdrtop)
-            { hdrtop = 1.2*(hdrtot+len+1) + 10000;
-              headers = realloc(headers,hdrtop);
-              if (headers == NULL)
+          else
+            batch[1-b].nchunk = 0;
+
+          //  Step 1: scan the chunks in parallel
+
+          for (i = 1; i < N; i++)
+            pthread_create(threads+i,NULL,scan_chunk,c+i);
+          scan_chunk(c);
+          for (i = 1; i < N; i++)
+            pthread_join(threads[i],NULL);
+
+          //  Step 2: walk the events building the GDB skeleton
+
+          for (i = 0; i < N; i++, c++)
+            { Ingest_Event *e;
+
+              if (c->error)
                 { EPRINTF(EPLACE,"%s: Out of memory creating GDB for %s\n",Prog_Name,spath);
                   goto error2;
                 }
-            }
-          memcpy(headers+hdrtot,line+i,len);
-          hdrtot += len;
-          headers[hdrtot++] = '\0';
-    
-          in   = 0;
-          spos = 0;
-          while (1)
-            { nline += 1;
-              line   = read_line(input,gzipd,&len,nline,spath);
-              if (line == ERROR)
-                goto error2;
-              else if (line == NULL || line[0] == '>')
-                { if (in)
-                    { if (bps)
-                        { if ((clen & 0x7) != 0)
-                            { if (bpscur >= 1024)
-                                { fwrite(bpsbuf,1024,1,bases);
-                                  bpscur = 0;
-                                }
-                              bpsbuf[bpscur++] = byte;
-                              boff += 1;
+              count[0] += c->count[0];
+              count[1] += c->count[1];
+              count[2] += c->count[2];
+              count[3] += c->count[3];
+
+              c->pin   = in;
+              c->phase = (in ? (clen & 0x3) : 0);
+              c->pbeg  = (in ? cboff + (clen >> 2) : boff);
+              for (k = 0, e = c->evts; k < c->nevt; k++, e++)
+                switch (e->kind)
+                { case EVT_BASE:
+                    if (!in)
+                      { if (ncontig >= ctgtop)
+                          { ctgtop = 1.2*ncontig + 1000;
+                            contigs = realloc(contigs,ctgtop*sizeof(GDB_CONTIG));
+                            if (contigs == NULL)
+                              { EPRINTF(EPLACE,"%s: Out of memory creating GDB for %s\n",
+                                               Prog_Name,spath);
+                                goto error2;
+                              }
+                          }
+                        contigs[ncontig].sbeg = spos;
+                        contigs[ncontig].boff = boff;
+                        contigs[ncontig].scaf = nscaff;
+                        cboff = boff;
+                        clen  = 0;
+                        in    = 1;
+                      }
+                    clen += e->len;
+                    break;
+
+                  case EVT_GAP:
+                  case EVT_HEAD:
+                    if (in)
+                      { spos += clen;
+                        contigs[ncontig].clen = clen;
+                        seqtot += clen;
+                        if (clen > maxctg)
+                          maxctg = clen;
+                        ncontig += 1;
+                        if (bps)
+                          boff = cboff + ((clen+3) >> 2);
+                        in = 0;
+                      }
+                    if (e->kind == EVT_GAP)
+                      { spos += e->len;
+                        break;
+                      }
+
+                    if (started)
+                      { if (spos == 0)
+                          { EPRINTF(EPLACE,"%s: Missing sequence entry at line %lld in file %s\n",
+                                           Prog_Name,nline+e->line+1,spath);
+                            goto error2;
+                          }
+                        scaffs[nscaff].slen = spos;
+                        scaffs[nscaff].ectg = ncontig;
+                        nscaff += 1;
+                      }
+                    started = 1;
+
+                    { char *line = c->text + e->off;
+
+                      len = e->len;
+                      for (plen = 0; plen < len; plen++)
+                        if (!isspace(line[plen]))
+                          break;
+                      line += plen;
+                      len  -= plen;
+
+                      if (nscaff >= scftop)
+                        { scftop = 1.2*nscaff + 500;
+                          scaffs = realloc(scaffs,scftop*sizeof(GDB_SCAFFOLD));
+                          if (scaffs == NULL)
+                            { EPRINTF(EPLACE,"%s: Out of memory creating GDB for %s\n",
+                                             Prog_Name,spath);
+                              goto error2;
                             }
-                          clen >>= 1;
                         }
-                      spos += clen;
-                      contigs[ncontig].clen = clen;
-                      seqtot += clen;
-                      if (clen > maxctg)
-                        maxctg = clen;
-                      ncontig += 1;
-                      if (ncontig >= ctgtop)
-                        { ctgtop = 1.2*ncontig + 1000;
-                          contigs = realloc(contigs,ctgtop*sizeof(GDB_CONTIG));
-                          if (contigs == NULL)
+                      scaffs[nscaff].fctg = ncontig;
+                      scaffs[nscaff].hoff = hdrtot;
+
+                      if (hdrtot + len + 1 > hdrtop)
+                        { hdrtop = 1.2*(hdrtot+len+1) + 10000;
+                          headers = realloc(headers,hdrtop);
+                          if (headers == NULL)
                             { EPRINTF(EPLACE,"%s: Out of memory creating GDB for %s\n",
                                              Prog_Name,spath);
                               goto error2;
                             }
                         }
+                      memcpy(headers+hdrtot,line,len);
+                      hdrtot += len;
+                      headers[hdrtot++] = '\0';
                     }
-                  break;
+                    spos = 0;
+                    break;
                 }
-    
-              if (bps)
-                for (i = 0; i < len; i++)
-                  { x = number[(int) line[i]];
-                    if (x < 4)
-                      { if (!in)
-                          { if (ncontig >= ctgtop)
-                              { ctgtop = 1.2*ncontig + 1000;
-                                contigs = realloc(contigs,ctgtop*sizeof(GDB_CONTIG));
-                                if (contigs == NULL)
-                                  { EPRINTF(EPLACE,"%s: Out of memory creating GDB for %s\n",
-                                                   Prog_Name,spath);
-                                    goto error2;
-                                  }
-                              }
-                            contigs[ncontig].sbeg = spos;
-                            contigs[ncontig].boff = boff;
-                            contigs[ncontig].scaf = nscaff;
-                            clen = 0;
-                            in   = 1;
-                          }
-                        count[x] += 1;
-                        m = (clen & 0x7);
-                        if (m == 0)
-                          byte = x;
-                        else
-                          { byte |= (x << m);
-                            if (m == 6)
-                              { if (bpscur >= 1024)
-                                  { fwrite(bpsbuf,1024,1,bases);
-                                    bpscur = 0;
-                                  }
-                                bpsbuf[bpscur++] = byte;
-                                boff += 1;
-                              }
-                          }
-                        clen += 2;
-                      }
-                    else
-                      { if (in)
-                          { if ((clen & 0x7) != 0)
-                              { if (bpscur >= 1024)
-                                  { fwrite(bpsbuf,1024,1,bases);
-                                    bpscur = 0;
-                                  }
-                                bpsbuf[bpscur++] = byte;
-                                boff += 1;
-                               }
-                            clen >>= 1;
-                            spos += clen;
-                            contigs[ncontig].clen = clen;
-                            seqtot += clen;
-                            if (clen > maxctg)
-                              maxctg = clen;
-                            ncontig += 1;
-                            in = 0;
-                          }
-                        spos += 1;
-                      }
-                  }
-              else
-                for (i = 0; i < len; i++)
-                  { x = number[(int) line[i]];
-                    if (x < 4)
-                      { if (!in)
-                          { if (ncontig >= ctgtop)
-                              { ctgtop = 1.2*ncontig + 1000;
-                                contigs = realloc(contigs,ctgtop*sizeof(GDB_CONTIG));
-                                if (contigs == NULL)
-                                  { EPRINTF(EPLACE,"%s: Out of memory creating GDB for %s\n",
-                                                   Prog_Name,spath);
-                                    goto error2;
-                                  }
-                              }
-                            contigs[ncontig].sbeg = spos;
-                            contigs[ncontig].boff = boff;
-                            contigs[ncontig].scaf = nscaff;
-                            clen = 0;
-                            in   = 1;
-                          }
-                        count[x] += 1;
-                        clen += 1;
-                      }
-                    else
-                      { if (in)
-                          { spos += clen;
-                            contigs[ncontig].clen = clen;
-                            seqtot += clen;
-                            if (clen > maxctg)
-                              maxctg = clen;
-                            ncontig += 1;
-                            in = 0;
-                          }
-                        spos += 1;
+              nline  += c->nlines;
+              c->hold = (in && (clen & 0x3) != 0);
+              c->pend = (in ? cboff + ((clen+3) >> 2) : boff);
+              if (!bps)
+                c->pend = c->pbeg;
+            }
+
+          //  Step 3: pack the chunks in parallel and write them out in order
+
+          if (bps)
+            { c = batch[b].chunk;
+              for (i = 0; i < N; i++)
+                if (c[i].pend - c[i].pbeg > c[i].pmax)
+                  { c[i].pmax = 1.2*(c[i].pend-c[i].pbeg) + 1000;
+                    free(c[i].pack);
+                    c[i].pack = malloc(c[i].pmax);
+                    if (c[i].pack == NULL)
+                      { EPRINTF(EPLACE,"%s: Out of memory creating GDB for %s\n",
+                                       Prog_Name,spath);
+                        goto error2;
                       }
                   }
+
+              for (i = 1; i < N; i++)
+                pthread_create(threads+i,NULL,pack_chunk,c+i);
+              pack_chunk(c);
+              for (i = 1; i < N; i++)
+                pthread_join(threads[i],NULL);
+
+              for (i = 0; i < N; i++, c++)
+                { int64 n = c->pend - c->pbeg;
+
+                  if (n == 0)
+                    continue;
+                  if (holding)
+                    c->pack[0] |= cbyte;
+                  if (fwrite(c->pack,1,n-c->hold,bases) != (size_t) (n-c->hold))
+                    { EPRINTF(EPLACE,"%s: Could not write to %s\n",Prog_Name,seqpath);
+                      goto error2;
+                    }
+                  holding = c->hold;
+                  if (holding)
+                    cbyte = c->pack[n-1];
+                }
             }
-    
-          if (spos == 0)
-            { EPRINTF(EPLACE,"%s: Missing sequence entry at line %d in file %s\n",
-                             Prog_Name,nline,spath);
-              goto error2;
+
+          if (reading)
+            { pthread_join(reader,NULL);
+              reading = 0;
             }
-          scaffs[nscaff].slen = spos;
-          scaffs[nscaff].ectg = ncontig;
-          nscaff += 1;
+          if (src.error)
+            goto error5;
         }
-    
-      if (bpscur > 0)
-        fwrite(bpsbuf,bpscur,1,bases);
 
-      if (gzipd)
-        gzclose(input);
-      else
-        fclose(input);
+      if (src.last != '\n')
+        { EPRINTF(EPLACE,"%s: Last line %lld of file %s does not end with new-line\n",
+                         Prog_Name,nline+1,spath);
+          goto error2;
+        }
+
+      if (in)
+        { spos += clen;
+          contigs[ncontig].clen = clen;
+          seqtot += clen;
+          if (clen > maxctg)
+            maxctg = clen;
+          ncontig += 1;
+          if (bps)
+            boff = cboff + ((clen+3) >> 2);
+        }
+      if (holding)
+        fwrite(&cbyte,1,1,bases);
+      if (spos == 0)
+        { EPRINTF(EPLACE,"%s: Missing sequence entry at line %lld in file %s\n",
+                         Prog_Name,nline+1,spath);
+          goto error2;
+        }
+      scaffs[nscaff].slen = spos;
+      scaffs[nscaff].ectg = ncontig;
+      nscaff += 1;
+
+      close_source(&src,chunks,2*T);
+      free(threads);
     }
 
   if (bps > 0)
@@ -922,6 +1461,7 @@ FILE **Create_GDB(GDB *gdb, char *spath, int ftype, int bps, char *tpath)
   gdb->contigs   = contigs;
   gdb->headers   = headers;
   gdb->seqstate  = EXTERNAL;
+  gdb->seqmap    = 0;
   gdb->seqsrc    = ftype;
   gdb->seqpath   = Strdup(seqpath,"Allocating GDB sequence file name (Create_GDB)");
   if (gdb->seqpath == NULL)
@@ -957,11 +1497,18 @@ error4:
 error3:
   oneSchemaDestroy(schema);
   goto error1;
-error2:
-  if (gzipd)
-    gzclose(input);
+error5:
+  if (src.error == 1)
+    EPRINTF(EPLACE,"%s: Could not read %s\n",Prog_Name,spath);
+  else if (src.error == 2)
+    EPRINTF(EPLACE,"%s: %s is not a well-formed BGZF file\n",Prog_Name,spath);
   else
-    fclose(input);
+    EPRINTF(EPLACE,"%s: Out of memory creating GDB for %s\n",Prog_Name,spath);
+error2:
+  if (reading)
+    pthread_join(reader,NULL);
+  close_source(&src,chunks,2*T);
+  free(threads);
 error1:
   free(gdb->srcpath);
   free(headers);
@@ -1179,6 +1726,7 @@ int Read_GDB(GDB *gdb, char *path)
 
   gdb->seqtot   = seqtot;
   gdb->seqstate = EXTERNAL;
+  gdb->seqmap   = 0;
   gdb->seqs     = seqs;
 
   srcpath += strlen(srcpath);
@@ -1325,6 +1873,41 @@ int Load_Sequences(GDB *gdb, int stype)
   return (0);
 }
 
+int Map_Sequences(GDB *gdb)
+{ FILE       *b = (FILE *) gdb->seqs;
+  struct stat state;
+  void       *seq;
+
+  if (b == NULL)
+    { EPRINTF(EPLACE,"%s: GDB has no sequence data (Map_Sequences)\n",Prog_Name);
+      EXIT(1);
+    }
+  if (gdb->seqstate != EXTERNAL)
+    { EPRINTF(EPLACE,"%s: GDB's sequencing info already loaded (Map_Sequences)\n",Prog_Name);
+      EXIT(1);
+    }
+
+  if (fstat(fileno(b),&state) < 0)
+    { EPRINTF(EPLACE,"%s: Cannot fetch size of GDB's base pair file (Map_Sequences)\n",
+                     Prog_Name);
+      EXIT(1);
+    }
+  if (state.st_size == 0)                   //  Nothing to map, the GDB stays EXTERNAL
+    return (0);
+
+  seq = mmap(NULL,state.st_size,PROT_READ,MAP_SHARED,fileno(b),0);
+  if (seq == MAP_FAILED)
+    { EPRINTF(EPLACE,"%s: Cannot memory map sequence file of GDB (Map_Sequences)\n",Prog_Name);
+      EXIT(1);
+    }
+  fclose(b);
+
+  gdb->seqstate = COMPRESSED;
+  gdb->seqmap   = state.st_size;
+  gdb->seqs     = seq;
+  return (0);
+}
+
 // Write the given gdb to the file 'tpath'.  The GDB must have seqstate EXTERNAL and tpath
 //   must be consistent with the name of the .bps file.
 
@@ -1428,6 +2011,8 @@ void Close_GDB(GDB *gdb)
 { if (gdb->seqs != NULL)
     { if (gdb->seqstate == EXTERNAL)
         fclose(gdb->seqs);
+      else if (gdb->seqmap > 0)
+        munmap(gdb->seqs,gdb->seqmap);
       else if (gdb->seqstate == COMPRESSED)
         free(gdb->seqs);
       else
@@ -1452,12 +2037,13 @@ void Close_GDB(GDB *gdb)
 // Allocate and return a buffer big enough for the largest contig in 'gdb'.
 //   If cannot allocate memory then return NULL with an error message at EPLACE.
 //   **NB** free(x-1) if x is the value returned as *prefix* and suffix 0(4)-bytes
-//   are needed by the alignment algorithms.  
+//   are needed by the alignment algorithms.  A further 8 bytes of slack at the end allow
+//   the alignment algorithms to compare a word at a time.
 
 char *New_Contig_Buffer(GDB *gdb)
 { char *contig;
 
-  contig = (char *) malloc(gdb->maxctg+4);
+  contig = (char *) malloc(gdb->maxctg+12);
   if (contig == NULL)
     { EPRINTF(EPLACE,"%s: Cannot allocate a contig buffer\n",Prog_Name);
       EXIT(NULL);
@@ -1615,7 +2201,7 @@ char *Get_Contig_Piece(GDB *gdb, int i, int beg, int end, int stype, char *buffe
   if (gdb->seqstate != EXTERNAL)
     { if (gdb->seqstate == COMPRESSED)
         { memcpy(buffer,m + off,clen);
-          Uncompress_Read(len,buffer);
+          Uncompress_Read(4*clen,buffer);
           buffer += beg%4;
           buffer[len] = 4;
           if (stype == LOWER_CASE)
@@ -64,6 +64,8 @@ typedef struct
     int           seqsrc;     //  One of the 3 file types below
     void         *seqs;       //  file pointer if EXTERNAL, mem pointer if not
                               //     NULL => not present
+    int64         seqmap;     //  if > 0 then seqs is a read-only map of the .bps file of
+                              //     this many bytes (see Map_Sequences)
 
     float         freq[4];    //  frequency of A, C, G, T, respectively
   } GDB; 
@@ -119,6 +121,13 @@ int Get_GDB_Paths(char *source, char *target, char **spath, char **tpath, int no
 
 FILE **Create_GDB(GDB *gdb, char *spath, int ftype, int bps, char *tpath);
 
+  // Set the number of threads Create_GDB uses to parse and compress a fasta source (1 by
+  //   default).  A reader thread always runs alongside them and is the inflate thread for a
+  //   gzip'd source, save that the blocks of a BGZF source are inflated by nthreads threads.
+  //   The GDB created is the same regardless.
+
+void Set_GDB_Threads(int nthreads);
+
   // Open the given database "path" into the supplied GDB record "gdb".
   //   Initially the sequence data, if any, stays in the .bps file with a FILE pointer to it.
   // Interactive return values:
@@ -134,6 +143,15 @@ int Read_GDB(GDB *gdb, char *spath);
 
 int Load_Sequences(GDB *gdb, int stype);
 
+  // Map_Sequences has the same effect as Load_Sequences(gdb,COMPRESSED) save that the .bps file
+  //   is memory mapped read-only rather than read into a private block.  So any number of
+  //   threads (and forked processes) can fetch contigs from the GDB, or copies of its record,
+  //   concurrently, sharing one page-cached 2-bit copy of the bases that is only paged in as
+  //   needed.  Close_GDB unmaps it.  A GDB with no bases at all remains EXTERNAL.
+  // In interactive mode, 1 is returned on error, 0 otherwise.
+
+int Map_Sequences(GDB *gdb);
+
   // Write the given gdb to the file 'tpath'.  The GDB must have seqstate EXTERNAL and tpath
   //   must be consistent with the name of the .bps file.
 
@@ -153,7 +171,8 @@ void Close_GDB(GDB *gdb);
   // Allocate and return a buffer big enough for the largest contig in 'gdb'.
   //   If it cannot allocate memory then returns NULL (in interactive mode).
   //   **NB** free(x-1) if x is the value returned as *prefix* and suffix sentinal bytes
-  //   are added for the convenience of the alignment algorithms.
+  //   are added for the convenience of the alignment algorithms, along with 8 bytes of
+  //   slack so that they may read a word at a time.
 
 char *New_Contig_Buffer(GDB *gdb);
 
@@ -97,7 +97,7 @@ int main(int argc, char *argv[])
 
   //  Read GDB and establish sorted order of headers
 
-  { int   s, c;
+  { int   s;
     char *sptr, *eptr;
 
     Read_GDB(gdb,argv[1]);
@@ -108,21 +108,14 @@ int main(int argc, char *argv[])
     SCAFFS  = gdb->scaffolds;
     HEADERS = gdb->headers;
 
-    HASH  = New_Hash_Table(NSCAFF,1);
-    for (s = 0; s < NSCAFF; s++)
+    HASH = New_Hash_Block(HEADERS,NSCAFF,&SCAFFS[0].hoff,sizeof(GDB_SCAFFOLD),&s);
+    if (s >= 0)
       { sptr = HEADERS + SCAFFS[s].hoff;
         for (eptr = sptr; *eptr != '\0'; eptr++)
           if (isspace(*eptr))
             break;
-        c = *eptr;
-        *eptr = '\0';
-        if (Hash_Lookup(HASH,sptr) < 0)
-          Hash_Add(HASH,sptr);
-        else
-          { fprintf(stderr,"%s: Duplicate scaffold name: %s\n",Prog_Name,sptr);
-            exit (1);
-          }
-        *eptr = c;
+        fprintf(stderr,"%s: Duplicate scaffold name: %.*s\n",Prog_Name,(int) (eptr-sptr),sptr);
+        exit (1);
       }
   }
 
@@ -0,0 +1,2699 @@
+/*******************************************************************************************
+ *
+ *  Produce a k-mer index of genome's contigs suitable for finding adaptamer seed matches.
+ *    As such only k-mers whose count is less than the adaptamer frequency cutoff are in
+ *    the index which consists of a FASTK k-mer table and an associated position list that
+ *    contains the positions at which each k-mer occurs in order of the k-mers of the table.
+ *    What would normally be the count field for a k-mer contains the lcp of the k-mer with
+ *    its predecessor, and the # of positions at which the k-mer occurs, each in a byte.
+ *    This module is shared by GIXmake and FastGA (see GIX.h).
+ *
+ *  Author:  Gene Myers
+ *  Date  :  February 2023
+ *
+ *******************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+#include "libfastk.h"
+#include "GDB.h"
+#include "GIX.h"
+
+static int   FREQ;       //  adaptamer frequency cutoff
+static int   VERBOSE;    //  verbose progress to stderr
+static char *TPATH;
+static char *TROOT;
+static char *POST_NAME;
+
+static int NTHREADS;   //  # of threads and parts
+static int KMER;       //  must be >= 12 and divisible by 4
+static int KBYTES;     //  Bytes for 2-bit compress k-mer (KMER/4)
+
+#undef  DEBUG_MAP
+#undef  DEBUG_THREADS
+#undef  DEBUG_SORT
+
+#define BUFFER_LEN  1000000
+
+static int   *Perm;        //  Size sorted permutation of contigs
+static int   *InvP;        //  Inverse of Perm
+static uint64 *Csum;       //  Checksum of the bases of each contig (kept in the stub)
+
+static int    PostBytes;   //  # of bytes needed for a position
+static int    ContBytes;   //  # of bytes for a contig + sign bit
+
+static int    Comp[256];   //  DNA complement of packed byte
+static int    Select[256]; //  1st k-mer byte -> block (of NTHREAD)
+
+                           //  For p in [0,NTHREADS):
+static int   *DBsplit;     //    DB split: contig [DBsplit[p],DBsplit[p+1])
+static int64 *DBpost;      //    DB post: post of start of contig DBsplit[p] is DBpost[p]
+static int   *Ksplit;      //    Kmer split:  1st bytes [Ksplit[p],Ksplit[p+1])
+
+static int64 **Buckets;    //  NTHREADS x 256 array:
+                           //  B[i][j] = # of posts whose canonical k-mer's 1st byte
+                           //            is j from block DBsplit[i],DBsplit[i+1]
+                           //  Also used as "fingers" for loading initial sort array.
+
+static int *Units;  //  NTHREADS^2 IO units for distribution and import & k-mer table parts
+static int *Pnits;  //  NTHREADS^2 extra IO units for post parts
+static int *Dnits;  //  NTHREADS^2 extra IO units for drop parts
+
+typedef struct
+  { int   beg;
+    int   end;
+    int64 off;
+  } Range;
+
+extern void msd_sort(uint8 *array, int64 nelem, int rsize, int ksize,
+                     int64 *part, int nthreads, Range *range);
+
+
+/***********************************************************************************************
+ *
+ *   DISTRIBUTION PHASE:  Output signed posts for each 1/NTHREAD of the data and the k-mers
+ *        At completion file ._post.<jobid>.<i*NTHREADS+j>.idx contains the signed posts from
+ *             contigs (DBsplit[j],DBplist[j+1]) whose k-mers 1st byte is in Ksplit[i],Ksplit[i+1].
+ *
+ **********************************************************************************************/
+
+typedef struct
+  { int     beg;
+    int     end;
+    uint8  *seq;
+    uint8  *neq;
+    uint8  *ceq;
+    int64   buck[256];
+  } BP;
+
+// Thread computes neq[beg..end-1] and ceq[beg..end-1] given seq
+
+static void *pack_thread(void *args)
+{ BP *parm = (BP *) args;
+  int     beg    = parm->beg;
+  int     end    = parm->end;
+  uint8  *seq    = parm->seq;
+  uint8  *neq    = parm->neq;
+  uint8  *ceq    = parm->ceq;
+
+  int    i, k;
+  uint8 *s1, *s2, *s3, *n1;
+  
+  s1 = seq+1;
+  s2 = seq+2;
+  s3 = seq+3;
+  for (i = beg; i < end; i += 4)
+    { neq[i] = (seq[i] << 6) | (s1[i] << 4) | (s2[i] << 2) | s3[i];
+      ceq[i] = Comp[neq[i]];
+    }
+  n1 = neq-1;
+  for (k = 1; k < 4; k++)
+    for (i = beg+k; i < end; i += 4)
+      { neq[i] = (n1[i] << 2) | s3[i];
+        ceq[i] = Comp[neq[i]];
+      }
+
+  return (NULL);
+}
+
+// Given neq & ceq, upon completion, for i in [beg,end), seq[i] = file k-mer starting at i should
+//   go to and whether it should be complemented or not (0x80 flag) in order to be canonical.
+//   Also accumulates # of these k-mers with a given 1st byte in buck.
+
+static void *map_thread(void *args)
+{ BP *parm = (BP *) args;
+  int     beg    = parm->beg;
+  int     end    = parm->end;
+  uint8  *seq    = parm->seq;
+  uint8  *neq    = parm->neq;
+  uint8  *ceq    = parm->ceq;
+  int64  *buck   = parm->buck;
+
+  int    kspn = KMER-4;
+  int    i, u, v;
+
+  for (i = beg; i < end; i++)
+    { for (u = i, v = i+kspn; neq[u] == ceq[v]; u += 4, v -= 4)
+        if (u >= v)
+          break;
+      if (ceq[v] < neq[u])
+        { u = ceq[i+kspn];
+          seq[i] = Select[u] | 0x80;
+        }
+      else
+        { u = neq[i];
+          seq[i] = Select[u];
+        }
+      buck[u] += 1;
+    }
+
+  return (NULL);
+}
+
+typedef struct
+  { int    tid;
+    int    inum;
+    uint8 *seq;
+    int    len;
+    int    out;
+    uint8 *buffer;
+    uint8 *bend;
+    int64  post;
+    int64  last;
+  } DP;
+
+//  The thread scans seq and sends those posts assigned to file tid*Nthreads + ? to their
+//    designated file relative to the last emission in compressed form:
+//       x0   -> byte,   6-bit post delta with sign x
+//       x10  -> short, 13-bit ...
+//       x110 -> short, 28-bit ...
+//       x111 -> 0x10000000 spacer
+
+static void *distribute_thread(void *args)
+{ DP *parm = (DP *) args;
+  int    tid    = parm->tid;
+  uint8 *seq    = parm->seq;
+  int    len    = parm->len;
+  int    out    = parm->out;
+  uint8 *buffer = parm->buffer;
+  uint8 *bend   = parm->bend;
+
+  int64  post, last;
+  uint8 *lust = (uint8 *) (&last);
+  uint8 *b;
+  int    i, u;
+
+  b = buffer;
+  last = parm->last;
+  post = parm->post;
+  for (i = 0; i < len; i++, post++)
+    { u = seq[i];
+      if ((u & 0x7f) == tid)
+        { last = post-last;
+          if (last < 0x3f)
+            { if (u & 0x80)
+                *b++ = 0x80 | last;
+              else
+                *b++ = last;
+            }
+          else if (last < 0x1fff)
+            { if (u & 0x80)
+                last |= 0xc000;
+              else
+                last |= 0x4000;
+              *b++ = lust[1];
+              *b++ = lust[0];
+            }
+          else
+            { while (last >= 0x10000000)
+                { if (u & 0x80)
+                    *b++ = 0xf0;
+                  else
+                    *b++ = 0x70;
+                  if (b >= bend)
+                    { if (write(out,buffer,b-buffer) < 0)
+                        { fprintf(stderr,"%s: IO write to file %s%d.idx failed\n",
+                                          Prog_Name,POST_NAME,parm->inum);
+                           exit (1);
+                         }
+                      b = buffer;
+                    }
+                  last -= 0x10000000;
+                }
+              if (u & 0x80)
+                last |= 0xe0000000;
+              else
+                last |= 0x60000000;
+              *b++ = lust[3];
+              *b++ = lust[2];
+              *b++ = lust[1];
+              *b++ = lust[0];
+            }
+          if (b >= bend)
+            { if (write(out,buffer,b-buffer) < 0)
+                { fprintf(stderr,"%s: IO write to file %s%d.idx failed\n",
+                                 Prog_Name,POST_NAME,parm->inum);
+                  exit (1);
+                }
+              b = buffer;
+            }
+          last = post;
+        }
+    }
+  if (b > buffer)
+    if (write(out,buffer,b-buffer) < 0)
+      { fprintf(stderr,"%s: IO write to file %s%d.idx failed\n",
+                       Prog_Name,POST_NAME,parm->inum);
+        exit (1);
+      }
+
+  parm->last = last;
+  parm->post = post;
+  return (NULL);
+}
+
+// Distribute posts to the appropriate NTHREADS^2 files based on section of the DB and 1st byte
+//   of its canonical k-mer
+
+//  Checksum of the len bases of a contig in NUMERIC form, seeded with its length so that
+//    it also tells contigs of different lengths apart
+
+static uint64 contig_sum(uint8 *seq, int64 len)
+{ uint64 h, w;
+  int64  i;
+
+  h = 0x9e3779b97f4a7c15ull ^ ((uint64) len);
+  for (i = 0; i+8 <= len; i += 8)
+    { memcpy(&w,seq+i,8);
+      h = (h ^ w) * 0xff51afd7ed558ccdull;
+      h ^= (h >> 32);
+    }
+  if (i < len)
+    { w = 0;
+      memcpy(&w,seq+i,len-i);
+      h = (h ^ w) * 0xff51afd7ed558ccdull;
+      h ^= (h >> 32);
+    }
+  return (h);
+}
+
+static void distribute(GDB *gdb)
+{ uint8 *seq;
+  int    len, ren;
+  uint8 *neq, *ceq;
+  int    p, r, i, j;
+
+  DP        parm[NTHREADS];
+  BP        barm[NTHREADS];
+#ifndef DEBUG_THREADS
+  pthread_t threads[NTHREADS];
+#endif
+
+  seq = (uint8 *) New_Contig_Buffer(gdb);   //  Allocate work vectorss and set up fixed parts of
+  neq = (uint8 *) New_Contig_Buffer(gdb);   //    of the thread records
+  ceq = (uint8 *) New_Contig_Buffer(gdb);
+  if (seq == NULL || neq == NULL || ceq == NULL)
+    exit (1);
+
+  parm[0].buffer = Malloc(BUFFER_LEN*NTHREADS,"Allocating IO buffer");
+  for (i = 0; i < NTHREADS; i++)
+    { parm[i].tid    = i;
+      parm[i].seq    = seq;
+      parm[i].buffer = parm[0].buffer + BUFFER_LEN*i;
+      parm[i].bend   = parm[i].buffer + (BUFFER_LEN-4);
+      parm[i].post   = 0;
+      parm[i].last   = 0;
+    }
+
+  for (i = 0; i < NTHREADS; i++)
+    { barm[i].seq  = seq;
+      barm[i].neq  = neq;
+      barm[i].ceq  = ceq;
+      bzero(barm[i].buck,256*sizeof(int64));
+    }
+
+  //  For each segment of the input ...
+
+  for (p = 0; p < NTHREADS; p++)
+                                     //  Open the NTHREAD files to recieve posts from this segment
+    { for (i = 0; i < NTHREADS; i++)
+        { parm[i].out = Units[i*NTHREADS+p];
+          parm[i].inum = i*NTHREADS+p;
+        }
+
+      //  For each contig in the segment ...
+
+      ren = DBsplit[p+1];
+      for (r = DBsplit[p]; r < ren; r++)
+        { if (gdb->contigs[r].boff < 0)
+            { Csum[r] = contig_sum(seq,0);
+              continue;
+            }
+
+          len = gdb->contigs[r].clen;
+          Get_Contig(gdb,r,NUMERIC,(char *) seq);   //  Load the contig
+          Csum[r] = contig_sum(seq,len);
+    
+#ifdef DEBUG_MAP
+          printf("Src:");
+          for (i = 0; i < len; i++)
+            printf(" %d",seq[i]);
+          printf("\n");
+#endif
+          //  In segments each thread computes neq and ceq from seq
+    
+          len -= 3;
+          barm[0].beg = 0;
+          for (i = 1; i < NTHREADS; i++)
+            barm[i-1].end = barm[i].beg = (((int64) i)*len)/NTHREADS;
+          barm[NTHREADS-1].end = len;
+    
+#ifdef DEBUG_THREADS
+          for (i = 0; i < NTHREADS; i++)
+            pack_thread(barm+i);
+#else
+          for (i = 1; i < NTHREADS; i++)
+            pthread_create(threads+i,NULL,pack_thread,barm+i);
+          pack_thread(barm);
+          for (i = 1; i < NTHREADS; i++)
+            pthread_join(threads[i],NULL);
+#endif
+    
+#ifdef DEBUG_MAP
+          printf("Neq:");
+          for (i = 0; i < len; i++)
+            printf(" %02x",neq[i]);
+          printf("\n");
+
+          printf("Ceq:");
+          for (i = 0; i < len; i++)
+            printf(" %02x",ceq[i]);
+          printf("\n");
+#endif
+          //  In segments each thread computes processed seq array from neq,ceq
+    
+          len -= (KMER-4);
+          if (len < 0)
+            { for (i = 0; i < NTHREADS; i++)
+                parm[i].post += len + (KMER-1);
+              continue;
+            }
+
+          barm[0].beg = 0;
+          for (i = 1; i < NTHREADS; i++)
+            barm[i-1].end = barm[i].beg = (((int64) i)*len)/NTHREADS;
+          barm[NTHREADS-1].end = len;
+    
+#ifdef DEBUG_THREADS
+          for (i = 0; i < NTHREADS; i++)
+            map_thread(barm+i);
+#else
+          for (i = 1; i < NTHREADS; i++)
+            pthread_create(threads+i,NULL,map_thread,barm+i);
+          map_thread(barm);
+          for (i = 1; i < NTHREADS; i++)
+            pthread_join(threads[i],NULL);
+#endif
+    
+#ifdef DEBUG_MAP
+          printf("Out:");
+          for (i = 0; i < len; i++)
+            printf(" (%d)%d %02x %02x\n",(seq[i]&0x80)!=0,seq[i]&0x7f,neq[i],ceq[i+KMER-4]);
+          printf("\n");
+#endif
+
+          //  Each thread scans *all* of seq, writing the k-mers assigned to "its" file
+
+          for (i = 0; i < NTHREADS; i++)
+            parm[i].len = len;
+    
+#ifdef DEBUG_THREADS
+          for (i = 0; i < NTHREADS; i++)
+            distribute_thread(parm+i);
+#else
+          for (i = 1; i < NTHREADS; i++)
+            pthread_create(threads+i,NULL,distribute_thread,parm+i);
+          distribute_thread(parm);
+          for (i = 1; i < NTHREADS; i++)
+            pthread_join(threads[i],NULL);
+#endif
+    
+          for (i = 0; i < NTHREADS; i++)
+            parm[i].post += (KMER-1);
+        }
+
+      //  Accumulate bucket counts into Bucket vector for data panel
+
+      { int64 *buck;
+
+        buck = Buckets[p];
+        for (i = 0; i < NTHREADS; i++)
+          { for (j = 0; j < 256; j++)
+              buck[j] += barm[i].buck[j];
+            parm[i].last = parm[i].post;
+          }
+      }
+    }
+ 
+  free(parm[0].buffer);
+  free(seq-1);
+  free(neq-1);
+  free(ceq-1);
+
+  //  Complete the bucket array by accumulating counts across k-mer 1st bytes
+
+  { int   i, j; 
+    int64 cum;
+
+    cum = 0;
+    for (i = 0; i < 256; i++)
+      { for (j = 0; j < NTHREADS; j++)
+          Buckets[j][i] += cum;
+        if (i < 255 && Select[i] == Select[i+1])
+          cum = Buckets[NTHREADS-1][i];
+        else
+          cum = 0;
+      }
+  }
+}
+
+
+/***********************************************************************************************
+ *
+ *   SORT PHASE:  Read in posts for a given k-mer 1st byte range, recompute their 2-bit compressed
+ *        canonical k-mer, and place them and their k-mer in a sort array in order of 1st byte
+ *        using the Bucket array as a set of "fingers".  Then complete the sort with a min-first
+ *        radix sort.  Finally output the k-mer table and index for each k-mer range.
+ *
+ **********************************************************************************************/
+
+
+#ifdef DEBUG_SORT
+
+static void print_table(uint8 *array, int swide, int64 nelem)
+{ static char  DNA[4] = { 'a', 'c', 'g', 't' };
+  static char *fmer[256], _fmer[1280];
+  static int   first = 1;
+
+  int64 x, post, cont, flag, end;
+  int   k;
+  uint8 *pust = (uint8 *) &post;
+  uint8 *cust = (uint8 *) &cont;
+
+  if (first)
+    { char *t;
+      int   i, l3, l2, l1, l0;
+
+      first = 0;
+
+      i = 0;
+      t = _fmer;
+      for (l3 = 0; l3 < 4; l3++)
+       for (l2 = 0; l2 < 4; l2++)
+        for (l1 = 0; l1 < 4; l1++)
+         for (l0 = 0; l0 < 4; l0++)
+           { fmer[i] = t;
+             *t++ = DNA[l3];
+             *t++ = DNA[l2];
+             *t++ = DNA[l1];
+             *t++ = DNA[l0];
+             *t++ = 0;
+             i += 1;
+           }
+    }
+
+  flag = (0x1ll << (8*ContBytes-1));
+  post = 0;
+  cont = 0;
+  end  = nelem * swide;
+  for (x = 0; x < end; x += swide)
+    { printf(" %10lld %2d: ",x,array[x]);
+      for (k = 1; k < KBYTES; k++)
+        printf("%s",fmer[array[x+k]]);
+      for (k = 0; k < PostBytes; k++)
+        pust[k] = array[x+KBYTES+k];
+      for (k = 0; k < ContBytes; k++)
+        cust[k] = array[x+KBYTES+PostBytes+k];
+      if (cont & flag)
+        printf(" - %11lld (%d)\n",post,cont-flag);
+      else
+        printf(" + %11lld (%d)\n",post,cont); 
+      fflush(stdout);
+    }
+}
+
+#endif
+
+typedef struct
+  { GDB      gdb;
+    int      tid;
+    int      inum;
+    int      in;
+    int      swide;
+    uint8   *sarr;
+    uint8   *buff;
+  } SP;
+
+//  Read post file, uncompressing it, recomputing the canonical k-mer at its absolute
+//   position and loading the k-mer and the signed post into the initial soring array
+//   for the current 1st byte panel.
+
+static void *setup_thread(void *args)
+{ SP *parm = (SP *) args;
+  int in        = parm->in;
+  int tid       = parm->tid;
+  int swide     = parm->swide;
+  uint8 *sarr   = parm->sarr;
+  uint8 *buffer = parm->buff;
+  GDB   *gdb    = &(parm->gdb);
+  int64 *buck   = Buckets[tid];
+
+  int    iamt;
+  uint8 *seq;
+  int    len;
+  uint8 *neq, *ceq, *keq;
+  int    ncntg, inv;
+  int64  post, bost, last;
+  int64  cont, nont, flag;
+  uint8 *lust = (uint8 *) (&last);
+  uint8 *bust = (uint8 *) (&bost);
+  uint8 *cust = (uint8 *) (&cont);
+  uint8 *nust = (uint8 *) (&nont);
+  int64  nextpost, basepost;
+  uint8 *bend, *btop, *b;
+
+  seq = (uint8 *) New_Contig_Buffer(gdb);
+  neq = (uint8 *) New_Contig_Buffer(gdb);
+  ceq = (uint8 *) New_Contig_Buffer(gdb);
+  if (seq == NULL || neq == NULL || ceq == NULL)
+    exit (1);
+  keq = ceq+(KMER-4);
+
+  flag = (0x1ll << (8*ContBytes-1));
+
+  if (lseek(in,0,SEEK_SET) < 0)
+    { fprintf(stderr,"%s: Rewind of file %s%d.idx failed\n",
+                     Prog_Name,POST_NAME,parm->inum);
+      exit (1);
+    }
+
+  iamt = read(in,buffer,BUFFER_LEN);
+  if (iamt < 0)
+    { fprintf(stderr,"%s: IO read to file %s%d.idx failed\n",
+                     Prog_Name,POST_NAME,parm->inum);
+      exit (1);
+    }
+  bend = buffer + iamt;
+  if (bend-buffer < BUFFER_LEN)
+    btop = bend;
+  else
+    btop = bend-4;
+  b = buffer;
+  if (btop <= buffer)   //  Nothing to do
+    { close(in);
+      return (NULL);
+    }
+
+  ncntg = DBsplit[tid];
+  post  = DBpost[tid];
+  nextpost = post;
+  basepost = post;
+  while (1)
+    { { int   v;
+        int64 extra;
+
+        v = *b++;                    //  Get next encoded post, uncompress it and "un-delta"
+        inv = ((v & 0x80) != 0);
+        if (v & 0x40)
+          if (v & 0x20)
+            { extra = 0;
+              while (v & 0x1)
+                { extra -= 0x10000000;
+                  v = *b++;
+                }
+              last = 0;
+              lust[3] = (v & 0x0f); 
+              lust[2] = *b++;
+              lust[1] = *b++;
+              lust[0] = *b++;
+              last += extra;
+            }
+          else
+            { last = 0;
+              lust[1] = (v & 0x1f); 
+              lust[0] = *b++;
+            }
+        else
+          last = (v & 0x3f);
+        post += last;
+      }
+
+      if (post >= nextpost)    //  if position is not in current contig, then fetch the next one
+        { int    i, k, l;
+          uint8 *s1, *s2, *s3, *n1;
+
+          do
+            { len = gdb->contigs[ncntg].clen;
+              basepost = nextpost;
+              if (gdb->contigs[ncntg].boff >= 0)
+                nextpost += len;
+              ncntg += 1;
+            }
+          while (post >= nextpost);
+
+          Get_Contig(gdb,ncntg-1,NUMERIC,(char *) seq);
+
+          cont = InvP[ncntg-1];
+          nont = cont | flag;
+
+          s1 = seq+1;
+          s2 = seq+2;
+          s3 = seq+3;
+          n1 = neq-1;
+          l  = len-3;
+          for (i = 0; i < l; i += 4)
+            { neq[i] = (seq[i] << 6) | (s1[i] << 4) | (s2[i] << 2) | s3[i];
+              ceq[i] = Comp[neq[i]];
+            }
+          for (k = 1; k < 4; k++)
+            for (i = k; i < l; i += 4)
+              { neq[i] = (n1[i] << 2) | s3[i];
+                ceq[i] = Comp[neq[i]];
+              }
+        }
+
+      { int    i;        //  load the k-mer / post pair into the next available slot in the
+        uint8 *n, *x;    //    initial sort array using the bucket index
+
+        bost = post-basepost;
+        if (inv)
+          { n = keq+bost;
+            x = sarr + swide * buck[*n]++;
+            *x++ = 0;
+            for (i = 4; i < KMER; i += 4)
+              *x++ = n[-i];
+            for (i = 0; i < PostBytes; i++)
+              *x++ = bust[i];
+            for (i = 0; i < ContBytes; i++)
+              *x++ = nust[i];
+          }
+        else
+          { n = neq+bost;
+            x = sarr + swide * buck[*n]++;
+            *x++ = 0;
+            for (i = 4; i < KMER; i += 4)
+              *x++ = n[i];
+            for (i = 0; i < PostBytes; i++)
+              *x++ = bust[i];
+            for (i = 0; i < ContBytes; i++)
+              *x++ = cust[i];
+          }
+      }
+
+      if (b >= btop)           //  refill input buffer if needed
+        { int ex = bend-b;
+          memcpy(buffer,b,ex); 
+          bend = buffer+ex;
+          iamt = read(in,bend,BUFFER_LEN-ex);
+          if (iamt < 0)
+            { fprintf(stderr,"%s: IO read to file %s%d.idx failed\n",
+                             Prog_Name,POST_NAME,parm->inum);
+              exit (1);
+            }
+          bend += iamt;
+          if (bend == buffer)
+            break;
+          if (bend-buffer < BUFFER_LEN)
+            btop = bend;
+          else
+            btop = bend-4;
+          b = buffer;
+        }
+    }
+
+  free(seq-1);
+  free(neq-1);
+  free(ceq-1);
+  close(in);
+
+  return (NULL);
+}
+
+typedef struct
+  { int      inum;
+    int      swide;
+    int64   *panel;
+    uint8   *sarr;
+    uint8   *buff;
+    Range   *range;
+    int      tout;
+    int      pout;
+    int      dout;
+    int64   *prefix;
+    int64   *posfix;
+    int64    nelim;
+    int64    nbase;
+    int64    nkmer;
+    int64    npost;
+  } RP;
+
+//  for 1st k-mer byte range [beg,end), find each group of equal k-mers and if < FREQ, then
+//    write to FastK table under construtions and output (signed) posts of each equal
+//    k-mer to the associated post list.  K-mer 2byte payloads contain the count in the
+//    first byte and the lcp with its predecessor in the 2nd byte.  A k-mer that occurs FREQ
+//    or more times is written in full to the drop list so that an update can tell it apart
+//    from a k-mer that is not in the genome at all.
+
+static void *output_thread(void *args)
+{ RP     *parm  = (RP *) args;
+  int     swide  = parm->swide;
+  int64  *panel  = parm->panel;
+  uint8  *sarray = parm->sarr;
+  Range  *range  = parm->range;
+  int     beg    = range->beg;
+  int     end    = range->end;
+  int     tout   = parm->tout;
+  int     pout   = parm->pout;
+  int64  *prefix = parm->prefix;
+  int64  *posfix = parm->posfix;
+
+  int     dout   = parm->dout;
+
+  uint8 *buf1 = parm->buff;
+  uint8 *buf2 = buf1 + 400000;
+  uint8 *buf3 = buf2 + 400000;
+  uint8 *bed1 = (buf1 + 400000) - (KBYTES-1);
+  uint8 *bed2 = (buf2 + 400000) - (PostBytes+ContBytes);
+  uint8 *bed3 = (buf3 + 200000) - KBYTES;
+
+  int64   nelim, nkmer, nbase;
+  int64   x, e, y;
+  int     o, w, k, z, lcp, idx;
+  uint8 *_w = (uint8 *) &w;
+  uint8  *b, *c, *d;
+
+  nelim = nkmer = nbase = 0;
+  o = KMER;
+
+  b = buf1;
+  c = buf2;
+  d = buf3;
+  x = range->off;
+  lcp = sarray[x];
+  prefix += (beg << 16);
+  posfix += (beg << 8);
+  for (o = beg; o < end; o++, prefix += 0x10000, posfix += 0x100)
+   { e = x + panel[o];
+     z = (sarray[e] == 0);   //  Caution: end of panel can have 0 lcp
+     if (z)
+       sarray[e] = 1;
+     for (e = x + panel[o]; x < e; )
+      { y = x+swide;
+        w = 1;
+        while (sarray[y] == 0)
+          { y += swide;
+            w += 1;
+          }
+
+        //  sorted w entries in [x,y) are all equal
+
+        if (w >= FREQ)
+          { *d++ = o;
+            for (k = 1; k < KBYTES; k++)
+              *d++ = sarray[x+k];
+            if (d >= bed3)
+              { if (write(dout,buf3,d-buf3) < 0)
+                  { fprintf(stderr,"%s: IO write to file %s%d.drp failed\n",
+                                   Prog_Name,POST_NAME,parm->inum);
+                    exit (1);
+                  }
+                d = buf3;
+              }
+            x = y;
+            if (sarray[x] < lcp)
+              lcp = sarray[x];
+            nelim += 1;
+            nbase += w;
+            continue;
+          }
+
+        //  if < FREQ then output to k-mer table and post list
+
+        idx = sarray[x+1];
+        posfix[idx] += (y-x)/swide;
+        idx = ((idx << 8) | sarray[x+2]);
+        prefix[idx] += 1;
+
+        for (k = 3; k < KBYTES; k++)
+          *b++ = sarray[x+k];
+        *b++ = _w[0];
+        *b++ = lcp;
+        if (b >= bed1)
+          { if (write(tout,buf1,b-buf1) < 0)
+              { fprintf(stderr,"%s: IO write to file %s%d.ktb failed\n",
+                               Prog_Name,POST_NAME,parm->inum);
+                exit (1);
+              }
+            b = buf1;
+          }
+        nkmer += 1;
+
+        while (x < y)
+          { for (k = KBYTES; k < swide; k++)
+              *c++ = sarray[x+k];
+            if (c >= bed2)
+              { if (write(pout,buf2,c-buf2) < 0)
+                  { fprintf(stderr,"%s: IO write to file %s%d.pst failed\n",
+                                   Prog_Name,POST_NAME,parm->inum);
+                    exit (1);
+                  }
+                c = buf2;
+              }
+            x += swide;
+          }
+
+        lcp = sarray[x];
+      }
+    if (z)
+      lcp = sarray[e] = 0;
+   }
+  if (b > buf1)
+    if (write(tout,buf1,b-buf1) < 0)
+      { fprintf(stderr,"%s: IO write to file %s%d.ktb failed\n",
+                       Prog_Name,POST_NAME,parm->inum);
+        exit (1);
+      }
+  if (c > buf2)
+    if (write(pout,buf2,c-buf2) < 0)
+      { fprintf(stderr,"%s: IO write to file %s%d.pst failed\n",
+                       Prog_Name,POST_NAME,parm->inum);
+        exit (1);
+      }
+  if (d > buf3)
+    if (write(dout,buf3,d-buf3) < 0)
+      { fprintf(stderr,"%s: IO write to file %s%d.drp failed\n",
+                       Prog_Name,POST_NAME,parm->inum);
+        exit (1);
+      }
+
+  parm->npost = (x-range->off)/swide - nbase;
+  parm->nelim = nelim;
+  parm->nbase = nbase;
+  parm->nkmer = nkmer;
+  return (NULL);
+}
+
+typedef struct
+  { int      tid;
+    uint8   *bufr;
+    int64    nkmer;
+    int64    npost;
+    int64    ndrop;
+    int      fail;
+    int      tout, pout, dout;
+  } CP;
+
+static void *catenate_thread(void *args)
+{ CP     *parm = (CP *) args;
+  uint8  *bufr = parm->bufr;
+  int     tid  = parm->tid;
+  int     tout = parm->tout;
+  int     pout = parm->pout;
+  int     dout = parm->dout;
+
+  int tin, pin, din;
+  int p, x;
+
+  parm->fail = 1;
+
+  if (write(tout,&KMER,sizeof(int)) < 0) goto tout_write_fail;
+  if (write(tout,&parm->nkmer,sizeof(int64)) < 0) goto tout_write_fail;
+
+  for (p = tid*NTHREADS; p < (tid+1)*NTHREADS; p++)
+    { tin = Units[p];
+      if (lseek(tin,0,SEEK_SET) < 0)
+        { fprintf(stderr,"%s: Rewind of file %s%d.ktb failed\n",Prog_Name,POST_NAME,p);
+          return (NULL);
+        }
+      while (1)
+        { x = read(tin,bufr,BUFFER_LEN);
+          if (x < 0)
+            { fprintf(stderr,"%s: IO read from file %s%d.ktb failed\n",Prog_Name,POST_NAME,p);
+              return (NULL);
+            }
+          if (x == 0)
+            break;
+          if (write(tout,bufr,x) < 0) goto tout_write_fail;
+        }
+      close(tin);
+    }
+  close(tout);
+
+  if (write(pout,&PostBytes,sizeof(int)) < 0) goto pout_write_fail;
+  if (write(pout,&ContBytes,sizeof(int)) < 0) goto pout_write_fail;
+  if (write(pout,&parm->npost,sizeof(int64)) < 0) goto pout_write_fail;
+
+  for (p = tid*NTHREADS; p < (tid+1)*NTHREADS; p++)
+    { pin = Pnits[p];
+      if (lseek(pin,0,SEEK_SET) < 0)
+        { fprintf(stderr,"%s: Rewind of file %s%d.pst failed\n",Prog_Name,POST_NAME,p);
+          return (NULL);
+        }
+      while (1)
+        { x = read(pin,bufr,BUFFER_LEN);
+          if (x < 0)
+            { fprintf(stderr,"%s: IO read from file %s%d.pst failed\n",Prog_Name,POST_NAME,p);
+              return (NULL);
+            }
+          if (x == 0)
+            break;
+          if (write(pout,bufr,x) < 0) goto pout_write_fail;
+        }
+      close(pin);
+    }
+  close(pout);
+
+  if (write(dout,&KMER,sizeof(int)) < 0) goto dout_write_fail;
+  if (write(dout,&parm->ndrop,sizeof(int64)) < 0) goto dout_write_fail;
+
+  for (p = tid*NTHREADS; p < (tid+1)*NTHREADS; p++)
+    { din = Dnits[p];
+      if (lseek(din,0,SEEK_SET) < 0)
+        { fprintf(stderr,"%s: Rewind of file %s%d.drp failed\n",Prog_Name,POST_NAME,p);
+          return (NULL);
+        }
+      while (1)
+        { x = read(din,bufr,BUFFER_LEN);
+          if (x < 0)
+            { fprintf(stderr,"%s: IO read from file %s%d.drp failed\n",Prog_Name,POST_NAME,p);
+              return (NULL);
+            }
+          if (x == 0)
+            break;
+          if (write(dout,bufr,x) < 0) goto dout_write_fail;
+        }
+      close(din);
+    }
+  close(dout);
+
+  parm->fail = 0;
+  return (NULL);
+
+tout_write_fail:
+  fprintf(stderr,"%s: IO error writing to part file %s/.%s.ktab.%d\n",Prog_Name,TPATH,TROOT,tid+1);
+  return (NULL);
+
+pout_write_fail:
+  fprintf(stderr,"%s: IO error writing to part file %s/.%s.post.%d\n",Prog_Name,TPATH,TROOT,tid+1);
+  return (NULL);
+
+dout_write_fail:
+  fprintf(stderr,"%s: IO error writing to part file %s/.%s.drop.%d\n",Prog_Name,TPATH,TROOT,tid+1);
+  return (NULL);
+}
+
+//  Write the trailer of a stub: the length and checksum of each contig, by which an update
+//    can verify that the contigs of the index are unchanged.
+
+static int write_sums(int tab, GDB *gdb, uint64 *csum)
+{ int64 *clen;
+  int    r, bad;
+
+  clen = Malloc(sizeof(int64)*gdb->ncontig,"Allocating contig lengths");
+  if (clen == NULL)
+    exit (1);
+  for (r = 0; r < gdb->ncontig; r++)
+    clen[r] = gdb->contigs[r].clen;
+  bad = (write(tab,clen,sizeof(int64)*gdb->ncontig) < 0
+           || write(tab,csum,sizeof(uint64)*gdb->ncontig) < 0);
+  free(clen);
+  return (bad);
+}
+
+static void k_sort(GDB *gdb)
+{ uint8 *sarray;
+  uint8 *buffer;
+  int    p, part, swide;
+  int64  panel[256];
+  Range  range[NTHREADS];
+  SP     sarm[NTHREADS];
+  RP     rarm[NTHREADS];
+  CP     carm[NTHREADS];
+  int64  nelim, nbase, nkmer;
+  int64 *prefix;
+  int64 *posfix;
+#ifndef DEBUG_THREADS
+  pthread_t threads[NTHREADS];
+#endif
+
+  { int64 x, nelmax;
+
+    nelmax = 0;
+    for (p = 0; p < NTHREADS; p++)
+      { x = Buckets[NTHREADS-1][Ksplit[p+1]-1];
+        if (nelmax < x)
+          nelmax = x;
+      }
+
+    swide  = KBYTES + PostBytes + ContBytes;
+    prefix = Malloc(sizeof(int64)*0x1000000,"Allocating prefix array");
+    posfix = Malloc(sizeof(int64)*0x10000,"Allocating postfix array");
+    sarray = Malloc(nelmax*swide+1,"Allocating sort array");
+    buffer = Malloc(NTHREADS*BUFFER_LEN,"Allocating input buffers");
+    bzero(prefix,sizeof(int64)*0x1000000);
+    bzero(posfix,sizeof(int64)*0x10000);
+  }
+
+  { int i, j;
+
+    for (i = 255; i >= 0; i--)
+      { for (j = NTHREADS-1; j >= 1; j--)
+          Buckets[j][i] = Buckets[j-1][i];
+        if (i == 0 || Select[i] != Select[i-1])
+          Buckets[0][i] = 0;
+        else
+          Buckets[0][i] = Buckets[NTHREADS-1][i-1];
+      }
+  }
+
+  //  Must open a separate file descriptor to DB bases for each setup thread !!!
+  //    (unless the bases are in memory in which case they are shared)
+
+  for (p = 0; p < NTHREADS; p++)
+    { sarm[p].tid   = p;
+      sarm[p].swide = swide;
+      sarm[p].sarr  = sarray;
+      sarm[p].buff  = buffer + p*BUFFER_LEN;
+      sarm[p].gdb   = *gdb;
+      if (p > 0 && gdb->seqstate == EXTERNAL)
+        { sarm[p].gdb.seqs = fopen(gdb->seqpath,"r");
+          if (sarm[p].gdb.seqs == NULL)
+            { fprintf(stderr,"%s: Cannot open another copy of GDB\n",Prog_Name);
+              exit (1);
+            }
+        }
+    }
+
+  for (p = 0; p < NTHREADS; p++)
+    { rarm[p].swide  = swide;
+      rarm[p].sarr   = sarray;
+      rarm[p].buff   = buffer + p*BUFFER_LEN;
+      rarm[p].range  = range + p;
+      rarm[p].panel  = panel;
+      rarm[p].prefix = prefix;
+      rarm[p].posfix = posfix;
+    }
+
+  for (p = 0; p < NTHREADS; p++)
+    { carm[p].tid   = p;
+      carm[p].bufr  = buffer + p*BUFFER_LEN;
+      carm[p].nkmer = 0;
+      carm[p].npost = 0;
+      carm[p].ndrop = 0;
+    }
+
+  nelim = nbase = nkmer = 0;
+
+  for (part = 0; part < NTHREADS; part++)
+
+    { for (p = 0; p < NTHREADS; p++)
+        { sarm[p].in = Units[part*NTHREADS+p];
+          sarm[p].inum = part*NTHREADS+p;
+        }
+
+#ifdef DEBUG_THREADS
+      for (p = 0; p < NTHREADS; p++)
+        setup_thread(sarm+p);
+#else
+      for (p = 1; p < NTHREADS; p++)
+        pthread_create(threads+p,NULL,setup_thread,sarm+p);
+      setup_thread(sarm);
+      for (p = 1; p < NTHREADS; p++)
+        pthread_join(threads[p],NULL);
+#endif
+
+      { int64 prev, next;
+
+        bzero(panel,sizeof(int64)*256);
+        prev = 0;
+        for (p = Ksplit[part]; p < Ksplit[part+1]; p++)
+          { next = Buckets[NTHREADS-1][p];
+            panel[p] = (next - prev)*swide;
+            prev = next;
+          }
+
+        if (prev == 0)
+          { for (p = 0; p < NTHREADS; p++)
+              rarm[p].range->off = rarm[p].range->beg = rarm[p].range->end = 0;
+          }
+        else
+          { if (VERBOSE)
+              { fprintf(stderr,"\r    Sorting part %d  ",part+1);
+                fflush(stderr);
+              }
+
+            msd_sort(sarray,next,swide,KBYTES,panel,NTHREADS,range);
+
+#ifdef DEBUG_SORT
+            print_table(sarray,swide,next);
+#endif
+          }
+      }
+
+      for (p = 0; p < NTHREADS; p++)   //  open units for T^2 index parts
+        { char *name;
+          int   inum;
+
+          inum = part*NTHREADS+p;
+          name = Numbered_Suffix(POST_NAME,inum,".ktb");
+          rarm[p].tout = Units[inum] = open(name,O_RDWR|O_CREAT|O_TRUNC,S_IRWXU);
+          if (rarm[p].tout < 0)
+            { fprintf(stderr,"%s: Cannot open %s for reading & writing\n",Prog_Name,name);
+              exit (1);
+            }
+          unlink(name);
+
+          name = Numbered_Suffix(POST_NAME,inum,".pst");
+          rarm[p].pout = Pnits[inum] = open(name,O_RDWR|O_CREAT|O_TRUNC,S_IRWXU);
+          if (rarm[p].pout < 0)
+            { fprintf(stderr,"%s: Cannot open %s for reading & writing\n",Prog_Name,name);
+              exit (1);
+            }
+          unlink(name);
+
+          name = Numbered_Suffix(POST_NAME,inum,".drp");
+          rarm[p].dout = Dnits[inum] = open(name,O_RDWR|O_CREAT|O_TRUNC,S_IRWXU);
+          if (rarm[p].dout < 0)
+            { fprintf(stderr,"%s: Cannot open %s for reading & writing\n",Prog_Name,name);
+              exit (1);
+            }
+          unlink(name);
+
+          rarm[p].inum = inum;
+        }
+
+      if (VERBOSE)
+        { fprintf(stderr,"\r    Outputing part %d",part+1);
+          fflush(stderr);
+        }
+
+#ifdef DEBUG_THREADS
+      for (p = 0; p < NTHREADS; p++)
+        output_thread(rarm+p);
+#else
+      for (p = 1; p < NTHREADS; p++)
+        pthread_create(threads+p,NULL,output_thread,rarm+p);
+      output_thread(rarm);
+      for (p = 1; p < NTHREADS; p++)
+        pthread_join(threads[p],NULL);
+#endif
+
+      for (p = 0; p < NTHREADS; p++)
+        { nelim += rarm[p].nelim;
+          nbase += rarm[p].nbase;
+          nkmer += rarm[p].nkmer;
+          carm[part].nkmer += rarm[p].nkmer;
+          carm[part].npost += rarm[p].npost;
+          carm[part].ndrop += rarm[p].nelim;
+        }
+    }
+
+  if (VERBOSE)
+    { fprintf(stderr,"\n    Concat'ing parts\n");
+      fflush(stderr);
+    }
+
+  if (gdb->seqstate == EXTERNAL)
+    for (p = 1; p < NTHREADS; p++)
+      fclose(sarm[p].gdb.seqs);
+
+  for (p = 0; p < NTHREADS; p++)
+    { carm[p].tout = open(Catenate(TPATH,"/.",TROOT,
+                          Numbered_Suffix(".ktab.",p+1,"")),
+                          O_WRONLY|O_CREAT|O_TRUNC,S_IRWXU);
+      if (carm[p].tout < 0)
+        { fprintf(stderr,"%s: Cannot open part file %s/.%s.ktab.%d for writing\n",
+                         Prog_Name,TPATH,TROOT,p+1);
+          goto remove_parts;
+        }
+      carm[p].pout = open(Catenate(TPATH,"/.",TROOT,
+                          Numbered_Suffix(".post.",p+1,"")),
+                          O_WRONLY|O_CREAT|O_TRUNC,S_IRWXU);
+      if (carm[p].pout < 0)
+        { fprintf(stderr,"%s: Cannot open part file %s/.%s.post.%d for writing\n",
+                         Prog_Name,TPATH,TROOT,p+1);
+          goto remove_parts;
+        }
+      carm[p].dout = open(Catenate(TPATH,"/.",TROOT,
+                          Numbered_Suffix(".drop.",p+1,"")),
+                          O_WRONLY|O_CREAT|O_TRUNC,S_IRWXU);
+      if (carm[p].dout < 0)
+        { fprintf(stderr,"%s: Cannot open part file %s/.%s.drop.%d for writing\n",
+                         Prog_Name,TPATH,TROOT,p+1);
+          goto remove_parts;
+        }
+    }
+
+#ifdef DEBUG_THREADS
+  for (p = 0; p < NTHREADS; p++)
+    catenate_thread(carm+p);
+#else
+  for (p = 1; p < NTHREADS; p++)
+    pthread_create(threads+p,NULL,catenate_thread,carm+p);
+  catenate_thread(carm);
+  for (p = 1; p < NTHREADS; p++)
+    pthread_join(threads[p],NULL);
+#endif
+
+  for (p = 0; p < NTHREADS; p++)
+    if (carm[p].fail)
+      goto remove_parts;
+
+  if (VERBOSE)
+    { int64 npost = gdb->seqtot - gdb->ncontig*(KMER-1);
+
+      fprintf(stderr,"\r    Done                                           \n");
+      fprintf(stderr,"\n  Kept:    %11lld kmers, %11lld(%5.1f%%) positions\n",
+                     nkmer,npost-nbase,((npost-nbase)*100.)/npost);
+      fprintf(stderr,"  Dropped: %11lld kmers, %11lld(%5.1f%%) positions\n\n",
+                     nelim,nbase,(nbase*100.)/npost);
+      fflush(stderr);
+    }
+
+  { int   tab;
+    int   x;
+    int64 maxpre;
+
+    tab = open(Catenate(TPATH,"/",TROOT,".gix"),O_WRONLY|O_CREAT|O_TRUNC,S_IRWXU);
+    if (tab < 0)
+      { fprintf(stderr,"%s: Cannot open %s/%s.gix for writing\n",Prog_Name,TPATH,TROOT);
+        goto remove_parts;
+      }
+    if (write(tab,&KMER,sizeof(int)) < 0) goto gix_error;
+    if (write(tab,&NTHREADS,sizeof(int)) < 0) goto gix_error;
+    x = 1;
+    if (write(tab,&x,sizeof(int)) < 0) goto gix_error;
+    x = 3;
+    if (write(tab,&x,sizeof(int)) < 0) goto gix_error;
+
+    maxpre = prefix[0];
+    for (x = 1; x < 0x1000000; x++)
+      { if (prefix[x] > maxpre)
+          maxpre = prefix[x];
+        prefix[x] += prefix[x-1];
+      }
+    if (write(tab,prefix,sizeof(int64)*0x1000000) < 0) goto gix_error;
+
+    if (write(tab,&PostBytes,sizeof(int)) < 0) goto gix_error;
+    if (write(tab,&ContBytes,sizeof(int)) < 0) goto gix_error;
+    if (write(tab,&NTHREADS,sizeof(int)) < 0) goto gix_error;
+    if (write(tab,&maxpre,sizeof(int64)) < 0) goto gix_error;
+    if (write(tab,&FREQ,sizeof(int)) < 0) goto gix_error;
+    if (write(tab,&(gdb->ncontig),sizeof(int)) < 0) goto gix_error;
+    if (write(tab,Perm,sizeof(int)*gdb->ncontig) < 0) goto gix_error;
+
+    for (x = 1; x < 0x10000; x++)
+      posfix[x] += posfix[x-1];
+    if (write(tab,posfix,sizeof(int64)*0x10000) < 0) goto gix_error;
+    if (write_sums(tab,gdb,Csum)) goto gix_error;
+
+    close(tab);
+  }
+ 
+  free(buffer);
+  free(sarray);
+  free(posfix);
+  free(prefix);
+  return;
+
+gix_error:
+  unlink(Catenate(TPATH,"/",TROOT,".gix"));
+  fprintf(stderr,"%s: IO error while writing %s/%s.gix\n",Prog_Name,TPATH,TROOT);
+  goto remove_parts;
+
+remove_parts:
+  for (p = 1; p <= NTHREADS; p++)
+    { unlink(Catenate(TPATH,"/.",TROOT,Numbered_Suffix(".ktab.",p,"")));
+      unlink(Catenate(TPATH,"/.",TROOT,Numbered_Suffix(".post.",p,"")));
+      unlink(Catenate(TPATH,"/.",TROOT,Numbered_Suffix(".drop.",p,"")));
+    }
+  exit (1);
+}
+
+
+/***********************************************************************************************
+ *
+ *   GIX CREATION
+ *
+ **********************************************************************************************/
+
+static void short_GDB_fix(GDB *gdb)
+{ int i;
+
+  if (gdb->ncontig >= NTHREADS)
+    return;
+
+  //  Add additional conitgs of length KMER that are the first bit of the 0th read/contig
+  //    Mark as "fake" with -1 in origin field.
+
+  gdb->contigs = Realloc(gdb->contigs,sizeof(GDB_CONTIG)*NTHREADS,"Reallocating DB read vector");
+  for (i = gdb->ncontig; i < NTHREADS; i++)
+    { gdb->contigs[i] = gdb->contigs[0];
+      gdb->contigs[i].clen = KMER;
+      gdb->contigs[i].boff = -1;
+    }
+  gdb->seqtot += (NTHREADS-gdb->ncontig)*KMER;
+  if (gdb->maxctg < KMER)
+    gdb->maxctg = KMER;
+  gdb->ncontig = NTHREADS;
+}
+
+static GDB_CONTIG *CONTIGS;
+
+static int LSORT(const void *l, const void *r)
+{ int x = *((int *) l);
+  int y = *((int *) r);
+
+  return (CONTIGS[y].clen - CONTIGS[x].clen);
+}
+
+//  Compute NTHREADS 1st byte partitions based on bp frequency
+
+static void split_kmers(GDB *gdb)
+{ int    i, n;
+  double p, t;
+
+  Ksplit = Malloc((NTHREADS+1)*sizeof(int),"Allocating Kmer split array");
+
+  p = 0.;
+  n = 0;
+  t = 1./NTHREADS;
+  Ksplit[0] = 0;
+  for (i = 0; i < 256; i++)
+    { p += gdb->freq[i >> 6] * gdb->freq[(i >> 4) & 0x3] 
+         * gdb->freq[(i >> 2) & 0x3] * gdb->freq[i&0x3];
+      while (p*(2.-p) > t)
+        { n += 1;
+          Ksplit[n] = i;
+          t = (n+1.)/NTHREADS;
+        }
+      Select[i] = n;
+    }
+  Ksplit[NTHREADS] = 256;
+}
+
+//  Compute the # of bytes for encoding a post and for a contig + sign bit
+
+static void post_sizes(GDB *gdb)
+{ int64 range, cum;
+  int   r;
+
+  range = 0;
+  for (r = 0; r < gdb->ncontig; r++)
+    if (range < gdb->contigs[r].clen)
+      range = gdb->contigs[r].clen;
+
+  PostBytes = 0;
+  cum = 1;
+  while (cum < range)
+    { cum *= 256;
+      PostBytes += 1;
+    }
+
+  range = 2*gdb->ncontig;
+  ContBytes = 0;
+  cum = 1;
+  while (cum < range)
+    { cum *= 256;
+      ContBytes += 1;
+    }
+}
+
+//  Produce perms for length sorted order of contigs
+
+static void sort_contigs(GDB *gdb)
+{ int i;
+ 
+  Perm = Malloc(2*gdb->ncontig*sizeof(int),"Allocating sort permutation arrays");
+  InvP = Perm + gdb->ncontig;
+
+  for (i = 0; i < gdb->ncontig; i++)
+    Perm[i] = i;
+  
+  CONTIGS = gdb->contigs;
+  qsort(Perm,gdb->ncontig,sizeof(int),LSORT);
+
+  for (i = 0; i < gdb->ncontig; i++)
+    InvP[Perm[i]] = i;
+}
+
+int Create_GIX(GDB *gdb, char *tpath, int kmer, int freq, int nthreads, char *sort_path,
+               int verbose)
+{ FREQ     = freq;
+  KMER     = kmer;
+  KBYTES   = (KMER>>2);
+  NTHREADS = nthreads;
+  VERBOSE  = verbose;
+
+  TPATH = PathTo(tpath);
+  TROOT = Root(tpath,NULL);
+  if (TPATH == NULL || TROOT == NULL)
+    exit (1);
+
+  //  Make sure you can open (3 * NTHREADS + 3) * NTHREADS + 1 + tid files at one time.
+  //    tid is typically 3 unless using valgrind or other instrumentation.
+
+  { struct rlimit rlp;
+    int           tid;
+    uint64        nfiles;
+
+    tid = open(".xxx",O_CREAT|O_TRUNC|O_WRONLY,S_IRWXU);
+    close(tid);
+    unlink(".xxx");
+
+    nfiles = (3*NTHREADS+3)*NTHREADS + 1 + tid;
+    getrlimit(RLIMIT_NOFILE,&rlp);
+    if (nfiles > rlp.rlim_max)
+      { fprintf(stderr,"\n%s: Cannot open %lld files simultaneously\n",Prog_Name,nfiles);
+        exit (1);
+      } 
+    if (rlp.rlim_cur < nfiles)
+      rlp.rlim_cur = nfiles;
+    if (setrlimit(RLIMIT_NOFILE,&rlp) < 0)
+      { fprintf(stderr,"%s: Could not increase IO unit resourc to %d\n",
+                       Prog_Name,(3*NTHREADS+3)*NTHREADS);
+        exit (1);
+      }
+  } 
+
+  POST_NAME = Strdup(Catenate(sort_path,"/.",Numbered_Suffix("post.",getpid(),"."),""),
+                     "Allocating post index name");
+  if (POST_NAME == NULL)
+    exit (1);
+
+  short_GDB_fix(gdb);
+
+  Csum = Malloc(sizeof(uint64)*gdb->ncontig,"Allocating contig checksums");
+  if (Csum == NULL)
+    exit (1);
+
+  { int i, l0, l1, l2, l3;   //  Compute byte complement table
+
+    i = 0;
+    for (l0 = 3; l0 >= 0; l0 -= 1)
+     for (l1 = 12; l1 >= 0; l1 -= 4)
+      for (l2 = 48; l2 >= 0; l2 -= 16)
+       for (l3 = 192; l3 >= 0; l3 -= 64)
+         Comp[i++] = (l3 | l2 | l1 | l0);
+  }
+
+  split_kmers(gdb);   //  Compute NTHREADS 1st byte partitions based on bp frequency
+
+  { int64 npost, cum, t;   //  Compute DB split into NTHREADS parts
+    int   p, r, len;
+
+    DBsplit = Malloc((NTHREADS+1)*sizeof(int),"Allocating DB split arrays");
+    DBpost  = Malloc((NTHREADS+1)*sizeof(int64),"Allocating DB split arrays");
+
+    npost = gdb->seqtot;
+    cum   = 0;
+
+    DBsplit[0] = 0;
+    DBpost [0] = 0;
+    p = 1;
+    t = (npost*p)/NTHREADS;
+    for (r = 0; r < gdb->ncontig; r++)
+      { len = gdb->contigs[r].clen;
+        cum += len;
+        while (cum >= t)
+          { DBsplit[p] = r+1;
+            DBpost [p] = cum;
+            p += 1;
+            t = (npost*p)/NTHREADS;
+          }
+      }
+    DBsplit[NTHREADS] = gdb->ncontig;
+    DBpost [NTHREADS] = npost;
+  }
+
+  post_sizes(gdb);   //  Compute # of bytes for encoding a post and a contig + sign bit
+
+  sort_contigs(gdb);   //  Produce perms for length sorted order of contigs
+
+  if (VERBOSE)
+    { fprintf(stderr,"  Partitioning K-mers via pos-lists into %d parts\n",NTHREADS);
+      fflush(stderr);
+    }
+
+  { int p;   //  Setup distribution bucket array
+
+    Buckets = Malloc(NTHREADS*sizeof(int64 *),"Allocating distribution buckets");
+    Buckets[0] = Malloc(NTHREADS*256*sizeof(int64),"Allocating distribution buckets");
+    bzero(Buckets[0],NTHREADS*256*sizeof(int64));
+    for (p = 1; p < NTHREADS; p++)
+      Buckets[p] = Buckets[p-1] + 256;
+  }
+
+  { int   p, i, k;         //  Open IO units for distribution and reimport
+    char *name;
+
+    Units = Malloc(3*NTHREADS*NTHREADS*sizeof(int),"Allocating IO Units");
+    Pnits = Units + NTHREADS*NTHREADS;
+    Dnits = Pnits + NTHREADS*NTHREADS;
+
+    k = 0;
+    for (p = 0; p < NTHREADS; p++)
+      for (i = 0; i < NTHREADS; i++)
+        { name = Numbered_Suffix(POST_NAME,k,".idx");
+          Units[k] = open(name,O_RDWR|O_CREAT|O_TRUNC,S_IRWXU);
+          if (Units[k] < 0)
+            { fprintf(stderr,"%s: Cannot open %s for reading & writing\n",Prog_Name,name);
+              exit (1);
+            }
+          unlink(name);
+          k += 1;
+        }
+  }
+
+  distribute(gdb);   //  Distribute k-mers to 1st byte partitions, encoded as compressed
+                     //    relative positions of the given k-mers
+
+  if (VERBOSE)
+    { fprintf(stderr,"  Starting sort & index output of each part\n");
+      fflush(stderr);
+    }
+
+  k_sort(gdb);  //  Reimport the post listings, recreating the k-mers and sorting
+                //    them with their posts to produce the final genome index.
+
+  free(Units);
+
+  free(Buckets[0]);
+  free(Buckets);
+  free(Csum);
+  free(Perm);
+  free(DBpost);
+  free(DBsplit);
+  free(Ksplit);
+
+  free(POST_NAME);
+  free(TROOT);
+  free(TPATH);
+
+  return (0);
+}
+
+
+/***********************************************************************************************
+ *
+ *   GIX UPDATE:  When contigs have been appended to a GDB, a delta index of just the new contigs
+ *        is built with Create_GIX and then merged with the existing index in a single streaming
+ *        pass over both k-mer tables, their post lists, and their drop lists (the k-mers that
+ *        occurred FREQ or more times in each).  A k-mer is kept if it is on neither drop list
+ *        and its combined count is less than FREQ, otherwise it is added to the new drop list.
+ *        The contigs are re-sorted by length, every post's contig is renumbered accordingly,
+ *        and the lcp and count bytes and prefix indices are recomputed as the merged table
+ *        is output into parts split on 1st byte as for a fresh build.
+ *
+ **********************************************************************************************/
+
+typedef struct
+  { int     rbyte;    //  # of bytes in a record
+    int     hbyte;    //  # of bytes in the header of a part
+    int     nthr;     //  # of parts
+    int     part;     //  part currently open (nthr+1 when exhausted)
+    int     copn;     //  its file descriptor
+    char   *name;     //  path name of the parts (only # missing)
+    int     nlen;     //  length of path name
+    uint8  *cache;    //  buffer of records [cptr,ctop) remain
+    uint8  *cptr;
+    uint8  *ctop;
+  } Part_List;
+
+#define PART_BLOCK 0x10000
+
+static void Free_Part_List(Part_List *P)
+{ if (P->part <= P->nthr)
+    close(P->copn);
+  free(P->cache);
+  free(P->name);
+  free(P);
+}
+
+//  Open the parts <dir>/.<root><suffix>1 .. nthr of a post or drop list for sequential
+//    reading, returning NULL if any is missing.
+
+static Part_List *Open_Part_List(char *dir, char *root, char *suffix, int nthr,
+                                 int hbyte, int rbyte)
+{ Part_List *P;
+  struct stat status;
+  int p;
+
+  for (p = 1; p <= nthr; p++)
+    if (stat(Catenate(dir,"/.",root,Numbered_Suffix(suffix,p,"")),&status) != 0)
+      return (NULL);
+
+  P = Malloc(sizeof(Part_List),"Allocating part list");
+  if (P == NULL)
+    exit (1);
+  P->name  = Strdup(Catenate(dir,"/.",root,suffix),"Allocating part list");
+  P->cache = Malloc(PART_BLOCK*rbyte,"Allocating part list");
+  if (P->name == NULL || P->cache == NULL)
+    exit (1);
+  P->nlen  = strlen(P->name);
+  P->name  = Realloc(P->name,P->nlen+20,"Allocating part list");
+  P->rbyte = rbyte;
+  P->hbyte = hbyte;
+  P->nthr  = nthr;
+  P->part  = 0;
+  P->cptr  = P->ctop = P->cache;
+  return (P);
+}
+
+//  Return a pointer to the next record of P, or NULL if there are no more.
+
+static uint8 *Next_Part_Record(Part_List *P)
+{ uint8 *r;
+  int    len;
+
+  while (P->cptr >= P->ctop)
+    { if (P->part > 0)
+        { if (P->part > P->nthr)
+            return (NULL);
+          len = read(P->copn,P->cache,PART_BLOCK*P->rbyte);
+          if (len < 0)
+            { fprintf(stderr,"%s: Error reading part file %s\n",Prog_Name,P->name);
+              exit (1);
+            }
+          if (len % P->rbyte != 0)
+            { fprintf(stderr,"%s: Part file %s is truncated\n",Prog_Name,P->name);
+              exit (1);
+            }
+          if (len > 0)
+            { P->cptr = P->cache;
+              P->ctop = P->cache + len;
+              break;
+            }
+          close(P->copn);
+        }
+      P->part += 1;
+      if (P->part > P->nthr)
+        return (NULL);
+      sprintf(P->name+P->nlen,"%d",P->part);
+      P->copn = open(P->name,O_RDONLY);
+      if (P->copn < 0)
+        { fprintf(stderr,"%s: Cannot open part file %s for reading\n",Prog_Name,P->name);
+          exit (1);
+        }
+      if (lseek(P->copn,P->hbyte,SEEK_SET) < 0)
+        { fprintf(stderr,"%s: Cannot advance part file %s to data part\n",Prog_Name,P->name);
+          exit (1);
+        }
+    }
+  r = P->cptr;
+  P->cptr += P->rbyte;
+  return (r);
+}
+
+typedef struct
+  { int    kmer;
+    int    nthr;
+    int    pbyte;
+    int    cbyte;
+    int    freq;
+    int    nctg;
+    int   *perm;
+    int64 *clen;     //  length and checksum of each contig
+    uint64 *csum;
+  } GIX_Stub;
+
+//  Read the fields of the GIX stub <dir>/<root>.gix needed for an update
+
+static int read_stub(char *dir, char *root, GIX_Stub *S)
+{ int   f, x;
+  int64 maxp;
+
+  f = open(Catenate(dir,"/",root,".gix"),O_RDONLY);
+  if (f < 0)
+    { fprintf(stderr,"%s: Cannot open GIX stub %s/%s.gix\n",Prog_Name,dir,root);
+      return (1);
+    }
+  if (read(f,&S->kmer,sizeof(int)) != sizeof(int)) goto stub_error;
+  if (read(f,&S->nthr,sizeof(int)) != sizeof(int)) goto stub_error;
+  if (read(f,&x,sizeof(int)) != sizeof(int)) goto stub_error;
+  if (read(f,&x,sizeof(int)) != sizeof(int)) goto stub_error;
+  if (x != 3)
+    { fprintf(stderr,"%s: %s/%s.gix is not a genome index\n",Prog_Name,dir,root);
+      close(f);
+      return (1);
+    }
+  if (lseek(f,4*sizeof(int)+0x1000000*sizeof(int64),SEEK_SET) < 0) goto stub_error;
+  if (read(f,&S->pbyte,sizeof(int)) != sizeof(int)) goto stub_error;
+  if (read(f,&S->cbyte,sizeof(int)) != sizeof(int)) goto stub_error;
+  if (read(f,&x,sizeof(int)) != sizeof(int)) goto stub_error;
+  if (read(f,&maxp,sizeof(int64)) != sizeof(int64)) goto stub_error;
+  if (read(f,&S->freq,sizeof(int)) != sizeof(int)) goto stub_error;
+  if (read(f,&S->nctg,sizeof(int)) != sizeof(int)) goto stub_error;
+  S->perm = Malloc(sizeof(int)*S->nctg,"Allocating GIX permutation");
+  S->clen = Malloc(sizeof(int64)*S->nctg,"Allocating GIX contig lengths");
+  S->csum = Malloc(sizeof(uint64)*S->nctg,"Allocating GIX contig checksums");
+  if (S->perm == NULL || S->clen == NULL || S->csum == NULL)
+    exit (1);
+  if (read(f,S->perm,sizeof(int)*S->nctg) != (ssize_t) (sizeof(int)*S->nctg)) goto stub_error;
+  if (lseek(f,sizeof(int64)*0x10000,SEEK_CUR) < 0) goto stub_error;
+  if (read(f,S->clen,sizeof(int64)*S->nctg) != (ssize_t) (sizeof(int64)*S->nctg)
+        || read(f,S->csum,sizeof(uint64)*S->nctg) != (ssize_t) (sizeof(uint64)*S->nctg))
+    { fprintf(stderr,"%s: Index %s/%s.gix has no contig checksums, rebuild it once to update it\n",
+                     Prog_Name,dir,root);
+      close(f);
+      return (1);
+    }
+  close(f);
+  return (0);
+
+stub_error:
+  fprintf(stderr,"%s: IO error reading GIX stub %s/%s.gix\n",Prog_Name,dir,root);
+  close(f);
+  return (1);
+}
+
+//  Buffered output to one of the current parts
+
+typedef struct
+  { int    fd;
+    uint8 *buf;
+    uint8 *ptr;
+    uint8 *end;
+  } Part_Out;
+
+static void flush_out(Part_Out *o, char *what, int p)
+{ if (o->ptr > o->buf)
+    if (write(o->fd,o->buf,o->ptr-o->buf) < 0)
+      { fprintf(stderr,"%s: IO error writing to part file %s/.%s.%s.%d.new\n",
+                       Prog_Name,TPATH,TROOT,what,p+1);
+        exit (1);
+      }
+  o->ptr = o->buf;
+}
+
+//  lcp in bases of the packed k-mers a and b
+
+static inline int kmer_lcp(uint8 *a, uint8 *b)
+{ int i, x;
+
+  for (i = 0; i < KBYTES; i++)
+    if ((x = (a[i] ^ b[i])) != 0)
+      { i <<= 2;
+        if (x & 0xc0)
+          return (i);
+        if (x & 0x30)
+          return (i+1);
+        if (x & 0x0c)
+          return (i+2);
+        return (i+3);
+      }
+  return (KMER);
+}
+
+static char *Part_Name[3] = { "ktab", "post", "drop" };
+static char *Part_Sfx[3]  = { ".ktab.", ".post.", ".drop." };
+
+//  Open the new table, post, and drop list parts 'part' and write their headers with a
+//    count of 0 for the moment
+
+static int open_parts(Part_Out *out, int64 *nels, int part)
+{ int p;
+
+  for (p = 0; p < 3; p++)
+    { out[p].fd = open(Catenate(TPATH,"/.",TROOT,Numbered_Suffix(Part_Sfx[p],part+1,".new")),
+                       O_WRONLY|O_CREAT|O_TRUNC,S_IRWXU);
+      if (out[p].fd < 0)
+        { fprintf(stderr,"%s: Cannot open part file %s/.%s.%s.%d.new for writing\n",
+                         Prog_Name,TPATH,TROOT,Part_Name[p],part+1);
+          return (1);
+        }
+      nels[p] = 0;
+    }
+  if (write(out[0].fd,&KMER,sizeof(int)) < 0 ||
+      write(out[0].fd,&nels[0],sizeof(int64)) < 0 ||
+      write(out[1].fd,&PostBytes,sizeof(int)) < 0 ||
+      write(out[1].fd,&ContBytes,sizeof(int)) < 0 ||
+      write(out[1].fd,&nels[1],sizeof(int64)) < 0 ||
+      write(out[2].fd,&KMER,sizeof(int)) < 0 ||
+      write(out[2].fd,&nels[2],sizeof(int64)) < 0)
+    { fprintf(stderr,"%s: IO error writing to part %d of the update of %s/%s.gix\n",
+                     Prog_Name,part+1,TPATH,TROOT);
+      return (1);
+    }
+  return (0);
+}
+
+//  Flush the new parts 'part', set the counts in their headers, and close them
+
+static int close_parts(Part_Out *out, int64 *nels, int part)
+{ int p;
+
+  for (p = 0; p < 3; p++)
+    flush_out(out+p,Part_Name[p],part);
+  if (pwrite(out[0].fd,&nels[0],sizeof(int64),sizeof(int)) < 0 ||
+      pwrite(out[1].fd,&nels[1],sizeof(int64),2*sizeof(int)) < 0 ||
+      pwrite(out[2].fd,&nels[2],sizeof(int64),sizeof(int)) < 0)
+    { fprintf(stderr,"%s: IO error writing to part %d of the update of %s/%s.gix\n",
+                     Prog_Name,part+1,TPATH,TROOT);
+      return (1);
+    }
+  for (p = 0; p < 3; p++)
+    close(out[p].fd);
+  return (0);
+}
+
+int Update_GIX(GDB *gdb, char *tpath, int nthreads, char *sort_path, int verbose)
+{ GIX_Stub  old, del;
+  char     *dpath, *droot;
+  int       nctg, ndel;
+  int      *map0, *map1;
+
+  TPATH = PathTo(tpath);
+  TROOT = Root(tpath,NULL);
+  if (TPATH == NULL || TROOT == NULL)
+    exit (1);
+
+  if (read_stub(TPATH,TROOT,&old))
+    exit (1);
+
+  //  The contigs of the existing index must be the first old.nctg contigs of gdb
+
+  nctg = gdb->ncontig;
+  ndel = nctg - old.nctg;
+  if (old.nctg <= old.nthr)
+    { fprintf(stderr,"%s: Index %s/%s.gix has too few contigs to be updated, rebuild it\n",
+                     Prog_Name,TPATH,TROOT);
+      exit (1);
+    }
+  if (ndel < 0)
+    { fprintf(stderr,"%s: GDB has fewer contigs than its index %s/%s.gix\n",
+                     Prog_Name,TPATH,TROOT);
+      exit (1);
+    }
+
+  { uint8 *seq;
+    int    r;
+
+    for (r = 0; r < old.nctg; r++)
+      if (old.perm[r] < 0 || old.perm[r] >= old.nctg)
+        { fprintf(stderr,"%s: Index %s/%s.gix is corrupted\n",Prog_Name,TPATH,TROOT);
+          exit (1);
+        }
+
+    seq = (uint8 *) New_Contig_Buffer(gdb);
+    if (seq == NULL)
+      exit (1);
+    for (r = 0; r < old.nctg; r++)
+      { if (gdb->contigs[r].clen == old.clen[r])
+          { Get_Contig(gdb,r,NUMERIC,(char *) seq);
+            if (contig_sum(seq,old.clen[r]) == old.csum[r])
+              continue;
+          }
+        fprintf(stderr,"%s: Contig %d of the GDB differs from that of index %s/%s.gix,\n",
+                       Prog_Name,r+1,TPATH,TROOT);
+        fprintf(stderr,"%*s  new contigs must follow the unchanged contigs of the index\n",
+                       (int) strlen(Prog_Name),"");
+        exit (1);
+      }
+    free(seq-1);
+  }
+
+  { int p;
+
+    for (p = 0; p < 3; p++)
+      { Part_List *P;
+
+        P = Open_Part_List(TPATH,TROOT,Part_Sfx[p],old.nthr,0,1);
+        if (P == NULL)
+          { if (p == 2)
+              fprintf(stderr,"%s: Index %s/%s.gix has no drop lists, rebuild it once to update it\n",
+                             Prog_Name,TPATH,TROOT);
+            else
+              fprintf(stderr,"%s: Index %s/%s.gix is missing %s parts\n",
+                             Prog_Name,TPATH,TROOT,Part_Name[p]);
+            exit (1);
+          }
+        Free_Part_List(P);
+      }
+  }
+
+  if (ndel == 0)
+    { if (verbose)
+        { fprintf(stderr,"  Index %s/%s.gix already covers all %d contigs\n",TPATH,TROOT,nctg);
+          fflush(stderr);
+        }
+      free(old.csum);
+      free(old.clen);
+      free(old.perm);
+      free(TROOT);
+      free(TPATH);
+      return (0);
+    }
+
+  //  Build the delta index of the new contigs in the temporary directory
+
+  { GDB   dgdb;
+    int64 tot, max;
+    int   r, dthreads;
+
+    if (verbose)
+      { fprintf(stderr,"  Building delta index of %d new contigs\n\n",ndel);
+        fflush(stderr);
+      }
+
+    free(TROOT);
+    free(TPATH);
+
+    dgdb = *gdb;
+    dgdb.ncontig = ndel;
+    dgdb.contigs = Malloc(sizeof(GDB_CONTIG)*ndel,"Allocating delta contigs");
+    if (dgdb.contigs == NULL)
+      exit (1);
+    memcpy(dgdb.contigs,gdb->contigs+old.nctg,sizeof(GDB_CONTIG)*ndel);
+    tot = max = 0;
+    for (r = 0; r < ndel; r++)
+      { tot += dgdb.contigs[r].clen;
+        if (dgdb.contigs[r].clen > max)
+          max = dgdb.contigs[r].clen;
+      }
+    dgdb.seqtot = tot;
+    dgdb.maxctg = max;
+
+    dthreads = (ndel < nthreads ? ndel : nthreads);
+    dpath = Strdup(Catenate(sort_path,"/",Numbered_Suffix("gixdelta.",getpid(),".gix"),""),
+                   "Allocating delta index name");
+    if (dpath == NULL)
+      exit (1);
+    Create_GIX(&dgdb,dpath,old.kmer,old.freq,dthreads,sort_path,verbose);
+    free(dgdb.contigs);
+
+    droot = Root(dpath,NULL);
+    free(dpath);
+    dpath = Strdup(sort_path,"Allocating delta index name");
+
+    if (read_stub(dpath,droot,&del))
+      goto remove_delta;
+  }
+
+  FREQ     = old.freq;
+  KMER     = old.kmer;
+  KBYTES   = (KMER>>2);
+  NTHREADS = old.nthr;
+  VERBOSE  = verbose;
+
+  TPATH = PathTo(tpath);
+  TROOT = Root(tpath,NULL);
+  if (TPATH == NULL || TROOT == NULL)
+    exit (1);
+
+  split_kmers(gdb);
+  post_sizes(gdb);
+  sort_contigs(gdb);
+
+  //  Maps from the contig numbers of the old and delta posts to those of the update
+
+  { int r;
+
+    map0 = Malloc(sizeof(int)*(old.nctg+del.nctg),"Allocating contig maps");
+    if (map0 == NULL)
+      exit (1);
+    map1 = map0 + old.nctg;
+    for (r = 0; r < old.nctg; r++)
+      map0[r] = InvP[old.perm[r]];
+    for (r = 0; r < del.nctg; r++)
+      map1[r] = InvP[old.nctg + del.perm[r]];
+
+    Csum = Malloc(sizeof(uint64)*nctg,"Allocating contig checksums");
+    if (Csum == NULL)
+      exit (1);
+    memcpy(Csum,old.csum,sizeof(uint64)*old.nctg);
+    memcpy(Csum+old.nctg,del.csum,sizeof(uint64)*del.nctg);
+  }
+
+  if (VERBOSE)
+    { fprintf(stderr,"\n  Merging delta into index %s/%s.gix of %d parts\n",TPATH,TROOT,NTHREADS);
+      fflush(stderr);
+    }
+
+  { Kmer_Stream *T0, *T1;
+    Part_List   *P0, *P1, *D0, *D1;
+    Part_Out     out[3];
+    int64        nels[3], *prefix, *posfix, maxpre;
+    int64        nkmer, ndrop, npost;
+    uint8       *k0, *k1, *d0, *d1, *key, *prev, *zero;
+    int          part, first, nthr, p, x;
+    int          pbyte, rbyte0, rbyte1;
+    int64        flag, flag0, flag1;
+
+    T0 = Open_Kmer_Stream(Catenate(TPATH,"/",TROOT,".gix"));
+    T1 = Open_Kmer_Stream(Catenate(dpath,"/",droot,".gix"));
+    if (T0 == NULL || T1 == NULL)
+      { fprintf(stderr,"%s: Cannot open the k-mer tables of the index and its delta\n",
+                       Prog_Name);
+        goto remove_delta;
+      }
+
+    rbyte0 = old.pbyte + old.cbyte;
+    rbyte1 = del.pbyte + del.cbyte;
+    P0 = Open_Part_List(TPATH,TROOT,".post.",old.nthr,2*sizeof(int)+sizeof(int64),rbyte0);
+    D0 = Open_Part_List(TPATH,TROOT,".drop.",old.nthr,sizeof(int)+sizeof(int64),KBYTES);
+    P1 = Open_Part_List(dpath,droot,".post.",del.nthr,2*sizeof(int)+sizeof(int64),rbyte1);
+    D1 = Open_Part_List(dpath,droot,".drop.",del.nthr,sizeof(int)+sizeof(int64),KBYTES);
+    if (P0 == NULL || D0 == NULL || P1 == NULL || D1 == NULL)
+      { fprintf(stderr,"%s: Cannot open the post and drop lists of the index and its delta\n",
+                       Prog_Name);
+        goto remove_delta;
+      }
+
+    pbyte  = PostBytes + ContBytes;
+    flag   = (0x1ll << (8*ContBytes-1));
+    flag0  = (0x1ll << (8*old.cbyte-1));
+    flag1  = (0x1ll << (8*del.cbyte-1));
+
+    prefix = Malloc(sizeof(int64)*0x1000000,"Allocating prefix array");
+    posfix = Malloc(sizeof(int64)*0x10000,"Allocating postfix array");
+    key    = Malloc(5*KBYTES,"Allocating merge k-mers");
+    out[0].buf = Malloc(3*BUFFER_LEN,"Allocating output buffers");
+    if (prefix == NULL || posfix == NULL || key == NULL || out[0].buf == NULL)
+      exit (1);
+    bzero(prefix,sizeof(int64)*0x1000000);
+    bzero(posfix,sizeof(int64)*0x10000);
+    k0   = key + KBYTES;
+    k1   = k0 + KBYTES;
+    prev = k1 + KBYTES;
+    zero = prev + KBYTES;
+    bzero(zero,KBYTES);
+    for (p = 0; p < 3; p++)
+      { out[p].buf = out[0].buf + p*BUFFER_LEN;
+        out[p].end = out[p].buf + (BUFFER_LEN - pbyte*256 - 2*KBYTES);
+        out[p].ptr = out[p].buf;
+        out[p].fd  = -1;
+      }
+
+    nkmer = ndrop = npost = 0;
+    nthr  = NTHREADS;
+    part  = -1;
+    first = 0;
+
+    First_Kmer_Entry(T0);
+    First_Kmer_Entry(T1);
+    d0 = Next_Part_Record(D0);
+    d1 = Next_Part_Record(D1);
+
+#define LOAD_KMER(T,k)						\
+  if (T->csuf != NULL)						\
+    { k[0] = (T->cpre >> 16);					\
+      k[1] = (T->cpre >> 8) & 0xff;				\
+      k[2] = T->cpre & 0xff;					\
+      memcpy(k+3,T->csuf,KBYTES-3);				\
+    }
+
+    LOAD_KMER(T0,k0)
+    LOAD_KMER(T1,k1)
+
+    while (1)
+      { uint8 *m;
+        int    in0, in1, drop, c0, c1, c;
+
+        //  Find the least k-mer at the head of the four lists
+
+        m = NULL;
+        if (T0->csuf != NULL)
+          m = k0;
+        if (T1->csuf != NULL && (m == NULL || memcmp(k1,m,KBYTES) < 0))
+          m = k1;
+        if (d0 != NULL && (m == NULL || memcmp(d0,m,KBYTES) < 0))
+          m = d0;
+        if (d1 != NULL && (m == NULL || memcmp(d1,m,KBYTES) < 0))
+          m = d1;
+        if (m == NULL)
+          break;
+        memcpy(key,m,KBYTES);
+
+        in0  = (T0->csuf != NULL && memcmp(k0,key,KBYTES) == 0);
+        in1  = (T1->csuf != NULL && memcmp(k1,key,KBYTES) == 0);
+        drop = ((d0 != NULL && memcmp(d0,key,KBYTES) == 0) ||
+                (d1 != NULL && memcmp(d1,key,KBYTES) == 0));
+        c0 = (in0 ? T0->csuf[KBYTES-3] : 0);
+        c1 = (in1 ? T1->csuf[KBYTES-3] : 0);
+        c  = c0+c1;
+
+        //  Move on to the part of the k-mer, finishing those before it
+
+        while (part < Select[key[0]])
+          { if (part >= 0 && close_parts(out,nels,part))
+              goto remove_new;
+            part += 1;
+            if (open_parts(out,nels,part))
+              goto remove_new;
+            first = 1;
+          }
+
+        //  The lcp of the 1st k-mer of a part is with the all-a k-mer, save that it is 0
+        //    if the part starts with an a-a-a-a prefix, as in a fresh build
+
+        if (first)
+          { memcpy(prev,zero,KBYTES);
+            first = (key[0] == 0 ? 2 : 0);
+          }
+
+        if (drop || c >= FREQ)
+          { memcpy(out[2].ptr,key,KBYTES);
+            out[2].ptr += KBYTES;
+            nels[2] += 1;
+            ndrop   += 1;
+            for (x = 0; x < c0; x++)
+              if (Next_Part_Record(P0) == NULL)
+                goto inconsistent;
+            for (x = 0; x < c1; x++)
+              if (Next_Part_Record(P1) == NULL)
+                goto inconsistent;
+          }
+
+        else
+          { uint8 *o;
+            int64  post, cont;
+            uint8 *pptr = (uint8 *) (&post);
+            uint8 *cptr = (uint8 *) (&cont);
+            uint8 *r;
+            int    lcp;
+
+            lcp = (first == 2 ? 0 : kmer_lcp(prev,key));
+            first = 0;
+            memcpy(prev,key,KBYTES);
+
+            o = out[0].ptr;
+            memcpy(o,key+3,KBYTES-3);
+            o[KBYTES-3] = c;
+            o[KBYTES-2] = lcp;
+            out[0].ptr = o + (KBYTES-1);
+            nels[0] += 1;
+            nkmer   += 1;
+            npost   += c;
+
+            x = (key[0] << 16) | (key[1] << 8) | key[2];
+            prefix[x] += 1;
+            posfix[x >> 8] += c;
+
+            o = out[1].ptr;
+            for (x = 0; x < c; x++)
+              { if (x < c0)
+                  { r = Next_Part_Record(P0);
+                    if (r == NULL)
+                      goto inconsistent;
+                    post = cont = 0;
+                    memcpy(pptr,r,old.pbyte);
+                    memcpy(cptr,r+old.pbyte,old.cbyte);
+                    if (cont & flag0)
+                      cont = map0[cont-flag0] | flag;
+                    else
+                      cont = map0[cont];
+                  }
+                else
+                  { r = Next_Part_Record(P1);
+                    if (r == NULL)
+                      goto inconsistent;
+                    post = cont = 0;
+                    memcpy(pptr,r,del.pbyte);
+                    memcpy(cptr,r+del.pbyte,del.cbyte);
+                    if (cont & flag1)
+                      cont = map1[cont-flag1] | flag;
+                    else
+                      cont = map1[cont];
+                  }
+                memcpy(o,pptr,PostBytes);
+                memcpy(o+PostBytes,cptr,ContBytes);
+                o += pbyte;
+              }
+            out[1].ptr = o;
+            nels[1] += c;
+          }
+
+        for (p = 0; p < 3; p++)
+          if (out[p].ptr >= out[p].end)
+            flush_out(out+p,Part_Name[p],part);
+
+        if (in0)
+          { Next_Kmer_Entry(T0);
+            LOAD_KMER(T0,k0)
+          }
+        if (in1)
+          { Next_Kmer_Entry(T1);
+            LOAD_KMER(T1,k1)
+          }
+        if (d0 != NULL && memcmp(d0,key,KBYTES) == 0)
+          d0 = Next_Part_Record(D0);
+        if (d1 != NULL && memcmp(d1,key,KBYTES) == 0)
+          d1 = Next_Part_Record(D1);
+      }
+
+    if (Next_Part_Record(P0) != NULL || Next_Part_Record(P1) != NULL)
+      goto inconsistent;
+
+    //  Finish the last part and create any empty parts after it
+
+    while (part < nthr)
+      { if (part >= 0 && close_parts(out,nels,part))
+          goto remove_new;
+        part += 1;
+        if (part < nthr && open_parts(out,nels,part))
+          goto remove_new;
+      }
+
+    Free_Kmer_Stream(T1);
+    Free_Kmer_Stream(T0);
+    Free_Part_List(P0);
+    Free_Part_List(P1);
+    Free_Part_List(D0);
+    Free_Part_List(D1);
+    free(out[0].buf);
+
+    if (VERBOSE)
+      { int64 tpost = gdb->seqtot - gdb->ncontig*(KMER-1);
+
+        fprintf(stderr,"\n  Kept:    %11lld kmers, %11lld(%5.1f%%) positions\n",
+                       nkmer,npost,(npost*100.)/tpost);
+        fprintf(stderr,"  Dropped: %11lld kmers, %11lld(%5.1f%%) positions\n\n",
+                       ndrop,tpost-npost,((tpost-npost)*100.)/tpost);
+        fflush(stderr);
+      }
+
+    //  Write the new stub and then replace the old index with the new one
+
+    { int tab;
+
+      tab = open(Catenate(TPATH,"/.",TROOT,".gix.new"),O_WRONLY|O_CREAT|O_TRUNC,S_IRWXU);
+      if (tab < 0)
+        { fprintf(stderr,"%s: Cannot open %s/.%s.gix.new for writing\n",Prog_Name,TPATH,TROOT);
+          goto remove_new;
+        }
+      if (write(tab,&KMER,sizeof(int)) < 0) goto gix_error;
+      if (write(tab,&NTHREADS,sizeof(int)) < 0) goto gix_error;
+      x = 1;
+      if (write(tab,&x,sizeof(int)) < 0) goto gix_error;
+      x = 3;
+      if (write(tab,&x,sizeof(int)) < 0) goto gix_error;
+
+      maxpre = prefix[0];
+      for (x = 1; x < 0x1000000; x++)
+        { if (prefix[x] > maxpre)
+            maxpre = prefix[x];
+          prefix[x] += prefix[x-1];
+        }
+      if (write(tab,prefix,sizeof(int64)*0x1000000) < 0) goto gix_error;
+
+      if (write(tab,&PostBytes,sizeof(int)) < 0) goto gix_error;
+      if (write(tab,&ContBytes,sizeof(int)) < 0) goto gix_error;
+      if (write(tab,&NTHREADS,sizeof(int)) < 0) goto gix_error;
+      if (write(tab,&maxpre,sizeof(int64)) < 0) goto gix_error;
+      if (write(tab,&FREQ,sizeof(int)) < 0) goto gix_error;
+      if (write(tab,&(gdb->ncontig),sizeof(int)) < 0) goto gix_error;
+      if (write(tab,Perm,sizeof(int)*gdb->ncontig) < 0) goto gix_error;
+
+      for (x = 1; x < 0x10000; x++)
+        posfix[x] += posfix[x-1];
+      if (write(tab,posfix,sizeof(int64)*0x10000) < 0) goto gix_error;
+      if (write_sums(tab,gdb,Csum)) goto gix_error;
+
+      close(tab);
+    }
+
+    { char *name;
+
+      for (part = 1; part <= NTHREADS; part++)
+        for (p = 0; p < 3; p++)
+          { name = Strdup(Catenate(TPATH,"/.",TROOT,Numbered_Suffix(Part_Sfx[p],part,".new")),
+                          "Allocating part name");
+            if (name == NULL)
+              exit (1);
+            if (rename(name,Catenate(TPATH,"/.",TROOT,Numbered_Suffix(Part_Sfx[p],part,""))) < 0)
+              { fprintf(stderr,"%s: Could not replace part %s\n",Prog_Name,name);
+                exit (1);
+              }
+            free(name);
+          }
+      name = Strdup(Catenate(TPATH,"/.",TROOT,".gix.new"),"Allocating stub name");
+      if (name == NULL)
+        exit (1);
+      if (rename(name,Catenate(TPATH,"/",TROOT,".gix")) < 0)
+        { fprintf(stderr,"%s: Could not replace stub %s/%s.gix\n",Prog_Name,TPATH,TROOT);
+          exit (1);
+        }
+      free(name);
+    }
+
+    free(key);
+    free(posfix);
+    free(prefix);
+    goto done;
+
+  inconsistent:
+    fprintf(stderr,"%s: Post list of %s/%s.gix or its delta is inconsistent with its table\n",
+                   Prog_Name,TPATH,TROOT);
+    goto remove_new;
+
+  gix_error:
+    fprintf(stderr,"%s: IO error while writing %s/.%s.gix.new\n",Prog_Name,TPATH,TROOT);
+    goto remove_new;
+  }
+
+remove_new:
+  { int p, x;
+
+    unlink(Catenate(TPATH,"/.",TROOT,".gix.new"));
+    for (p = 1; p <= NTHREADS; p++)
+      for (x = 0; x < 3; x++)
+        unlink(Catenate(TPATH,"/.",TROOT,Numbered_Suffix(Part_Sfx[x],p,".new")));
+  }
+
+remove_delta:
+  { int p, x;
+
+    unlink(Catenate(dpath,"/",droot,".gix"));
+    for (p = 1; p <= nthreads; p++)
+      for (x = 0; x < 3; x++)
+        unlink(Catenate(dpath,"/.",droot,Numbered_Suffix(Part_Sfx[x],p,"")));
+  }
+  exit (1);
+
+done:
+  { int p, x;
+
+    unlink(Catenate(dpath,"/",droot,".gix"));
+    for (p = 1; p <= del.nthr; p++)
+      for (x = 0; x < 3; x++)
+        unlink(Catenate(dpath,"/.",droot,Numbered_Suffix(Part_Sfx[x],p,"")));
+  }
+
+  free(map0);
+  free(Perm);
+  free(Ksplit);
+  free(Csum);
+  free(del.csum);
+  free(del.clen);
+  free(del.perm);
+  free(old.csum);
+  free(old.clen);
+  free(old.perm);
+  free(droot);
+  free(dpath);
+  free(TROOT);
+  free(TPATH);
+
+  return (0);
+}
+
+
+/***********************************************************************************************
+ *
+ *   BATCH QUERIES:  Every k-mer of the query sequences is packed in canonical form along with
+ *        the index of its hit record, and the records are sorted.  A single forward sweep of
+ *        the k-mer table then resolves them, jumping ahead by way of the table's prefix index
+ *        only when the next distinct query k-mer is far away.  The number of posts before the
+ *        current table entry is tracked in the sweep (and reset from the post list's 2-byte
+ *        prefix index on a jump) so that the posts of each k-mer found are read with one
+ *        positioned read of its part file, again in increasing order.
+ *
+ **********************************************************************************************/
+
+#define SWEEP_JUMP 0x10000   //  Jump ahead in the table rather than scan if further than this
+
+static int QBYTES;   //  Bytes of a packed query k-mer (the sort key)
+
+static int QSORT(const void *l, const void *r)
+{ return (memcmp(l,r,QBYTES)); }
+
+static uint8 Code[128] =
+  { 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    4, 0, 4, 1, 4, 4, 4, 2, 4, 4, 4, 4, 4, 4, 4, 4,
+    4, 4, 4, 4, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+    4, 0, 4, 1, 4, 4, 4, 2, 4, 4, 4, 4, 4, 4, 4, 4,
+    4, 4, 4, 4, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+  };
+
+GIX_Batch *Find_GIX_Kmers(char *path, int nseq, char **seqs, int64 *lens)
+{ GIX_Batch   *B;
+  Kmer_Stream *T;
+  int          kmer, kbyte, rsize;
+  int64        nrec;
+  uint8       *recs;
+
+  int    pbyte, cbyte, nfile, freq, nctg;
+  int64  maxp;
+  int   *perm;
+  int64 *pindex;
+  int64 *neps;
+  int   *pfile;
+  char  *dir, *root;
+
+  //  Open the k-mer table and the post list stub and parts
+
+  T = Open_Kmer_Stream(path);
+  if (T == NULL)
+    { fprintf(stderr,"%s: Cannot open k-mer table of GIX %s\n",Prog_Name,path);
+      exit (1);
+    }
+  if (T->ibyte != 3)
+    { fprintf(stderr,"%s: %s is not a genome index\n",Prog_Name,path);
+      exit (1);
+    }
+  kmer  = T->kmer;
+  kbyte = T->kbyte;
+
+  { int   f, p, pb, cb;
+    int64 n;
+
+    dir  = PathTo(path);
+    root = Root(path,".gix");
+    f = open(Catenate(dir,"/",root,".gix"),O_RDONLY);
+    if (f < 0)
+      { fprintf(stderr,"%s: Cannot open GIX stub %s/%s.gix\n",Prog_Name,dir,root);
+        exit (1);
+      }
+    if (lseek(f,4*sizeof(int)+0x1000000*sizeof(int64),SEEK_SET) < 0) goto stub_error;
+    if (read(f,&pbyte,sizeof(int)) != sizeof(int)) goto stub_error;
+    if (read(f,&cbyte,sizeof(int)) != sizeof(int)) goto stub_error;
+    if (read(f,&nfile,sizeof(int)) != sizeof(int)) goto stub_error;
+    if (read(f,&maxp,sizeof(int64)) != sizeof(int64)) goto stub_error;
+    if (read(f,&freq,sizeof(int)) != sizeof(int)) goto stub_error;
+    if (read(f,&nctg,sizeof(int)) != sizeof(int)) goto stub_error;
+
+    perm   = Malloc(sizeof(int)*nctg,"Allocating GIX permutation");
+    pindex = Malloc(sizeof(int64)*(0x10000+nfile+1),"Allocating post index");
+    pfile  = Malloc(sizeof(int)*nfile,"Allocating post files");
+    if (perm == NULL || pindex == NULL || pfile == NULL)
+      exit (1);
+    neps = pindex + 0x10000;
+
+    if (read(f,perm,sizeof(int)*nctg) != (ssize_t) (sizeof(int)*nctg)) goto stub_error;
+    if (read(f,pindex,sizeof(int64)*0x10000) != sizeof(int64)*0x10000) goto stub_error;
+    close(f);
+
+    neps[0] = 0;
+    for (p = 0; p < nfile; p++)
+      { pfile[p] = open(Catenate(dir,"/.",root,Numbered_Suffix(".post.",p+1,"")),O_RDONLY);
+        if (pfile[p] < 0)
+          { fprintf(stderr,"%s: Post list part %s/.%s.post.%d is missing ?\n",
+                           Prog_Name,dir,root,p+1);
+            exit (1);
+          }
+        if (read(pfile[p],&pb,sizeof(int)) != sizeof(int) ||
+            read(pfile[p],&cb,sizeof(int)) != sizeof(int) ||
+            read(pfile[p],&n,sizeof(int64)) != sizeof(int64))
+          { fprintf(stderr,"%s: IO error reading post list part %s/.%s.post.%d\n",
+                           Prog_Name,dir,root,p+1);
+            exit (1);
+          }
+        if (pb != pbyte || cb != cbyte)
+          { fprintf(stderr,"%s: Post list part %s/.%s.post.%d does not match its stub ?\n",
+                           Prog_Name,dir,root,p+1);
+            exit (1);
+          }
+        neps[p+1] = neps[p] + n;
+      }
+    pbyte += cbyte;
+
+    free(root);
+    free(dir);
+  }
+
+  B = Malloc(sizeof(GIX_Batch),"Allocating batch query");
+  if (B == NULL)
+    exit (1);
+  B->kmer = kmer;
+  B->freq = freq;
+
+  //  Pack each valid k-mer of the queries in canonical form with the index of its hit record
+
+  { int64    s, i, j, len, last;
+    int      k, x, c;
+    uint8   *fwd, *rev, *r;
+    char    *seq;
+    GIX_Hit *h;
+
+    nrec = 0;
+    for (s = 0; s < nseq; s++)
+      if (lens[s] >= kmer)
+        nrec += lens[s] - (kmer-1);
+
+    QBYTES = kbyte;
+    rsize  = kbyte + sizeof(int64);
+    recs   = Malloc(nrec*rsize+1,"Allocating query k-mers");
+    B->hits = Malloc(sizeof(GIX_Hit)*(nrec+1),"Allocating query hits");
+    fwd    = Malloc(2*kbyte,"Allocating query k-mers");
+    if (recs == NULL || B->hits == NULL || fwd == NULL)
+      exit (1);
+    rev = fwd + kbyte;
+
+    r = recs;
+    h = B->hits;
+    for (s = 0; s < nseq; s++)
+      { seq = seqs[s];
+        len = lens[s] - (kmer-1);
+        last = -1;                       //  last non-acgt symbol in seq[0..j)
+        for (i = j = 0; i < len; i++)
+          { for ( ; j < i+kmer; j++)
+              if (Code[seq[j] & 0x7f] > 3)
+                last = j;
+            if (last >= i)
+              continue;
+
+            for (k = 0; k < kmer; k += 4)
+              { x = 0;
+                for (c = 0; c < 4; c++)
+                  x = (x << 2) | Code[seq[i+k+c] & 0x7f];
+                fwd[k>>2] = x;
+                x = 0;
+                for (c = 1; c <= 4; c++)
+                  x = (x << 2) | (3 - Code[seq[i+kmer-(k+c)] & 0x7f]);
+                rev[k>>2] = x;
+              }
+
+            h->qseq = s;
+            h->qpos = i;
+            h->comp = (memcmp(rev,fwd,kbyte) < 0);
+            h->count = 0;
+            h->post  = -1;
+            memcpy(r,h->comp ? rev : fwd,kbyte);
+            *((int64 *) (r+kbyte)) = h - B->hits;
+            r += rsize;
+            h += 1;
+          }
+      }
+    nrec = h - B->hits;
+    B->nhit = nrec;
+    free(fwd);
+  }
+
+  qsort(recs,nrec,rsize,QSORT);
+
+  //  Sweep the table with the sorted query k-mers
+
+  { uint8   *q, *e, *pbuf;
+    int64    pidx, npost, mpost, kb;
+    int      qpre, b2, cnt, p, n;
+    GIX_Hit *h;
+    GIX_Post *o;
+    int64    post, cont, flag;
+    uint8   *pptr = (uint8 *) (&post);
+    uint8   *cptr = (uint8 *) (&cont);
+
+    mpost = 1024;
+    npost = 0;
+    B->posts = Malloc(sizeof(GIX_Post)*mpost,"Allocating query posts");
+    pbuf = Malloc(freq*pbyte+1,"Allocating post buffer");
+    if (B->posts == NULL || pbuf == NULL)
+      exit (1);
+    flag = (0x1ll << (8*cbyte-1));
+
+    First_Kmer_Entry(T);
+    pidx = 0;
+    e = recs + nrec*rsize;
+    for (q = recs; q < e; )
+      { qpre = (q[0] << 16) | (q[1] << 8) | q[2];
+
+        b2 = (qpre >> 8);                 //  Far ahead? then jump to the 2-byte prefix block
+        kb = (b2 > 0 ? T->index[(b2<<8)-1] : 0);
+        if (kb > T->cidx + SWEEP_JUMP)
+          { GoTo_Kmer_Index(T,kb);
+            pidx = (b2 > 0 ? pindex[b2-1] : 0);
+          }
+
+        while (T->csuf != NULL && (T->cpre < qpre ||    //  Scan to the first entry >= q
+                  (T->cpre == qpre && memcmp(T->csuf,q+3,kbyte-3) < 0)))
+          { pidx += T->csuf[kbyte-3];
+            Next_Kmer_Entry(T);
+          }
+
+        if (T->csuf != NULL && T->cpre == qpre && memcmp(T->csuf,q+3,kbyte-3) == 0)
+          { cnt = T->csuf[kbyte-3];
+
+            if (npost + cnt > mpost)      //  Read its cnt posts, pidx ... pidx+cnt-1
+              { mpost = 1.2*(npost+cnt) + 1024;
+                B->posts = Realloc(B->posts,sizeof(GIX_Post)*mpost,"Reallocating query posts");
+                if (B->posts == NULL)
+                  exit (1);
+              }
+            for (p = 0; pidx >= neps[p+1]; p++)
+              ;
+            if (pidx + cnt > neps[p+1])
+              { fprintf(stderr,"%s: Post list of GIX %s is inconsistent with its table\n",
+                               Prog_Name,path);
+                exit (1);
+              }
+            n = pread(pfile[p],pbuf,cnt*pbyte,
+                      2*sizeof(int)+sizeof(int64) + (pidx-neps[p])*pbyte);
+            if (n != cnt*pbyte)
+              { fprintf(stderr,"%s: IO error reading post list of GIX %s\n",Prog_Name,path);
+                exit (1);
+              }
+            o = B->posts + npost;
+            for (n = 0; n < cnt; n++, o++)
+              { post = cont = 0;
+                memcpy(pptr,pbuf+n*pbyte,pbyte-cbyte);
+                memcpy(cptr,pbuf+n*pbyte+(pbyte-cbyte),cbyte);
+                o->comp = ((cont & flag) != 0);
+                if (o->comp)
+                  cont -= flag;
+                o->contig = perm[cont];
+                o->pos    = post;
+              }
+
+            do                            //  and give them to every query of the k-mer
+              { h = B->hits + *((int64 *) (q+kbyte));
+                h->count = cnt;
+                h->post  = npost;
+                q += rsize;
+              }
+            while (q < e && memcmp(q,q-rsize,kbyte) == 0);
+            npost += cnt;
+          }
+        else
+          do
+            q += rsize;
+          while (q < e && memcmp(q,q-rsize,kbyte) == 0);
+      }
+
+    B->npost = npost;
+    free(pbuf);
+  }
+
+  { int p;
+
+    for (p = 0; p < nfile; p++)
+      close(pfile[p]);
+    free(pfile);
+    free(pindex);
+    free(perm);
+    free(recs);
+    Free_Kmer_Stream(T);
+  }
+
+  return (B);
+
+stub_error:
+  fprintf(stderr,"%s: IO error reading GIX stub %s/%s.gix\n",Prog_Name,dir,root);
+  exit (1);
+}
+
+void Free_GIX_Batch(GIX_Batch *B)
+{ free(B->posts);
+  free(B->hits);
+  free(B);
+}
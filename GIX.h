@@ -0,0 +1,81 @@
+/*******************************************************************************************
+ *
+ *  Genome index module.  Build the k-mer table and position list of a GDB that together form
+ *    the genome index (GIX) searched by FastGA.  Factored out of GIXmake so that FastGA can
+ *    build the indices of its inputs in-process.
+ *
+ *  Author :  Gene Myers
+ *  Date   :  February 2023
+ *
+ ********************************************************************************************/
+
+#ifndef _GIX_DEFS
+
+#define _GIX_DEFS
+
+#include "gene_core.h"
+#include "GDB.h"
+
+#define GIX_KMER 40   //  Default k-mer size of an index
+
+  // Create the GIX for 'gdb' with the .gix stub and its hidden parts placed at the same path
+  //   and root as the GDB file 'tpath'.  Only k-mers of length 'kmer' (a multiple of 4) that
+  //   occur less than 'freq' times are indexed.  Work is divided into 'nthreads' parts and
+  //   temporary files are placed in the directory 'sort_path'.
+  // The sequences of gdb may be EXTERNAL, in which case each thread opens its own copy of the
+  //   .bps file, or COMPRESSED in memory, in which case all threads share the loaded bases.
+  // If gdb has fewer than nthreads contigs then it is padded with dummy contigs as FastGA
+  //   expects.  On error a message is output and the program exits (batch mode only).
+
+int Create_GIX(GDB *gdb, char *tpath, int kmer, int freq, int nthreads, char *sort_path,
+               int verbose);
+
+  // Update the GIX at 'tpath' after contigs have been appended to 'gdb', whose first contigs
+  //   must be exactly those the GIX was built from.  A delta index of the new contigs only is
+  //   built with 'nthreads' threads in the directory 'sort_path' and then merged into the GIX
+  //   in one streaming pass, keeping its k-mer size, frequency cutoff, and number of parts.
+  //   This requires the GIX's drop lists (the .drop parts of the k-mers dropped for occurring
+  //   freq or more times) and the contig lengths and checksums at the end of its stub, which
+  //   are only made by a Create_GIX of this version, and the latter must match the first
+  //   contigs of 'gdb'.  The new parts are written alongside the old ones before replacing
+  //   them.  On error a message is output and the program exits.
+
+int Update_GIX(GDB *gdb, char *tpath, int nthreads, char *sort_path, int verbose);
+
+  // Find every k-mer of the nseq query sequences seqs[s] of length lens[s] (ASCII, any case;
+  //   k-mers containing a symbol other than acgt are skipped) in the GIX at 'path'.  The
+  //   k-mers are canonicalized and sorted and then resolved in a single sweep through the
+  //   index.  The result has a hit record for each query k-mer in order of sequence and then
+  //   offset, giving its count in the genome, 0 if it does not occur or occurs freq or more
+  //   times (and so is not in the index), and where its positions are in the posts array.
+  //   Each distinct k-mer's positions appear once in posts, in index order.  On error a
+  //   message is output and the program exits.
+
+typedef struct
+  { int64   qpos;    //  Offset of the k-mer's first base in query sequence qseq
+    int     qseq;
+    int     comp;    //  The query k-mer is the complement of the canonical k-mer indexed
+    int     count;   //  # of positions in the genome
+    int64   post;    //  posts[post..post+count) are its positions (if count > 0)
+  } GIX_Hit;
+
+typedef struct
+  { int     contig;  //  GDB contig and offset of the canonical k-mer (complemented if comp)
+    int     comp;
+    int64   pos;
+  } GIX_Post;
+
+typedef struct
+  { int       kmer;    //  k-mer size of the index
+    int       freq;    //  k-mers occurring freq or more times are not in the index
+    int64     nhit;    //  hits[0..nhit)
+    GIX_Hit  *hits;
+    int64     npost;   //  posts[0..npost)
+    GIX_Post *posts;
+  } GIX_Batch;
+
+GIX_Batch *Find_GIX_Kmers(char *path, int nseq, char **seqs, int64 *lens);
+
+void Free_GIX_Batch(GIX_Batch *B);
+
+#endif // _GIX_DEFS
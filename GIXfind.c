@@ -0,0 +1,267 @@
+/*******************************************************************************************
+ *
+ *  Look up every k-mer of a set of query sequences, e.g. probes or markers, in a genome index
+ *    with one sorted sweep of the index (see Find_GIX_Kmers in GIX.h), outputting for each
+ *    k-mer found its count and the scaffold positions at which it occurs.
+ *
+ *  Author:  agent (agent@local)
+ *  Date  :  October 2026
+ *
+ *******************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#include "GDB.h"
+#include "GIX.h"
+
+static char *Usage =
+   "[-a] <source:path>[.gix] ( <queries:path>[<fa_extn>|<1_extn>|.1gdb] | - )";
+
+  //  Query sequences: name of each and offset of its first base in the named sequence
+
+static int     NSEQ;
+static char  **SEQS;
+static int64  *LENS;
+static char  **NAME;
+static int64  *BASE;
+
+static int MSEQ;
+
+static void add_query(char *name, char *seq, int64 len)
+{ if (NSEQ >= MSEQ)
+    { MSEQ = 1.2*NSEQ + 1024;
+      SEQS = Realloc(SEQS,sizeof(char *)*MSEQ,"Allocating query sequences");
+      LENS = Realloc(LENS,sizeof(int64)*MSEQ,"Allocating query sequences");
+      NAME = Realloc(NAME,sizeof(char *)*MSEQ,"Allocating query sequences");
+      if (SEQS == NULL || LENS == NULL || NAME == NULL)
+        exit (1);
+    }
+  SEQS[NSEQ] = seq;
+  LENS[NSEQ] = len;
+  NAME[NSEQ] = name;
+  NSEQ += 1;
+}
+
+  //  Read FASTA, or else one sequence per line named "line<#>", from stdin
+
+static void read_stream()
+{ char   *line, *seq, *name, *e;
+  size_t  lmax;
+  ssize_t len;
+  int64   nlen, mlen;
+  int     nline, fasta;
+
+  NSEQ = MSEQ = 0;
+  SEQS = NULL;
+  LENS = NULL;
+  NAME = NULL;
+
+  line  = NULL;
+  lmax  = 0;
+  name  = NULL;
+  seq   = NULL;
+  nlen  = mlen = 0;
+  fasta = -1;
+  for (nline = 1; (len = getline(&line,&lmax,stdin)) >= 0; nline++)
+    { while (len > 0 && isspace(line[len-1]))
+        line[--len] = '\0';
+      if (len == 0)
+        continue;
+      if (fasta < 0)
+        fasta = (line[0] == '>');
+
+      if (line[0] == '>' || !fasta)
+        { if (name != NULL)
+            add_query(name,seq,nlen);
+          seq  = NULL;
+          nlen = mlen = 0;
+          if (line[0] == '>')
+            { for (e = line+1; *e != '\0' && !isspace(*e); e++)
+                ;
+              *e = '\0';
+              name = Strdup(line+1,"Allocating query name");
+              if (name == NULL)
+                exit (1);
+              continue;
+            }
+          name = Strdup(Numbered_Suffix("line",nline,""),"Allocating query name");
+          if (name == NULL)
+            exit (1);
+        }
+
+      if (nlen + len >= mlen)
+        { mlen = 1.2*(nlen+len) + 1024;
+          seq  = Realloc(seq,mlen,"Allocating query sequence");
+          if (seq == NULL)
+            exit (1);
+        }
+      memcpy(seq+nlen,line,len);
+      nlen += len;
+    }
+  if (name != NULL)
+    add_query(name,seq,nlen);
+  free(line);
+
+  BASE = Malloc(sizeof(int64)*(NSEQ+1),"Allocating query sequences");
+  if (BASE == NULL)
+    exit (1);
+  bzero(BASE,sizeof(int64)*(NSEQ+1));
+}
+
+int main(int argc, char *argv[])
+{ GDB        _rgdb, *rgdb = &_rgdb;
+  GDB        _qgdb, *qgdb = &_qgdb;
+  GIX_Batch  *B;
+  int         ALL;
+  int         QGDB;
+
+  //  Process options
+
+  { int    i, j, k;
+    int    flags[128];
+
+    ARG_INIT("GIXfind")
+
+    j = 1;
+    for (i = 1; i < argc; i++)
+      if (argv[i][0] == '-' && argv[i][1] != '\0')
+        switch (argv[i][1])
+        { default:
+            ARG_FLAGS("a")
+            break;
+        }
+      else
+        argv[j++] = argv[i];
+    argc = j;
+
+    ALL = flags['a'];
+
+    if (argc != 3)
+      { fprintf(stderr,"Usage: %s %s\n",Prog_Name,Usage);
+        fprintf(stderr,"\n");
+        fprintf(stderr,"      -a: also output k-mers that are not in the index\n");
+        exit (1);
+      }
+  }
+
+  //  Open the GDB of the index for its scaffold names and contig placements
+
+  { char *dir, *root;
+
+    dir  = PathTo(argv[1]);
+    root = Root(argv[1],".gix");
+    Read_GDB(rgdb,Catenate(dir,"/",root,".1gdb"));
+    free(root);
+    free(dir);
+  }
+
+  //  Get the query sequences, from stdin or a sequence file/GDB, in memory
+
+  if (strcmp(argv[2],"-") == 0)
+    { QGDB = 0;
+      read_stream();
+    }
+  else
+    { char *spath, *tpath;
+      int   type, s, c;
+
+      QGDB = 1;
+      type = Get_GDB_Paths(argv[2],NULL,&spath,&tpath,0);
+      if (type != IS_GDB)
+        Create_GDB(qgdb,spath,type,1,NULL);
+      else
+        { Read_GDB(qgdb,tpath);
+          if (qgdb->seqs == NULL)
+            { fprintf(stderr,"%s: GDB %s must have sequence data\n",Prog_Name,tpath);
+              exit (1);
+            }
+        }
+      free(spath);
+      free(tpath);
+
+      Load_Sequences(qgdb,LOWER_CASE);
+
+      NSEQ = qgdb->ncontig;
+      SEQS = Malloc(sizeof(char *)*NSEQ,"Allocating query sequences");
+      LENS = Malloc(sizeof(int64)*NSEQ,"Allocating query sequences");
+      NAME = Malloc(sizeof(char *)*qgdb->nscaff,"Allocating query sequences");
+      BASE = Malloc(sizeof(int64)*NSEQ,"Allocating query sequences");
+      if (SEQS == NULL || LENS == NULL || NAME == NULL || BASE == NULL)
+        exit (1);
+      for (c = 0; c < NSEQ; c++)
+        { SEQS[c] = Get_Contig(qgdb,c,LOWER_CASE,NULL);
+          LENS[c] = qgdb->contigs[c].clen;
+          BASE[c] = qgdb->contigs[c].sbeg;
+        }
+      for (s = 0; s < qgdb->nscaff; s++)
+        { char *e;
+
+          NAME[s] = qgdb->headers + qgdb->scaffolds[s].hoff;
+          for (e = NAME[s]; *e != '\0' && !isspace(*e); e++)
+            ;
+          *e = '\0';
+        }
+    }
+
+  B = Find_GIX_Kmers(argv[1],NSEQ,SEQS,LENS);
+
+  //  Output a line for each k-mer:  query, offset, k-mer, count, and the positions as
+  //    <scaffold>:<offset><orientation of the query k-mer>
+
+  { int64     i, j;
+    int       c, q, s, kmer;
+    char     *rhead, *e;
+    GIX_Hit  *h;
+    GIX_Post *p;
+
+    rhead = rgdb->headers;
+    for (s = 0; s < rgdb->nscaff; s++)
+      { for (e = rhead + rgdb->scaffolds[s].hoff; *e != '\0' && !isspace(*e); e++)
+          ;
+        *e = '\0';
+      }
+
+    kmer = B->kmer;
+    for (i = 0, h = B->hits; i < B->nhit; i++, h++)
+      { if (h->count == 0 && !ALL)
+          continue;
+        q = h->qseq;
+        printf("%s\t%lld\t%.*s\t%d",QGDB ? NAME[qgdb->contigs[q].scaf] : NAME[q],
+                                     BASE[q] + h->qpos,kmer,SEQS[q] + h->qpos,h->count);
+        for (j = 0, p = B->posts + h->post; j < h->count; j++, p++)
+          { c = p->contig;
+            printf("\t%s:%lld%c",rhead + rgdb->scaffolds[rgdb->contigs[c].scaf].hoff,
+                                 rgdb->contigs[c].sbeg + p->pos,p->comp == h->comp ? '+' : '-');
+          }
+        printf("\n");
+      }
+  }
+
+  Free_GIX_Batch(B);
+
+  if (QGDB)
+    Close_GDB(qgdb);
+  else
+    { int s;
+
+      for (s = 0; s < NSEQ; s++)
+        { free(SEQS[s]);
+          free(NAME[s]);
+        }
+    }
+  free(BASE);
+  free(NAME);
+  free(LENS);
+  free(SEQS);
+  Close_GDB(rgdb);
+
+  Catenate(NULL,NULL,NULL,NULL);
+  Numbered_Suffix(NULL,0,NULL);
+  free(Prog_Name);
+
+  exit (0);
+}
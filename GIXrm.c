@@ -151,6 +151,10 @@ int main(int argc, char *argv[])
                 sprintf(command,"%s %s/%s.gix %s/.%s.ktab.* %s/.%s.post.*",
                                 com,PATH,ROOT,PATH,ROOT,PATH,ROOT);
                 if (system(command) != 0) goto sys_error;
+                if (access(Catenate(PATH,"/.",ROOT,".drop.1"),F_OK) == 0)
+                  { sprintf(command,"%s %s/.%s.drop.*",com,PATH,ROOT);
+                    if (system(command) != 0) goto sys_error;
+                  }
               }
           }
 
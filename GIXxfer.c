@@ -208,6 +208,11 @@ int main(int argc, char *argv[])
                    sprintf(command,"%s %s/.%s.post.%d %s/.%s.post.%d",
                                    op,SPATH,SROOT,a,TPATH,TROOT,a);
                    if (system(command) != 0) goto sys_error;
+                   if (stat(Catenate(SPATH,"/.",SROOT,Numbered_Suffix(".drop.",a,"")),&status) != 0)
+                     continue;
+                   sprintf(command,"%s %s/.%s.drop.%d %s/.%s.drop.%d",
+                                   op,SPATH,SROOT,a,TPATH,TROOT,a);
+                   if (system(command) != 0) goto sys_error;
                  }
               }
           }
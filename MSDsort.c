@@ -104,16 +104,79 @@ static void print_table(uint8 *array, int64 asize)
 
 #endif
 
+/*******************************************************************************************
+ *
+ *  Record moves and comparisons.  Records are short (typically 10-24 bytes) so rather than a
+ *    byte at a time, they are moved and compared 16 bytes (a vector register) or 8 bytes (a
+ *    word) at a time, finishing with an overlapping load or store of the last 16 or 8 bytes
+ *    when the length is not a multiple.  A word comparison finds the first differing byte as
+ *    the most significant one after a byte swap on little-endian machines.  On x86-64
+ *    radix_sort is compiled for AVX2, SSE4.2, and the baseline ISA, the variant for the host
+ *    being selected at load time.
+ *
+ ********************************************************************************************/
+
+#if defined(__x86_64__) && defined(__GNUC__) && defined(__linux__)
+#define ISA_CLONES __attribute__((target_clones("avx2","sse4.2","default")))
+#else
+#define ISA_CLONES
+#endif
+
+static inline uint64 load_word(uint8 *a)
+{ uint64 x;
+  memcpy(&x,a,8);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  x = __builtin_bswap64(x);
+#endif
+  return (x);
+}
+
 static inline void mycpy(uint8 *a, uint8 *b, int n)
-{ while (n--)
-    *a++ = *b++;
+{ if (n >= 16)
+    { while (n > 16)
+        { memcpy(a,b,16);
+          a += 16;
+          b += 16;
+          n -= 16;
+        }
+      memcpy(a+(n-16),b+(n-16),16);
+    }
+  else if (n >= 8)
+    { uint64 x, y;
+
+      memcpy(&x,b,8);
+      memcpy(&y,b+(n-8),8);
+      memcpy(a,&x,8);
+      memcpy(a+(n-8),&y,8);
+    }
+  else
+    while (n--)
+      *a++ = *b++;
 }
 
 static inline int mycmp(uint8 *a, uint8 *b, int n)
-{ while (n--)
-    { if (*a++ != *b++)
-        return (a[-1] < b[-1] ? -1 : 1);
+{ uint64 x, y;
+
+  if (n < 8)
+    { while (n--)
+        { if (*a++ != *b++)
+            return (a[-1] < b[-1] ? -1 : 1);
+        }
+      return (0);
+    }
+  while (n > 8)
+    { x = load_word(a);
+      y = load_word(b);
+      if (x != y)
+        return (x < y ? -1 : 1);
+      a += 8;
+      b += 8;
+      n -= 8;
     }
+  x = load_word(a+(n-8));
+  y = load_word(b+(n-8));
+  if (x != y)
+    return (x < y ? -1 : 1);
   return (0);
 }
 
@@ -209,6 +272,7 @@ static inline void shell_sort(uint8 *array, int asize, int digit)
 #endif
 }
 
+ISA_CLONES
 static void radix_sort(uint8 *array, int64 asize, int digit, int64 *alive)
 { int64  n, len[256];
   int    y, q, ntop;
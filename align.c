@@ -350,6 +350,93 @@ typedef struct
 
 static int VectorEl = 6*sizeof(int) + sizeof(BVEC);
 
+//  Snakes: unless Set_Word_Snakes(0) has been called, a run of matches along a diagonal is
+//    found 8 bases at a time by xor'ing a word of each sequence, a 4 in the B-word (the bit
+//    0x4 of a byte is set only for the terminal 4's) also ending the run, and the path bit
+//    vector and its match count are then advanced over the entire run in one step.  The
+//    forward scan may read up to 7 bytes beyond the terminal 4's (New_Contig_Buffer leaves
+//    room for this) and the reverse scan never reads before them.
+
+#define SNAKE_FOUR 0x0404040404040404ll
+
+static int Word_Snakes = 1;
+
+void Set_Word_Snakes(int on)
+{ Word_Snakes = on; }
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+  //  Return the index of the first base at or after y at which a and b do not match or
+  //    b[y] = 4.
+
+static inline int forward_snake(char *a, char *b, int y)
+{ uint64 u, v;
+
+  while (1)
+    { memcpy(&u,b+y,sizeof(uint64));
+      memcpy(&v,a+y,sizeof(uint64));
+      v = (u ^ v) | (u & SNAKE_FOUR);
+      if (v != 0)
+        return (y + (__builtin_ctzll(v) >> 3));
+      y += 8;
+    }
+}
+
+  //  Return the index of the first base at or before y at which a and b do not match or
+  //    b[y] = 4, scanning words only while y >= ylim, so that a+y-7 and b+y-7 are in bounds.
+
+static inline int reverse_snake(char *a, char *b, int y, int ylim)
+{ uint64 u, v;
+
+  while (y >= ylim)
+    { memcpy(&u,b+(y-7),sizeof(uint64));
+      memcpy(&v,a+(y-7),sizeof(uint64));
+      v = (u ^ v) | (u & SNAKE_FOUR);
+      if (v != 0)
+        return (y - (__builtin_clzll(v) >> 3));
+      y -= 8;
+    }
+  return (y);
+}
+
+#else
+
+static inline int forward_snake(char *a, char *b, int y)
+{ (void) a;
+  (void) b;
+  return (y);
+}
+
+static inline int reverse_snake(char *a, char *b, int y, int ylim)
+{ (void) a;
+  (void) b;
+  (void) ylim;
+  return (y);
+}
+
+#endif
+
+  //  Advance the path vector *b over a run of len matches, adding to *m the number of
+  //    0-bits that pass through PATH_TOP, exactly as len single steps would.
+
+static inline void snake_path(BVEC *b, int *m, int len)
+{ BVEC x;
+  int  l;
+
+  if (len <= 0)
+    return;
+  if (len > PATH_LEN+1)
+    l = PATH_LEN+1;
+  else
+    l = len;
+  x   = ((((BVEC) 1) << l) - 1) << ((PATH_LEN+1) - l);
+  *m += l - __builtin_popcountll(*b & x);
+  if (len >= (int) (8*sizeof(BVEC)))
+    *b = ~((BVEC) 0);
+  else
+    *b = (*b << len) | ((((BVEC) 1) << len) - 1);
+}
+
 static int forward_wave(_Work_Data *work, _Align_Spec *spec, Alignment *align, Path *bpath,
                         int *mind, int maxd, int mida, int minp, int maxp, int aoff, int boff)
 { char *aseq  = align->aseq;
@@ -475,6 +562,8 @@ static int forward_wave(_Work_Data *work, _Align_Spec *spec, Alignment *align, P
         hb  = avail++;
         nb += TRACE_SPACE;
 
+        if (Word_Snakes && bseq[y] == a[y])
+          y = forward_snake(a,bseq,y);
         while (1)
           { c = bseq[y];
             if (c == 4)
@@ -745,6 +834,11 @@ static int forward_wave(_Work_Data *work, _Align_Spec *spec, Alignment *align, P
           b <<= 1;
 
           y = (c-k) >> 1;
+          if (Word_Snakes && bseq[y] == a[y])
+            { c = forward_snake(a,bseq,y);
+              snake_path(&b,&m,c-y);
+              y = c;
+            }
           while (1)
             { c = bseq[y];
               if (c == 4)
@@ -1133,6 +1227,8 @@ static int reverse_wave(_Work_Data *work, _Align_Spec *spec, Alignment *align, P
         pb->mark = y;
         hb  = avail++;
 
+        if (Word_Snakes && bseq[y] == a[y])
+          y = reverse_snake(a,bseq,y,k < 0 ? 7-k : 7);
         while (1)
           { c = bseq[y];
             if (c == 4)
@@ -1400,6 +1496,11 @@ static int reverse_wave(_Work_Data *work, _Align_Spec *spec, Alignment *align, P
           b <<= 1;
 
           y = (c-k) >> 1;
+          if (Word_Snakes && bseq[y] == a[y])
+            { c = reverse_snake(a,bseq,y,k < 0 ? 7-k : 7);
+              snake_path(&b,&m,y-c);
+              y = c;
+            }
           while (1)
             { c = bseq[y];
               if (c == 4)
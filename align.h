@@ -232,6 +232,15 @@ void Complement_Seq(char *a, int n);
   Path *Local_Alignment(Alignment *align, Work_Data *work, Align_Spec *spec,
                         int low, int hgh, int anti, int lbord, int hbord);
 
+  /* Local_Alignment extends runs of matches 8 bases at a time, for which the sequences of
+     'align' must be in buffers with 8 bytes of slack after their terminal 4 (e.g. as given by
+     New_Contig_Buffer).  Set_Word_Snakes(0) reverts to comparing a base at a time, and (1)
+     restores the default.  The alignments found are identical either way.  It should be
+     called before any threads are aligning.
+  */
+
+  void  Set_Word_Snakes(int on);
+
   int   Find_Extension(Alignment *align, Work_Data *work, Align_Spec *spec,    //  experimental !!
                        int diag, int anti, int lbord, int hbord, int prefix);
 
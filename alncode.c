@@ -10,8 +10,11 @@
  *-------------------------------------------------------------------
  */
 
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "alncode.h"
 
@@ -114,7 +117,12 @@ clean_up:
   // Next two routines read the records from the file
 
 void Read_Aln_Overlap(OneFile *of, Overlap *ovl)
-{ if (of->lineType != 'A')
+{ Read_Aln_Overlap_Cigar(of,ovl,NULL,NULL); }
+
+int Read_Aln_Overlap_Cigar(OneFile *of, Overlap *ovl, char **cigar, int *cmax)
+{ int clen;
+
+  if (of->lineType != 'A')
     { fprintf(stderr,"%s: Failed to be at start of alignment in Read_Aln_Overlap()\n",Prog_Name);
       exit (1);
     }
@@ -127,6 +135,7 @@ void Read_Aln_Overlap(OneFile *of, Overlap *ovl)
   ovl->path.bbpos = oneInt(of,4);
   ovl->path.bepos = oneInt(of,5);
 
+  clen = 0;
   while (oneReadLine(of))
     if (of->lineType == 'T')
        break;
@@ -134,6 +143,17 @@ void Read_Aln_Overlap(OneFile *of, Overlap *ovl)
       ovl->flags |= COMP_FLAG;
     else if (of->lineType == 'D')
       ovl->path.diffs = oneInt(of,0);
+    else if (of->lineType == 'C' && cigar != NULL)
+      { clen = oneLen(of);
+        if (clen >= *cmax)
+          { *cmax  = 1.2*clen + 1000;
+            *cigar = (char *) Realloc(*cigar,*cmax,"Reallocating cigar string");
+            if (*cigar == NULL)
+              exit (1);
+          }
+        memcpy(*cigar,oneString(of),clen);
+        (*cigar)[clen] = '\0';
+      }
     else if (of->lineType == 'A')
        break;
 
@@ -142,6 +162,8 @@ void Read_Aln_Overlap(OneFile *of, Overlap *ovl)
                      Prog_Name,of->info['A']->accum.count);
       exit (1);
     }
+
+  return (clen);
 }
 
 int Read_Aln_Trace(OneFile *of, uint8 *trace)
@@ -258,6 +280,9 @@ void Write_Aln_Overlap (OneFile *of, Overlap *ovl)
   oneWriteLine (of,'D',0,0);
 }
 
+void Write_Aln_Cigar (OneFile *of, char *cigar, int clen)
+{ oneWriteLine (of,'C',clen,cigar); }
+
 void Write_Aln_Trace (OneFile *of, uint8 *trace, int tlen)
 { static int    tmax = 0;
   static int64 *trace64 = NULL;
@@ -278,3 +303,264 @@ void Write_Aln_Trace (OneFile *of, uint8 *trace, int tlen)
     trace64[j++] = trace[x];
   oneWriteLine(of,'X',j,trace64);
 }
+
+  // The alignment index in the hidden file .<root>.aix beside <root>.1aln
+
+#define AIX_MAGIC 0x31786961ll    // "aix1"
+
+static char *aix_name(char *filename)
+{ char *name, *base;
+  int   dlen, blen;
+
+  base = strrchr(filename,'/');
+  if (base == NULL)
+    base = filename;
+  else
+    base += 1;
+  dlen = base-filename;
+  blen = strlen(base);
+  if (blen > 5 && strcmp(base+(blen-5),".1aln") == 0)
+    blen -= 5;
+  name = (char *) Malloc(dlen+blen+6,"Allocating index name");
+  if (name == NULL)
+    return (NULL);
+  sprintf(name,"%.*s.%.*s.aix",dlen,filename,blen,base);
+  return (name);
+}
+
+Aln_Index *Aln_Index_Start()
+{ Aln_Index *aix;
+
+  aix = (Aln_Index *) Malloc(sizeof(Aln_Index),"Allocating alignment index");
+  if (aix == NULL)
+    return (NULL);
+  aix->novl  = 0;
+  aix->nctg  = 0;
+  aix->nbck  = 0;
+  aix->apos  = 0;
+  aix->fnext = 0;
+  aix->cmax  = 1024;
+  aix->bmax  = 4096;
+  aix->obeg  = (int64 *) Malloc(2*(aix->cmax+1)*sizeof(int64),"Allocating alignment index");
+  aix->over  = (int64 *) Malloc(2*aix->bmax*sizeof(int64),"Allocating alignment index");
+  if (aix->obeg == NULL || aix->over == NULL)
+    { free(aix->over);
+      free(aix->obeg);
+      free(aix);
+      return (NULL);
+    }
+  aix->bbeg = aix->obeg + (aix->cmax+1);
+  aix->from = aix->over + aix->bmax;
+  return (aix);
+}
+
+  //  Add the next alignment, aread[abpos,aepos], in file order.  If the alignments turn out
+  //    not to be in (aread,abpos) order the index is abandoned (novl = -1).
+
+void Aln_Index_Add(Aln_Index *aix, int aread, int abpos, int aepos)
+{ int64 o, b, cb, top;
+
+  if (aix->novl < 0)
+    return;
+  o = aix->novl++;
+  if (aread < aix->nctg-1 || (aread == aix->nctg-1 && abpos < aix->apos))
+    { aix->novl = -1;
+      return;
+    }
+  aix->apos = abpos;
+
+  if (aread >= aix->nctg)
+    { if (aread >= aix->cmax)
+        { int    cmax = 1.2*aread + 1024;
+          int64 *obeg;
+
+          obeg = (int64 *) Malloc(2*(cmax+1)*sizeof(int64),"Reallocating alignment index");
+          if (obeg == NULL)
+            exit (1);
+          memcpy(obeg,aix->obeg,aix->nctg*sizeof(int64));
+          memcpy(obeg+(cmax+1),aix->bbeg,aix->nctg*sizeof(int64));
+          free(aix->obeg);
+          aix->obeg = obeg;
+          aix->bbeg = obeg + (cmax+1);
+          aix->cmax = cmax;
+        }
+      for (b = aix->fnext; b < aix->nbck; b++)    // no more alignments start in the last
+        aix->from[b] = o;                          //   contig's remaining buckets
+      aix->fnext = aix->nbck;
+      while (aix->nctg <= aread)
+        { aix->obeg[aix->nctg] = o;
+          aix->bbeg[aix->nctg] = aix->nbck;
+          aix->nctg += 1;
+        }
+    }
+
+  cb  = aix->bbeg[aread];
+  top = cb + ((aepos-1) >> AIX_SHIFT) + 1;
+  if (top > aix->bmax)
+    { int64  bmax = 1.2*top + 4096;
+      int64 *over;
+
+      over = (int64 *) Malloc(2*bmax*sizeof(int64),"Reallocating alignment index");
+      if (over == NULL)
+        exit (1);
+      memcpy(over,aix->over,aix->nbck*sizeof(int64));
+      memcpy(over+bmax,aix->from,aix->nbck*sizeof(int64));
+      free(aix->over);
+      aix->over = over;
+      aix->from = over + bmax;
+      aix->bmax = bmax;
+    }
+  for ( ; aix->nbck < top; aix->nbck++)
+    aix->over[aix->nbck] = -1;
+
+  for (b = cb + (abpos >> AIX_SHIFT); b < top; b++)
+    if (aix->over[b] < 0)
+      aix->over[b] = o;
+  for (b = aix->fnext; b <= cb + (abpos >> AIX_SHIFT); b++)
+    aix->from[b] = o;
+  if (b > aix->fnext)
+    aix->fnext = b;
+}
+
+  //  Write the index of the (closed) .1aln file filename, or remove any old index of it if
+  //    the alignments were not in order.  Return 1 on an IO error.
+
+int Aln_Index_Write(Aln_Index *aix, char *filename)
+{ struct stat sb;
+  int64  head[5];
+  char  *name;
+  FILE  *f;
+  int64  b;
+
+  name = aix_name(filename);
+  if (name == NULL)
+    return (1);
+
+  if (aix->novl < 0 || stat(filename,&sb) < 0)
+    { unlink(name);
+      free(name);
+      return (0);
+    }
+
+  for (b = aix->fnext; b < aix->nbck; b++)
+    aix->from[b] = aix->novl;
+  aix->fnext = aix->nbck;
+  aix->obeg[aix->nctg] = aix->novl;
+  aix->bbeg[aix->nctg] = aix->nbck;
+
+  head[0] = AIX_MAGIC;
+  head[1] = aix->novl;
+  head[2] = sb.st_size;
+  head[3] = aix->nctg;
+  head[4] = aix->nbck;
+
+  f = fopen(name,"w");
+  if (f == NULL)
+    { fprintf(stderr,"%s: Cannot open alignment index %s for writing\n",Prog_Name,name);
+      free(name);
+      return (1);
+    }
+  if (fwrite(head,sizeof(int64),5,f) != 5
+      || fwrite(aix->obeg,sizeof(int64),aix->nctg+1,f) != (size_t) (aix->nctg+1)
+      || fwrite(aix->bbeg,sizeof(int64),aix->nctg+1,f) != (size_t) (aix->nctg+1)
+      || fwrite(aix->over,sizeof(int64),aix->nbck,f) != (size_t) aix->nbck
+      || fwrite(aix->from,sizeof(int64),aix->nbck,f) != (size_t) aix->nbck
+      || fclose(f) != 0)
+    { fprintf(stderr,"%s: Could not write alignment index %s\n",Prog_Name,name);
+      unlink(name);
+      free(name);
+      return (1);
+    }
+
+  free(name);
+  return (0);
+}
+
+  //  Read the index of the .1aln file filename of novl alignments, if there is one and it
+  //    is current.
+
+Aln_Index *Aln_Index_Read(char *filename, int64 novl)
+{ struct stat sb;
+  Aln_Index *aix;
+  int64  head[5];
+  char  *name;
+  FILE  *f;
+  int    ok;
+
+  name = aix_name(filename);
+  if (name == NULL)
+    return (NULL);
+  f = fopen(name,"r");
+  free(name);
+  if (f == NULL)
+    return (NULL);
+
+  aix = NULL;
+  if (fread(head,sizeof(int64),5,f) != 5 || head[0] != AIX_MAGIC || head[1] != novl
+      || stat(filename,&sb) < 0 || head[2] != sb.st_size)
+    goto done;
+
+  aix = (Aln_Index *) Malloc(sizeof(Aln_Index),"Allocating alignment index");
+  if (aix == NULL)
+    goto done;
+  aix->novl  = head[1];
+  aix->nctg  = head[3];
+  aix->nbck  = head[4];
+  aix->cmax  = aix->nctg;
+  aix->bmax  = aix->nbck;
+  aix->fnext = aix->nbck;
+  aix->obeg  = (int64 *) Malloc(2*(aix->nctg+1)*sizeof(int64),"Allocating alignment index");
+  aix->over  = (int64 *) Malloc((2*aix->nbck+1)*sizeof(int64),"Allocating alignment index");
+  ok = (aix->obeg != NULL && aix->over != NULL);
+  if (ok)
+    { aix->bbeg = aix->obeg + (aix->nctg+1);
+      aix->from = aix->over + aix->nbck;
+      ok = (fread(aix->obeg,sizeof(int64),2*(aix->nctg+1),f) == (size_t) (2*(aix->nctg+1))
+         && fread(aix->over,sizeof(int64),2*aix->nbck,f) == (size_t) (2*aix->nbck));
+    }
+  if ( ! ok)
+    { Aln_Index_Free(aix);
+      aix = NULL;
+    }
+
+done:
+  fclose(f);
+  return (aix);
+}
+
+int Aln_Index_Range(Aln_Index *aix, int aread, int64 abeg, int64 aend, int64 *beg, int64 *end)
+{ int64 cb, nb, lo, hi, b, s;
+
+  if (aread < 0 || aread >= aix->nctg || aend <= abeg)
+    return (0);
+  if (abeg < 0)
+    abeg = 0;
+  cb = aix->bbeg[aread];
+  nb = aix->bbeg[aread+1] - cb;
+  lo = (abeg >> AIX_SHIFT);
+  hi = ((aend-1) >> AIX_SHIFT);
+  if (lo >= nb)
+    return (0);
+  if (hi >= nb)
+    hi = nb-1;
+
+  s = -1;
+  for (b = lo; b <= hi; b++)
+    if (aix->over[cb+b] >= 0 && (s < 0 || aix->over[cb+b] < s))
+      s = aix->over[cb+b];
+  if (s < 0)
+    return (0);
+
+  *beg = s;
+  if (hi+1 < nb)
+    *end = aix->from[cb+hi+1];
+  else
+    *end = aix->obeg[aread+1];
+  return (1);
+}
+
+void Aln_Index_Free(Aln_Index *aix)
+{ free(aix->over);
+  free(aix->obeg);
+  free(aix);
+}
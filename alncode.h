@@ -21,19 +21,57 @@ OneFile *open_Aln_Read (char *filename, int nThreads,
 			int64 *nOverlaps, int *tspace,
 			char **db1_name, char **db2_name, char **cpath) ;
 
-// next two routines read the records from the file
+// next routines read the records from the file; Read_Aln_Overlap_Cigar also copies the
+//   C-line cigar string of the alignment, if it has one, into *cigar (of *cmax bytes, grown
+//   as needed) and returns its length (0 if none)
 
 void Read_Aln_Overlap(OneFile *of, Overlap *ovl);
+int  Read_Aln_Overlap_Cigar(OneFile *of, Overlap *ovl, char **cigar, int *cmax);
 int  Read_Aln_Trace  (OneFile *of, uint8 *trace);
 void Skip_Aln_Trace  (OneFile *of);
 
-// and equivalents for writing
+// and equivalents for writing, where the optional cigar line is written between the two
 
 OneFile *open_Aln_Write (char *filename, int nThreads,
 			 char *progname, char *version, char *commandLine,
 			 int tspace, char *db1_name, char *db2_name, char *cpath);
 
 void Write_Aln_Overlap(OneFile *of, Overlap *ovl);
+void Write_Aln_Cigar  (OneFile *of, char *cigar, int clen);
 void Write_Aln_Trace  (OneFile *of, uint8 *trace, int tlen);
 
+// An optional index of a .1aln file sorted on (aread,abpos), kept in the hidden file .<root>.aix
+//   beside it: for each A-contig, the range of alignments on it, and for each AIX_WIDTH-base
+//   bucket of it, the first alignment overlapping the bucket and the first starting in or
+//   after it.  Build one with Aln_Index_Start, Aln_Index_Add (for each alignment in file order),
+//   and Aln_Index_Write once the .1aln file is closed.  Aln_Index_Read returns NULL if there
+//   is no index or it is not of the .1aln file as it now is, and Aln_Index_Range sets
+//   [*beg,*end) to a range of alignments containing all those of contig aread that overlap
+//   [abeg,aend), returning 0 if there are none.
+
+#define AIX_SHIFT 16
+#define AIX_WIDTH (1 << AIX_SHIFT)
+
+typedef struct
+  { int64  novl;    // # of alignments, or -1 if they were not added in order
+    int    nctg;    // # of A-contigs up to the last with an alignment
+    int64  nbck;    // # of buckets
+    int64 *obeg;    // alignments on contig c are [obeg[c],obeg[c+1])
+    int64 *bbeg;    // buckets of contig c are [bbeg[c],bbeg[c+1])
+    int64 *over;    // over[b] = first alignment overlapping bucket b, -1 if none
+    int64 *from;    // from[b] = first alignment starting in or after bucket b
+    int64  apos;    // abpos of the last alignment added
+    int64  fnext;   // from[b] is not yet known for b >= fnext
+    int    cmax;    // space allocated for obeg & bbeg, and for over & from
+    int64  bmax;
+  } Aln_Index;
+
+Aln_Index *Aln_Index_Start();
+void       Aln_Index_Add  (Aln_Index *aix, int aread, int abpos, int aepos);
+int        Aln_Index_Write(Aln_Index *aix, char *filename);
+Aln_Index *Aln_Index_Read (char *filename, int64 novl);
+int        Aln_Index_Range(Aln_Index *aix, int aread, int64 abeg, int64 aend,
+                           int64 *beg, int64 *end);
+void       Aln_Index_Free (Aln_Index *aix);
+
 // end of file
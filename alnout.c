@@ -0,0 +1,1310 @@
+/*******************************************************************************************
+ *
+ *  Alignment output module: PAF and PSL formatting of alignments, one at a time or as an
+ *    ordered stream formatted by a pool of threads and written by a writer thread (see
+ *    alnout.h).
+ *
+ *  Author:  agent (agent@local)
+ *  Date  :  October 2026
+ *
+ *******************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "alncode.h"
+#include "alnout.h"
+
+#undef DEBUG_STREAM
+
+void Trim_GDB_Headers(GDB *gdb)
+{ char *head, *sptr, *eptr;
+  int   s;
+
+  head = gdb->headers;
+  for (s = 0; s < gdb->nscaff; s++)
+    { sptr = head + gdb->scaffolds[s].hoff;
+      for (eptr = sptr; *eptr != '\0'; eptr++)
+        if (isspace(*eptr))
+          break;
+      *eptr = '\0';
+    }
+}
+
+
+/*******************************************************************************************
+ *
+ *  FORMATTER
+ *
+ ********************************************************************************************/
+
+Aln_Formatter *New_Aln_Formatter(GDB *gdb1, GDB *gdb2, int format, int tspace)
+{ Aln_Formatter *fmt;
+
+  fmt = Malloc(sizeof(Aln_Formatter),"Allocating alignment formatter");
+  if (fmt == NULL)
+    exit (1);
+
+  fmt->gdb1   = gdb1;
+  fmt->gdb2   = gdb2;
+  fmt->format = format;
+  fmt->tspace = tspace;
+  fmt->alast  = -1;
+  fmt->tmax   = 0;
+  fmt->trace  = NULL;
+
+  if (format == PAF_OUT)
+    { fmt->work = NULL;
+      fmt->aseq = NULL;
+      fmt->bseq = NULL;
+    }
+  else
+    { fmt->work = New_Work_Data();
+      fmt->aseq = New_Contig_Buffer(gdb1);
+      fmt->bseq = New_Contig_Buffer(gdb2);
+      if (fmt->work == NULL || fmt->aseq == NULL || fmt->bseq == NULL)
+        exit (1);
+    }
+
+  return (fmt);
+}
+
+void Free_Aln_Formatter(Aln_Formatter *fmt)
+{ free(fmt->trace);
+  if (fmt->format != PAF_OUT)
+    { free(fmt->bseq-1);
+      free(fmt->aseq-1);
+      Free_Work_Data(fmt->work);
+    }
+  free(fmt);
+}
+
+//  Compute the exact alignment for the trace points of aln->path (in fmt->trace)
+
+static void compute_alignment(Aln_Formatter *fmt, Alignment *aln, int acontig, int bcontig,
+                              int clip)
+{ Path *path = aln->path;
+  int   bmin, bmax;
+  char *bact;
+
+  if (acontig != fmt->alast)
+    { Get_Contig(fmt->gdb1,acontig,NUMERIC,fmt->aseq);
+      fmt->alast = acontig;
+    }
+  aln->aseq = fmt->aseq;
+
+  if (COMP(aln->flags))
+    { bmin = (aln->blen-path->bepos);
+      bmax = (aln->blen-path->bbpos);
+    }
+  else
+    { bmin = path->bbpos;
+      bmax = path->bepos;
+    }
+  if (clip)
+    { if (bmin < 0) bmin = 0;
+      if (bmax > aln->blen) bmax = aln->blen;
+    }
+
+  bact = Get_Contig_Piece(fmt->gdb2,bcontig,bmin,bmax,NUMERIC,fmt->bseq);
+  if (COMP(aln->flags))
+    { Complement_Seq(bact,bmax-bmin);
+      aln->bseq = bact - (aln->blen-bmax);
+    }
+  else
+    aln->bseq = bact - bmin;
+
+  Compute_Trace_PTS(aln,fmt->work,fmt->tspace,GREEDIEST);
+
+  Gap_Improver(aln,fmt->work);
+}
+
+//  Append a tab and then num, or num and then the character c, to out
+
+static void int_tab(Line_Buffer *out, int64 num)
+{ Line_Char(out,'\t');
+  Line_Int(out,num);
+}
+
+static void int_char(Line_Buffer *out, int64 num, int c)
+{ Line_Int(out,num);
+  Line_Char(out,c);
+}
+
+//  Compute the exact alignment of aln (between contigs acontig and bcontig) and append its
+//    CIGAR string of ='s, X's, I's, and D's to out
+
+static void x_cigar(Aln_Formatter *fmt, Alignment *aln, int acontig, int bcontig,
+                    Line_Buffer *out)
+{ Path  *path = aln->path;
+  int    k, h, p, x, b, blen;
+  int32 *t;
+  int    T;
+  int    ilen, dlen;
+  int    xlen, elen;
+  char  *A, *B;
+
+  compute_alignment(fmt,aln,acontig,bcontig,0);
+
+  t = (int32 *) path->trace;
+  T = path->tlen;
+  A = aln->aseq-1;
+  B = aln->bseq-1;
+  ilen = dlen = 0;
+  k = path->abpos+1;
+  h = path->bbpos+1;
+  for (x = 0; x < T; x++)
+    { if ((p = t[x]) < 0)
+        { blen = -(p+k);
+          if (dlen > 0)
+            int_char(out,dlen,'I');
+          dlen = 0;
+          if (blen == 0)
+            ilen += 1;
+          else
+            { if (ilen > 0)
+                int_char(out,ilen,'D');
+              elen = xlen = 0;
+              for (b = 0; b < blen; b++, k++, h++)
+                if (A[k] == B[h])
+                  { if (xlen > 0)
+                      int_char(out,xlen,'X');
+                    xlen = 0;
+                    elen += 1;
+                  }
+                else
+                  { if (elen > 0)
+                      int_char(out,elen,'=');
+                    elen = 0;
+                    xlen += 1;
+                  }
+              if (xlen > 0)
+                int_char(out,xlen,'X');
+              if (elen > 0)
+                int_char(out,elen,'=');
+              ilen = 1;
+            }
+          h += 1;
+        }
+      else
+        { blen = p-h;
+          if (ilen > 0)
+            int_char(out,ilen,'D');
+          ilen = 0;
+          if (blen == 0)
+            dlen += 1;
+          else
+            { if (dlen > 0)
+                int_char(out,dlen,'I');
+              elen = xlen = 0;
+              for (b = 0; b < blen; b++, k++, h++)
+                if (A[k] == B[h])
+                  { if (xlen > 0)
+                      int_char(out,xlen,'X');
+                    xlen = 0;
+                    elen += 1;
+                  }
+                else
+                  { if (elen > 0)
+                      int_char(out,elen,'=');
+                    elen = 0;
+                    xlen += 1;
+                  }
+              if (xlen > 0)
+                int_char(out,xlen,'X');
+              if (elen > 0)
+                int_char(out,elen,'=');
+              dlen = 1;
+            }
+          k += 1;
+        }
+    }
+  if (dlen > 0)
+    int_char(out,dlen,'I');
+  if (ilen > 0)
+    int_char(out,ilen,'D');
+  blen = (path->aepos - k)+1;
+  if (blen > 0)
+    { elen = xlen = 0;
+      for (b = 0; b < blen; b++, k++, h++)
+        if (A[k] == B[h])
+          { if (xlen > 0)
+              int_char(out,xlen,'X');
+            xlen = 0;
+            elen += 1;
+          }
+        else
+          { if (elen > 0)
+              int_char(out,elen,'=');
+            elen = 0;
+            xlen += 1;
+          }
+      if (xlen > 0)
+        int_char(out,xlen,'X');
+      if (elen > 0)
+        int_char(out,elen,'=');
+    }
+}
+
+
+//  Append to out the CIGAR string of M's, I's, and D's equivalent to the string cigar of ='s,
+//    X's, I's, and D's, i.e. with each maximal run of ='s and X's merged into one M
+
+static void m_cigar(char *cigar, Line_Buffer *out)
+{ char *c;
+  int   n, mlen;
+
+  mlen = 0;
+  for (c = cigar; *c != '\0'; c++)
+    { n = 0;
+      while (isdigit(*c))
+        n = 10*n + (*c++ - '0');
+      if (*c == '=' || *c == 'X')
+        mlen += n;
+      else
+        { if (mlen > 0)
+            int_char(out,mlen,'M');
+          mlen = 0;
+          int_char(out,n,*c);
+        }
+    }
+  if (mlen > 0)
+    int_char(out,mlen,'M');
+}
+
+static void paf_line(Aln_Formatter *fmt, Overlap *ovl, Alignment *aln, char *cigar,
+                     Line_Buffer *out)
+{ GDB_CONTIG   *contigs1 = fmt->gdb1->contigs;
+  GDB_CONTIG   *contigs2 = fmt->gdb2->contigs;
+  GDB_SCAFFOLD *scaff1   = fmt->gdb1->scaffolds;
+  GDB_SCAFFOLD *scaff2   = fmt->gdb2->scaffolds;
+  char         *ahead    = fmt->gdb1->headers;
+  char         *bhead    = fmt->gdb2->headers;
+  Path         *path     = aln->path;
+
+  int           acontig, bcontig;
+  int           ascaff, bscaff;
+  int64         aoff, boff;
+  int           blocksum, iid;
+
+  acontig = ovl->aread;
+  aln->alen = contigs1[acontig].clen;
+  bcontig = ovl->bread;
+  aln->blen  = contigs2[bcontig].clen;
+  aln->flags = ovl->flags;
+  ascaff = contigs1[acontig].scaf;
+  bscaff = contigs2[bcontig].scaf;
+
+  aoff = contigs1[acontig].sbeg;
+  Line_String(out,ahead + scaff1[ascaff].hoff);
+  int_tab(out,scaff1[ascaff].slen);
+  int_tab(out,aoff + path->abpos);
+  int_tab(out,aoff + path->aepos);
+
+  Line_Char(out,'\t');
+  Line_Char(out,COMP(aln->flags)?'-':'+');
+
+  Line_Char(out,'\t');
+  Line_String(out,bhead + scaff2[bscaff].hoff);
+  int_tab(out,scaff2[bscaff].slen);
+
+  if (COMP(aln->flags))
+    { boff = contigs2[bcontig].sbeg + contigs2[bcontig].clen;
+      int_tab(out,boff - path->bepos);
+      int_tab(out,boff - path->bbpos);
+    }
+  else
+    { boff = contigs2[bcontig].sbeg;
+      int_tab(out,boff + path->bbpos);
+      int_tab(out,boff + path->bepos);
+    }
+
+  blocksum = (path->aepos-path->abpos) + (path->bepos-path->bbpos);
+  iid      = (blocksum - path->diffs)/2;
+
+  int_tab(out,iid);
+  int_tab(out,blocksum/2);
+  Line_String(out,"\t255");
+
+  Line_String(out,"\tdv:f:");
+  Line_Fixed(out,1.*((path->aepos-path->abpos)-iid)/(path->aepos-path->abpos),0,4);
+  Line_String(out,"\tdf:i:");
+  Line_Int(out,path->diffs);
+
+  if (fmt->format == PAF_M_OUT && cigar != NULL)
+    { Line_String(out,"\tcg:Z:");
+      m_cigar(cigar,out);
+    }
+
+  else if (fmt->format == PAF_M_OUT)
+    { int    k, h, p, x, blen;
+      int32 *t;
+      int    T;
+      int    ilen, dlen;
+
+      compute_alignment(fmt,aln,acontig,bcontig,0);
+
+      t = (int32 *) path->trace;
+      T = path->tlen;
+      ilen = dlen = 0;
+      Line_String(out,"\tcg:Z:");
+      k = path->abpos+1;
+      h = path->bbpos+1;
+      for (x = 0; x < T; x++)
+        { if ((p = t[x]) < 0)
+            { blen = -(p+k);
+              k += blen;
+              h += blen+1;
+              if (dlen > 0)
+                int_char(out,dlen,'I');
+              dlen = 0;
+              if (blen == 0)
+                ilen += 1;
+              else
+                { if (ilen > 0)
+                    int_char(out,ilen,'D');
+                  int_char(out,blen,'M');
+                  ilen = 1;
+                }
+            }
+          else
+            { blen = p-h;
+              k += blen+1;
+              h += blen;
+              if (ilen > 0)
+                int_char(out,ilen,'D');
+              ilen = 0;
+              if (blen == 0)
+                dlen += 1;
+              else
+                { if (dlen > 0)
+                    int_char(out,dlen,'I');
+                  int_char(out,blen,'M');
+                  dlen = 1;
+                }
+            }
+        }
+      if (dlen > 0)
+        int_char(out,dlen,'I');
+      if (ilen > 0)
+        int_char(out,ilen,'D');
+      blen = (path->aepos - k)+1;
+      if (blen > 0)
+        int_char(out,blen,'M');
+    }
+
+  else if (fmt->format == PAF_X_OUT)
+    { Line_String(out,"\tcg:Z:");
+      if (cigar != NULL)
+        Line_String(out,cigar);
+      else
+        x_cigar(fmt,aln,acontig,bcontig,out);
+    }
+  Line_Char(out,'\n');
+}
+
+//  Advance *i and *j (positions in A and B) over the indels at *cig and return the length of
+//    the following run of aligned symbols (='s and X's), or 0 if the cigar string is exhausted,
+//    leaving *cig just past the run
+
+static int cigar_block(char **cig, int *i, int *j)
+{ char *c, *d;
+  int   n, len;
+
+  len = 0;
+  for (c = *cig; *c != '\0'; c = d+1)
+    { n = 0;
+      for (d = c; isdigit(*d); d++)
+        n = 10*n + (*d - '0');
+      if (*d == '=' || *d == 'X')
+        len += n;
+      else if (len > 0)
+        break;
+      else if (*d == 'I')
+        *i += n;
+      else
+        *j += n;
+    }
+  *cig = c;
+  return (len);
+}
+
+static void psl_line(Aln_Formatter *fmt, Overlap *ovl, Alignment *aln, char *cigar,
+                     Line_Buffer *out)
+{ GDB_CONTIG   *contig1 = fmt->gdb1->contigs;
+  GDB_CONTIG   *contig2 = fmt->gdb2->contigs;
+  GDB_SCAFFOLD *scaff1  = fmt->gdb1->scaffolds;
+  GDB_SCAFFOLD *scaff2  = fmt->gdb2->scaffolds;
+  char         *ahead   = fmt->gdb1->headers;
+  char         *bhead   = fmt->gdb2->headers;
+  Path         *path    = aln->path;
+
+  int           acontig, bcontig;
+  int           ascaff, bscaff;
+  int64         aoff, boff;
+
+  acontig = ovl->aread;
+  aln->alen = contig1[acontig].clen;
+  aoff      = contig1[acontig].sbeg;
+  bcontig = ovl->bread;
+  aln->blen  = contig2[bcontig].clen;
+  aln->flags = ovl->flags;
+
+  ascaff = contig1[acontig].scaf;
+  bscaff = contig2[bcontig].scaf;
+
+  if (COMP(aln->flags))
+    boff = contig2[bcontig].sbeg + contig2[bcontig].clen;
+  else
+    boff = contig2[bcontig].sbeg;
+
+  if (cigar == NULL)
+    compute_alignment(fmt,aln,acontig,bcontig,1);
+
+  { int     i, j, x, p, q;
+    int    *t, T;
+    int     M, N;
+    int     I, D, S, X;
+    int     IB, DB;
+    int     bcnt, bmat;
+    char   *c;
+
+    t = (int *) path->trace;
+    T = path->tlen;
+
+    M = path->aepos - path->abpos;
+    N = path->bepos - path->bbpos;
+    I = D = 0;
+    IB = DB = 0;
+    if (cigar == NULL)
+      { p = 0;
+        for (x = 0; x < T; x++)
+          { q = p;
+            if ((p = t[x]) < 0)
+              { I += 1;
+                if (p != q)
+                  IB += 1;
+              }
+            else
+              { D += 1;
+                if (p != q)
+                  DB += 1;
+              }
+          }
+        S = path->diffs - (I+D);
+      }
+    else
+      { S = 0;
+        for (c = cigar; *c != '\0'; c++)      //  A trace point < 0 (> 0) is a D (an I)
+          { p = 0;
+            while (isdigit(*c))
+              p = 10*p + (*c++ - '0');
+            if (*c == 'D')
+              { I  += p;
+                IB += 1;
+              }
+            else if (*c == 'I')
+              { D  += p;
+                DB += 1;
+              }
+            else if (*c == 'X')
+              S += p;
+          }
+      }
+    X = (M+N - (I+D+2*S))/2;
+
+    Line_Int(out,X);
+    int_tab(out,S);
+    Line_String(out,"\t0\t0");
+    int_tab(out,IB);
+    int_tab(out,I);
+    int_tab(out,DB);
+    int_tab(out,D);
+    Line_Char(out,'\t');
+    Line_Char(out,COMP(ovl->flags)?'-':'+');
+
+    Line_Char(out,'\t');
+    Line_String(out,ahead+scaff1[ascaff].hoff);
+    int_tab(out,scaff1[ascaff].slen);
+    int_tab(out,aoff+path->abpos);
+    int_tab(out,aoff+path->aepos);
+
+    Line_Char(out,'\t');
+    Line_String(out,bhead+scaff2[bscaff].hoff);
+    int_tab(out,scaff2[bscaff].slen);
+    if (COMP(aln->flags))
+      { int_tab(out,boff-path->bepos);
+        int_tab(out,boff-path->bbpos);
+      }
+    else
+      { int_tab(out,boff+path->bbpos);
+        int_tab(out,boff+path->bepos);
+      }
+
+    if (cigar != NULL)
+      { bcnt = 0;
+        c = cigar;
+        i = path->abpos+1;
+        j = path->bbpos+1;
+        while ((bmat = cigar_block(&c,&i,&j)) > 0)
+          { bcnt += 1;
+            i += bmat;
+            j += bmat;
+          }
+        int_tab(out,bcnt);
+        Line_Char(out,'\t');
+
+        for (x = 0; x < 3; x++)
+          { c = cigar;
+            i = path->abpos+1;
+            j = path->bbpos+1;
+            while ((bmat = cigar_block(&c,&i,&j)) > 0)
+              { int_char(out,x==0?bmat:(x==1?i:j),',');
+                i += bmat;
+                j += bmat;
+              }
+            Line_Char(out,x<2?'\t':'\n');
+          }
+      }
+    else
+      { bcnt = 0;
+        i = path->abpos+1;
+        j = path->bbpos+1;
+        for (x = 0; x < T; x++)
+          { if ((p = t[x]) < 0)
+              { bmat = -(p+i);
+                i += bmat;
+                j += bmat+1;
+              }
+            else
+              { bmat = p-j;
+                i += bmat+1;
+                j += bmat;
+              }
+            if (bmat > 0)
+              bcnt += 1;
+          }
+        bmat = (path->aepos - i)+1;
+        if (bmat > 0)
+          bcnt += 1;
+        int_tab(out,bcnt);
+        Line_Char(out,'\t');
+
+        i = path->abpos+1;
+        j = path->bbpos+1;
+        for (x = 0; x < T; x++)
+          { if ((p = t[x]) < 0)
+              { bmat = -(p+i);
+                i += bmat;
+                j += bmat+1;
+              }
+            else
+              { bmat = p-j;
+                i += bmat+1;
+                j += bmat;
+              }
+            if (bmat > 0)
+              int_char(out,bmat,',');
+          }
+        bmat = (path->aepos - i)+1;
+        if (bmat > 0)
+          int_char(out,bmat,',');
+        Line_Char(out,'\t');
+
+        i = path->abpos+1;
+        j = path->bbpos+1;
+        for (x = 0; x < T; x++)
+          { if ((p = t[x]) < 0)
+              { bmat = -(p+i);
+                if (bmat > 0)
+                  int_char(out,i,',');
+                i += bmat;
+                j += bmat+1;
+              }
+            else
+              { bmat = p-j;
+                if (bmat > 0)
+                  int_char(out,i,',');
+                i += bmat+1;
+                j += bmat;
+              }
+          }
+        bmat = (path->aepos - i)+1;
+        if (bmat > 0)
+          int_char(out,i,',');
+        Line_Char(out,'\t');
+
+        i = path->abpos+1;
+        j = path->bbpos+1;
+        for (x = 0; x < T; x++)
+          { if ((p = t[x]) < 0)
+              { bmat = -(p+i);
+                if (bmat > 0)
+                  int_char(out,j,',');
+                i += bmat;
+                j += bmat+1;
+              }
+            else
+              { bmat = p-j;
+                if (bmat > 0)
+                  int_char(out,j,',');
+                i += bmat+1;
+                j += bmat;
+              }
+          }
+        bmat = (path->aepos - i)+1;
+        if (bmat > 0)
+          int_char(out,j,',');
+        Line_Char(out,'\n');
+      }
+  }
+}
+
+void Format_Aln(Aln_Formatter *fmt, Overlap *ovl, char *cigar, Line_Buffer *out)
+{ Path      path;
+  Alignment aln;
+  uint8    *t8;
+  int       j;
+
+  //  Unless its exact alignment is given by cigar, work on a copy of ovl's path whose trace
+  //    is widened to 16-bits in fmt->trace as the alignment routines require
+
+  path = ovl->path;
+  if (fmt->format != PAF_OUT && cigar == NULL)
+    { if (path.tlen > fmt->tmax)
+        { fmt->tmax  = 1.2*path.tlen + 1000;
+          fmt->trace = (uint16 *) Realloc(fmt->trace,sizeof(uint16)*fmt->tmax,
+                                          "Reallocating trace vector");
+          if (fmt->trace == NULL)
+            exit (1);
+        }
+      t8 = (uint8 *) ovl->path.trace;
+      for (j = 0; j < path.tlen; j++)
+        fmt->trace[j] = t8[j];
+      path.trace = fmt->trace;
+    }
+  aln.path = &path;
+
+  if (fmt->format == CIGAR_OUT)
+    { if (cigar != NULL)
+        Line_String(out,cigar);
+      else
+        { aln.alen  = fmt->gdb1->contigs[ovl->aread].clen;
+          aln.blen  = fmt->gdb2->contigs[ovl->bread].clen;
+          aln.flags = ovl->flags;
+          x_cigar(fmt,&aln,ovl->aread,ovl->bread,out);
+        }
+      Line_Char(out,'\n');
+    }
+  else if (fmt->format == PSL_OUT)
+    psl_line(fmt,ovl,&aln,cigar,out);
+  else
+    paf_line(fmt,ovl,&aln,cigar,out);
+}
+
+
+
+/*******************************************************************************************
+ *
+ *  ORDERED STREAM
+ *
+ *  Output is produced in numbered batches held in a ring of nslot slots, batch k in slot
+ *    k % nslot.  The alignments of a batch are either put there by the caller (Put_Aln_Stream),
+ *    who starts batch k only once batch k-nslot has been written out, or, for Output_Aln_File,
+ *    are a range of the .1aln file that the thread formatting the batch reads itself.  A pool
+ *    of threads formats the batches into the in-memory text buffers of their slots (and when
+ *    requested compresses them into BGZF blocks), and a single writer thread outputs the run
+ *    of consecutive finished batches at the head of the ring with one writev, so the batches
+ *    go out strictly in order.  At most nslot batches are ever held, so memory is bounded
+ *    independently of the size of the output, and no temporary files are written.
+ *
+ ********************************************************************************************/
+
+#define BATCH_ALNS  1000              //  A batch is handed off when it has this many alignments
+#define BATCH_BYTES 0x400000          //    or this many trace bytes
+
+#define BGZF_BLOCK  0xff00            //  Max. uncompressed bytes of a BGZF block (as bgzip)
+#define BGZF_HEAD   18                //  Bytes of a BGZF block header
+#define BGZF_TAIL   8                 //    and trailer
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+static uint8 BGZF_EOF[28] =   //  The empty block that ends a BGZF file
+  { 0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+    0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+  };
+
+typedef struct
+  { int      novl;    //  # of alignments in the batch (when put by the caller)
+    int      omax;    //  ovls has room for omax alignments
+    Overlap *ovls;
+    int64    ttop;    //  # of trace bytes in the batch
+    int64    tmax;    //  tbuf has room for tmax bytes
+    uint8   *tbuf;
+    Line_Buffer text; //  the formatted lines
+    uint8   *zbuf;    //  BGZF compression of the text (if requested)
+    int64    zlen;
+    int64    zmax;
+    int      done;    //  batch has been formatted and awaits output
+  } Batch;
+
+typedef struct
+  { Aln_Stream    *stream;
+    GDB            gdb1;
+    GDB            gdb2;
+    Aln_Formatter *fmt;
+    int            own1;    //  gdb1.seqs (gdb2.seqs) was opened for this thread
+    int            own2;
+    OneFile       *in;      //  Output_Aln_File: this thread's reader of the .1aln file,
+    int64          inext;   //    the alignment it is positioned at (-1 if not known),
+    uint8         *trace;   //    and buffers for a trace and a cigar string
+    char          *cigar;
+    int            cmax;
+    z_stream       zs;      //  deflate state if compressing
+  } Worker;
+
+struct Aln_Stream
+  { int              fd;         //  file descriptor output is written to
+    OneFile         *of;         //    or .1aln file the alignments are written to
+    int              bgzf;       //  compress output in BGZF format
+    int64            novl;       //  Output_Aln_File: # of alignments in the file, else -1
+    int              nthreads;
+    int              nslot;
+    Batch           *slot;
+    int64            nfill;      //  # of batches handed off for formatting
+    int64            nclaim;     //  # of batches claimed by a thread
+    int64            nout;       //  # of batches output
+    int              closed;     //  no more batches will be handed off
+    int              open;       //  caller holds the slot of batch nfill
+    int64            nbytes;     //  # of bytes output
+    pthread_mutex_t  lock;
+    pthread_cond_t   ready;      //  a batch can be claimed or the stream was closed
+    pthread_cond_t   formatted;  //  a batch was formatted
+    pthread_cond_t   freed;      //  batches were output, freeing their slots
+    Worker          *work;
+    pthread_t       *threads;
+    pthread_t        writer;
+  };
+
+//  Compress the text of batch b into a series of BGZF blocks in b->zbuf
+
+static void compress_batch(Worker *w, Batch *b)
+{ z_stream *zs = &w->zs;
+  uint8    *z;
+  int64     beg, len, need;
+  uint32    crc;
+  int       bsize;
+
+  need = ((b->text.len + BGZF_BLOCK-1) / BGZF_BLOCK) * (BGZF_HEAD + BGZF_TAIL
+                                                     + deflateBound(zs,BGZF_BLOCK));
+  if (need > b->zmax)
+    { b->zmax = need;
+      b->zbuf = Realloc(b->zbuf,need,"Reallocating compression buffer");
+      if (b->zbuf == NULL)
+        exit (1);
+    }
+
+  b->zlen = 0;
+  for (beg = 0; beg < b->text.len; beg += len)
+    { len = b->text.len - beg;
+      if (len > BGZF_BLOCK)
+        len = BGZF_BLOCK;
+      z = b->zbuf + b->zlen;
+
+      deflateReset(zs);
+      zs->next_in   = (Bytef *) (b->text.text + beg);
+      zs->avail_in  = len;
+      zs->next_out  = z + BGZF_HEAD;
+      zs->avail_out = b->zmax - (b->zlen + BGZF_HEAD + BGZF_TAIL);
+      if (deflate(zs,Z_FINISH) != Z_STREAM_END)
+        { fprintf(stderr,"%s: BGZF compression of output failed\n",Prog_Name);
+          exit (1);
+        }
+      bsize = BGZF_HEAD + zs->total_out + BGZF_TAIL;
+      crc   = crc32(crc32(0,NULL,0),(Bytef *) (b->text.text + beg),len);
+
+      memcpy(z,BGZF_EOF,BGZF_HEAD);
+      z[16] = (bsize-1) & 0xff;
+      z[17] = (bsize-1) >> 8;
+      z += BGZF_HEAD + zs->total_out;
+      z[0] = crc & 0xff;
+      z[1] = (crc >> 8) & 0xff;
+      z[2] = (crc >> 16) & 0xff;
+      z[3] = crc >> 24;
+      z[4] = len & 0xff;
+      z[5] = (len >> 8) & 0xff;
+      z[6] = z[7] = 0;
+
+      b->zlen += bsize;
+    }
+}
+
+//  Read and format the alignments of batch k of the .1aln file of Output_Aln_File
+
+static void read_batch(Worker *w, Batch *b, int64 k)
+{ OneFile *in = w->in;
+  Overlap  _ovl, *ovl = &_ovl;
+  int64    beg, end;
+  int      clen;
+
+  beg = k*BATCH_ALNS;
+  end = beg+BATCH_ALNS;
+  if (end > w->stream->novl)
+    end = w->stream->novl;
+
+  if (beg != w->inext)
+    { if (!oneGoto(in,'A',beg+1))
+        { fprintf(stderr,"%s: Can't locate to object %lld in aln file\n",Prog_Name,beg+1);
+          exit (1);
+        }
+      oneReadLine(in);
+    }
+
+  ovl->path.trace = (void *) w->trace;
+  for ( ; beg < end; beg++)
+    { clen = Read_Aln_Overlap_Cigar(in,ovl,&w->cigar,&w->cmax);
+      ovl->path.tlen = Read_Aln_Trace(in,w->trace);
+      Format_Aln(w->fmt,ovl,clen>0?w->cigar:NULL,&b->text);
+    }
+  w->inext = end;
+}
+
+static void *format_thread(void *args)
+{ Worker     *w = (Worker *) args;
+  Aln_Stream *s = w->stream;
+  Batch      *b;
+  uint8      *t;
+  int64       k;
+  int         i;
+
+  pthread_mutex_lock(&s->lock);
+  while (1)
+    { while (s->nclaim < s->nfill ? s->nclaim >= s->nout + s->nslot : ! s->closed)
+        pthread_cond_wait(&s->ready,&s->lock);
+      if (s->nclaim >= s->nfill)
+        break;
+      k = s->nclaim++;
+      pthread_mutex_unlock(&s->lock);
+
+      b = s->slot + (k % s->nslot);
+      if (s->novl >= 0)
+        read_batch(w,b,k);
+      else
+        { t = b->tbuf;
+          for (i = 0; i < b->novl; i++)
+            { b->ovls[i].path.trace = t;
+              t += b->ovls[i].path.tlen;
+              Format_Aln(w->fmt,b->ovls+i,NULL,&b->text);
+            }
+        }
+      if (s->bgzf)
+        compress_batch(w,b);
+
+#ifdef DEBUG_STREAM
+      fprintf(stderr,"  Batch %lld: %lld bytes formatted\n",k,b->text.len);
+#endif
+
+      pthread_mutex_lock(&s->lock);
+      b->done = 1;
+      pthread_cond_signal(&s->formatted);
+    }
+  pthread_mutex_unlock(&s->lock);
+
+  return (NULL);
+}
+
+//  Write the n buffers of iov to s->fd in full
+
+static void write_iov(Aln_Stream *s, struct iovec *iov, int n)
+{ ssize_t x;
+
+  while (n > 0)
+    { x = writev(s->fd,iov,n);
+      if (x < 0)
+        { if (errno == EINTR)
+            continue;
+          fprintf(stderr,"%s: Output of alignments failed (%s)\n",Prog_Name,strerror(errno));
+          exit (1);
+        }
+      s->nbytes += x;
+      while (n > 0 && (size_t) x >= iov->iov_len)
+        { x -= iov->iov_len;
+          iov += 1;
+          n   -= 1;
+        }
+      if (n > 0)
+        { iov->iov_base = ((char *) iov->iov_base) + x;
+          iov->iov_len -= x;
+        }
+    }
+}
+
+//  Write the alignments of batch b to the .1aln file s->of, each with a C-line giving the
+//    cigar string that is its line in b->text
+
+static void write_records(Aln_Stream *s, Batch *b)
+{ char *c, *e;
+  int   i;
+
+  c = b->text.text;
+  for (i = 0; i < b->novl; i++)
+    { e = memchr(c,'\n',(b->text.text + b->text.len) - c);
+      Write_Aln_Overlap(s->of,b->ovls+i);
+      Write_Aln_Cigar(s->of,c,e-c);
+      Write_Aln_Trace(s->of,b->ovls[i].path.trace,b->ovls[i].path.tlen);
+      c = e+1;
+    }
+  s->nbytes += b->text.len;
+}
+
+static void *write_thread(void *args)
+{ Aln_Stream  *s = (Aln_Stream *) args;
+  struct iovec iov[s->nslot < IOV_MAX ? s->nslot : IOV_MAX];
+  Batch       *b;
+  int          i, n, m;
+
+  pthread_mutex_lock(&s->lock);
+  while (1)
+    { while ( ! s->slot[s->nout % s->nslot].done && ! (s->closed && s->nout >= s->nfill))
+        pthread_cond_wait(&s->formatted,&s->lock);
+      if ( ! s->slot[s->nout % s->nslot].done)
+        break;
+      for (n = 1; n < s->nslot && n < IOV_MAX; n++)
+        if ( ! s->slot[(s->nout+n) % s->nslot].done)
+          break;
+      pthread_mutex_unlock(&s->lock);
+
+      if (s->of != NULL)
+        for (i = 0; i < n; i++)
+          write_records(s,s->slot + ((s->nout+i) % s->nslot));
+      else
+        { m = 0;
+          for (i = 0; i < n; i++)
+            { b = s->slot + ((s->nout+i) % s->nslot);
+              if (s->bgzf)
+                { iov[m].iov_base = b->zbuf;
+                  iov[m].iov_len  = b->zlen;
+                }
+              else
+                { iov[m].iov_base = b->text.text;
+                  iov[m].iov_len  = b->text.len;
+                }
+              if (iov[m].iov_len > 0)
+                m += 1;
+            }
+          write_iov(s,iov,m);
+        }
+
+#ifdef DEBUG_STREAM
+      fprintf(stderr,"  Batches %lld-%lld written\n",s->nout,s->nout+n-1);
+#endif
+
+      for (i = 0; i < n; i++)
+        { b = s->slot + ((s->nout+i) % s->nslot);
+          b->text.len = 0;
+          b->novl = 0;
+          b->ttop = 0;
+        }
+
+      pthread_mutex_lock(&s->lock);
+      for (i = 0; i < n; i++)
+        s->slot[(s->nout+i) % s->nslot].done = 0;
+      s->nout += n;
+      pthread_cond_broadcast(&s->freed);
+      pthread_cond_broadcast(&s->ready);
+    }
+  pthread_mutex_unlock(&s->lock);
+
+  if (s->bgzf)
+    { iov[0].iov_base = BGZF_EOF;
+      iov[0].iov_len  = sizeof(BGZF_EOF);
+      write_iov(s,iov,1);
+    }
+
+  return (NULL);
+}
+
+//  Set up a stream of nthreads formatters writing to out, where thread p formats the
+//    contigs of gdb1[p] and gdb2[p].  If own is set then each thread but the first makes its
+//    own copies of the file pointers for any EXTERNAL sequences, otherwise they are used as is.
+
+static Aln_Stream *new_stream(GDB *gdb1, GDB *gdb2, int own, int format, int tspace,
+                              int nthreads, FILE *out, int bgzf, int64 novl)
+{ Aln_Stream *s;
+  Worker     *w;
+  int         p;
+
+  s = Malloc(sizeof(Aln_Stream),"Allocating alignment stream");
+  if (s == NULL)
+    exit (1);
+
+  if (out != NULL)
+    { fflush(out);
+      s->fd = fileno(out);
+    }
+  else
+    s->fd = -1;
+  s->of       = NULL;
+  s->bgzf     = bgzf;
+  s->novl     = novl;
+  s->nthreads = nthreads;
+  s->nslot    = 2*nthreads;
+  s->nfill    = 0;
+  s->nclaim   = 0;
+  s->nout     = 0;
+  s->closed   = 0;
+  s->open     = 0;
+  s->nbytes   = 0;
+
+  s->slot    = Malloc(sizeof(Batch)*s->nslot,"Allocating stream batches");
+  s->work    = Malloc(sizeof(Worker)*nthreads,"Allocating stream threads");
+  s->threads = Malloc(sizeof(pthread_t)*nthreads,"Allocating stream threads");
+  if (s->slot == NULL || s->work == NULL || s->threads == NULL)
+    exit (1);
+
+  for (p = 0; p < s->nslot; p++)
+    { Batch *b = s->slot + p;
+
+      b->novl = 0;
+      b->ttop = 0;
+      if (novl < 0)
+        { b->omax = BATCH_ALNS;
+          b->ovls = Malloc(sizeof(Overlap)*BATCH_ALNS,"Allocating stream batches");
+          b->tmax = BATCH_BYTES;
+          b->tbuf = Malloc(BATCH_BYTES,"Allocating stream batches");
+          if (b->ovls == NULL || b->tbuf == NULL)
+            exit (1);
+        }
+      else
+        { b->omax = 0;
+          b->ovls = NULL;
+          b->tmax = 0;
+          b->tbuf = NULL;
+        }
+      Line_Init(&b->text);
+      b->zbuf = NULL;
+      b->zlen = 0;
+      b->zmax = 0;
+      b->done = 0;
+    }
+
+  for (p = 0; p < nthreads; p++)
+    { w = s->work + p;
+      w->stream = s;
+      w->gdb1   = gdb1[own?0:p];
+      w->gdb2   = gdb2[own?0:p];
+      w->own1   = 0;
+      w->own2   = 0;
+      w->in     = NULL;
+      w->inext  = -1;
+      w->trace  = NULL;
+      w->cigar  = NULL;
+      w->cmax   = 0;
+      if (own && p > 0 && format != PAF_OUT)
+        { if (gdb1->seqstate == EXTERNAL)
+            { w->gdb1.seqs = fopen(gdb1->seqpath,"r");
+              if (w->gdb1.seqs == NULL)
+                { fprintf(stderr,"%s: Cannot open another copy of GDB %s\n",
+                                 Prog_Name,gdb1->seqpath);
+                  return (NULL);
+                }
+              w->own1 = 1;
+            }
+          if (gdb2 == gdb1)
+            w->gdb2.seqs = w->gdb1.seqs;
+          else if (gdb2->seqstate == EXTERNAL)
+            { w->gdb2.seqs = fopen(gdb2->seqpath,"r");
+              if (w->gdb2.seqs == NULL)
+                { fprintf(stderr,"%s: Cannot open another copy of GDB %s\n",
+                                 Prog_Name,gdb2->seqpath);
+                  return (NULL);
+                }
+              w->own2 = 1;
+            }
+        }
+      w->fmt = New_Aln_Formatter(&w->gdb1,&w->gdb2,format,tspace);
+      if (bgzf)
+        { w->zs.zalloc = Z_NULL;
+          w->zs.zfree  = Z_NULL;
+          w->zs.opaque = Z_NULL;
+          if (deflateInit2(&w->zs,Z_DEFAULT_COMPRESSION,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY)
+                != Z_OK)
+            { fprintf(stderr,"%s: Cannot initialize BGZF compression\n",Prog_Name);
+              exit (1);
+            }
+        }
+    }
+
+  pthread_mutex_init(&s->lock,NULL);
+  pthread_cond_init(&s->ready,NULL);
+  pthread_cond_init(&s->formatted,NULL);
+  pthread_cond_init(&s->freed,NULL);
+
+  return (s);
+}
+
+static void start_stream(Aln_Stream *s)
+{ int p;
+
+  for (p = 0; p < s->nthreads; p++)
+    pthread_create(s->threads+p,NULL,format_thread,s->work+p);
+  pthread_create(&s->writer,NULL,write_thread,s);
+}
+
+//  Wait for all batches to be output, then free the stream and return the # of bytes output
+
+static int64 finish_stream(Aln_Stream *s)
+{ Batch *b;
+  int64  nbytes;
+  int    p;
+
+  for (p = 0; p < s->nthreads; p++)
+    pthread_join(s->threads[p],NULL);
+  pthread_join(s->writer,NULL);
+
+  pthread_cond_destroy(&s->freed);
+  pthread_cond_destroy(&s->formatted);
+  pthread_cond_destroy(&s->ready);
+  pthread_mutex_destroy(&s->lock);
+
+  for (p = 0; p < s->nthreads; p++)
+    { Worker *w = s->work + p;
+
+      if (s->bgzf)
+        deflateEnd(&w->zs);
+      free(w->cigar);
+      free(w->trace);
+      Free_Aln_Formatter(w->fmt);
+      if (w->own2)
+        fclose(w->gdb2.seqs);
+      if (w->own1)
+        fclose(w->gdb1.seqs);
+    }
+
+  for (p = 0; p < s->nslot; p++)
+    { b = s->slot + p;
+      Line_Free(&b->text);
+      free(b->zbuf);
+      free(b->tbuf);
+      free(b->ovls);
+    }
+
+  nbytes = s->nbytes;
+
+  free(s->threads);
+  free(s->work);
+  free(s->slot);
+  free(s);
+
+  return (nbytes);
+}
+
+Aln_Stream *Open_Aln_Stream(GDB *gdb1, GDB *gdb2, int format, int tspace, int nthreads,
+                            FILE *out, int bgzf)
+{ Aln_Stream *s;
+
+  s = new_stream(gdb1,gdb2,1,format,tspace,nthreads,out,bgzf,-1);
+  if (s != NULL)
+    start_stream(s);
+  return (s);
+}
+
+Aln_Stream *Open_Aln_Writer(GDB *gdb1, GDB *gdb2, int tspace, int nthreads, OneFile *of)
+{ Aln_Stream *s;
+
+  s = new_stream(gdb1,gdb2,1,CIGAR_OUT,tspace,nthreads,NULL,0,-1);
+  if (s != NULL)
+    { s->of = of;
+      start_stream(s);
+    }
+  return (s);
+}
+
+static void hand_off(Aln_Stream *s)
+{ pthread_mutex_lock(&s->lock);
+  s->nfill += 1;
+  s->open   = 0;
+  pthread_cond_signal(&s->ready);
+  pthread_mutex_unlock(&s->lock);
+}
+
+void Put_Aln_Stream(Aln_Stream *s, Overlap *ovl, uint8 *trace)
+{ Batch *b;
+  int    tlen;
+
+  //  Before starting a batch in a slot, wait for the batch it last held to be output
+
+  if ( ! s->open)
+    { pthread_mutex_lock(&s->lock);
+      while (s->nfill >= s->nout + s->nslot)
+        pthread_cond_wait(&s->freed,&s->lock);
+      pthread_mutex_unlock(&s->lock);
+      s->open = 1;
+    }
+
+  b = s->slot + (s->nfill % s->nslot);
+
+  tlen = ovl->path.tlen;
+  if (b->ttop + tlen > b->tmax)
+    { b->tmax = 1.2*(b->ttop + tlen) + 1000;
+      b->tbuf = Realloc(b->tbuf,b->tmax,"Reallocating stream batch");
+      if (b->tbuf == NULL)
+        exit (1);
+    }
+
+  b->ovls[b->novl] = *ovl;
+  b->ovls[b->novl].flags &= COMP_FLAG;
+  memcpy(b->tbuf + b->ttop,trace,tlen);
+  b->novl += 1;
+  b->ttop += tlen;
+
+  if (b->novl >= b->omax || b->ttop >= BATCH_BYTES)
+    hand_off(s);
+}
+
+int64 Close_Aln_Stream(Aln_Stream *s)
+{ if (s->open)
+    hand_off(s);
+
+  pthread_mutex_lock(&s->lock);
+  s->closed = 1;
+  pthread_cond_broadcast(&s->ready);
+  pthread_cond_signal(&s->formatted);
+  pthread_mutex_unlock(&s->lock);
+
+  return (finish_stream(s));
+}
+
+int64 Output_Aln_File(OneFile *in, int64 novl, GDB *gdb1, GDB *gdb2, int format, int tspace,
+                      int nthreads, FILE *out, int bgzf)
+{ Aln_Stream *s;
+  Worker     *w;
+  int         p;
+
+  s = new_stream(gdb1,gdb2,0,format,tspace,nthreads,out,bgzf,novl);
+
+  for (p = 0; p < nthreads; p++)
+    { w = s->work + p;
+      w->in    = in + p;
+      w->trace = Malloc(2*in->info['T']->given.max,"Allocating trace vector");
+      if (w->trace == NULL)
+        exit (1);
+    }
+
+  s->nfill  = (novl + BATCH_ALNS-1) / BATCH_ALNS;
+  s->closed = 1;
+
+  start_stream(s);
+  return (finish_stream(s));
+}
@@ -0,0 +1,101 @@
+/*******************************************************************************************
+ *
+ *  Alignment output module.  Format alignments as PAF or PSL lines, either one at a time
+ *    with a formatter, or as an ordered stream whose lines are formatted by a pool of threads
+ *    while the caller is still producing alignments or while they are read from a .1aln
+ *    file.  Factored out of ALNtoPAF and ALNtoPSL so that FastGA can stream its output
+ *    straight from its final merge without writing and then re-reading a .1aln file.
+ *
+ *  Author :  agent (agent@local)
+ *  Date   :  October 2026
+ *
+ ********************************************************************************************/
+
+#ifndef _ALNOUT_DEFS
+
+#define _ALNOUT_DEFS
+
+#include <stdio.h>
+
+#include "gene_core.h"
+#include "GDB.h"
+#include "align.h"
+#include "ONElib.h"
+
+#define PAF_OUT   0   //  PAF lines
+#define PAF_M_OUT 1   //  PAF lines with a cg:Z: CIGAR tag of M's, I's, and D's
+#define PAF_X_OUT 2   //  PAF lines with a cg:Z: CIGAR tag of ='s, X's, I's, and D's
+#define PSL_OUT   3   //  PSL lines
+#define CIGAR_OUT 4   //  Just the CIGAR string of ='s, X's, I's, and D's (as for PAF_X_OUT)
+
+  // PAF names a sequence by the first word of its header (PSL by the whole header).
+  //   Trim_GDB_Headers truncates every scaffold header of gdb at its first white space.
+
+void Trim_GDB_Headers(GDB *gdb);
+
+  // A formatter holds the buffers and work space one thread needs to output alignments
+  //   between the contigs of gdb1 and gdb2 (which may be the same) in the given format.
+  //   Unless the format is PAF_OUT, the sequences of both GDBs must be available, and if
+  //   EXTERNAL, the file pointers in gdb1 and gdb2 must be for the sole use of this formatter.
+  //   tspace is the trace spacing of the alignments.
+  // Format_Aln appends the line for ovl, whose trace is a list of path.tlen 8-bit trace
+  //   point values, to the line buffer out.  ovl is not modified.  If cigar is not NULL then
+  //   it is the exact alignment of ovl as a CIGAR string of ='s, X's, I's, and D's (e.g. from
+  //   the C-line of a .1aln file), and the lines are derived from it rather than by computing
+  //   the alignment from the sequences and trace.
+
+typedef struct
+  { GDB       *gdb1;
+    GDB       *gdb2;
+    int        format;
+    int        tspace;
+    Work_Data *work;
+    char      *aseq;    //  contig buffers for gdb1 and gdb2
+    char      *bseq;
+    int        alast;   //  contig of gdb1 currently in aseq (-1 if none)
+    uint16    *trace;   //  16-bit copy of the trace of the current alignment
+    int        tmax;
+  } Aln_Formatter;
+
+Aln_Formatter *New_Aln_Formatter(GDB *gdb1, GDB *gdb2, int format, int tspace);
+void           Free_Aln_Formatter(Aln_Formatter *fmt);
+
+void Format_Aln(Aln_Formatter *fmt, Overlap *ovl, char *cigar, Line_Buffer *out);
+
+  // An alignment stream outputs the alignments given to it with Put_Aln_Stream to out in the
+  //   order given, where the lines are formatted in batches by nthreads threads, each with its
+  //   own formatter, while the caller produces the next alignments, and a further thread
+  //   writes the finished batches to out in order.  At most 2*nthreads batches are held at
+  //   any one time, nothing is written to temporary files, and out may be a pipe.  If bgzf
+  //   is set the output is compressed in the blocked gzip format of bgzip.  The trace of ovl
+  //   is given separately as trace (path.trace of ovl is ignored), and both are copied so
+  //   the caller may reuse them on return.  Close_Aln_Stream outputs any remaining lines,
+  //   frees the stream, and returns the number of bytes output.  Open_Aln_Stream returns
+  //   NULL (after reporting why to stderr) if it cannot open the copies of EXTERNAL sequence
+  //   files that its threads require.
+
+typedef struct Aln_Stream Aln_Stream;
+
+Aln_Stream *Open_Aln_Stream(GDB *gdb1, GDB *gdb2, int format, int tspace, int nthreads,
+                            FILE *out, int bgzf);
+void        Put_Aln_Stream(Aln_Stream *stream, Overlap *ovl, uint8 *trace);
+int64       Close_Aln_Stream(Aln_Stream *stream);
+
+  // Open_Aln_Writer opens a stream whose alignments are instead written in order to the .1aln
+  //   file of (as opened by open_Aln_Write), each with a C-line giving its exact alignment as
+  //   a CIGAR string of ='s, X's, I's, and D's computed by the stream's threads.  The sequences
+  //   of both GDBs must be available.  Close_Aln_Stream returns the total length of the
+  //   CIGAR strings (plus one per alignment), and does not close of.
+
+Aln_Stream *Open_Aln_Writer(GDB *gdb1, GDB *gdb2, int tspace, int nthreads, OneFile *of);
+
+  // Output_Aln_File outputs all novl alignments of a .1aln file to out in the same way, using
+  //   the C-line of an alignment in place of computing its alignment when it has one, where
+  //   thread p reads its batches itself from in[p], one of nthreads readers opened with
+  //   open_Aln_Read, and formats them with gdb1[p] and gdb2[p], whose EXTERNAL file pointers
+  //   must be for its sole use.  It returns the number of bytes output.
+
+int64 Output_Aln_File(OneFile *in, int64 novl, GDB *gdb1, GDB *gdb2, int format, int tspace,
+                      int nthreads, FILE *out, int bgzf);
+
+#endif // _ALNOUT_DEFS
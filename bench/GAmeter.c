@@ -0,0 +1,158 @@
+/********************************************************************************************
+ *
+ *  Run a command and append one tab-separated line of its resource usage to a file:
+ *
+ *      <label> <wall secs> <user secs> <sys secs> <peak RSS KB> <peak temp bytes> <status>
+ *
+ *  The peak RSS is that of the largest process in the command's process tree (as given by
+ *    getrusage of the reaped children), and the peak temp bytes is the largest excess, over
+ *    its value when the command started, of the space used on the file system holding the
+ *    temporary directory given by -P, sampled every -i milliseconds.  The file system is
+ *    measured rather than the directory as FastGA unlinks many of its temporary files as soon
+ *    as they are opened.  The command's exit status is also GAmeter's.
+ *
+ *  Author:  agent (agent@local)
+ *  Date  :  October 2026
+ *
+ ********************************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/statvfs.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "gene_core.h"
+
+static char *Usage = "[-v] [-P<dir(/tmp)>] [-i<int(100)>] -o<file> <label> <command> [<arg> ...]";
+
+//  Bytes in use on the file system holding directory dir
+
+static int64 used_bytes(char *dir)
+{ struct statvfs fs;
+
+  if (statvfs(dir,&fs) < 0)
+    return (0);
+  return ((int64) (fs.f_blocks - fs.f_bfree) * fs.f_frsize);
+}
+
+int main(int argc, char *argv[])
+{ int   VERBOSE;
+  char *TEMP;
+  char *OUTPUT;
+  int   INTERVAL;
+
+  //  Process arguments up to the command
+
+  { int   i, k;
+    int   flags[128];
+    char *eptr;
+
+    ARG_INIT("GAmeter")
+
+    TEMP     = "/tmp";
+    OUTPUT   = NULL;
+    INTERVAL = 100;
+
+    for (i = 1; i < argc; i++)
+      if (argv[i][0] != '-')
+        break;
+      else
+        switch (argv[i][1])
+        { default:
+            ARG_FLAGS("v")
+            break;
+          case 'P':
+            TEMP = argv[i]+2;
+            break;
+          case 'o':
+            OUTPUT = argv[i]+2;
+            break;
+          case 'i':
+            ARG_POSITIVE(INTERVAL,"sampling interval")
+            break;
+        }
+
+    VERBOSE = flags['v'];
+
+    if (argc-i < 2 || OUTPUT == NULL || *OUTPUT == '\0')
+      { fprintf(stderr,"Usage: %s %s\n",Prog_Name,Usage);
+        fprintf(stderr,"\n");
+        fprintf(stderr,"      -v: Verbose mode, also output the usage line to stderr\n");
+        fprintf(stderr,"      -P: Temporary directory whose file system's growth is measured\n");
+        fprintf(stderr,"      -i: Sampling interval in milliseconds\n");
+        fprintf(stderr,"      -o: File to which the usage line is appended\n");
+        exit (1);
+      }
+
+    argv += i;
+    argc -= i;
+  }
+
+  { struct timespec start, stop, nap;
+    struct rusage   usage;
+    int64  base, peak, now;
+    pid_t  pid;
+    int    status;
+    FILE  *output;
+    double wall;
+
+    base = used_bytes(TEMP);
+    peak = 0;
+
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    pid = fork();
+    if (pid < 0)
+      { fprintf(stderr,"%s: Could not fork %s\n",Prog_Name,argv[1]);
+        exit (1);
+      }
+    if (pid == 0)
+      { execvp(argv[1],argv+1);
+        fprintf(stderr,"%s: Could not execute %s\n",Prog_Name,argv[1]);
+        _exit (127);
+      }
+
+    nap.tv_sec  = INTERVAL / 1000;
+    nap.tv_nsec = (INTERVAL % 1000) * 1000000;
+    while (waitpid(pid,&status,WNOHANG) == 0)
+      { now = used_bytes(TEMP) - base;
+        if (now > peak)
+          peak = now;
+        nanosleep(&nap,NULL);
+      }
+    clock_gettime(CLOCK_MONOTONIC,&stop);
+    getrusage(RUSAGE_CHILDREN,&usage);
+
+    if (WIFEXITED(status))
+      status = WEXITSTATUS(status);
+    else
+      status = 128 + WTERMSIG(status);
+
+    wall = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec)/1e9;
+
+    output = Fopen(OUTPUT,"a");
+    if (output == NULL)
+      exit (1);
+    fprintf(output,"%s\t%.3f\t%.3f\t%.3f\t%ld\t%lld\t%d\n",argv[0],wall,
+                   usage.ru_utime.tv_sec + usage.ru_utime.tv_usec/1e6,
+                   usage.ru_stime.tv_sec + usage.ru_stime.tv_usec/1e6,
+                   usage.ru_maxrss,peak,status);
+    fclose(output);
+
+    if (VERBOSE)
+      fprintf(stderr,"%s: %s %.3fw %.3fu %.3fs %ldKB %lldB exit %d\n",Prog_Name,argv[0],wall,
+                     usage.ru_utime.tv_sec + usage.ru_utime.tv_usec/1e6,
+                     usage.ru_stime.tv_sec + usage.ru_stime.tv_usec/1e6,
+                     usage.ru_maxrss,peak,status);
+
+    free(Prog_Name);
+    free(Command_Line);
+
+    exit (status);
+  }
+}
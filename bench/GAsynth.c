@@ -0,0 +1,340 @@
+/********************************************************************************************
+ *
+ *  Generate a synthetic pair of genomes for benchmarking FastGA.  Genome A is random
+ *    sequence partitioned into contigs whose lengths are drawn from a log-normal distribution
+ *    with a given mean and coefficient of variation, and that contains a given fraction of
+ *    interspersed copies of a set of repeat families.  Genome B is a copy of A mutated with
+ *    substitutions and short indels at a given rate, with a fraction of its contigs
+ *    reverse-complemented.  The same seed and parameters always give the same genomes.
+ *
+ *  Author:  agent (agent@local)
+ *  Date  :  October 2026
+ *
+ ********************************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "gene_core.h"
+
+static char *Usage[] =
+  { "[-v] [-S<int(1)>] [-g<int(10000000)>] [-c<int(1000000)>] [-s<float(.5)>]",
+    "[-d<float(.05)>] [-r<float(.1)>] [-l<int(300)>] [-f<int(20)>] [-i<float(.25)>]",
+    "<output:path>"
+  };
+
+static unsigned short Seed[3];
+
+static char DNA[4] = { 'a', 'c', 'g', 't' };
+
+static inline int rand_base()
+{ return ((int) (erand48(Seed)*4.)); }
+
+static inline double rand_unit()
+{ return (erand48(Seed)); }
+
+static int64 rand_lognormal(double mean, double cv)
+{ double u, v, s2, mu;
+
+  if (cv <= 0.)
+    return ((int64) mean);
+  s2 = log(1.+cv*cv);
+  mu = log(mean) - .5*s2;
+  u  = rand_unit();
+  v  = rand_unit();
+  if (u < 1e-300)
+    u = 1e-300;
+  return ((int64) exp(mu + sqrt(s2)*sqrt(-2.*log(u))*cos(2.*M_PI*v)));
+}
+
+static int rand_geometric(double mean)
+{ int n;
+
+  n = 1;
+  while (rand_unit() > 1./mean)
+    n += 1;
+  return (n);
+}
+
+//  Write sequence seq[0..len-1] as FASTA entry name to output, complemented if comp is set
+
+static void write_fasta(FILE *output, char *name, char *seq, int64 len, int comp)
+{ static char cmp[128];
+  int64 i;
+  int   w;
+
+  cmp['a'] = 't';
+  cmp['c'] = 'g';
+  cmp['g'] = 'c';
+  cmp['t'] = 'a';
+
+  fprintf(output,">%s\n",name);
+  w = 0;
+  for (i = 0; i < len; i++)
+    { if (comp)
+        fputc(cmp[(int) seq[len-1-i]],output);
+      else
+        fputc(seq[i],output);
+      if (++w == 80)
+        { fputc('\n',output);
+          w = 0;
+        }
+    }
+  if (w > 0)
+    fputc('\n',output);
+}
+
+int main(int argc, char *argv[])
+{ int    VERBOSE;
+  int    SEED;
+  int64  GSIZE;
+  int64  CMEAN;
+  double CVAR;
+  double DIVERGE;
+  double REPEAT;
+  int    RLEN;
+  int    NFAM;
+  double INVERT;
+
+  //  Process arguments
+
+  { int    i, j, k;
+    int    flags[128];
+    char  *eptr;
+    int    x;
+
+    ARG_INIT("GAsynth")
+
+    SEED    = 1;
+    GSIZE   = 10000000;
+    CMEAN   = 1000000;
+    CVAR    = .5;
+    DIVERGE = .05;
+    REPEAT  = .1;
+    RLEN    = 300;
+    NFAM    = 20;
+    INVERT  = .25;
+
+    j = 1;
+    for (i = 1; i < argc; i++)
+      if (argv[i][0] == '-')
+        switch (argv[i][1])
+        { default:
+            ARG_FLAGS("v")
+            break;
+          case 'S':
+            ARG_NON_NEGATIVE(SEED,"random seed")
+            break;
+          case 'g':
+            ARG_POSITIVE(x,"genome size")
+            GSIZE = x;
+            break;
+          case 'c':
+            ARG_POSITIVE(x,"mean contig length")
+            CMEAN = x;
+            break;
+          case 's':
+            ARG_REAL(CVAR)
+            if (CVAR < 0.)
+              { fprintf(stderr,"%s: Contig length CV must be non-negative\n",Prog_Name);
+                exit (1);
+              }
+            break;
+          case 'd':
+            ARG_REAL(DIVERGE)
+            if (DIVERGE < 0. || DIVERGE > .5)
+              { fprintf(stderr,"%s: Divergence must be in [0,.5]\n",Prog_Name);
+                exit (1);
+              }
+            break;
+          case 'r':
+            ARG_REAL(REPEAT)
+            if (REPEAT < 0. || REPEAT > .9)
+              { fprintf(stderr,"%s: Repeat fraction must be in [0,.9]\n",Prog_Name);
+                exit (1);
+              }
+            break;
+          case 'l':
+            ARG_POSITIVE(RLEN,"repeat length")
+            break;
+          case 'f':
+            ARG_POSITIVE(NFAM,"# of repeat families")
+            break;
+          case 'i':
+            ARG_REAL(INVERT)
+            if (INVERT < 0. || INVERT > 1.)
+              { fprintf(stderr,"%s: Inverted contig fraction must be in [0,1]\n",Prog_Name);
+                exit (1);
+              }
+            break;
+        }
+      else
+        argv[j++] = argv[i];
+    argc = j;
+
+    VERBOSE = flags['v'];
+
+    if (argc != 2)
+      { fprintf(stderr,"\nUsage: %s %s\n",Prog_Name,Usage[0]);
+        fprintf(stderr,"       %*s %s\n",(int) strlen(Prog_Name),"",Usage[1]);
+        fprintf(stderr,"       %*s %s\n",(int) strlen(Prog_Name),"",Usage[2]);
+        fprintf(stderr,"\n");
+        fprintf(stderr,"      -v: Verbose mode, report what was generated\n");
+        fprintf(stderr,"      -S: Seed for the random number generator\n");
+        fprintf(stderr,"      -g: Size of genome A in bases\n");
+        fprintf(stderr,"      -c: Mean contig length\n");
+        fprintf(stderr,"      -s: Coefficient of variation of contig length (0 => fixed)\n");
+        fprintf(stderr,"      -d: Divergence of B from A (90%% substitutions, 10%% indels)\n");
+        fprintf(stderr,"      -r: Fraction of A that is interspersed repeats\n");
+        fprintf(stderr,"      -l: Length of a repeat element\n");
+        fprintf(stderr,"      -f: Number of repeat families (copies diverge 10%% from their family)\n");
+        fprintf(stderr,"      -i: Fraction of B's contigs that are reverse complemented\n");
+        fprintf(stderr,"\n");
+        fprintf(stderr,"   Writes <output>_A.fa and <output>_B.fa\n");
+        exit (1);
+      }
+
+    Seed[0] = 0x330e;
+    Seed[1] = SEED & 0xffff;
+    Seed[2] = (SEED >> 16) & 0xffff;
+  }
+
+  { char  **family;
+    char   *aseq, *bseq;
+    int64   amax, bmax;
+    FILE   *afile, *bfile;
+    double  rprob;
+    int64   total, clen, alen, blen;
+    int64   i;
+    int     f, j, n, c, nctg;
+
+    //  Make the repeat families
+
+    family = Malloc(sizeof(char *)*NFAM,"Allocating repeat families");
+    if (family == NULL)
+      exit (1);
+    for (f = 0; f < NFAM; f++)
+      { family[f] = Malloc(RLEN,"Allocating repeat families");
+        if (family[f] == NULL)
+          exit (1);
+        for (j = 0; j < RLEN; j++)
+          family[f][j] = DNA[rand_base()];
+      }
+
+    //  A repeat starts at a unique base with the probability that makes REPEAT the expected
+    //    fraction of repeat bases
+
+    rprob = REPEAT / (RLEN * (1.-REPEAT));
+
+    afile = Fopen(Catenate(argv[1],"_A",".fa",""),"w");
+    bfile = Fopen(Catenate(argv[1],"_B",".fa",""),"w");
+    if (afile == NULL || bfile == NULL)
+      exit (1);
+
+    amax = bmax = 0;
+    aseq = bseq = NULL;
+    nctg  = 0;
+    total = 0;
+    while (total < GSIZE)
+      { clen = rand_lognormal((double) CMEAN,CVAR);
+        if (clen < 1000)
+          clen = 1000;
+        if (clen > GSIZE-total)
+          clen = GSIZE-total;
+        total += clen;
+        nctg  += 1;
+
+        if (clen > amax)
+          { amax = clen;
+            bmax = 2*clen + 1000;
+            aseq = Realloc(aseq,amax,"Allocating contig");
+            bseq = Realloc(bseq,bmax,"Allocating contig");
+            if (aseq == NULL || bseq == NULL)
+              exit (1);
+          }
+
+        //  Contig of A: unique sequence with interspersed diverged repeat copies
+
+        alen = 0;
+        while (alen < clen)
+          if (rand_unit() < rprob)
+            { int comp = (rand_unit() < .5);
+              char *r  = family[(int) (rand_unit()*NFAM)];
+
+              for (j = 0; j < RLEN && alen < clen; j++)
+                { if (rand_unit() < .1)
+                    c = DNA[rand_base()];
+                  else if (comp)
+                    c = DNA[3-(index(DNA,r[RLEN-1-j])-DNA)];
+                  else
+                    c = r[j];
+                  aseq[alen++] = c;
+                }
+            }
+          else
+            aseq[alen++] = DNA[rand_base()];
+
+        //  Contig of B: A mutated at rate DIVERGE
+
+        blen = 0;
+        for (i = 0; i < alen; i++)
+          { if (blen + 100 >= bmax)
+              { bmax = 1.2*bmax + 1000;
+                bseq = Realloc(bseq,bmax,"Allocating contig");
+                if (bseq == NULL)
+                  exit (1);
+              }
+            if (rand_unit() >= DIVERGE)
+              bseq[blen++] = aseq[i];
+            else
+              { double e = rand_unit();
+
+                if (e < .9)
+                  { c = rand_base();
+                    if (DNA[c] == aseq[i])
+                      c = (c+1+(int) (rand_unit()*3)) % 4;
+                    bseq[blen++] = DNA[c];
+                  }
+                else if (e < .95)
+                  { n = rand_geometric(2.);
+                    if (n > 50)
+                      n = 50;
+                    for (j = 0; j < n; j++)
+                      bseq[blen++] = DNA[rand_base()];
+                    bseq[blen++] = aseq[i];
+                  }
+                else
+                  { n = rand_geometric(2.);
+                    i += n-1;
+                  }
+              }
+          }
+
+        write_fasta(afile,Catenate("A_ctg",Numbered_Suffix("",nctg,""),"",""),aseq,alen,0);
+        write_fasta(bfile,Catenate("B_ctg",Numbered_Suffix("",nctg,""),"",""),bseq,blen,
+                    rand_unit() < INVERT);
+      }
+
+    fclose(afile);
+    fclose(bfile);
+
+    free(bseq);
+    free(aseq);
+    for (f = 0; f < NFAM; f++)
+      free(family[f]);
+    free(family);
+
+    if (VERBOSE)
+      fprintf(stderr,"%s: %lld bases in %d contigs written to %s_A.fa and %s_B.fa\n",
+                     Prog_Name,total,nctg,argv[1],argv[1]);
+  }
+
+  Catenate(NULL,NULL,NULL,NULL);
+  Numbered_Suffix(NULL,0,NULL);
+  free(Prog_Name);
+  free(Command_Line);
+
+  exit (0);
+}
@@ -0,0 +1,218 @@
+/********************************************************************************************
+ *
+ *  Time the construction of, and lookups in, a hash table of scaffold names with the
+ *    open-addressing table of hash.c against the chained table it replaced (hash_chain.c).
+ *
+ *  A block of -n synthetic scaffold headers, each a name followed by a description, is
+ *    laid out as in a GDB.  Each table is built as ALNshow and GDBshow do, i.e. by looking
+ *    up and then adding each name (the names are 0-terminated in a copy of the block first,
+ *    which is not timed), the new table both with and without keeping its strings.  (The
+ *    chained table is not built with keep set as its string array moved under the pointers
+ *    of its earlier entries when it grew.)  The new table is also built in one call by
+ *    New_Hash_Block directly over the headers.  Then every name is looked up -r times in a random order,
+ *    interleaved with as many names that are not in the table.  One tab-separated line
+ *    is output per table and method:
+ *
+ *      <table> <method> <names> <build secs> <lookup secs> <lookups/sec>
+ *
+ *  Author:  agent (agent@local)
+ *  Date  :  October 2026
+ *
+ ********************************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "GDB.h"
+#include "hash.h"
+#include "hash_chain.h"
+
+static char *Usage = "[-v] [-n<int(1000000)>] [-r<int(3)>] [-s<int(1)>]";
+
+static double now()
+{ struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return (t.tv_sec + t.tv_nsec/1e9);
+}
+
+static uint64 Seed;
+
+static uint64 rand64()
+{ Seed ^= Seed << 13;
+  Seed ^= Seed >> 7;
+  Seed ^= Seed << 17;
+  return (Seed);
+}
+
+int main(int argc, char *argv[])
+{ int   VERBOSE;
+  int   NAMES;
+  int   ROUNDS;
+  int   SEED;
+
+  { int   i, j, k;
+    int   flags[128];
+    char *eptr;
+
+    ARG_INIT("HASHbench")
+
+    NAMES  = 1000000;
+    ROUNDS = 3;
+    SEED   = 1;
+
+    j = 1;
+    for (i = 1; i < argc; i++)
+      if (argv[i][0] == '-')
+        switch (argv[i][1])
+        { default:
+            ARG_FLAGS("v")
+            break;
+          case 'n':
+            ARG_POSITIVE(NAMES,"number of names")
+            break;
+          case 'r':
+            ARG_POSITIVE(ROUNDS,"lookup rounds")
+            break;
+          case 's':
+            ARG_POSITIVE(SEED,"random seed")
+            break;
+        }
+      else
+        argv[j++] = argv[i];
+    argc = j;
+
+    VERBOSE = flags['v'];
+
+    if (argc != 1)
+      { fprintf(stderr,"Usage: %s %s\n",Prog_Name,Usage);
+        fprintf(stderr,"\n");
+        fprintf(stderr,"      -v: Verbose mode, report each build and lookup run as it starts\n");
+        fprintf(stderr,"      -n: Number of scaffold names\n");
+        fprintf(stderr,"      -r: Number of rounds of lookups of every name\n");
+        fprintf(stderr,"      -s: Random seed for the names and lookup order\n");
+        exit (1);
+      }
+
+    Seed = 0x9e3779b97f4a7c15ull * SEED;
+  }
+
+  { GDB_SCAFFOLD *scaffs;
+    char         *block, *names, *misses;
+    int64        *moff;
+    int          *order;
+    int64         hlen, o;
+    int           i, j, n, dup;
+    Hash_Table   *hash;
+    double        t0, build, look;
+    int           keep, found;
+
+    //  Make the headers block: alternately draft-assembly accession names and
+    //    scaffold_<n> names, each followed by a description, and the names not in it
+
+    block  = Malloc(NAMES*64,"Allocating headers");
+    misses = Malloc(NAMES*32,"Allocating misses");
+    scaffs = Malloc(NAMES*sizeof(GDB_SCAFFOLD),"Allocating scaffolds");
+    moff   = Malloc(NAMES*sizeof(int64),"Allocating misses");
+    order  = Malloc(NAMES*sizeof(int),"Allocating lookup order");
+    if (block == NULL || misses == NULL || scaffs == NULL || moff == NULL || order == NULL)
+      exit (1);
+
+    hlen = 0;
+    o    = 0;
+    for (i = 0; i < NAMES; i++)
+      { scaffs[i].hoff = hlen;
+        if (i % 2 == 0)
+          hlen += sprintf(block+hlen,"JAKVLN01%07d.1 Homo sapiens isolate %d scaffold",i,i%97) + 1;
+        else
+          hlen += sprintf(block+hlen,"scaffold_%d length=%llu",i,rand64() % 1000000) + 1;
+        moff[i] = o;
+        o += sprintf(misses+o,"%s_%d",(i%2 == 0) ? "JAKVLN02" : "contig",i) + 1;
+        order[i] = i;
+      }
+    for (i = NAMES-1; i > 0; i--)
+      { j = rand64() % (i+1);
+        n = order[i];
+        order[i] = order[j];
+        order[j] = n;
+      }
+
+    names = Malloc(hlen,"Allocating names");
+    if (names == NULL)
+      exit (1);
+    memcpy(names,block,hlen);
+    for (i = 0; i < NAMES; i++)
+      *index(names+scaffs[i].hoff,' ') = '\0';
+
+    printf("table\tmethod\tnames\tbuild\tlookup\tlookups_per_sec\n");
+
+#define LOOKUPS(lookup)								\
+    if (VERBOSE)								\
+      fprintf(stderr,"  Looking up with %s\n",#lookup);				\
+    t0 = now();									\
+    found = 0;									\
+    for (n = 0; n < ROUNDS; n++)						\
+      for (i = 0; i < NAMES; i++)						\
+        { if (lookup(hash,names+scaffs[order[i]].hoff) == order[i])		\
+            found += 1;								\
+          if (lookup(hash,misses+moff[order[i]]) < 0)				\
+            found += 1;								\
+        }									\
+    look = now() - t0;								\
+    if (found != 2*ROUNDS*NAMES)						\
+      { fprintf(stderr,"%s: %s lookups failed\n",Prog_Name,#lookup);		\
+        exit (1);								\
+      }
+
+    if (VERBOSE)
+      fprintf(stderr,"  Building chained table of %d names\n",NAMES);
+    t0   = now();
+    hash = Chain_New_Hash_Table(NAMES,0);
+    for (i = 0; i < NAMES; i++)
+      if (Chain_Hash_Lookup(hash,names+scaffs[i].hoff) < 0)
+        Chain_Hash_Add(hash,names+scaffs[i].hoff);
+    build = now() - t0;
+    LOOKUPS(Chain_Hash_Lookup)
+    printf("chain\tadd\t%d\t%.3f\t%.3f\t%.0f\n",NAMES,build,look,2.*ROUNDS*NAMES/look);
+    Chain_Free_Hash_Table(hash);
+
+    for (keep = 0; keep <= 1; keep++)
+      { if (VERBOSE)
+          fprintf(stderr,"  Building open table of %d names%s\n",NAMES,keep?", keeping strings":"");
+        t0   = now();
+        hash = New_Hash_Table(NAMES,keep);
+        for (i = 0; i < NAMES; i++)
+          if (Hash_Lookup(hash,names+scaffs[i].hoff) < 0)
+            Hash_Add(hash,names+scaffs[i].hoff);
+        build = now() - t0;
+        LOOKUPS(Hash_Lookup)
+        printf("open\tadd%s\t%d\t%.3f\t%.3f\t%.0f\n",keep?"+keep":"",NAMES,build,look,
+                                                     2.*ROUNDS*NAMES/look);
+        Free_Hash_Table(hash);
+      }
+
+    if (VERBOSE)
+      fprintf(stderr,"  Building open table of %d names from the headers block\n",NAMES);
+    t0   = now();
+    hash = New_Hash_Block(block,NAMES,&scaffs[0].hoff,sizeof(GDB_SCAFFOLD),&dup);
+    build = now() - t0;
+    if (dup >= 0)
+      { fprintf(stderr,"%s: Duplicate name %d in block\n",Prog_Name,dup);
+        exit (1);
+      }
+    LOOKUPS(Hash_Lookup)
+    printf("open\tblock\t%d\t%.3f\t%.3f\t%.0f\n",NAMES,build,look,2.*ROUNDS*NAMES/look);
+    Free_Hash_Table(hash);
+
+    free(names);
+    free(order);
+    free(moff);
+    free(scaffs);
+    free(misses);
+    free(block);
+  }
+
+  exit (0);
+}
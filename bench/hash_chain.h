@@ -0,0 +1,26 @@
+/*****************************************************************************************\
+*                                                                                         *
+*  The former chained-bucket Hash Table (see hash_chain.c), for comparison in HASHbench.  *
+*    The routines behave as those of the same name, less the Chain_ prefix, in hash.h.    *
+*                                                                                         *
+\*****************************************************************************************/
+
+#ifndef _HASH_CHAIN
+
+#define _HASH_CHAIN
+
+#include "hash.h"
+
+Hash_Table *Chain_New_Hash_Table(int size, int keep);
+void        Chain_Clear_Hash_Table(Hash_Table *table);
+void        Chain_Free_Hash_Table(Hash_Table *table);
+
+int Chain_Hash_Lookup(Hash_Table *table, char *entry);
+int Chain_Hash_Add(Hash_Table *table, char *entry);
+
+int   Chain_Get_Hash_Size(Hash_Table *table);
+char *Chain_Get_Hash_String(Hash_Table *table, int i);
+
+void Chain_Print_Hash_Table(FILE *file, Hash_Table *table);
+
+#endif
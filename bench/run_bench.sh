@@ -0,0 +1,83 @@
+#!/bin/bash
+#
+#  Benchmark GIXmake and FastGA on the synthetic genome pairs of a suite.
+#
+#  Usage: run_bench.sh [-T<int(8)>] [-P<dir(/tmp)>] [-s<suite(suite.tsv)>] [-o<dir(results/<date>)>]
+#
+#  Each line of the suite gives a name, random seed, genome size, mean contig length, contig
+#    length CV, divergence, and repeat fraction for GAsynth.  The pair is generated once into
+#    data/ and reused.  For each pair, GIXmake is run on both genomes and then FastGA on the
+#    resulting indices, each under GAmeter.  Two tab-separated files are written to the
+#    output directory:
+#
+#      runs.tsv:    label wall user sys peak_rss_kb peak_temp_bytes status
+#      phases.tsv:  label phase wall user sys     (from FastGA's -v phase reports)
+#
+#  along with the logs, PAF output, and -stats records (<name>.stats.tsv) of each FastGA run.
+
+BENCH=$(cd "$(dirname "$0")" && pwd)
+PATH="$BENCH/..:$BENCH:$PATH"
+
+THREADS=8
+TEMP=/tmp
+SUITE=$BENCH/suite.tsv
+OUT=$BENCH/results/$(date +%Y%m%d-%H%M%S)
+
+for arg in "$@"
+do case "$arg" in
+     -T*) THREADS=${arg#-T} ;;
+     -P*) TEMP=${arg#-P} ;;
+     -s*) SUITE=${arg#-s} ;;
+     -o*) OUT=${arg#-o} ;;
+     *)   echo "Usage: run_bench.sh [-T<int(8)>] [-P<dir(/tmp)>] [-s<suite>] [-o<dir>]" >&2
+          exit 1 ;;
+   esac
+done
+
+mkdir -p "$OUT" "$BENCH/data" || exit 1
+printf "label\twall\tuser\tsys\tpeak_rss_kb\tpeak_temp_bytes\tstatus\n" > "$OUT/runs.tsv"
+printf "label\tphase\twall\tuser\tsys\n" > "$OUT/phases.tsv"
+
+#  Convert the "Resources for phase" reports of a -v log into phases.tsv lines, naming each
+#    phase by the last heading seen before it.  Times are either s.mmm or m:ss.mmm.
+
+phases()
+{ tr '\r' '\n' < "$2" | awk -v label="$1" '
+    function secs(t)
+      { sub(/[usw]$/,"",t)
+        if (split(t,p,":") == 2)
+          return (p[1]*60 + p[2])
+        return (t+0)
+      }
+    /Creating genome data base/           { phase = "gdb_build" }
+    /Creating genome index/               { phase = "gix_build" }
+    /Starting adaptive seed merge/        { phase = "adaptamer_merge" }
+    /Starting seed sort and alignment/    { phase = "seed_search_and_la_merge" }
+    /Resources for phase:/                { printf "%s\t%s\t%.3f\t%.3f\t%.3f\n",
+                                                   label,phase,secs($6),secs($4),secs($5) }
+  ' >> "$OUT/phases.tsv"
+}
+
+grep -v '^#' "$SUITE" | while read -r name seed size cmean cvar div rep
+do [ -z "$name" ] && continue
+   data=$BENCH/data/${name}
+   if [ ! -e "${data}_A.fa" ] || [ ! -e "${data}_B.fa" ]
+   then GAsynth -v -S"$seed" -g"$size" -c"$cmean" -s"$cvar" -d"$div" -r"$rep" "$data" || exit 1
+   fi
+   GIXrm -fg "${data}_A" "${data}_B" > /dev/null 2>&1
+
+   for g in A B
+   do GAmeter -P"$TEMP" -o"$OUT/runs.tsv" "$name/GIXmake_$g" \
+              GIXmake -v -T"$THREADS" -P"$TEMP" "${data}_$g.fa" 2> "$OUT/$name.GIXmake_$g.log"
+   done
+
+   GAmeter -P"$TEMP" -o"$OUT/runs.tsv" "$name/FastGA" \
+           FastGA -v -T"$THREADS" -P"$TEMP" -stats:"$OUT/$name.stats.tsv" "${data}_A" "${data}_B" \
+           > "$OUT/$name.paf" 2> "$OUT/$name.FastGA.log"
+   phases "$name/FastGA" "$OUT/$name.FastGA.log"
+
+   GIXrm -fg "${data}_A" "${data}_B" > /dev/null 2>&1
+   echo "  $name: $(wc -l < "$OUT/$name.paf") alignments"
+done
+
+echo "Results in $OUT"
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <zlib.h>
@@ -249,6 +250,222 @@ int  Number_Digits(int64 num)
 }
 
 
+/*******************************************************************************************
+ *
+ *  LINE BUILDER
+ *
+ ********************************************************************************************/
+
+static char Digit_Pairs[201] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+static uint64 Power10[10] =
+  { 1ll, 10ll, 100ll, 1000ll, 10000ll, 100000ll, 1000000ll, 10000000ll, 100000000ll,
+    1000000000ll
+  };
+
+//  Place the decimal digits of u just before end, returning how many there are
+
+static int digits_of(uint64 u, char *end)
+{ char *s = end;
+  int   r;
+
+  while (u >= 100)
+    { r = (u % 100) << 1;
+      u /= 100;
+      *--s = Digit_Pairs[r+1];
+      *--s = Digit_Pairs[r];
+    }
+  if (u >= 10)
+    { r = u << 1;
+      *--s = Digit_Pairs[r+1];
+      *--s = Digit_Pairs[r];
+    }
+  else
+    *--s = (char) ('0' + u);
+  return (end-s);
+}
+
+void Line_Init(Line_Buffer *line)
+{ line->text = NULL;
+  line->len  = 0;
+  line->max  = 0;
+}
+
+void Line_Free(Line_Buffer *line)
+{ free(line->text);
+  Line_Init(line);
+}
+
+void Line_Room(Line_Buffer *line, int64 n)
+{ if (line->len + n > line->max)
+    { line->max  = 1.2*(line->len + n) + 1000;
+      line->text = (char *) Realloc(line->text,line->max,"Reallocating line buffer");
+      if (line->text == NULL)
+        exit (1);
+    }
+}
+
+void Line_Write(Line_Buffer *line, FILE *out)
+{ if (line->len > 0)
+    fwrite(line->text,1,line->len,out);
+  line->len = 0;
+}
+
+void Line_Char(Line_Buffer *line, int c)
+{ if (line->len >= line->max)
+    Line_Room(line,1);
+  line->text[line->len++] = (char) c;
+}
+
+void Line_String(Line_Buffer *line, char *s)
+{ int64 n = strlen(s);
+
+  Line_Room(line,n);
+  memcpy(line->text+line->len,s,n);
+  line->len += n;
+}
+
+void Line_Padded(Line_Buffer *line, int64 num, int width, int zero)
+{ char   buf[24], *t;
+  uint64 u;
+  int    n, neg, pad;
+
+  neg = (num < 0);
+  if (neg)
+    u = - (uint64) num;
+  else
+    u = num;
+  n   = digits_of(u,buf+24);
+  pad = width - (n+neg);
+  if (pad < 0)
+    pad = 0;
+
+  Line_Room(line,n+neg+pad);
+  t = line->text + line->len;
+  if (zero)
+    { if (neg)
+        *t++ = '-';
+      memset(t,'0',pad);
+      t += pad;
+    }
+  else
+    { memset(t,' ',pad);
+      t += pad;
+      if (neg)
+        *t++ = '-';
+    }
+  memcpy(t,buf+24-n,n);
+  line->len = (t+n) - line->text;
+}
+
+void Line_Int(Line_Buffer *line, int64 num)
+{ char  *t;
+  uint64 u;
+
+  if (line->len + 21 > line->max)
+    Line_Room(line,21);
+  t = line->text + line->len;
+  if (num < 0)
+    { *t++ = '-';
+      u = - (uint64) num;
+    }
+  else
+    u = num;
+  if (u < 10)
+    *t++ = (char) ('0' + u);
+  else
+    { char buf[24];
+      int  n = digits_of(u,buf+24);
+
+      memcpy(t,buf+24-n,n);
+      t += n;
+    }
+  line->len = t - line->text;
+}
+
+//  The value is scaled to an integer of prec decimal places and rounded.  When the scaled
+//    value is so large, or so close to a rounding tie, that the product's error could matter,
+//    printf is used to get exactly its conversion of the true binary value.
+
+void Line_Fixed(Line_Buffer *line, double x, int width, int prec)
+{ char   buf[64], *t;
+  double v, f;
+  uint64 u, ip, fp;
+  int    n, neg, pad;
+
+  if (prec < 0 || prec > 9 || !(fabs(x) < 1e9))
+    goto slow;
+  v = fabs(x) * Power10[prec];
+  if (v >= 1e9)
+    goto slow;
+  u = (uint64) v;
+  f = v - u;
+  if (f > .499999 && f < .500001)
+    goto slow;
+  if (f > .5)
+    u += 1;
+
+  ip  = u / Power10[prec];
+  fp  = u % Power10[prec];
+  t   = buf+64;
+  if (prec > 0)
+    { n = digits_of(fp,t);
+      t -= n;
+      while (n++ < prec)
+        *--t = '0';
+      *--t = '.';
+    }
+  t  -= digits_of(ip,t);
+  neg = (signbit(x) != 0);
+  if (neg)
+    *--t = '-';
+  n   = (buf+64) - t;
+  pad = width - n;
+  if (pad < 0)
+    pad = 0;
+
+  Line_Room(line,n+pad);
+  memset(line->text+line->len,' ',pad);
+  memcpy(line->text+line->len+pad,t,n);
+  line->len += n+pad;
+  return;
+
+slow:
+  snprintf(buf,64,"%*.*f",width,prec,x);
+  Line_String(line,buf);
+}
+
+void Line_Number(Line_Buffer *line, int64 num, int width)
+{ char  buf[32], *t, *e;
+  int   n, pad;
+
+  if (num < 1000ll)
+    { Line_Padded(line,num,width,0);
+      return;
+    }
+
+  e = buf+32;
+  t = e - digits_of(num,e);
+  for (n = 3; n <= 11 && e-n > t; n += 4)     //  at most 3 commas, as Print_Number
+    { memmove(t-1,t,(e-n)-t);
+      t -= 1;
+      e[-n-1] = COMMA;
+    }
+  n   = (buf+32) - t;
+  pad = width - n;
+  if (pad < 0)
+    pad = 0;
+
+  Line_Room(line,n+pad);
+  memset(line->text+line->len,' ',pad);
+  memcpy(line->text+line->len+pad,t,n);
+  line->len += n+pad;
+}
+
+
 /*******************************************************************************************
  *
  *  READ AND ARROW COMPRESSION/DECOMPRESSION UTILITIES
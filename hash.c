@@ -5,225 +5,207 @@
 *  Author:  Gene Myers                                                                    *
 *  Date  :  March 2006                                                                    *
 *                                                                                         *
+*  Open addressing with linear probing over a power-of-two vector of slots, each holding   *
+*    a 32-bit hash tag and the index of its entry, so that a probe only touches a string   *
+*    when the tags match.  The strings of a table that keeps them are in a single arena     *
+*    and are referred to by offset, so the arena can grow without invalidating them.        *
+*                                                                                         *
 \*****************************************************************************************/
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
-#include "hash.h"
 #include "gene_core.h"
+#include "hash.h"
 
-/* Hash Table cell or entry, index is implicitly given by position in table->cells array.  */
+/* Hash vector slot: the tag is the 32-bit hash of the entry, whose low bits give its home slot */
 
 typedef struct
-{ int      next;  // hash bucket link
-  char    *text;  // string entry
+{ uint32  tag;   // hash of the entry's string
+  int     idx;   // index of the entry, -1 if the slot is empty
+} Slot;
+
+/* Entry, index is implicitly given by position in table->cells array.  */
+
+typedef struct
+{ union
+    { char  *ptr;  // string entry if not kept
+      int64  off;  //   or its offset in the arena if kept
+    } text;
+  int      len;    // length of the string
 } Entry;
 
 typedef struct
-{ int         veclen;  // size of hash vector
+{ int         vmask;   // size of hash vector - 1 (size is a power of 2)
   int         cntmax;  // current max # of entries
   int         count;   // number of entries in hash table
-  int         strmax;  // current max of string array
-  int         strtop;  // current top of string array
-  int        *vector;  // hash vector
-  Entry      *cells;   // array where hash cells are allocated
-  char       *strings; // array of entry strings
+  int         keep;    // strings are kept in the arena
+  int64       strmax;  // current max of string arena
+  int64       strtop;  // current top of string arena
+  Slot       *vector;  // hash vector
+  Entry      *cells;   // array of entries
+  char       *strings; // arena of entry strings (if keep)
 } Table;
 
-#define CELL_RATIO    .4  // ratio of max # of cells to hash vector length
+#define LOAD_MAX      .5  // max ratio of entries to hash vector slots
 #define STRING_RATIO   6  // expected average entry length (including terminating 0-byte)
 
 #define T(x) ((Table *) x)
 
+#define TEXT(t,c) ((t)->keep ? (t)->strings + (c)->text.off : (c)->text.ptr)
+
 void Free_Hash_Table(Hash_Table *hash_table)
 { Table *table = T(hash_table);
 
+  free(table->strings);
+  free(table->vector);
   free(table->cells);
   free(table);
 }
 
-/* Hash key for a string is xor of each consecutive 3 bytes. */
+/* Hash key of the len bytes at entry: 64-bit FNV-1a folded to 32 bits */
 
-static int hash_key(char *entry)
-{ int i, key, glob;
+static uint32 hash_key(char *entry, int len)
+{ uint64 key;
+  int    i;
 
-  key = 0;
-  glob = 0;
-  for (i = 0; entry[i] != '\0'; i++)
-    { glob = (glob << 8) | entry[i];
-      if (i % 3 == 2)
-        { key = key ^ glob;
-          glob = 0;
-        }
+  key = 0xcbf29ce484222325ll;
+  for (i = 0; i < len; i++)
+    { key ^= (uint8) entry[i];
+      key *= 0x100000001b3ll;
     }
-  if (i % 3 != 0)
-    key = key ^ glob;
-  return (key);
+  return ((uint32) (key ^ (key >> 32)));
 }
 
-/*  Find the next prime larger than size.  Variant of Sieve of Arosthenes:  First
-      time its called computes all primes between 2 and 0xFFFF using the basic
-      sieve algorithm.  With these one builds a sieve for the 0xFFFF numbers from
-      size upwards, using the primes to x-out sieve elements as being non-prime.
-      This will work up to 0x7FFFFFF, beyond the largest positive integer, because 
-      it suffices to sieve against the square root of the largest number in the sieve.   */
-
-static int next_prime(int size)
-{ static int           firstime = 1;
-  static int           Prime[0x4000], Ptop;
-  static unsigned char Sieve[0x10000];
-  int p, q, n;
-
-  if (firstime)
-    { firstime = 0;
-
-      Ptop = 0;
-      for (p = 2; p < 0x10000; p++)
-        Sieve[p] = 1;
-      for (p = 2; p < 0x10000; p++)
-        if (Sieve[p])
-          { for (q = 2*p; q < 0x10000; q += p)
-              Sieve[q] = 0;
-            Prime[Ptop++] = p;
-          }
-    }
+/* Smallest power of 2 vector with at least 1/LOAD_MAX slots per entry for size entries */
 
-  while (size < 0x7FFF0000)
-    { for (q = 0; q < 0x10000; q++)
-        Sieve[q] = 1;
-      for (p = 0; p < Ptop; p++)
-        { n = Prime[p];
-          if (n >= size) break;
-          for (q = ((size-1)/n+1)*n - size; q < 0x10000; q += n)
-            Sieve[q] = 0;
-        }
-      for (q = 0; q < 0x10000; q++)
-        if (Sieve[q])
-          return (size+q);
-      size += 0x10000;
-    }
+static int vector_size(int size)
+{ int vlen;
 
-  return (size);
+  for (vlen = 64; vlen*LOAD_MAX < size; vlen <<= 1)
+    if (vlen >= 0x40000000)
+      break;
+  return (vlen);
 }
 
+/* Return the slot holding the entry equal to the len bytes at entry with hash key, or the
+   empty slot where it would be placed if it is not in the table.                          */
+
+static Slot *find_slot(Table *table, char *entry, int len, uint32 key)
+{ Slot  *vector = table->vector;
+  int    vmask  = table->vmask;
+  Entry *cell;
+  Slot  *s;
+  int    i;
+
+  for (i = key & vmask; 1; i = (i+1) & vmask)
+    { s = vector + i;
+      if (s->idx < 0)
+        return (s);
+      if (s->tag == key)
+        { cell = table->cells + s->idx;
+          if (cell->len == len && memcmp(TEXT(table,cell),entry,len) == 0)
+            return (s);
+        }
+    }
+}
 
 /* Diagnostic output of hash table contents. */
 
 void Print_Hash_Table(FILE *file, Hash_Table *hash_table)
 { Table      *table  = T(hash_table);
-  int        *vector = table->vector;
+  Slot       *vector = table->vector;
   Entry      *cells  = table->cells;
   int         i, c;
 
-  fprintf(file,"\nHASH TABLE %d/%d %d",table->count,table->cntmax,table->veclen);
-  if (table->strmax > 0)
-    fprintf(file," %d/%d",table->strtop,table->strmax);
+  fprintf(file,"\nHASH TABLE %d/%d %d",table->count,table->cntmax,table->vmask+1);
+  if (table->keep)
+    fprintf(file," %lld/%lld",table->strtop,table->strmax);
   fprintf(file,"\n");
-  for (i = 0; i < table->veclen; i++)
-    if ((c = vector[i]) >= 0)
-      { fprintf(file,"  Vector %4d:\n",i);
-        for (; c >= 0; c = cells[c].next)
-          fprintf(file,"    %4d: '%s'\n",c,cells[c].text);
-      }
+  for (i = 0; i <= table->vmask; i++)
+    if ((c = vector[i].idx) >= 0)
+      fprintf(file,"  Slot %4d (home %4d): %4d '%.*s'\n",i,vector[i].tag & table->vmask,
+                   c,cells[c].len,TEXT(table,cells+c));
 }
 
-Hash_Table *New_Hash_Table(int size, int keep)
+static Table *new_table(int size, int keep)
 { Table *table;
-  void  *room;
-  int    vlen, smax;
-  int    i;
+  int    vlen, i;
 
   if (size <= 0)
     { fprintf(stderr,"%s: Table must have > 0 entries (New_Hash_Table)\n",Prog_Name);
       EXIT (NULL);
     }
 
-  vlen = next_prime((int) (size/CELL_RATIO));
-  smax = size*STRING_RATIO;
-
+  vlen  = vector_size(size);
   table = Malloc(sizeof(Table),"Allocating hash table");
+  if (table == NULL)
+    EXIT (NULL);
+  table->vector  = Malloc(vlen*sizeof(Slot),"Allocating hash table");
+  table->cells   = Malloc(size*sizeof(Entry),"Allocating hash table");
+  table->strings = NULL;
   if (keep)
-    room = Malloc(size*sizeof(Entry)+vlen*sizeof(int)+smax,"Allocating hash table");
-  else
-    room = Malloc(size*sizeof(Entry)+vlen*sizeof(int),"Allocating hash table");
-  if (table == NULL || room == NULL)
-    { if (table != NULL)
-        free(table);
-      if (room != NULL)
-        free (room);
+    table->strings = Malloc(size*STRING_RATIO,"Allocating hash table");
+  if (table->vector == NULL || table->cells == NULL || (keep && table->strings == NULL))
+    { Free_Hash_Table(table);
       EXIT (NULL);
     }
 
-  table->cells = (Entry *) room;
-  room += size*sizeof(Entry);
-  table->vector = (int *) room;
-
+  table->vmask  = vlen-1;
   table->cntmax = size;
-  table->veclen = vlen;
-
   table->count  = 0;
+  table->keep   = keep;
+  table->strmax = keep ? size*STRING_RATIO : 0;
+  table->strtop = 0;
   for (i = 0; i < vlen; i++)
-    table->vector[i] = -1;
+    table->vector[i].idx = -1;
 
-  if (keep)
-    { room += vlen*sizeof(int);
-      table->strings = (char *) room;
-      table->strmax  = smax;
-      table->strtop  = 0;
-    }
-  else
-    table->strmax = 0;
-
-  return ((Hash_Table *) table);
+  return (table);
 }
 
-/* Double the size of a hash table
-   while preserving its contents.    */
-
-static int double_hash_table(Table *table)
-{ int   size, vlen, smax;
-  void *room;
+Hash_Table *New_Hash_Table(int size, int keep)
+{ return ((Hash_Table *) new_table(size,keep)); }
 
-  size = 2*table->cntmax;
-  vlen = next_prime((int) (size/CELL_RATIO));
-  smax = (int) (2.1 * table->strtop + 1000);
+/* Double the number of entries a hash table can hold while preserving its contents.
+   The vector is rebuilt from the tags alone, no string is rehashed.                 */
 
-  if (table->strmax > 0)
-    room = Realloc(table->cells,size*sizeof(Entry)+vlen*sizeof(int)+smax,"Expanding hash table");
-  else
-    room = Realloc(table->cells,size*sizeof(Entry)+vlen*sizeof(int),"Expanding hash table");
-  if (room == NULL)
+static int double_hash_table(Table *table)
+{ int    size, vlen, vmask;
+  Slot  *vector, *old;
+  Entry *cells;
+  int    i, j;
+
+  size  = 2*table->cntmax;
+  vlen  = vector_size(size);
+  cells = Realloc(table->cells,size*sizeof(Entry),"Expanding hash table");
+  if (cells == NULL)
     return (1);
-
-  table->cells = (Entry *) room;
-  room += size*sizeof(Entry);
-  table->vector = (int *) room;
-
+  table->cells  = cells;
   table->cntmax = size;
-  table->veclen = vlen;
 
-  if (table->strmax > 0)
-    { room += vlen*sizeof(int);
-      memmove(room,table->strings,table->strtop);
-      table->strings = (char *) room;
-      table->strmax  = smax;
-    }
- 
-  { int   *vector = table->vector;
-    Entry *cells  = table->cells;
-    int    c, key;
-
-    for (c = 0; c < vlen; c++)
-      vector[c] = -1;
-    for (c = 0; c < table->count; c++)
-      { key = hash_key(cells[c].text) % size;
-        cells[c].next = vector[key];
-        vector[key] = c;
+  if (vlen <= table->vmask+1)
+    return (0);
+
+  vector = Malloc(vlen*sizeof(Slot),"Expanding hash table");
+  if (vector == NULL)
+    return (1);
+  vmask = vlen-1;
+  for (j = 0; j < vlen; j++)
+    vector[j].idx = -1;
+
+  old = table->vector;
+  for (i = 0; i <= table->vmask; i++)
+    if (old[i].idx >= 0)
+      { for (j = old[i].tag & vmask; vector[j].idx >= 0; j = (j+1) & vmask)
+          ;
+        vector[j] = old[i];
       }
-  }
+  free(old);
 
+  table->vector = vector;
+  table->vmask  = vmask;
   return (0);
 }
 
@@ -231,72 +213,90 @@ static int double_hash_table(Table *table)
    unique nonnegative id, or -1 if it is not in the table. */
 
 int Hash_Lookup(Hash_Table *hash_table, char *entry)
-{ Table *table = T(hash_table);
-  int    key, chain;
-
-  key   = hash_key(entry) % table->veclen;
-  chain = table->vector[key];
-  while (chain >= 0)
-    { if (strcmp(table->cells[chain].text,entry) == 0)
-        return (chain);
-      chain = table->cells[chain].next;
-    }
-  return (-1);
+{ int len = (int) strlen(entry);
+
+  return (find_slot(T(hash_table),entry,len,hash_key(entry,len))->idx);
 }
 
-/* Add string 'entry' in table 'table' and return its assigned
-   uniqe nonnegative id.  Return -1 if an error occurs in INTERACTIVE mode. */
+/* Add the len bytes at 'entry' to 'table' with hash 'key', copying them to the arena if the
+   table keeps its strings.  Return its index, or -1 if an error occurs in INTERACTIVE mode.  */
 
-int Hash_Add(Hash_Table *hash_table, char *entry)
-{ Table *table = T(hash_table);
-  void  *room;
-  int    smax, vlen, size;
-  int    key, chain, len;
-
-  key   = hash_key(entry) % table->veclen;
-  chain = table->vector[key];
-  while (chain >= 0)
-    { if (strcmp(table->cells[chain].text,entry) == 0)
-        return (chain);
-      chain = table->cells[chain].next;
-    }
+static int add_entry(Table *table, char *entry, int len, uint32 key)
+{ Slot  *s;
+  Entry *cell;
+  int    c;
+
+  s = find_slot(table,entry,len,key);
+  if (s->idx >= 0)
+    return (s->idx);
 
   if (table->count+1 > table->cntmax)
     { if (double_hash_table(table))
         EXIT (-1);
-      key = hash_key(entry) % table->veclen;
+      s = find_slot(table,entry,len,key);
     }
 
-  chain = table->count;
-  table->cells[chain].next = table->vector[key];
-  table->vector[key] = chain;
-
-  if (table->strmax == 0)
-    { table->cells[chain].text = entry;
-      return (table->count++);
+  c    = table->count;
+  cell = table->cells + c;
+  cell->len = len;
+  if ( ! table->keep)
+    cell->text.ptr = entry;
+  else
+    { if (table->strtop + len + 1 > table->strmax)
+        { int64 smax;
+          char *room;
+
+          smax = ((table->strtop+len+1)*1.1*table->cntmax) / (table->count+1) + 1000;
+          room = Realloc(table->strings,smax,"Expanding hash table");
+          if (room == NULL)
+            EXIT (-1);
+          table->strings = room;
+          table->strmax  = smax;
+        }
+      cell->text.off = table->strtop;
+      memcpy(table->strings + table->strtop,entry,len);
+      table->strings[table->strtop+len] = '\0';
+      table->strtop += len+1;
     }
 
-  len = (int) (strlen(entry) + 1);
-  if (table->strtop + len > table->strmax)
-    { smax = ((table->strtop+len)*1.1*table->cntmax) / (table->count+1) + 1000;
-      vlen = table->veclen;
-      size = table->cntmax;
+  s->tag = key;
+  s->idx = c;
+  return (table->count++);
+}
 
-      room = Realloc(table->cells,size*sizeof(Entry)+vlen*sizeof(int)+smax,"Expanding hash table");
-      if (room == NULL)
-        EXIT (-1);
+/* Add string 'entry' in table 'table' and return its assigned
+   uniqe nonnegative id.  Return -1 if an error occurs in INTERACTIVE mode. */
+
+int Hash_Add(Hash_Table *hash_table, char *entry)
+{ int len = (int) strlen(entry);
 
-      table->cells = (Entry *) room;
-      room += size*sizeof(Entry);
-      table->vector = (int *) room;
-      room += vlen*sizeof(int);
-      table->strings = room;
-      table->strmax = smax;
+  return (add_entry(T(hash_table),entry,len,hash_key(entry,len)));
+}
+
+/* Build a table of the names at block + offs[i*stride] in one pass, where a name
+   ends at its first white-space or 0-byte.  The names are not copied.             */
+
+Hash_Table *New_Hash_Block(char *block, int n, int64 *offs, int stride, int *dup)
+{ Table  *table;
+  char   *name;
+  int     i, len;
+
+  *dup  = -1;
+  table = new_table(n > 0 ? n : 1,0);
+  if (table == NULL)
+    EXIT (NULL);
+
+  for (i = 0; i < n; i++)
+    { name = block + *((int64 *) (((char *) offs) + ((int64) i)*stride));
+      for (len = 0; name[len] != '\0' && ! isspace(name[len]); len++)
+        ;
+      if (add_entry(table,name,len,hash_key(name,len)) != i)
+        { *dup = i;
+          break;
+        }
     }
-  strcpy(table->strings + table->strtop, entry);
-  table->cells[chain].text = table->strings + table->strtop;
-  table->strtop += len;
-  return (table->count++);
+
+  return ((Hash_Table *) table);
 }
 
 /* Return the current # of entries in the hash table. */
@@ -307,7 +307,10 @@ int Get_Hash_Size(Hash_Table *hash_table)
 /* Return the string with unique id i in table. */
 
 char *Get_Hash_String(Hash_Table *hash_table, int i)
-{ return (T(hash_table)->cells[i].text); }
+{ Table *table = T(hash_table);
+
+  return (TEXT(table,table->cells+i));
+}
 
 /* Clear the contents of hash table, reseting it to be empty. */
 
@@ -317,6 +320,6 @@ void Clear_Hash_Table(Hash_Table *hash_table)
 
   table->count  = 0;
   table->strtop = 0;
-  for (i = 0; i < table->veclen; i++)
-    table->vector[i] = -1;
+  for (i = 0; i <= table->vmask; i++)
+    table->vector[i].idx = -1;
 }
@@ -28,6 +28,18 @@ Hash_Table *New_Hash_Table(int size, int keep);
 void        Clear_Hash_Table(Hash_Table *table);
 void        Free_Hash_Table(Hash_Table *table);
 
+  //  New_Hash_Block:
+  //    Create a hash table of the n names at block + *offs, block + *(offs+stride bytes), ...,
+  //    e.g. New_Hash_Block(gdb->headers,gdb->nscaff,&gdb->scaffolds[0].hoff,
+  //    sizeof(GDB_SCAFFOLD),&dup) for the scaffold names of a GDB.  A name ends at its first
+  //    white-space or 0-byte and is not copied, so the block must persist while the table is
+  //    in use, and Get_Hash_String gives a pointer to the name in the block.  The i'th name
+  //    gets index i.  If a name is the same as an earlier one, then building stops and *dup
+  //    is set to its index, otherwise *dup is -1.  NULL is returned if there is an error in
+  //    INTERACTIVE mode.
+
+Hash_Table *New_Hash_Block(char *block, int n, int64 *offs, int stride, int *dup);
+
   //  Hash_Lookup:
   //    Lookup "entry" in the hash table.  If found return its index, otherwise return -1
   //  Hash_Add:
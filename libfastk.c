@@ -7,6 +7,9 @@
  *
  *******************************************************************************************/
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "libfastk.h"
 #include "gene_core.h"
 
@@ -741,6 +744,8 @@ typedef struct
     uint8 *ctop;       //  Ptr top of current table block in buffer
     int64 *neps;       //  Size of each thread part in elements
     int    clone;      //  Is this a clone?
+    uint8 **maps;      //  If mapped, maps[p] = data of part p+1, else NULL
+    int64  mpos;       //  If mapped, index of next element in current part
   } _Kmer_Stream;
 
 #define STREAM(S) ((_Kmer_Stream *) S)
@@ -753,7 +758,63 @@ typedef struct
  *
  *****************************************************************************************/
 
-//  Load up the table buffer with the next STREAM_BLOCK suffixes (if possible)
+//  Part p of a table holds elements [neps[p-2],neps[p-1]) (neps[-1] = 0)
+
+static inline int64 Kmer_Part_Size(_Kmer_Stream *S, int p)
+{ if (p == 1)
+    return (S->neps[0]);
+  return (S->neps[p-1] - S->neps[p-2]);
+}
+
+//  Make part p the current part: open its file unless the table is memory mapped
+
+static void Open_Kmer_Part(_Kmer_Stream *S, int p)
+{ S->part = p;
+  if (S->maps == NULL)
+    { sprintf(S->name+S->nlen,"%d",p);
+      S->copn = open(S->name,O_RDONLY);
+    }
+}
+
+static void Close_Kmer_Part(_Kmer_Stream *S)
+{ if (S->maps == NULL)
+    close(S->copn);
+}
+
+//  Position at element i of the current part.  If mapped, hint the kernel that the next
+//    block will be needed soon.
+
+static void Seek_Kmer_Part(_Kmer_Stream *S, int64 i)
+{ if (S->maps != NULL)
+    { int64  n = Kmer_Part_Size(S,S->part);
+      int64  e = i + STREAM_BLOCK;
+      uint64 b, page;
+
+      S->mpos = i;
+      if (e > n)
+        e = n;
+      if (i >= e)
+        return;
+      page = sysconf(_SC_PAGESIZE);
+      b    = (uint64) (S->maps[S->part-1] + i*S->pbyte);
+      madvise((void *) (b & ~(page-1)),(b & (page-1)) + (e-i)*S->pbyte,MADV_WILLNEED);
+    }
+  else
+    lseek(S->copn,sizeof(int) + sizeof(int64) + i*S->pbyte,SEEK_SET);
+}
+
+static void Unmap_Kmer_Parts(_Kmer_Stream *S)
+{ int p;
+
+  for (p = 1; p <= S->nthr; p++)
+    munmap(S->maps[p-1] - (sizeof(int) + sizeof(int64)),
+           sizeof(int) + sizeof(int64) + Kmer_Part_Size(S,p)*S->pbyte);
+  free(S->maps);
+  S->maps = NULL;
+}
+
+//  Load up the table buffer with the next STREAM_BLOCK suffixes (if possible).  If the
+//    table is memory mapped then simply point at the remainder of the current part.
 
 static void More_Kmer_Stream(_Kmer_Stream *S)
 { int    pbyte = S->pbyte;
@@ -763,6 +824,24 @@ static void More_Kmer_Stream(_Kmer_Stream *S)
 
   if (S->part > S->nthr)
     return;
+  if (S->maps != NULL)
+    { while (1)
+        { int64 n = Kmer_Part_Size(S,S->part);
+
+          if (S->mpos < n)
+            { S->csuf = S->maps[S->part-1] + S->mpos*pbyte;
+              S->ctop = S->maps[S->part-1] + n*pbyte;
+              S->mpos = n;
+              return;
+            }
+          S->part += 1;
+          S->mpos  = 0;
+          if (S->part > S->nthr)
+            { S->csuf = NULL;
+              return;
+            }
+        }
+    }
   while (1)
     { ctop = table + read(copn,table,STREAM_BLOCK*pbyte);
       if (ctop > table)
@@ -782,7 +861,7 @@ static void More_Kmer_Stream(_Kmer_Stream *S)
   S->copn = copn;
 }
 
-Kmer_Stream *Open_Kmer_Stream(char *name)
+static Kmer_Stream *open_kmer_stream(char *name, int map)
 { _Kmer_Stream *S;
   int           kmer, tbyte, kbyte, minval, ibyte, pbyte, hbyte, ixlen;
   int64         nels;
@@ -829,10 +908,21 @@ Kmer_Stream *Open_Kmer_Stream(char *name)
   S        = Malloc(sizeof(_Kmer_Stream),"Allocating table record");
   S->name  = full;
   S->nlen  = strlen(full);
-  S->table = Malloc(STREAM_BLOCK*pbyte,"Allocating k-mer buffer\n");
   S->neps  = Malloc(nthreads*sizeof(int64),"Allocating parts table of Kmer_Stream");
   S->index = Malloc(ixlen*sizeof(int64),"Allocating table prefix index\n");
-  if (S == NULL || S->table == NULL || S->neps == NULL || S->index == NULL)
+  if (map)
+    { S->table = NULL;
+      S->maps  = Malloc(nthreads*sizeof(uint8 *),"Allocating part maps of Kmer_Stream");
+      if (S->maps == NULL)
+        exit (1);
+    }
+  else
+    { S->table = Malloc(STREAM_BLOCK*pbyte,"Allocating k-mer buffer\n");
+      S->maps  = NULL;
+      if (S->table == NULL)
+        exit (1);
+    }
+  if (S == NULL || S->neps == NULL || S->index == NULL)
     exit (1);
 
   //  Read in index from stub and then close it
@@ -859,6 +949,18 @@ Kmer_Stream *Open_Kmer_Stream(char *name)
                          Prog_Name,S->name);
           exit (1);
         }
+      if (map)
+        { int64  size = sizeof(int) + sizeof(int64) + n*pbyte;
+          uint8 *base;
+
+          base = mmap(NULL,size,PROT_READ,MAP_SHARED,copn,0);
+          if (base == MAP_FAILED)
+            { fprintf(stderr,"%s: Cannot memory map table part %s\n",Prog_Name,S->name);
+              exit (1);
+            }
+          madvise(base,size,MADV_SEQUENTIAL);
+          S->maps[p-1] = base + (sizeof(int) + sizeof(int64));
+        }
       close(copn);
     }
 
@@ -878,15 +980,12 @@ Kmer_Stream *Open_Kmer_Stream(char *name)
   S->hbyte  = hbyte;
   S->nthr   = nthreads;
   S->clone  = 0;
+  S->copn   = -1;
 
   //  Set position to beginning
 
-  sprintf(S->name+S->nlen,"%d",1);
-  copn = open(S->name,O_RDONLY);
-  lseek(copn,sizeof(int)+sizeof(int64),SEEK_SET);
-
-  S->copn  = copn;
-  S->part  = 1;
+  Open_Kmer_Part(S,1);
+  Seek_Kmer_Part(S,0);
 
   More_Kmer_Stream(S);
 
@@ -906,9 +1005,14 @@ Kmer_Stream *Open_Kmer_Stream(char *name)
   return ((Kmer_Stream *) S);
 }
 
+Kmer_Stream *Open_Kmer_Stream(char *name)
+{ return (open_kmer_stream(name,0)); }
+
+Kmer_Stream *Map_Kmer_Stream(char *name)
+{ return (open_kmer_stream(name,1)); }
+
 Kmer_Stream *Clone_Kmer_Stream(Kmer_Stream *O)
 { _Kmer_Stream *S;
-  int copn;
 
   S = Malloc(sizeof(_Kmer_Stream),"Allocating table record");
   if (S == NULL)
@@ -917,20 +1021,21 @@ Kmer_Stream *Clone_Kmer_Stream(Kmer_Stream *O)
   *S = *STREAM(O);
   S->clone = 1;
 
-  S->table = Malloc(STREAM_BLOCK*STREAM(O)->pbyte,"Allocating k-mer buffer\n");
+  if (S->maps == NULL)
+    { S->table = Malloc(STREAM_BLOCK*STREAM(O)->pbyte,"Allocating k-mer buffer\n");
+      if (S->table == NULL)
+        exit (1);
+    }
   S->name  = Malloc(S->nlen+20,"Allocating k-mer buffer\n");
-  if (S->table == NULL || S->name == NULL)
+  if (S->name == NULL)
     exit (1);
   strncpy(S->name,STREAM(O)->name,S->nlen);
 
   //  Set position to beginning
 
-  sprintf(S->name+S->nlen,"%d",1);
-  copn = open(S->name,O_RDONLY);
-  lseek(copn,sizeof(int)+sizeof(int64),SEEK_SET);
-
-  S->copn  = copn;
-  S->part  = 1;
+  S->copn = -1;
+  Open_Kmer_Part(S,1);
+  Seek_Kmer_Part(S,0);
 
   More_Kmer_Stream(S);
   S->cidx  = 0;
@@ -953,7 +1058,9 @@ void Free_Kmer_Stream(Kmer_Stream *_S)
 { _Kmer_Stream *S = STREAM(_S);
 
   if (!S->clone)
-    { free(S->neps);
+    { if (S->maps != NULL)
+        Unmap_Kmer_Parts(S);
+      free(S->neps);
       free(S->index);
       free(S->inver);
     }
@@ -1009,7 +1116,14 @@ int Open_Kmer_Cache(Kmer_Stream *_S, int64 bidx, int64 eidx, int bpre, int epre,
   S->index -= bpre;
 
   if (S->part <= S->nthr)
-    close(S->copn);
+    Close_Kmer_Part(S);
+  if (S->maps != NULL)
+    { if (S->clone)           //  The parts of a clone are the maps of its original
+        S->maps = NULL;
+      else
+        Unmap_Kmer_Parts(S);
+      S->table = Malloc(STREAM_BLOCK*S->pbyte,"Allocating k-mer buffer\n");
+    }
 
   name = Malloc(S->nlen+strlen(where)+10,"Reallocing table name");
   if (name == NULL)
@@ -1139,13 +1253,11 @@ inline void First_Kmer_Entry(Kmer_Stream *_S)
   if (S->cidx != 0)
     { if (S->part != 1)
         { if (S->part <= S->nthr)
-            close(S->copn);
-          sprintf(S->name+S->nlen,"%d",1);
-          S->copn = open(S->name,O_RDONLY);
-          S->part = 1;
+            Close_Kmer_Part(S);
+          Open_Kmer_Part(S,1);
         }
 
-      lseek(S->copn,sizeof(int)+sizeof(int64),SEEK_SET);
+      Seek_Kmer_Part(S,0);
 
       More_Kmer_Stream(S);
       S->cidx = 0;
@@ -1301,13 +1413,11 @@ inline void GoTo_Kmer_Index(Kmer_Stream *_S, int64 i)
 
   if (S->part != p)
     { if (S->part <= S->nthr)
-        close(S->copn);
-      sprintf(S->name+S->nlen,"%d",p);
-      S->copn = open(S->name,O_RDONLY);
-      S->part = p;
+        Close_Kmer_Part(S);
+      Open_Kmer_Part(S,p);
     }
 
-  lseek(S->copn,sizeof(int) + sizeof(int64) + i*S->pbyte,SEEK_SET);
+  Seek_Kmer_Part(S,i);
 
   More_Kmer_Stream(S);
 }
@@ -1346,7 +1456,7 @@ int GoTo_Kmer_Entry(Kmer_Stream *_S, uint8 *entry)
     l = index[m-1];
   if (l >= S->nels)
     { if (S->part <= S->nthr)
-        close(S->copn);
+        Close_Kmer_Part(S);
       S->csuf = NULL;
       S->cidx = S->nels;
       S->cpre = S->ixlen;
@@ -1361,7 +1471,7 @@ int GoTo_Kmer_Entry(Kmer_Stream *_S, uint8 *entry)
   S->cpre = m;
 
   if (S->part <= S->nthr)
-    close(S->copn);
+    Close_Kmer_Part(S);
 
   hi = r;
   lo = 0;
@@ -1374,17 +1484,19 @@ int GoTo_Kmer_Entry(Kmer_Stream *_S, uint8 *entry)
   l -= lo;
   r -= lo;
 
-  sprintf(S->name+S->nlen,"%d",p);
-  f = open(S->name,O_RDONLY);
-  S->part = p;
-  S->copn = f;
+  Open_Kmer_Part(S,p);
+  f = S->copn;
 
   // smallest l s.t. KMER(l) >= entry  (or S->neps[p] if does not exist)
 
   while (r-l > STREAM_BLOCK)
     { m = ((l+r) >> 1);
-      lseek(f,proff+m*pbyte,SEEK_SET);
-      read(f,kbuf,hbyte);
+      if (S->maps != NULL)
+        memcpy(kbuf,S->maps[p-1]+m*pbyte,hbyte);
+      else
+        { lseek(f,proff+m*pbyte,SEEK_SET);
+          read(f,kbuf,hbyte);
+        }
       if (mycmp(kbuf,entry,hbyte) < 0)
         l = m+1;
       else
@@ -1392,7 +1504,7 @@ int GoTo_Kmer_Entry(Kmer_Stream *_S, uint8 *entry)
     }
 
   if (l >= S->nels)
-    { close(S->copn);
+    { Close_Kmer_Part(S);
       S->csuf = NULL;
       S->cidx = S->nels;
       S->cpre = S->ixlen;
@@ -1400,7 +1512,7 @@ int GoTo_Kmer_Entry(Kmer_Stream *_S, uint8 *entry)
       return (0);
     }
 
-  lseek(f,proff+l*pbyte,SEEK_SET);
+  Seek_Kmer_Part(S,l);
 
   More_Kmer_Stream(S);
   S->cidx = l + lo;
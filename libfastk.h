@@ -90,9 +90,12 @@ typedef struct
     uint8 *ctop;       //  Ptr top of current table block in buffer
     int64 *neps;       //  Size of each thread part in elements
     int    clone;      //  Is this a clone?
+    uint8 **maps;      //  If mapped, maps[p] = data of part p+1, else NULL
+    int64  mpos;       //  If mapped, index of next element in current part
   } Kmer_Stream;
 
 Kmer_Stream *Open_Kmer_Stream(char *name);
+Kmer_Stream *Map_Kmer_Stream(char *name);     //  As above but table parts are memory mapped
 Kmer_Stream *Clone_Kmer_Stream(Kmer_Stream *S);
 void         Free_Kmer_Stream(Kmer_Stream *S);
 